@@ -0,0 +1,51 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright 2020 Meng-Shan Jiang                                             *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License");            *
+ * you may not use this file except in compliance with the License.           *
+ * You may obtain a copy of the License at                                    *
+ *                                                                            *
+ *    http://www.apache.org/licenses/LICENSE-2.0                              *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ *                                                                            *
+ *****************************************************************************/
+
+/* endianess 
+ * 0 : big endian
+ * 1 : little endian
+ * see <secp256k1_x64/common.h> and secp256k1_x64/CMakeLists.txt
+ */
+#define ENDIANESS 1
+
+/* bits */
+#define SIXTY_FOUR_BIT_LONG
+/* #undef SIXTY_FOUR_BIT */
+
+/* thread */
+#define HAVE_PTHREAD
+/* #undef HAVE_WIN32_THREAD */
+/* #undef HAVE_NO_THREAD */
+
+/* header file */
+#define HAVE_IMMINTRIN_H
+
+/* field elements are plain(not montgomery), reduced by folding with
+ * 2^256 mod P, the *_mont field functions keep their names.
+ */
+/* #undef SECP256K1_PSEUDO_MERSENNE */
+
+/* the C-level code uses the inline field functions of
+ * secp256k1_x64/secp256k1/field_lcl.h instead of the asm ones.
+ */
+/* #undef SECP256K1_INLINE_FIELD */
+
+/* table entries of the next N windows secp256k1_scalar_mul_gen prefetches,
+ * 0 : none. Set with -DGEN_PREFETCH_DISTANCE=N.
+ */
+#define SECP256K1_GEN_PREFETCH 2
@@ -0,0 +1,51 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright 2020 Meng-Shan Jiang                                             *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License");            *
+ * you may not use this file except in compliance with the License.           *
+ * You may obtain a copy of the License at                                    *
+ *                                                                            *
+ *    http://www.apache.org/licenses/LICENSE-2.0                              *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ *                                                                            *
+ *****************************************************************************/
+
+#pragma once
+
+#include <secp256k1_x64/common.h>
+#include <secp256k1_x64/secp256k1.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* verify an ecdsa signature
+ * msg32  : 32 bytes message hash(big endian)
+ * sig    : 64 bytes compact signature, r || s(big endian)
+ * pubkey : public key, jacobian coordinate(mont)
+ * return CRYPTO_OK if signature is valid, CRYPTO_ERR otherwise.
+ */
+X64_EXPORT int secp256k1_ecdsa_verify(const unsigned char msg32[32],
+                                      const unsigned char sig[64],
+                                      const POINT256 *pubkey);
+
+/* create an ecdsa signature, nonce is derived deterministically from
+ * seckey and msg32 as in RFC 6979(HMAC-SHA256), s is normalized to low-S.
+ * sig    : 64 bytes compact signature, r || s(big endian)
+ * msg32  : 32 bytes message hash(big endian)
+ * seckey : 32 bytes secret key(big endian), 0 < seckey < n
+ * return CRYPTO_OK on success, CRYPTO_ERR if seckey is invalid.
+ */
+X64_EXPORT int secp256k1_ecdsa_sign(unsigned char sig[64],
+                                    const unsigned char msg32[32],
+                                    const unsigned char seckey[32]);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,70 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright 2020 Meng-Shan Jiang                                             *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License");            *
+ * you may not use this file except in compliance with the License.           *
+ * You may obtain a copy of the License at                                    *
+ *                                                                            *
+ *    http://www.apache.org/licenses/LICENSE-2.0                              *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ *                                                                            *
+ *****************************************************************************/
+
+#pragma once
+
+#include <secp256k1_x64/common.h>
+#include <secp256k1_x64/secp256k1.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* x-only public key(BIP340) of seckey
+ * pubkey32 : 32 bytes x coordinate(big endian)
+ * seckey   : 32 bytes secret key(big endian), 0 < seckey < n
+ */
+X64_EXPORT int secp256k1_xonly_pubkey_create(unsigned char pubkey32[32],
+                                             const unsigned char seckey[32]);
+/* lift_x, pubkey is the point with x = pubkey32 and even y,
+ * jacobian coordinate(mont). return CRYPTO_ERR if x is not on curve.
+ */
+X64_EXPORT int secp256k1_xonly_pubkey_parse(POINT256 *pubkey,
+                                            const unsigned char pubkey32[32]);
+
+/* create a BIP340 schnorr signature
+ * sig        : 64 bytes signature, x(R) || s(big endian)
+ * msg32      : 32 bytes message
+ * seckey     : 32 bytes secret key(big endian), 0 < seckey < n
+ * aux_rand32 : 32 bytes auxiliary randomness, NULL is treated as 32 zero bytes
+ * return CRYPTO_OK on success, CRYPTO_ERR otherwise.
+ */
+X64_EXPORT int secp256k1_schnorrsig_sign(unsigned char sig[64],
+                                         const unsigned char msg32[32],
+                                         const unsigned char seckey[32],
+                                         const unsigned char aux_rand32[32]);
+/* verify a BIP340 schnorr signature
+ * return CRYPTO_OK if signature is valid, CRYPTO_ERR otherwise.
+ */
+X64_EXPORT int secp256k1_schnorrsig_verify(const unsigned char sig[64],
+                                           const unsigned char msg32[32],
+                                           const unsigned char pubkey32[32]);
+
+/* verify n BIP340 schnorr signatures at once, with a random linear
+ * combination of the verification equations.
+ * return CRYPTO_OK if all signatures are valid, CRYPTO_ERR if any of
+ * them is invalid(with overwhelming probability) or on allocation failure.
+ */
+X64_EXPORT int secp256k1_schnorrsig_verify_batch(const unsigned char (*sig)[64],
+                                                 const unsigned char (*msg32)[32],
+                                                 const unsigned char (*pubkey32)[32],
+                                                 size_t n);
+
+#ifdef __cplusplus
+}
+#endif
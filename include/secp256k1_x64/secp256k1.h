@@ -36,6 +36,25 @@ typedef POINT256_AFFINE PRECOMP256_ROW[64];
 X64_EXPORT int secp256k1_precompute_table_gen();
 X64_EXPORT void secp256k1_precompute_table_free();
 
+/* generator table geometry of secp256k1_scalar_mul_gen */
+# define SECP256K1_GEN_BOOTH    0   /* Booth windows, window 4 .. 8 */
+# define SECP256K1_GEN_COMB     1   /* Lim-Lee comb, teeth 1 .. 8, teeth*blocks <= 256 */
+
+typedef struct {
+    int method;
+    int window;
+    int teeth;
+    int blocks;
+} SECP256K1_GEN_CONFIG;
+
+/* rebuild the table of secp256k1_scalar_mul_gen with another geometry,
+ * call it after CRYPTO_init and before other threads use the library.
+ * Booth w7 is the default, variable time code always uses it.
+ */
+X64_EXPORT int secp256k1_precompute_table_config(const SECP256K1_GEN_CONFIG *config);
+/* bytes of the table used by secp256k1_scalar_mul_gen */
+X64_EXPORT size_t secp256k1_precompute_table_size();
+
 X64_EXPORT int secp256k1_get_p(BN_ULONG r[P256_LIMBS]);
 X64_EXPORT int secp256k1_get_order(BN_ULONG r[P256_LIMBS]);
 X64_EXPORT int secp256k1_get_generator(POINT256 *r);
@@ -86,6 +105,10 @@ X64_EXPORT void secp256k1_reduce(BN_ULONG res[4], BN_ULONG a[P256_LIMBS]);
 X64_EXPORT void secp256k1_mul_word(BN_ULONG res[P256_LIMBS],
                           const BN_ULONG a[P256_LIMBS],
                           const BN_ULONG w);
+/* The field functions below work on the representation of field elements,
+ * built with SECP256K1_PSEUDO_MERSENNE it is the plain one(2^256 -> 1),
+ * *_mont become pseudo-Mersenne mul/sqr and the conversions only reduce.
+ */
 /* Montgomery mul: res = a*b*2^-256 mod P */
 X64_EXPORT void secp256k1_mul_mont(BN_ULONG res[P256_LIMBS],
                           const BN_ULONG a[P256_LIMBS],
@@ -93,12 +116,49 @@ X64_EXPORT void secp256k1_mul_mont(BN_ULONG res[P256_LIMBS],
 /* Montgomery sqr: res = a*a*2^-256 mod P */
 X64_EXPORT void secp256k1_sqr_mont(BN_ULONG res[P256_LIMBS],
                           const BN_ULONG a[P256_LIMBS]);
+/* res = a^(2^n), n squarings in a row, res = a if n <= 0 */
+X64_EXPORT void secp256k1_sqr_mont_n(BN_ULONG res[P256_LIMBS],
+                            const BN_ULONG a[P256_LIMBS], int n);
 /* Convert a number from Montgomery domain, by multiplying with 1 */
 X64_EXPORT void secp256k1_from_mont(BN_ULONG res[P256_LIMBS],
                            const BN_ULONG in[P256_LIMBS]);
 /* Convert a number to Montgomery domain, by multiplying with 2^512 mod P*/
 X64_EXPORT void secp256k1_to_mont(BN_ULONG res[P256_LIMBS],
                          const BN_ULONG in[P256_LIMBS]);
+/* Pseudo-Mersenne mul: res = a*b mod P, high half folded with 2^256 mod P */
+X64_EXPORT void secp256k1_mul_pm(BN_ULONG res[P256_LIMBS],
+                        const BN_ULONG a[P256_LIMBS],
+                        const BN_ULONG b[P256_LIMBS]);
+/* Pseudo-Mersenne sqr: res = a*a mod P */
+X64_EXPORT void secp256k1_sqr_pm(BN_ULONG res[P256_LIMBS],
+                        const BN_ULONG a[P256_LIMBS]);
+/* Scalar arithmetic modulo the group order N, inputs fully reduced */
+/* res = a+b mod N */
+X64_EXPORT void secp256k1_scalar_add(BN_ULONG res[P256_LIMBS],
+                            const BN_ULONG a[P256_LIMBS],
+                            const BN_ULONG b[P256_LIMBS]);
+/* res = a-b mod N */
+X64_EXPORT void secp256k1_scalar_sub(BN_ULONG res[P256_LIMBS],
+                            const BN_ULONG a[P256_LIMBS],
+                            const BN_ULONG b[P256_LIMBS]);
+/* res = -a mod N */
+X64_EXPORT void secp256k1_scalar_neg(BN_ULONG res[P256_LIMBS], const BN_ULONG a[P256_LIMBS]);
+/* res = a mod N, any 256-bit a */
+X64_EXPORT void secp256k1_scalar_reduce(BN_ULONG res[P256_LIMBS], const BN_ULONG a[P256_LIMBS]);
+/* Montgomery mul: res = a*b*2^-256 mod N */
+X64_EXPORT void secp256k1_scalar_mul_mont(BN_ULONG res[P256_LIMBS],
+                                 const BN_ULONG a[P256_LIMBS],
+                                 const BN_ULONG b[P256_LIMBS]);
+/* Montgomery sqr repeated rep(>= 1) times: res = a^(2^rep) in Montgomery domain */
+X64_EXPORT void secp256k1_scalar_sqr_mont(BN_ULONG res[P256_LIMBS],
+                                 const BN_ULONG a[P256_LIMBS], int rep);
+/* Convert a scalar from Montgomery domain */
+X64_EXPORT void secp256k1_scalar_from_mont(BN_ULONG res[P256_LIMBS],
+                                  const BN_ULONG in[P256_LIMBS]);
+/* Convert a scalar to Montgomery domain, in < N */
+X64_EXPORT void secp256k1_scalar_to_mont(BN_ULONG res[P256_LIMBS],
+                                const BN_ULONG in[P256_LIMBS]);
+
 /* Functions that perform constant time access to the precomputed tables */
 X64_EXPORT void secp256k1_scatter_w5(POINT256 *val,
                             const POINT256 *in_t, int idx);
@@ -109,17 +169,100 @@ X64_EXPORT void secp256k1_scatter_w7(POINT256_AFFINE *val,
 X64_EXPORT int secp256k1_point_cmp(const POINT256 *a, const POINT256 *b);
 
 X64_EXPORT void secp256k1_point_dbl(POINT256 *r, const POINT256 *a);
+/* r = 2^n * a, n doublings in one call, r = a if n <= 0 */
+X64_EXPORT void secp256k1_point_dbl_n(POINT256 *r, const POINT256 *a, int n);
 X64_EXPORT void secp256k1_point_add(POINT256 *r, const POINT256 *a, const POINT256 *b);
 X64_EXPORT void secp256k1_point_add_affine(POINT256 *r,
                                   const POINT256 *a,
                                   const POINT256_AFFINE *b);
+/* r += d * row[|d| - 1], digit = 2*|d| + sign as returned by _booth_recode_w7,
+ * |d| = 0 adds nothing. The row entry is read directly, not scanned.
+ */
+X64_EXPORT void secp256k1_point_add_affine_lookup(POINT256 *r,
+                                         const PRECOMP256_ROW row,
+                                         unsigned int digit);
 
 /* r = scalar * generator */
 X64_EXPORT int secp256k1_scalar_mul_gen(POINT256 *r, BN_ULONG scalar[P256_LIMBS]);
 /* r = scalar * point */
 X64_EXPORT int secp256k1_scalar_mul_point(POINT256 *r, BN_ULONG scalar[P256_LIMBS], POINT256 *point);
-/* convert jacobian coordinate(mont) to affine coordinate */
+/* r[i] = scalars[i] * generator, i = 0 .. 3. Four calls of
+ * secp256k1_scalar_mul_gen, the four-lane AVX2 engine is not used while it
+ * is slower than that.
+ */
+X64_EXPORT int secp256k1_scalar_mul_gen_x4(POINT256 r[4], const BN_ULONG (*scalars)[P256_LIMBS]);
+/* r[i] = k[i] * generator, i = 0 .. n-1. The batch walks the table row by
+ * row, every accumulator adds its entry of row j before row j+1 is touched,
+ * so the row stays in L1 across the batch.
+ */
+X64_EXPORT int secp256k1_scalar_mul_gen_batch(POINT256 *r, const BN_ULONG (*k)[P256_LIMBS], size_t n);
+/* r[i] = scalars[i] * points[i], i = 0 .. 3, like
+ * secp256k1_scalar_mul_gen_x4.
+ */
+X64_EXPORT int secp256k1_scalar_mul_point_x4(POINT256 r[4], const BN_ULONG (*scalars)[P256_LIMBS],
+                                             const POINT256 points[4]);
+/* r = scalar * point in variable time, only for public inputs.
+ * GLV split plus width-w NAF over a table of 2^(w-2) odd multiples
+ * normalized to affine, w in [2, 8], 0 selects the default window(5).
+ */
+X64_EXPORT int secp256k1_scalar_mul_point_var(POINT256 *r, const BN_ULONG scalar[P256_LIMBS],
+                                              const POINT256 *point, int w);
+/* precomputed multiples of a base point, reused by secp256k1_scalar_mul_prepared */
+typedef struct secp256k1_prepared_point_st SECP256K1_PREPARED_POINT;
+/* build the GLV tables of point once, w in [4, 8], 0 means 6.
+ * point must not be at infinity. Free with secp256k1_prepared_point_free.
+ */
+X64_EXPORT SECP256K1_PREPARED_POINT *secp256k1_prepared_point_new(const POINT256 *point, int w);
+X64_EXPORT void secp256k1_prepared_point_free(SECP256K1_PREPARED_POINT *pp);
+/* r = scalar * point, same ladder as secp256k1_scalar_mul_point without
+ * building the table.
+ */
+X64_EXPORT int secp256k1_scalar_mul_prepared(POINT256 *r, const BN_ULONG scalar[P256_LIMBS],
+                                             const SECP256K1_PREPARED_POINT *pp);
+/* bytes written by secp256k1_prepared_point_serialize */
+X64_EXPORT size_t secp256k1_prepared_point_serialized_size(const SECP256K1_PREPARED_POINT *pp);
+/* *outlen is the size of out on input, bytes written on output */
+X64_EXPORT int secp256k1_prepared_point_serialize(unsigned char *out, size_t *outlen,
+                                                  const SECP256K1_PREPARED_POINT *pp);
+/* load a serialized prepared point, entries are checked to be on the curve */
+X64_EXPORT SECP256K1_PREPARED_POINT *secp256k1_prepared_point_load(const unsigned char *in, size_t inlen);
+/* counters of the secp256k1_scalar_mul_point cache */
+typedef struct {
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t evictions;
+    size_t entries;
+    size_t bytes;
+    size_t budget;
+} SECP256K1_POINT_CACHE_STATS;
+/* let secp256k1_scalar_mul_point cache the prepared point(window w, see
+ * secp256k1_prepared_point_new) of up to budget bytes of input points,
+ * least recently used ones are evicted. Only points with Z = 1(e.g. from
+ * secp256k1_point_set_affine) are cached. Budget 0 disables the cache, the
+ * default. Reconfiguring drops every entry and resets the counters.
+ */
+X64_EXPORT int secp256k1_point_cache_config(size_t budget, int w);
+X64_EXPORT int secp256k1_point_cache_stats(SECP256K1_POINT_CACHE_STATS *stats);
+/* bytes of scratch memory needed by secp256k1_multi_scalar_mul for n points */
+X64_EXPORT size_t secp256k1_multi_scalar_mul_scratch_size(size_t n);
+/* r = sum(scalars[i] * points[i]) in variable time, only for public inputs.
+ * Strauss(wNAF, shared doublings) for small n, Pippenger(bucket method with
+ * GLV, window chosen from n) for large n.
+ * scratch must hold secp256k1_multi_scalar_mul_scratch_size(n) bytes.
+ */
+X64_EXPORT int secp256k1_multi_scalar_mul(POINT256 *r, const BN_ULONG (*scalars)[P256_LIMBS],
+                                          const POINT256 *points, size_t n, void *scratch);
+/* convert jacobian coordinate(mont) to affine coordinate,
+ * variable time in Z.
+ */
 X64_EXPORT int secp256k1_point_get_affine(BN_ULONG x[P256_LIMBS], BN_ULONG y[P256_LIMBS], const POINT256 *point);
+/* convert n jacobian coordinates(mont) to affine coordinates with a single
+ * field inversion, points at infinity are converted to (0, 0).
+ * scratch must hold n field elements.
+ */
+X64_EXPORT int secp256k1_point_get_affine_batch(BN_ULONG (*x)[P256_LIMBS], BN_ULONG (*y)[P256_LIMBS],
+                                                const POINT256 *points, size_t n,
+                                                BN_ULONG (*scratch)[P256_LIMBS]);
 /* convert affine coordinate to jacobian coordinate(mont) */
 X64_EXPORT int secp256k1_point_set_affine(POINT256 *point, const BN_ULONG x[P256_LIMBS], const BN_ULONG y[P256_LIMBS]);
 /* field inversion
@@ -128,6 +271,39 @@ X64_EXPORT int secp256k1_point_set_affine(POINT256 *point, const BN_ULONG x[P256
  * (R = 2^256 mod p)
  */
 X64_EXPORT void secp256k1_mod_inverse(BN_ULONG r[P256_LIMBS], const BN_ULONG in[P256_LIMBS]);
+/* variable time field inversion(safegcd), same input and output as
+ * secp256k1_mod_inverse, only for public inputs.
+ */
+X64_EXPORT void secp256k1_mod_inverse_var(BN_ULONG r[P256_LIMBS], const BN_ULONG in[P256_LIMBS]);
+/* batch field inversion(Montgomery's trick), one inversion for n elements
+ * in[i] = aR mod p
+ * r[i]  = (a^-1)R mod p, zero elements are left zero
+ * r may alias in, scratch must hold n field elements.
+ */
+X64_EXPORT int secp256k1_mod_inverse_batch(BN_ULONG (*r)[P256_LIMBS], const BN_ULONG (*in)[P256_LIMBS],
+                                           size_t n, BN_ULONG (*scratch)[P256_LIMBS]);
+/* field square root
+ * in = aR mod p
+ * r  = (sqrt(a))R mod p
+ * return CRYPTO_OK if a is a square, CRYPTO_ERR otherwise(r is undefined).
+ */
+X64_EXPORT int secp256k1_mod_sqrt(BN_ULONG r[P256_LIMBS], const BN_ULONG in[P256_LIMBS]);
+/* res = a mod N, a is 512-bit(little endian limbs) */
+X64_EXPORT void secp256k1_scalar_reduce_wide(BN_ULONG res[P256_LIMBS], const BN_ULONG a[2 * P256_LIMBS]);
+/* GLV decomposition, k = k1 + k2*lambda mod N, k < N.
+ * k1 and k2 are residues mod N of integers in (-2^128, 2^128),
+ * i.e. either k or N - k is below 2^128.
+ */
+X64_EXPORT void secp256k1_scalar_split_lambda(BN_ULONG k1[P256_LIMBS], BN_ULONG k2[P256_LIMBS],
+                                              const BN_ULONG k[P256_LIMBS]);
+/* scalar inversion
+ * in = aR mod N
+ * r  = (a^-1)R mod N
+ * (R = 2^256 mod N)
+ */
+X64_EXPORT void secp256k1_scalar_inverse(BN_ULONG r[P256_LIMBS], const BN_ULONG in[P256_LIMBS]);
+/* variable time scalar inversion, only for public inputs */
+X64_EXPORT void secp256k1_scalar_inverse_var(BN_ULONG r[P256_LIMBS], const BN_ULONG in[P256_LIMBS]);
 /* 1 : point is on curve, 
  * 0 : point is not on curve 
  */
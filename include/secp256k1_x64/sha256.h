@@ -0,0 +1,70 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright 2020 Meng-Shan Jiang                                             *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License");            *
+ * you may not use this file except in compliance with the License.           *
+ * You may obtain a copy of the License at                                    *
+ *                                                                            *
+ *    http://www.apache.org/licenses/LICENSE-2.0                              *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ *                                                                            *
+ *****************************************************************************/
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <secp256k1_x64/common.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define SECP256K1_SHA256_DIGEST_LENGTH 32
+#define SECP256K1_SHA256_BLOCK_SIZE    64
+
+typedef struct {
+    uint32_t h[8];
+    unsigned char buf[SECP256K1_SHA256_BLOCK_SIZE];
+    /* total length in bytes */
+    uint64_t bytes;
+} SECP256K1_SHA256_CTX;
+
+typedef struct {
+    SECP256K1_SHA256_CTX inner;
+    SECP256K1_SHA256_CTX outer;
+} SECP256K1_HMAC_SHA256_CTX;
+
+X64_EXPORT void secp256k1_sha256_init(SECP256K1_SHA256_CTX *ctx);
+X64_EXPORT void secp256k1_sha256_update(SECP256K1_SHA256_CTX *ctx, const unsigned char *data, size_t len);
+X64_EXPORT void secp256k1_sha256_final(unsigned char digest[SECP256K1_SHA256_DIGEST_LENGTH],
+                                       SECP256K1_SHA256_CTX *ctx);
+/* digest = sha256(data) */
+X64_EXPORT void secp256k1_sha256(unsigned char digest[SECP256K1_SHA256_DIGEST_LENGTH],
+                                 const unsigned char *data, size_t len);
+
+/* BIP340 tagged hash, ctx is initialized with sha256(tag) || sha256(tag) */
+X64_EXPORT void secp256k1_sha256_init_tagged(SECP256K1_SHA256_CTX *ctx, const unsigned char *tag, size_t taglen);
+/* digest = sha256(sha256(tag) || sha256(tag) || data) */
+X64_EXPORT void secp256k1_sha256_tagged(unsigned char digest[SECP256K1_SHA256_DIGEST_LENGTH],
+                                        const unsigned char *tag, size_t taglen,
+                                        const unsigned char *data, size_t len);
+
+X64_EXPORT void secp256k1_hmac_sha256_init(SECP256K1_HMAC_SHA256_CTX *ctx, const unsigned char *key, size_t keylen);
+X64_EXPORT void secp256k1_hmac_sha256_update(SECP256K1_HMAC_SHA256_CTX *ctx, const unsigned char *data, size_t len);
+X64_EXPORT void secp256k1_hmac_sha256_final(unsigned char mac[SECP256K1_SHA256_DIGEST_LENGTH],
+                                            SECP256K1_HMAC_SHA256_CTX *ctx);
+/* mac = hmac-sha256(key, data) */
+X64_EXPORT void secp256k1_hmac_sha256(unsigned char mac[SECP256K1_SHA256_DIGEST_LENGTH],
+                                      const unsigned char *key, size_t keylen,
+                                      const unsigned char *data, size_t len);
+
+#ifdef __cplusplus
+}
+#endif
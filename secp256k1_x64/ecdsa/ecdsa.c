@@ -0,0 +1,213 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright 2020 Meng-Shan Jiang                                             *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License");            *
+ * you may not use this file except in compliance with the License.           *
+ * You may obtain a copy of the License at                                    *
+ *                                                                            *
+ *    http://www.apache.org/licenses/LICENSE-2.0                              *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ *                                                                            *
+ *****************************************************************************/
+
+#include <string.h>
+#include <secp256k1_x64/fp256.h>
+#include <secp256k1_x64/secp256k1.h>
+#include <secp256k1_x64/ecdsa.h>
+#include <secp256k1_x64/sha256.h>
+#include "../secp256k1/secp256k1_lcl.h"
+#include "../secp256k1/field_lcl.h"
+
+/* p - n */
+static const BN_ULONG P_MINUS_N[P256_LIMBS] = {
+    0x402da1722fc9baeeULL, 0x4551231950b75fc4ULL, 0x0000000000000001ULL, 0ULL
+};
+
+/* (n - 1) / 2, largest low-S value */
+static const BN_ULONG N_HALF[P256_LIMBS] = {
+    0xdfe92f46681b20a0ULL, 0x5d576e7357a4501dULL, 0xffffffffffffffffULL, 0x7fffffffffffffffULL
+};
+
+/* RFC 6979 HMAC-SHA256 DRBG state */
+typedef struct {
+    unsigned char K[SECP256K1_SHA256_DIGEST_LENGTH];
+    unsigned char V[SECP256K1_SHA256_DIGEST_LENGTH];
+    int retry;
+} RFC6979_CTX;
+
+/* K = HMAC_K(V || b || x || h1), V = HMAC_K(V) */
+static void rfc6979_update(RFC6979_CTX *ctx, unsigned char b,
+                           const unsigned char *x, const unsigned char *h1)
+{
+    SECP256K1_HMAC_SHA256_CTX hmac;
+
+    secp256k1_hmac_sha256_init(&hmac, ctx->K, SECP256K1_SHA256_DIGEST_LENGTH);
+    secp256k1_hmac_sha256_update(&hmac, ctx->V, SECP256K1_SHA256_DIGEST_LENGTH);
+    secp256k1_hmac_sha256_update(&hmac, &b, 1);
+    if (x != NULL) {
+        secp256k1_hmac_sha256_update(&hmac, x, 32);
+        secp256k1_hmac_sha256_update(&hmac, h1, 32);
+    }
+    secp256k1_hmac_sha256_final(ctx->K, &hmac);
+    secp256k1_hmac_sha256(ctx->V, ctx->K, SECP256K1_SHA256_DIGEST_LENGTH, ctx->V, SECP256K1_SHA256_DIGEST_LENGTH);
+}
+
+/* x = int2octets(seckey), h1 = bits2octets(msg) */
+static void rfc6979_init(RFC6979_CTX *ctx, const unsigned char x[32], const unsigned char h1[32])
+{
+    memset(ctx->V, 0x01, SECP256K1_SHA256_DIGEST_LENGTH);
+    memset(ctx->K, 0x00, SECP256K1_SHA256_DIGEST_LENGTH);
+    rfc6979_update(ctx, 0x00, x, h1);
+    rfc6979_update(ctx, 0x01, x, h1);
+    ctx->retry = 0;
+}
+
+/* next nonce candidate, qlen = hlen = 256 so one block is enough */
+static void rfc6979_generate(RFC6979_CTX *ctx, unsigned char k[32])
+{
+    if (ctx->retry)
+        rfc6979_update(ctx, 0x00, NULL, NULL);
+
+    secp256k1_hmac_sha256(ctx->V, ctx->K, SECP256K1_SHA256_DIGEST_LENGTH, ctx->V, SECP256K1_SHA256_DIGEST_LENGTH);
+    memcpy(k, ctx->V, 32);
+    ctx->retry = 1;
+}
+
+int secp256k1_ecdsa_verify(const unsigned char msg32[32],
+                           const unsigned char sig[64],
+                           const POINT256 *pubkey)
+{
+    BN_ULONG n[P256_LIMBS];
+    BN_ULONG r[P256_LIMBS], s[P256_LIMBS], e[P256_LIMBS];
+    BN_ULONG w[P256_LIMBS], u1[P256_LIMBS], u2[P256_LIMBS];
+    BN_ULONG z2[P256_LIMBS], t[P256_LIMBS];
+    POINT256 R;
+
+    if (msg32 == NULL || sig == NULL || pubkey == NULL)
+        return CRYPTO_ERR;
+
+    if (secp256k1_point_is_at_infinity(pubkey) || !secp256k1_point_is_on_curve(pubkey))
+        return CRYPTO_ERR;
+
+    /* 0 < r, s < n */
+    secp256k1_get_order(n);
+    fp256_set_bytes(r, (unsigned char *)sig, 32);
+    fp256_set_bytes(s, (unsigned char *)sig + 32, 32);
+    if (fp256_is_zero(r) || fp256_cmp(r, n) >= 0 ||
+        fp256_is_zero(s) || fp256_cmp(s, n) >= 0)
+        return CRYPTO_ERR;
+
+    fp256_set_bytes(e, (unsigned char *)msg32, 32);
+    secp256k1_scalar_reduce(e, e);
+
+    /* w = s^-1, u1 = e*w, u2 = r*w */
+    secp256k1_scalar_to_mont(w, s);
+    secp256k1_scalar_inverse_var(w, w);
+    secp256k1_scalar_mul_mont(u1, w, e);
+    secp256k1_scalar_mul_mont(u2, w, r);
+
+    secp256k1_scalar_mul_double_var(&R, u1, u2, pubkey);
+    if (secp256k1_point_is_at_infinity(&R))
+        return CRYPTO_ERR;
+
+    /* R.x mod n == r, checked as r*Z^2 == X, and (r+n)*Z^2 == X if r+n < p */
+    secp256k1_fe_sqr(z2, R.Z);
+    secp256k1_fe_to_mont(t, r);
+    secp256k1_fe_mul(t, t, z2);
+    if (fp256_cmp(t, R.X) == 0)
+        return CRYPTO_OK;
+
+    if (fp256_cmp(r, P_MINUS_N) >= 0)
+        return CRYPTO_ERR;
+
+    secp256k1_add(t, r, n);
+    secp256k1_fe_to_mont(t, t);
+    secp256k1_fe_mul(t, t, z2);
+    if (fp256_cmp(t, R.X) == 0)
+        return CRYPTO_OK;
+
+    return CRYPTO_ERR;
+}
+
+int secp256k1_ecdsa_sign(unsigned char sig[64],
+                         const unsigned char msg32[32],
+                         const unsigned char seckey[32])
+{
+    int ret = CRYPTO_ERR;
+    BN_ULONG n[P256_LIMBS];
+    BN_ULONG d[P256_LIMBS], e[P256_LIMBS], k[P256_LIMBS];
+    BN_ULONG r[P256_LIMBS], s[P256_LIMBS], t[P256_LIMBS];
+    unsigned char x[32], h1[32], kb[32];
+    RFC6979_CTX drbg;
+    POINT256 R;
+
+    if (sig == NULL || msg32 == NULL || seckey == NULL)
+        return CRYPTO_ERR;
+
+    /* 0 < d < n */
+    secp256k1_get_order(n);
+    fp256_set_bytes(d, (unsigned char *)seckey, 32);
+    if (fp256_is_zero(d) || fp256_cmp(d, n) >= 0)
+        goto end;
+
+    fp256_set_bytes(e, (unsigned char *)msg32, 32);
+    secp256k1_scalar_reduce(e, e);
+
+    fp256_get_bytes(x, d);
+    fp256_get_bytes(h1, e);
+    rfc6979_init(&drbg, x, h1);
+
+    /* d in Montgomery domain for r*d */
+    secp256k1_scalar_to_mont(d, d);
+
+    for (;;) {
+        rfc6979_generate(&drbg, kb);
+        fp256_set_bytes(k, kb, 32);
+        if (fp256_is_zero(k) || fp256_cmp(k, n) >= 0)
+            continue;
+
+        /* r = (k*G).x mod n, constant time inversion since Z depends on k */
+        if (secp256k1_scalar_mul_gen(&R, k) != CRYPTO_OK)
+            goto end;
+        secp256k1_fe_inv(t, R.Z);
+        secp256k1_fe_sqr(t, t);
+        secp256k1_fe_mul(t, R.X, t);
+        secp256k1_fe_from_mont(t, t);
+        secp256k1_scalar_reduce(r, t);
+        if (fp256_is_zero(r))
+            continue;
+
+        /* s = k^-1 * (e + r*d) */
+        secp256k1_scalar_to_mont(k, k);
+        secp256k1_scalar_inverse(k, k);
+        secp256k1_scalar_mul_mont(t, r, d);
+        secp256k1_scalar_add(t, t, e);
+        secp256k1_scalar_mul_mont(s, k, t);
+        if (fp256_is_zero(s))
+            continue;
+
+        break;
+    }
+
+    /* low-S */
+    if (fp256_cmp(s, N_HALF) > 0)
+        secp256k1_scalar_neg(s, s);
+
+    fp256_get_bytes(sig, r);
+    fp256_get_bytes(sig + 32, s);
+    ret = CRYPTO_OK;
+
+end:
+    memset(d, 0, sizeof(d));
+    memset(k, 0, sizeof(k));
+    memset(x, 0, sizeof(x));
+    memset(kb, 0, sizeof(kb));
+    memset(&drbg, 0, sizeof(drbg));
+    return ret;
+}
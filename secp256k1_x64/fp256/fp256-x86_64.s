@@ -0,0 +1,400 @@
+.text	
+.hidden	cpu_info
+
+
+
+
+.globl	fp256_div_by_2
+.type	fp256_div_by_2,@function
+.align	32
+fp256_div_by_2:
+	pushq	%r12
+	pushq	%r13
+	pushq	%r14
+	pushq	%r15
+
+	movq	0(%rsi),%r8
+	movq	8(%rsi),%r9
+	movq	16(%rsi),%r10
+	movq	%r8,%rax
+	movq	24(%rsi),%r11
+
+	movq	%r9,%r15
+	xorq	%r13,%r13
+	addq	0(%rdx),%r8
+	movq	%r10,%r14
+	adcq	8(%rdx),%r9
+	adcq	16(%rdx),%r10
+	movq	%r11,%r12
+	adcq	24(%rdx),%r11
+	adcq	$0,%r13
+	xorq	%rdx,%rdx
+	testq	$1,%rax
+
+	cmovzq	%rax,%r8
+	cmovzq	%r15,%r9
+	cmovzq	%r14,%r10
+	cmovzq	%r12,%r11
+	cmovzq	%rdx,%r13
+
+	movq	%r9,%rax
+	shrq	$1,%r8
+	shlq	$63,%rax
+	movq	%r10,%r15
+	shrq	$1,%r9
+	orq	%rax,%r8
+	shlq	$63,%r15
+	movq	%r11,%r14
+	shrq	$1,%r10
+	orq	%r15,%r9
+	shlq	$63,%r14
+	shrq	$1,%r11
+	shlq	$63,%r13
+	orq	%r14,%r10
+	orq	%r13,%r11
+
+	movq	%r8,0(%rdi)
+	movq	%r9,8(%rdi)
+	movq	%r10,16(%rdi)
+	movq	%r11,24(%rdi)
+
+	popq	%r15
+	popq	%r14
+	popq	%r13
+	popq	%r12
+	.byte	0xf3,0xc3
+.size	fp256_div_by_2,.-fp256_div_by_2
+
+
+
+.globl	fp256_add
+.type	fp256_add,@function
+.align	32
+fp256_add:
+	pushq	%r12
+	pushq	%r13
+	pushq	%r14
+
+	movq	0(%rsi),%r8
+	xorq	%r13,%r13
+	movq	8(%rsi),%r9
+	movq	16(%rsi),%r10
+	movq	24(%rsi),%r11
+
+	addq	0(%rdx),%r8
+	adcq	8(%rdx),%r9
+	movq	%r8,%rax
+	adcq	16(%rdx),%r10
+	adcq	24(%rdx),%r11
+	movq	%r9,%rdx
+	adcq	$0,%r13
+
+	subq	0(%rcx),%r8
+	movq	%r10,%r14
+	sbbq	8(%rcx),%r9
+	sbbq	16(%rcx),%r10
+	movq	%r11,%r12
+	sbbq	24(%rcx),%r11
+	sbbq	$0,%r13
+
+	cmovcq	%rax,%r8
+	cmovcq	%rdx,%r9
+	movq	%r8,0(%rdi)
+	cmovcq	%r14,%r10
+	movq	%r9,8(%rdi)
+	cmovcq	%r12,%r11
+	movq	%r10,16(%rdi)
+	movq	%r11,24(%rdi)
+
+	popq	%r14
+	popq	%r13
+	popq	%r12
+	.byte	0xf3,0xc3
+.size	fp256_add,.-fp256_add
+
+
+
+.globl	fp256_add_word
+.type	fp256_add_word,@function
+.align	32
+fp256_add_word:
+	pushq	%r12
+	pushq	%r13
+	pushq	%r14
+
+	movq	0(%rsi),%r8
+	xorq	%r13,%r13
+	movq	8(%rsi),%r9
+	movq	16(%rsi),%r10
+	movq	24(%rsi),%r11
+
+	addq	0(%rdx),%r8
+	adcq	$0,%r9
+	movq	%r8,%rax
+	adcq	$0,%r10
+	adcq	$0,%r11
+	movq	%r9,%rdx
+	adcq	$0,%r13
+
+	subq	0(%rcx),%r8
+	movq	%r10,%r14
+	sbbq	8(%rcx),%r9
+	sbbq	16(%rcx),%r10
+	movq	%r11,%r12
+	sbbq	24(%rcx),%r11
+	sbbq	$0,%r13
+
+	cmovcq	%rax,%r8
+	cmovcq	%rdx,%r9
+	movq	%r8,0(%rdi)
+	cmovcq	%r14,%r10
+	movq	%r9,8(%rdi)
+	cmovcq	%r12,%r11
+	movq	%r10,16(%rdi)
+	movq	%r11,24(%rdi)
+
+	popq	%r14
+	popq	%r13
+	popq	%r12
+	.byte	0xf3,0xc3
+.size	fp256_add_word,.-fp256_add_word
+
+
+
+.globl	fp256_sub
+.type	fp256_sub,@function
+.align	32
+fp256_sub:
+	pushq	%r12
+	pushq	%r13
+	pushq	%r14
+
+	movq	0(%rsi),%r8
+	xorq	%r13,%r13
+	movq	8(%rsi),%r9
+	movq	16(%rsi),%r10
+	movq	24(%rsi),%r11
+
+
+	subq	0(%rdx),%r8
+	sbbq	8(%rdx),%r9
+	movq	%r8,%rax
+	sbbq	16(%rdx),%r10
+	sbbq	24(%rdx),%r11
+	movq	%r9,%rdx
+	sbbq	$0,%r13
+
+	addq	0(%rcx),%r8
+	movq	%r10,%r14
+	adcq	8(%rcx),%r9
+	adcq	16(%rcx),%r10
+	movq	%r11,%r12
+	adcq	24(%rcx),%r11
+	testq	%r13,%r13
+
+	cmovzq	%rax,%r8
+	cmovzq	%rdx,%r9
+	movq	%r8,0(%rdi)
+	cmovzq	%r14,%r10
+	movq	%r9,8(%rdi)
+	cmovzq	%r12,%r11
+	movq	%r10,16(%rdi)
+	movq	%r11,24(%rdi)
+
+	popq	%r14
+	popq	%r13
+	popq	%r12
+	.byte	0xf3,0xc3
+.size	fp256_sub,.-fp256_sub
+
+
+
+.globl	fp256_sub_word
+.type	fp256_sub_word,@function
+.align	32
+fp256_sub_word:
+	pushq	%r12
+	pushq	%r13
+	pushq	%r14
+
+	movq	0(%rsi),%r8
+	xorq	%r13,%r13
+	movq	8(%rsi),%r9
+	movq	16(%rsi),%r10
+	movq	24(%rsi),%r11
+
+
+	subq	0(%rdx),%r8
+	sbbq	$0,%r9
+	movq	%r8,%rax
+	sbbq	$0,%r10
+	sbbq	$0,%r11
+	movq	%r9,%rdx
+	sbbq	$0,%r13
+
+	addq	0(%rcx),%r8
+	movq	%r10,%r14
+	adcq	8(%rcx),%r9
+	adcq	16(%rcx),%r10
+	movq	%r11,%r12
+	adcq	24(%rcx),%r11
+	testq	%r13,%r13
+
+	cmovzq	%rax,%r8
+	cmovzq	%rdx,%r9
+	movq	%r8,0(%rdi)
+	cmovzq	%r14,%r10
+	movq	%r9,8(%rdi)
+	cmovzq	%r12,%r11
+	movq	%r10,16(%rdi)
+	movq	%r11,24(%rdi)
+
+	popq	%r14
+	popq	%r13
+	popq	%r12
+	.byte	0xf3,0xc3
+.size	fp256_sub_word,.-fp256_sub_word
+
+
+
+.globl	fp256_neg
+.type	fp256_neg,@function
+.align	32
+fp256_neg:
+
+	movq	0(%rdx),%r8
+	movq	8(%rdx),%r9
+	movq	16(%rdx),%r10
+	movq	24(%rdx),%r11
+
+	subq	0(%rsi),%r8
+	sbbq	8(%rsi),%r9
+	sbbq	16(%rsi),%r10
+	sbbq	24(%rsi),%r11
+
+	movq	%r8,0(%rdi)
+	movq	%r9,8(%rdi)
+	movq	%r10,16(%rdi)
+	movq	%r11,24(%rdi)
+
+	.byte	0xf3,0xc3
+.size	fp256_neg,.-fp256_neg
+
+
+
+.globl	fp256_double
+.type	fp256_double,@function
+.align	32
+fp256_double:
+	pushq	%r12
+	pushq	%r13
+	pushq	%r14
+	pushq	%r15
+
+	movq	0(%rsi),%r8
+	xorq	%r13,%r13
+	movq	8(%rsi),%r9
+	addq	%r8,%r8
+	movq	16(%rsi),%r10
+	adcq	%r9,%r9
+	movq	24(%rsi),%r11
+	movq	%r8,%rax
+	adcq	%r10,%r10
+	adcq	%r11,%r11
+	movq	%r9,%r15
+	adcq	$0,%r13
+
+	subq	0(%rdx),%r8
+	movq	%r10,%r14
+	sbbq	8(%rdx),%r9
+	sbbq	16(%rdx),%r10
+	movq	%r11,%r12
+	sbbq	24(%rdx),%r11
+	sbbq	$0,%r13
+
+	cmovcq	%rax,%r8
+	cmovcq	%r15,%r9
+	movq	%r8,0(%rdi)
+	cmovcq	%r14,%r10
+	movq	%r9,8(%rdi)
+	cmovcq	%r12,%r11
+	movq	%r10,16(%rdi)
+	movq	%r11,24(%rdi)
+
+	popq	%r15
+	popq	%r14
+	popq	%r13
+	popq	%r12
+	.byte	0xf3,0xc3
+.size	fp256_double,.-fp256_double
+
+
+
+.globl	fp256_triple
+.type	fp256_triple,@function
+.align	32
+fp256_triple:
+	pushq	%r12
+	pushq	%r13
+	pushq	%r14
+	pushq	%r15
+
+	movq	0(%rsi),%r8
+	xorq	%r13,%r13
+	movq	8(%rsi),%r9
+	addq	%r8,%r8
+	movq	16(%rsi),%r10
+	adcq	%r9,%r9
+	movq	24(%rsi),%r11
+	movq	%r8,%rax
+	adcq	%r10,%r10
+	adcq	%r11,%r11
+	movq	%r9,%r15
+	adcq	$0,%r13
+
+	subq	0(%rdx),%r8
+	movq	%r10,%r14
+	sbbq	8(%rdx),%r9
+	sbbq	16(%rdx),%r10
+	movq	%r11,%r12
+	sbbq	24(%rdx),%r11
+	sbbq	$0,%r13
+
+	cmovcq	%rax,%r8
+	cmovcq	%r15,%r9
+	cmovcq	%r14,%r10
+	cmovcq	%r12,%r11
+
+	xorq	%r13,%r13
+	addq	0(%rsi),%r8
+	adcq	8(%rsi),%r9
+	movq	%r8,%rax
+	adcq	16(%rsi),%r10
+	adcq	24(%rsi),%r11
+	movq	%r9,%r15
+	adcq	$0,%r13
+
+	subq	0(%rdx),%r8
+	movq	%r10,%r14
+	sbbq	8(%rdx),%r9
+	sbbq	16(%rdx),%r10
+	movq	%r11,%r12
+	sbbq	24(%rdx),%r11
+	sbbq	$0,%r13
+
+	cmovcq	%rax,%r8
+	cmovcq	%r15,%r9
+	movq	%r8,0(%rdi)
+	cmovcq	%r14,%r10
+	movq	%r9,8(%rdi)
+	cmovcq	%r12,%r11
+	movq	%r10,16(%rdi)
+	movq	%r11,24(%rdi)
+
+	popq	%r15
+	popq	%r14
+	popq	%r13
+	popq	%r12
+	.byte	0xf3,0xc3
+.size	fp256_triple,.-fp256_triple
+
@@ -0,0 +1,322 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright 2020 Meng-Shan Jiang                                             *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License");            *
+ * you may not use this file except in compliance with the License.           *
+ * You may obtain a copy of the License at                                    *
+ *                                                                            *
+ *    http://www.apache.org/licenses/LICENSE-2.0                              *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ *                                                                            *
+ *****************************************************************************/
+
+#include <string.h>
+#include <secp256k1_x64/crypto.h>
+#include <secp256k1_x64/fp256.h>
+#include <secp256k1_x64/rand.h>
+#include <secp256k1_x64/secp256k1.h>
+#include <secp256k1_x64/schnorrsig.h>
+#include <secp256k1_x64/sha256.h>
+#include "../secp256k1/secp256k1_lcl.h"
+#include "../secp256k1/field_lcl.h"
+
+#define TAG_AUX         "BIP0340/aux"
+#define TAG_NONCE       "BIP0340/nonce"
+#define TAG_CHALLENGE   "BIP0340/challenge"
+
+/* 7 in Montgomery domain */
+static const BN_ULONG B_MONT[P256_LIMBS] = {
+#ifndef SECP256K1_PSEUDO_MERSENNE
+    0x0000000700001ab7ULL, 0ULL, 0ULL, 0ULL
+#else
+    7ULL, 0ULL, 0ULL, 0ULL
+#endif
+};
+
+/* affine x, y(not in Montgomery domain) with constant time inversion,
+ * point may depend on secret data.
+ */
+static void point_get_affine_ct(BN_ULONG x[P256_LIMBS], BN_ULONG y[P256_LIMBS], const POINT256 *point)
+{
+    BN_ULONG z_inv2[P256_LIMBS], z_inv3[P256_LIMBS];
+
+    secp256k1_fe_inv(z_inv3, point->Z);
+    secp256k1_fe_sqr(z_inv2, z_inv3);
+    secp256k1_fe_mul(z_inv3, z_inv3, z_inv2);
+    secp256k1_fe_mul(x, point->X, z_inv2);
+    secp256k1_fe_mul(y, point->Y, z_inv3);
+    secp256k1_fe_from_mont(x, x);
+    secp256k1_fe_from_mont(y, y);
+}
+
+/* e = tagged_hash("BIP0340/challenge", r || p || m) mod n */
+static void schnorrsig_challenge(BN_ULONG e[P256_LIMBS], const unsigned char r32[32],
+                                 const unsigned char p32[32], const unsigned char msg32[32])
+{
+    SECP256K1_SHA256_CTX ctx;
+    unsigned char h[SECP256K1_SHA256_DIGEST_LENGTH];
+
+    secp256k1_sha256_init_tagged(&ctx, (const unsigned char*)TAG_CHALLENGE, sizeof(TAG_CHALLENGE) - 1);
+    secp256k1_sha256_update(&ctx, r32, 32);
+    secp256k1_sha256_update(&ctx, p32, 32);
+    secp256k1_sha256_update(&ctx, msg32, 32);
+    secp256k1_sha256_final(h, &ctx);
+
+    fp256_set_bytes(e, h, 32);
+    secp256k1_scalar_reduce(e, e);
+}
+
+int secp256k1_xonly_pubkey_create(unsigned char pubkey32[32], const unsigned char seckey[32])
+{
+    BN_ULONG n[P256_LIMBS], d[P256_LIMBS];
+    BN_ULONG x[P256_LIMBS], y[P256_LIMBS];
+    POINT256 P;
+
+    if (pubkey32 == NULL || seckey == NULL)
+        return CRYPTO_ERR;
+
+    secp256k1_get_order(n);
+    fp256_set_bytes(d, (unsigned char *)seckey, 32);
+    if (fp256_is_zero(d) || fp256_cmp(d, n) >= 0)
+        return CRYPTO_ERR;
+
+    secp256k1_scalar_mul_gen(&P, d);
+    point_get_affine_ct(x, y, &P);
+    fp256_get_bytes(pubkey32, x);
+
+    memset(d, 0, sizeof(d));
+    return CRYPTO_OK;
+}
+
+int secp256k1_xonly_pubkey_parse(POINT256 *pubkey, const unsigned char pubkey32[32])
+{
+    BN_ULONG p[P256_LIMBS], x[P256_LIMBS], y[P256_LIMBS], c[P256_LIMBS];
+
+    if (pubkey == NULL || pubkey32 == NULL)
+        return CRYPTO_ERR;
+
+    secp256k1_get_p(p);
+    fp256_set_bytes(x, (unsigned char *)pubkey32, 32);
+    if (fp256_cmp(x, p) >= 0)
+        return CRYPTO_ERR;
+
+    /* y = sqrt(x^3 + 7), even */
+    secp256k1_fe_to_mont(c, x);
+    secp256k1_fe_sqr(y, c);
+    secp256k1_fe_mul(y, y, c);
+    secp256k1_add(c, y, B_MONT);
+    if (secp256k1_mod_sqrt(y, c) != CRYPTO_OK)
+        return CRYPTO_ERR;
+
+    secp256k1_fe_from_mont(y, y);
+    if (y[0] & 1)
+        secp256k1_neg(y, y);
+
+    return secp256k1_point_set_affine(pubkey, x, y);
+}
+
+int secp256k1_schnorrsig_sign(unsigned char sig[64],
+                              const unsigned char msg32[32],
+                              const unsigned char seckey[32],
+                              const unsigned char aux_rand32[32])
+{
+    int i, ret = CRYPTO_ERR;
+    BN_ULONG n[P256_LIMBS];
+    BN_ULONG d[P256_LIMBS], k[P256_LIMBS], e[P256_LIMBS];
+    BN_ULONG x[P256_LIMBS], y[P256_LIMBS];
+    unsigned char t[32], px[32], rx[32], h[SECP256K1_SHA256_DIGEST_LENGTH];
+    SECP256K1_SHA256_CTX ctx;
+    POINT256 P;
+
+    if (sig == NULL || msg32 == NULL || seckey == NULL)
+        return CRYPTO_ERR;
+
+    secp256k1_get_order(n);
+    fp256_set_bytes(d, (unsigned char *)seckey, 32);
+    if (fp256_is_zero(d) || fp256_cmp(d, n) >= 0)
+        goto end;
+
+    /* P = d*G, d = n - d if y(P) is odd */
+    secp256k1_scalar_mul_gen(&P, d);
+    point_get_affine_ct(x, y, &P);
+    fp256_get_bytes(px, x);
+    if (y[0] & 1)
+        secp256k1_scalar_neg(d, d);
+
+    /* t = bytes(d) xor tagged_hash("BIP0340/aux", a) */
+    memset(h, 0, sizeof(h));
+    if (aux_rand32 != NULL)
+        memcpy(h, aux_rand32, 32);
+    secp256k1_sha256_tagged(h, (const unsigned char*)TAG_AUX, sizeof(TAG_AUX) - 1, h, 32);
+    fp256_get_bytes(t, d);
+    for (i = 0; i < 32; i++)
+        t[i] ^= h[i];
+
+    /* k = tagged_hash("BIP0340/nonce", t || bytes(P) || m) mod n */
+    secp256k1_sha256_init_tagged(&ctx, (const unsigned char*)TAG_NONCE, sizeof(TAG_NONCE) - 1);
+    secp256k1_sha256_update(&ctx, t, 32);
+    secp256k1_sha256_update(&ctx, px, 32);
+    secp256k1_sha256_update(&ctx, msg32, 32);
+    secp256k1_sha256_final(h, &ctx);
+    fp256_set_bytes(k, h, 32);
+    secp256k1_scalar_reduce(k, k);
+    if (fp256_is_zero(k))
+        goto end;
+
+    /* R = k*G, k = n - k if y(R) is odd */
+    secp256k1_scalar_mul_gen(&P, k);
+    point_get_affine_ct(x, y, &P);
+    fp256_get_bytes(rx, x);
+    if (y[0] & 1)
+        secp256k1_scalar_neg(k, k);
+
+    /* s = k + e*d mod n */
+    schnorrsig_challenge(e, rx, px, msg32);
+    secp256k1_scalar_to_mont(e, e);
+    secp256k1_scalar_mul_mont(e, e, d);
+    secp256k1_scalar_add(k, k, e);
+
+    memcpy(sig, rx, 32);
+    fp256_get_bytes(sig + 32, k);
+    ret = CRYPTO_OK;
+
+end:
+    memset(d, 0, sizeof(d));
+    memset(k, 0, sizeof(k));
+    memset(e, 0, sizeof(e));
+    memset(t, 0, sizeof(t));
+    memset(h, 0, sizeof(h));
+    return ret;
+}
+
+int secp256k1_schnorrsig_verify(const unsigned char sig[64],
+                                const unsigned char msg32[32],
+                                const unsigned char pubkey32[32])
+{
+    BN_ULONG p[P256_LIMBS], n[P256_LIMBS];
+    BN_ULONG r[P256_LIMBS], s[P256_LIMBS], e[P256_LIMBS];
+    BN_ULONG z[P256_LIMBS], t[P256_LIMBS];
+    POINT256 P, R;
+
+    if (sig == NULL || msg32 == NULL || pubkey32 == NULL)
+        return CRYPTO_ERR;
+
+    if (secp256k1_xonly_pubkey_parse(&P, pubkey32) != CRYPTO_OK)
+        return CRYPTO_ERR;
+
+    /* r < p, s < n */
+    secp256k1_get_p(p);
+    secp256k1_get_order(n);
+    fp256_set_bytes(r, (unsigned char *)sig, 32);
+    fp256_set_bytes(s, (unsigned char *)sig + 32, 32);
+    if (fp256_cmp(r, p) >= 0 || fp256_cmp(s, n) >= 0)
+        return CRYPTO_ERR;
+
+    /* R = s*G - e*P */
+    schnorrsig_challenge(e, sig, pubkey32, msg32);
+    secp256k1_scalar_neg(e, e);
+    secp256k1_scalar_mul_double_var(&R, s, e, &P);
+    if (secp256k1_point_is_at_infinity(&R))
+        return CRYPTO_ERR;
+
+    /* x(R) = r, checked as r*Z^2 == X, no inversion for a wrong x */
+    secp256k1_fe_sqr(z, R.Z);
+    secp256k1_fe_to_mont(t, r);
+    secp256k1_fe_mul(t, t, z);
+    if (fp256_cmp(t, R.X) != 0)
+        return CRYPTO_ERR;
+
+    /* y(R) even needs the affine y, Y/Z^3 with Z^3 = Z^2*Z inverted */
+    secp256k1_fe_mul(z, z, R.Z);
+    secp256k1_mod_inverse_var(t, z);
+    secp256k1_fe_mul(t, t, R.Y);
+    secp256k1_fe_from_mont(t, t);
+    if (t[0] & 1)
+        return CRYPTO_ERR;
+
+    return CRYPTO_OK;
+}
+
+/* sum(a_i*s_i)*G - sum(a_i*R_i) - sum(a_i*e_i*P_i) = 0, a_0 = 1 and a_i
+ * 128-bit random. R_i and P_i are negated instead of their scalars so the
+ * a_i stay short, everything goes through one multi-scalar multiplication.
+ */
+int secp256k1_schnorrsig_verify_batch(const unsigned char (*sig)[64],
+                                      const unsigned char (*msg32)[32],
+                                      const unsigned char (*pubkey32)[32],
+                                      size_t n)
+{
+    int ret = CRYPTO_ERR;
+    size_t i;
+    BN_ULONG order[P256_LIMBS];
+    BN_ULONG s[P256_LIMBS], e[P256_LIMBS], a[P256_LIMBS], g[P256_LIMBS];
+    BN_ULONG (*scalars)[P256_LIMBS] = NULL;
+    POINT256 *points = NULL;
+    void *scratch = NULL;
+    POINT256 R;
+
+    if (sig == NULL || msg32 == NULL || pubkey32 == NULL)
+        return CRYPTO_ERR;
+
+    if (n == 0)
+        return CRYPTO_OK;
+
+    if (n == 1)
+        return secp256k1_schnorrsig_verify(sig[0], msg32[0], pubkey32[0]);
+
+    points = (POINT256*)CRYPTO_malloc(2 * n * sizeof(POINT256));
+    scalars = (BN_ULONG (*)[P256_LIMBS])CRYPTO_malloc(2 * n * P256_LIMBS * sizeof(BN_ULONG));
+    scratch = CRYPTO_malloc(secp256k1_multi_scalar_mul_scratch_size(2 * n));
+    if (points == NULL || scalars == NULL || scratch == NULL)
+        goto end;
+
+    secp256k1_get_order(order);
+    fp256_set_word(g, 0);
+
+    for (i = 0; i < n; i++) {
+        /* -R_i = -lift_x(r_i), -P_i = -lift_x(p_i) */
+        if (secp256k1_xonly_pubkey_parse(&points[2 * i], sig[i]) != CRYPTO_OK ||
+            secp256k1_xonly_pubkey_parse(&points[2 * i + 1], pubkey32[i]) != CRYPTO_OK)
+            goto end;
+        secp256k1_neg(points[2 * i].Y, points[2 * i].Y);
+        secp256k1_neg(points[2 * i + 1].Y, points[2 * i + 1].Y);
+
+        fp256_set_bytes(s, (unsigned char *)sig[i] + 32, 32);
+        if (fp256_cmp(s, order) >= 0)
+            goto end;
+
+        if (i == 0)
+            fp256_set_word(a, 1);
+        else {
+            fp256_set_word(a, 0);
+            if (RAND_buf((unsigned char*)a, 16) != CRYPTO_OK)
+                goto end;
+        }
+
+        /* scalars are a_i and a_i*e_i, g += a_i*s_i */
+        schnorrsig_challenge(e, sig[i], pubkey32[i], msg32[i]);
+        fp256_copy(scalars[2 * i], a);
+        secp256k1_scalar_to_mont(a, a);
+        secp256k1_scalar_mul_mont(scalars[2 * i + 1], a, e);
+        secp256k1_scalar_mul_mont(s, a, s);
+        secp256k1_scalar_add(g, g, s);
+    }
+
+    if (secp256k1_ecmult_multi_var(&R, g, (const BN_ULONG (*)[P256_LIMBS])scalars, points, 2 * n, scratch) != CRYPTO_OK)
+        goto end;
+
+    if (secp256k1_point_is_at_infinity(&R))
+        ret = CRYPTO_OK;
+
+end:
+    CRYPTO_free(points);
+    CRYPTO_free(scalars);
+    CRYPTO_free(scratch);
+    return ret;
+}
@@ -64,6 +64,13 @@
 #                                                                            #
 ##############################################################################
 
+# "pm" : field elements in plain form, reduced by folding with 2^256 mod P
+# (pseudo-Mersenne) instead of montgomery reduction
+$pm=0; @ARGV = grep { $_ eq "pm" ? !($pm=1) : 1 } @ARGV;
+# "prefetch=N" : secp256k1_ecmult_gen_w7 prefetches the table entries of
+# the next N windows, 0 turns prefetching off
+$pf=2; @ARGV = grep { /^prefetch=(\d+)$/ ? !($pf=$1, 1) : 1 } @ARGV;
+
 $flavour = shift;
 $output  = shift;
 
@@ -82,6 +89,10 @@ open OUT,"| \"$^X\" \"$xlate\" $flavour \"$output\"";
 $avx = 2;
 $addx = 1;
 
+# reduction of the field elements used by the exported field and point functions
+$fe = $pm ? "pm" : "mont";
+$one = $pm ? "0x0000000000000001" : "0x00000001000003d1";
+
 $code.=<<___;
 .text
 .hidden	cpu_info
@@ -103,10 +114,26 @@ $code.=<<___;
 .long 2,2,2,2,2,2,2,2
 .LThree:
 .long 3,3,3,3,3,3,3,3
+# one in the representation of field elements
 .LONE_mont:
-.quad 0x00000001000003d1, 0x0000000000000000, 0x0000000000000000, 0x0000000000000000
+.quad $one, 0x0000000000000000, 0x0000000000000000, 0x0000000000000000
+# 2^256 mod P
+.Lpoly_c:
+.quad 0x00000001000003d1
 .LK:
 .quad 0xd838091dd2253531
+
+# The group order
+.Lord:
+.quad 0xbfd25e8cd0364141, 0xbaaedce6af48a03b, 0xfffffffffffffffe, 0xffffffffffffffff
+# -1/N mod 2^64
+.LordK:
+.quad 0x4b0dff665588b13f
+# 2^512 mod N
+.LRR_ord:
+.quad 0x896cf21467d7d140, 0x741496c20e7cf878, 0xe697f5e45bcd07c6, 0x9d671cd581c69bc5
+.Lord_one:
+.quad 1, 0, 0, 0
 ___
 
 {
@@ -432,6 +459,7 @@ secp256k1_neg:
 .type	secp256k1_reduce,\@function,2
 .align	32
 secp256k1_reduce:
+.Lreduce:
     push	%r12
     push	%r13
 
@@ -440,7 +468,7 @@ secp256k1_reduce:
     mov 8*2($a_ptr), $a2
     mov $a0, $t0
     mov 8*3($a_ptr), $a3
-    mov	.LONE_mont+8*0(%rip), $t3
+    mov	.Lpoly_c+8*0(%rip), $t3
     mov $a1, $t1
     xor	$t4, $t4
 
@@ -473,6 +501,140 @@ my ($acc0,$acc1,$acc2,$acc3,$acc4,$acc5,$acc6,$acc7)=map("%r$_",(8..15));
 my ($t0,$t1,$t2,$t3,$t4)=("%rcx","%rbp","%rbx","%rdx","%rax");
 my ($poly1,$poly3)=($acc6,$acc7);
 
+# 512-bit square of a, (acc7..acc0), shared by the montgomery and the
+# pseudo-Mersenne kernels
+my $sqr_bodyq=<<___;
+    mov	%rax, $acc5
+    mulq	$acc6			# a[1]*a[0]
+    mov	%rax, $acc1
+    mov	$acc7, %rax
+    mov	%rdx, $acc2
+
+    mulq	$acc5			# a[0]*a[2]
+    add	%rax, $acc2
+    mov	$acc0, %rax
+    adc	\$0, %rdx
+    mov	%rdx, $acc3
+
+    mulq	$acc5			# a[0]*a[3]
+    add	%rax, $acc3
+     mov	$acc7, %rax
+    adc	\$0, %rdx
+    mov	%rdx, $acc4
+
+    #################################
+    mulq	$acc6			# a[1]*a[2]
+    add	%rax, $acc3
+    mov	$acc0, %rax
+    adc	\$0, %rdx
+    mov	%rdx, $t1
+
+    mulq	$acc6			# a[1]*a[3]
+    add	%rax, $acc4
+     mov	$acc0, %rax
+    adc	\$0, %rdx
+    add	$t1, $acc4
+    mov	%rdx, $acc5
+    adc	\$0, $acc5
+
+    #################################
+    mulq	$acc7			# a[2]*a[3]
+    xor	$acc7, $acc7
+    add	%rax, $acc5
+     mov	8*0($a_ptr), %rax
+    mov	%rdx, $acc6
+    adc	\$0, $acc6
+
+    add	$acc1, $acc1		# acc1:6<<1
+    adc	$acc2, $acc2
+    adc	$acc3, $acc3
+    adc	$acc4, $acc4
+    adc	$acc5, $acc5
+    adc	$acc6, $acc6
+    adc	\$0, $acc7
+
+    mulq	%rax
+    mov	%rax, $acc0
+    mov	8*1($a_ptr), %rax
+    mov	%rdx, $t0
+
+    mulq	%rax
+    add	$t0, $acc1
+    adc	%rax, $acc2
+    mov	8*2($a_ptr), %rax
+    adc	\$0, %rdx
+    mov	%rdx, $t0
+
+    mulq	%rax
+    add	$t0, $acc3
+    adc	%rax, $acc4
+    mov	8*3($a_ptr), %rax
+    adc	\$0, %rdx
+    mov	%rdx, $t0
+
+    mulq	%rax
+    add	$t0, $acc5
+    adc	%rax, $acc6
+     mov	$acc0, %rax
+    adc	%rdx, $acc7
+
+___
+my $sqr_bodyx=<<___;
+    mulx	$acc6, $acc1, $acc2
+    mulx	$acc7, $t0, $acc3
+    xor	%eax, %eax
+    adc	$t0, $acc2
+    mulx	$acc0, $t1, $acc4
+     mov	$acc6, %rdx
+    adc	$t1, $acc3
+    adc	\$0, $acc4
+    xor	$acc5, $acc5		# $acc5=0,cf=0,of=0
+
+    #################################
+    mulx	$acc7, $t0, $t1
+    adcx	$t0, $acc3
+    adox	$t1, $acc4
+
+    mulx	$acc0, $t0, $t1
+     mov	$acc7, %rdx
+    adcx	$t0, $acc4
+    adox	$t1, $acc5
+    adc	\$0, $acc5
+
+    #################################
+    mulx	$acc0, $t0, $acc6
+     mov	8*0+128($a_ptr), %rdx
+    xor	$acc7, $acc7		# $acc7=0,cf=0,of=0
+     adcx	$acc1, $acc1		# acc1:6<<1
+    adox	$t0, $acc5
+     adcx	$acc2, $acc2
+    adox	$acc7, $acc6		# of=0
+
+    mulx	%rdx, $acc0, $t1
+    mov	8*1+128($a_ptr), %rdx
+     adcx	$acc3, $acc3
+    adox	$t1, $acc1
+     adcx	$acc4, $acc4
+    mulx	%rdx, $t0, $t4
+    mov	8*2+128($a_ptr), %rdx
+     adcx	$acc5, $acc5
+    adox	$t0, $acc2
+     adcx	$acc6, $acc6
+    .byte	0x67
+    mulx	%rdx, $t0, $t1
+    mov	8*3+128($a_ptr), %rdx
+    adox	$t4, $acc3
+     adcx	$acc7, $acc7
+    adox	$t0, $acc4
+    #  mov	\$32, $a_ptr
+    adox	$t1, $acc5
+    .byte	0x67,0x67
+    mulx	%rdx, $t0, $t4
+    adox	$t0, $acc6
+    adox	$t4, $acc7
+
+___
+
 $code.=<<___;
 
 ################################################################################
@@ -516,7 +678,7 @@ secp256k1_mul_word:
     mulq	$acc4
     add	%rax, $acc3
     adc	\$0, %rdx
-     mov	.LONE_mont+8*0(%rip), %rax 
+     mov	.Lpoly_c+8*0(%rip), %rax 
     xor	$acc5, $acc5
     mov	%rdx, $acc4
 
@@ -575,13 +737,19 @@ $code.=<<___;
 .align	32
 secp256k1_to_mont:
 ___
-$code.=<<___	if ($addx);
+# plain field elements only need to be reduced
+$code.=<<___	if ($pm);
+    jmp	.Lreduce
+___
+$code.=<<___	if ($addx && !$pm);
     mov	\$0x80100, %ecx  # 0x80000 : BMI2 SUPPORT, 0x100 : ADX SUPPORT
     and	cpu_info+8(%rip), %ecx
 ___
-$code.=<<___;
+$code.=<<___	if (!$pm);
     lea	.LRR(%rip), $b_org
     jmp	.Lmul_mont
+___
+$code.=<<___;
 .size	secp256k1_to_mont,.-secp256k1_to_mont
 
 ################################################################################
@@ -620,7 +788,7 @@ $code.=<<___;
     mov	8*2($a_ptr), $acc3
     mov	8*3($a_ptr), $acc4
 
-    call	__secp256k1_mul_montq
+    call	__secp256k1_mul_${fe}q
 ___
 $code.=<<___	if ($addx);
     jmp	.Lmul_mont_done
@@ -635,7 +803,7 @@ $code.=<<___	if ($addx);
     mov	8*3($a_ptr), $acc4
     lea	-128($a_ptr), $a_ptr	# control u-op density
 
-    call	__secp256k1_mul_montx
+    call	__secp256k1_mul_${fe}x
 ___
 $code.=<<___;
 .Lmul_mont_done:
@@ -688,7 +856,7 @@ __secp256k1_mul_montq:
     mov $acc0, $t1
     mulq $poly3       # rax = poly3 * rax mod 2^64
     add %rax, $acc4
-    mov	.LONE_mont+8*0(%rip),$poly1
+    mov	.Lpoly_c+8*0(%rip),$poly1
     adc \$0, $acc5
     mulq $poly1
     sub	%rax, $acc0
@@ -740,7 +908,7 @@ __secp256k1_mul_montq:
     mov $acc1, $t1
     mulq $poly3       # rax = poly3 * rax mod 2^64
     add %rax, $acc5
-    # mov	.LONE_mont+8*0(%rip),$poly1
+    # mov	.Lpoly_c+8*0(%rip),$poly1
     adc \$0, $acc0
     mulq $poly1
     sub	%rax, $acc1
@@ -792,7 +960,7 @@ __secp256k1_mul_montq:
     mov $acc2, $t1
     mulq $poly3       # rax = poly3 * rax mod 2^64
     add %rax, $acc0
-    # mov	.LONE_mont+8*0(%rip),$poly1
+    # mov	.Lpoly_c+8*0(%rip),$poly1
     adc \$0, $acc1
     mulq $poly1
     sub	%rax, $acc2
@@ -914,7 +1082,7 @@ $code.=<<___;
     mov	8*2($a_ptr), $acc7
     mov	8*3($a_ptr), $acc0
 
-    call	__secp256k1_sqr_montq
+    call	__secp256k1_sqr_${fe}q
 ___
 $code.=<<___	if ($addx);
     jmp	.Lsqr_mont_done
@@ -927,7 +1095,7 @@ $code.=<<___	if ($addx);
     mov	8*3($a_ptr), $acc0
     lea	-128($a_ptr), $a_ptr	# control u-op density
 
-    call	__secp256k1_sqr_montx
+    call	__secp256k1_sqr_${fe}x
 ___
 $code.=<<___;
 .Lsqr_mont_done:
@@ -940,85 +1108,103 @@ $code.=<<___;
     ret
 .size	secp256k1_sqr_mont,.-secp256k1_sqr_mont
 
-.type	__secp256k1_sqr_montq,\@abi-omnipotent
-.align	32
-__secp256k1_sqr_montq:
-    mov	%rax, $acc5
-    mulq	$acc6			# a[1]*a[0]
-    mov	%rax, $acc1
-    mov	$acc7, %rax
-    mov	%rdx, $acc2
-
-    mulq	$acc5			# a[0]*a[2]
-    add	%rax, $acc2
-    mov	$acc0, %rax
-    adc	\$0, %rdx
-    mov	%rdx, $acc3
-
-    mulq	$acc5			# a[0]*a[3]
-    add	%rax, $acc3
-     mov	$acc7, %rax
-    adc	\$0, %rdx
-    mov	%rdx, $acc4
-
-    #################################
-    mulq	$acc6			# a[1]*a[2]
-    add	%rax, $acc3
-    mov	$acc0, %rax
-    adc	\$0, %rdx
-    mov	%rdx, $t1
-
-    mulq	$acc6			# a[1]*a[3]
-    add	%rax, $acc4
-     mov	$acc0, %rax
-    adc	\$0, %rdx
-    add	$t1, $acc4
-    mov	%rdx, $acc5
-    adc	\$0, $acc5
-
-    #################################
-    mulq	$acc7			# a[2]*a[3]
-    xor	$acc7, $acc7
-    add	%rax, $acc5
-     mov	8*0($a_ptr), %rax
-    mov	%rdx, $acc6
-    adc	\$0, $acc6
-
-    add	$acc1, $acc1		# acc1:6<<1
-    adc	$acc2, $acc2
-    adc	$acc3, $acc3
-    adc	$acc4, $acc4
-    adc	$acc5, $acc5
-    adc	$acc6, $acc6
-    adc	\$0, $acc7
-
-    mulq	%rax
-    mov	%rax, $acc0
-    mov	8*1($a_ptr), %rax
-    mov	%rdx, $t0
+################################################################################
+# void secp256k1_sqr_mont_n(
+#   uint64_t res[4],
+#   uint64_t a[4],
+#   int n);
+# res = a^(2^n), a stays in registers from one squaring to the next
 
-    mulq	%rax
-    add	$t0, $acc1
-    adc	%rax, $acc2
-    mov	8*2($a_ptr), %rax
-    adc	\$0, %rdx
-    mov	%rdx, $t0
+.globl	secp256k1_sqr_mont_n
+.type	secp256k1_sqr_mont_n,\@function,3
+.align	32
+secp256k1_sqr_mont_n:
+___
+$code.=<<___	if ($addx);
+    mov	\$0x80100, %ecx
+    and	cpu_info+8(%rip), %ecx
+___
+$code.=<<___;
+    push	%rbp
+    push	%rbx
+    push	%r12
+    push	%r13
+    push	%r14
+    push	%r15
+    movslq	%edx, %rbx
+___
+$code.=<<___	if ($addx);
+    cmp	\$0x80100, %ecx
+    je	.Lsqr_mont_nx
+___
+$code.=<<___;
+    mov	8*0($a_ptr), %rax
+    mov	8*1($a_ptr), $acc6
+    mov	8*2($a_ptr), $acc7
+    mov	8*3($a_ptr), $acc0
+    test	%rbx, %rbx
+    jle	.Lsqr_mont_n_copy
+
+.Lsqr_mont_n_loopq:
+    call	__secp256k1_sqr_${fe}q
+    mov	$r_ptr, $a_ptr
+    mov	$acc7, $acc0
+    mov	$acc6, $acc7
+    mov	$acc5, $acc6
+    mov	$acc4, %rax
+    dec	%rbx
+    jnz	.Lsqr_mont_n_loopq
+    jmp	.Lsqr_mont_n_done
+___
+$code.=<<___	if ($addx);
 
-    mulq	%rax
-    add	$t0, $acc3
-    adc	%rax, $acc4
-    mov	8*3($a_ptr), %rax
-    adc	\$0, %rdx
-    mov	%rdx, $t0
+.align	32
+.Lsqr_mont_nx:
+    mov	8*0($a_ptr), %rdx
+    mov	8*1($a_ptr), $acc6
+    mov	8*2($a_ptr), $acc7
+    mov	8*3($a_ptr), $acc0
+    lea	-128($a_ptr), $a_ptr	# control u-op density
+    test	%rbx, %rbx
+    jle	.Lsqr_mont_n_copyx
+
+.Lsqr_mont_n_loopx:
+    call	__secp256k1_sqr_${fe}x
+    lea	-128($r_ptr), $a_ptr
+    mov	$acc7, $acc0
+    mov	$acc6, $acc7
+    mov	$acc5, $acc6
+    mov	$acc4, %rdx
+    dec	%rbx
+    jnz	.Lsqr_mont_n_loopx
+    jmp	.Lsqr_mont_n_done
+
+.Lsqr_mont_n_copyx:
+    mov	%rdx, %rax
+___
+$code.=<<___;
+.Lsqr_mont_n_copy:			# n <= 0, res = a
+    mov	%rax, 8*0($r_ptr)
+    mov	$acc6, 8*1($r_ptr)
+    mov	$acc7, 8*2($r_ptr)
+    mov	$acc0, 8*3($r_ptr)
 
-    mulq	%rax
-    add	$t0, $acc5
-    adc	%rax, $acc6
-     mov	$acc0, %rax
-    adc	%rdx, $acc7
+.Lsqr_mont_n_done:
+    pop	%r15
+    pop	%r14
+    pop	%r13
+    pop	%r12
+    pop	%rbx
+    pop	%rbp
+    ret
+.size	secp256k1_sqr_mont_n,.-secp256k1_sqr_mont_n
 
+.type	__secp256k1_sqr_montq,\@abi-omnipotent
+.align	32
+__secp256k1_sqr_montq:
+$sqr_bodyq
     mov	.LK+8*0(%rip), $a_ptr
-    mov	.LONE_mont+8*0(%rip), $t1
+    mov	.Lpoly_c+8*0(%rip), $t1
 
     ##########################################
     # Now the reduction
@@ -1046,7 +1232,7 @@ __secp256k1_sqr_montq:
     sbb %rdx, $acc2
     sbb \$0, $acc3
     mov $t0, $acc1
-    sbb \$0, $acc2
+    sbb \$0, $acc0
     sbb \$0, $acc1
 
     ##########################################
@@ -1060,7 +1246,7 @@ __secp256k1_sqr_montq:
     sbb %rdx, $acc3
     sbb \$0, $acc0
     mov $t0, $acc2
-    sbb \$0, $acc3
+    sbb \$0, $acc1
     sbb \$0, $acc2
 
     ###########################################
@@ -1074,7 +1260,7 @@ __secp256k1_sqr_montq:
     sbb %rdx, $acc0
     sbb \$0, $acc1
     mov $t0, $acc3
-    sbb \$0, $acc0
+    sbb \$0, $acc2
     sbb \$0, $acc3
 
     mov	$acc3, %rdx
@@ -1127,7 +1313,7 @@ __secp256k1_mul_montx:
     mulx	$acc3, $t1, $acc3
     adc	$t0, $acc1
     mulx	$acc4, $t0, $acc4
-     mov	.LONE_mont+8*0(%rip), $poly1
+     mov	.Lpoly_c+8*0(%rip), $poly1
     adc	$t1, $acc2
      mov     $t4, %rdx
     adc	$t0, $acc3
@@ -1306,59 +1492,7 @@ __secp256k1_mul_montx:
 .type	__secp256k1_sqr_montx,\@abi-omnipotent
 .align	32
 __secp256k1_sqr_montx:
-    mulx	$acc6, $acc1, $acc2
-    mulx	$acc7, $t0, $acc3
-    xor	%eax, %eax
-    adc	$t0, $acc2
-    mulx	$acc0, $t1, $acc4
-     mov	$acc6, %rdx
-    adc	$t1, $acc3
-    adc	\$0, $acc4
-    xor	$acc5, $acc5		# $acc5=0,cf=0,of=0
-
-    #################################
-    mulx	$acc7, $t0, $t1
-    adcx	$t0, $acc3
-    adox	$t1, $acc4
-
-    mulx	$acc0, $t0, $t1
-     mov	$acc7, %rdx
-    adcx	$t0, $acc4
-    adox	$t1, $acc5
-    adc	\$0, $acc5
-
-    #################################
-    mulx	$acc0, $t0, $acc6
-     mov	8*0+128($a_ptr), %rdx
-    xor	$acc7, $acc7		# $acc7=0,cf=0,of=0
-     adcx	$acc1, $acc1		# acc1:6<<1
-    adox	$t0, $acc5
-     adcx	$acc2, $acc2
-    adox	$acc7, $acc6		# of=0
-
-    mulx	%rdx, $acc0, $t1
-    mov	8*1+128($a_ptr), %rdx
-     adcx	$acc3, $acc3
-    adox	$t1, $acc1
-     adcx	$acc4, $acc4
-    mulx	%rdx, $t0, $t4
-    mov	8*2+128($a_ptr), %rdx
-     adcx	$acc5, $acc5
-    adox	$t0, $acc2
-     adcx	$acc6, $acc6
-    .byte	0x67
-    mulx	%rdx, $t0, $t1
-    mov	8*3+128($a_ptr), %rdx
-    adox	$t4, $acc3
-     adcx	$acc7, $acc7
-    adox	$t0, $acc4
-    #  mov	\$32, $a_ptr
-    adox	$t1, $acc5
-    .byte	0x67,0x67
-    mulx	%rdx, $t0, $t4
-    adox	$t0, $acc6
-    adox	$t4, $acc7
-
+$sqr_bodyx
     # reduction step 1
     mov     \$0xd838091dd2253531, %rdx
     mulx    $acc0, $acc0, $t1
@@ -1440,176 +1574,982 @@ __secp256k1_sqr_montx:
 .size	__secp256k1_sqr_montx,.-__secp256k1_sqr_montx
 ___
 }
-}
-{
-my ($r_ptr,$in_ptr)=("%rdi","%rsi");
-my ($acc0,$acc1,$acc2,$acc3)=map("%r$_",(8..11));
-my ($t0,$t1,$t2)=("%rcx","%r12","%r13");
 
-$code.=<<___;
 ################################################################################
-# void secp256k1_from_mont(
-#   uint64_t res[4],
-#   uint64_t in[4]);
-# This one performs Montgomery multiplication by 1, so we only need the reduction
-
-.globl	secp256k1_from_mont
-.type	secp256k1_from_mont,\@function,2
-.align	32
-secp256k1_from_mont:
-    push	%r12
-    push	%r13
+# Pseudo-Mersenne reduction: P = 2^256 - c, c = 0x1000003d1, so the high half
+# of a product folds into the low half as hi*c. Two folds leave a 257-bit
+# value, a final wrap and conditional subtraction reduce it below P.
+# The kernels keep the calling convention of the montgomery ones, the point
+# functions can use either.
+
+# (acc3, acc2, acc1, acc0) + cf*2^256 -> res, in (acc4, acc5, acc6, acc7)
+sub pm_final () {
+my $c = shift;
+
+"	sbb	%rax, %rax
+    and	$c, %rax
+    add	%rax, $acc0
+    adc	\$0, $acc1
+    adc	\$0, $acc2
+    adc	\$0, $acc3
 
-    mov	8*0($in_ptr), $acc0
-    mov	8*1($in_ptr), $acc1
-    mov	8*2($in_ptr), $acc2
-    mov	8*3($in_ptr), $acc3
+    ########################################################################
+    # Branch-less conditional subtraction of P, adding c carries iff >= P
 
-    mov	.LK+8*0(%rip), $t2
-    mov	.LONE_mont+8*0(%rip), $t1
-    #########################################
-    # First iteration
+    mov	$acc0, $acc4
+    mov	$acc1, $acc5
+    mov	$acc2, $acc6
+    mov	$acc3, $acc7
+    add	$c, $acc4
+    adc	\$0, $acc5
+    adc	\$0, $acc6
+    adc	\$0, $acc7
 
-    mov $acc0, %rax
-    mulq $t2
-    mov %rax, $t0
-    mulq $t1
-    sub %rax, $acc0
-    sbb %rdx, $acc1
-    sbb \$0, $acc2
-    mov $t0, $acc0
-    sbb \$0, $acc3
-    sbb \$0, $acc0
+    cmovnc	$acc0, $acc4
+    cmovnc	$acc1, $acc5
+    mov	$acc4, 8*0($r_ptr)
+    cmovnc	$acc2, $acc6
+    mov	$acc5, 8*1($r_ptr)
+    cmovnc	$acc3, $acc7
+    mov	$acc6, 8*2($r_ptr)
+    mov	$acc7, 8*3($r_ptr)"
+}
 
-    ##########################################
-    # Second iteration
+# fold (acc7, acc6, acc5, acc4) into (acc3, acc2, acc1, acc0), mulq
+sub pm_reduceq () {
+"	mov	\$0x1000003d1, $t1
+    mov	$acc4, %rax
+    mulq	$t1
+    add	%rax, $acc0
+    mov	$acc5, %rax
+    adc	\$0, %rdx
+    mov	%rdx, $t0
 
-    mov $acc1, %rax
-    mulq $t2
-    mov %rax, $t0
-    mulq $t1
-    sub %rax, $acc1
-    sbb %rdx, $acc2
-    sbb \$0, $acc3
-    mov $t0, $acc1
-    sbb \$0, $acc2
-    sbb \$0, $acc1
+    mulq	$t1
+    add	$t0, $acc1
+    adc	\$0, %rdx
+    add	%rax, $acc1
+    mov	$acc6, %rax
+    adc	\$0, %rdx
+    mov	%rdx, $t0
 
-    ##########################################
-    # Third iteration
+    mulq	$t1
+    add	$t0, $acc2
+    adc	\$0, %rdx
+    add	%rax, $acc2
+    mov	$acc7, %rax
+    adc	\$0, %rdx
+    mov	%rdx, $t0
 
-    mov $acc2, %rax
-    mulq $t2
-    mov %rax, $t0
-    mulq $t1
-    sub %rax, $acc2
-    sbb %rdx, $acc3
-    sbb \$0, $acc0
-    mov $t0, $acc2
-    sbb \$0, $acc3
-    sbb \$0, $acc2
+    mulq	$t1
+    add	$t0, $acc3
+    adc	\$0, %rdx
+    add	%rax, $acc3
+    adc	\$0, %rdx
 
-    ###########################################
-    # Last iteration
+    ########################################################################
+    # Second fold, the carry word is at most 34 bits
 
-    mov $acc3, %rax
-    mulq $t2
-    mov %rax, $t0
-    mulq $t1
-    sub %rax, $acc3
-    sbb %rdx, $acc0
-    sbb \$0, $acc1
-    mov $t0, $acc3
-    sbb \$0, $acc0
-    sbb \$0, $acc3
-    # now we have (acc3, acc2, acc1, acc0)
+    mov	%rdx, %rax
+    mulq	$t1
+    add	%rax, $acc0
+    adc	%rdx, $acc1
+    adc	\$0, $acc2
+    adc	\$0, $acc3
+" . &pm_final($t1)
+}
 
-    ###########################################
-    # Branch-less conditional subtraction
-    mov	$acc0, $t0
-    mov	$acc1, $in_ptr
-    mov	$acc2, %rax
-    mov	$acc3, %rdx
+# fold (acc7, acc6, acc5, acc4) into (acc3, acc2, acc1, acc0), mulx,
+# $zero is a scratch register
+sub pm_reducex () {
+my $zero = shift;
 
-    sub	.Lpoly+8*0(%rip), $acc0
-    sbb	.Lpoly+8*1(%rip), $acc1
-    sbb	.Lpoly+8*2(%rip), $acc2
-    sbb	.Lpoly+8*3(%rip), $acc3
-    sbb	$t2, $t2
+"	mov	\$0x1000003d1, %rdx
+    xor	$zero, $zero		# cf=0,of=0
+    mulx	$acc4, $t0, $t1
+    adcx	$t0, $acc0
+    adox	$t1, $acc1
+    mulx	$acc5, $t0, $t1
+    adcx	$t0, $acc1
+    adox	$t1, $acc2
+    mulx	$acc6, $t0, $t1
+    adcx	$t0, $acc2
+    adox	$t1, $acc3
+    mulx	$acc7, $t0, %rax
+    adcx	$t0, $acc3
+    adox	$zero, %rax
+    adcx	$zero, %rax
 
-    cmovnz	$t0, $acc0
-    cmovnz	$in_ptr, $acc1
-     mov	$acc0, 8*0($r_ptr)
-    cmovnz	%rax, $acc2
-     mov	$acc1, 8*1($r_ptr)
-    cmovnz	%rdx, $acc3
-     mov	$acc2, 8*2($r_ptr)
-     mov	$acc3, 8*3($r_ptr)
+    ########################################################################
+    # Second fold, the carry word is at most 34 bits
 
-    pop	%r13
-    pop	%r12
-    ret
-.size	secp256k1_from_mont,.-secp256k1_from_mont
-___
+    mulx	%rax, $t0, $t1
+    add	$t0, $acc0
+    adc	$t1, $acc1
+    adc	\$0, $acc2
+    adc	\$0, $acc3
+" . &pm_final("%rdx")
 }
-{
-my ($val,$in_t,$index)=$win64?("%rcx","%rdx","%r8d"):("%rdi","%rsi","%edx");
-my ($ONE,$INDEX,$Ra,$Rb,$Rc,$Rd,$Re,$Rf)=map("%xmm$_",(0..7));
-my ($M0,$T0a,$T0b,$T0c,$T0d,$T0e,$T0f,$TMP0)=map("%xmm$_",(8..15));
-my ($M1,$T2a,$T2b,$TMP2,$M2,$T2a,$T2b,$TMP2)=map("%xmm$_",(8..15));
 
 $code.=<<___;
 ################################################################################
-# void secp256k1_scatter_w5(uint64_t *val, uint64_t *in_t, int index);
-.globl	secp256k1_scatter_w5
-.type	secp256k1_scatter_w5,\@abi-omnipotent
-.align	32
-secp256k1_scatter_w5:
-    lea	-3($index,$index,2), $index
-    movdqa	0x00($in_t), %xmm0
-    shl	\$5, $index
-    movdqa	0x10($in_t), %xmm1
-    movdqa	0x20($in_t), %xmm2
-    movdqa	0x30($in_t), %xmm3
-    movdqa	0x40($in_t), %xmm4
-    movdqa	0x50($in_t), %xmm5
-    movdqa	%xmm0, 0x00($val,$index)
-    movdqa	%xmm1, 0x10($val,$index)
-    movdqa	%xmm2, 0x20($val,$index)
-    movdqa	%xmm3, 0x30($val,$index)
-    movdqa	%xmm4, 0x40($val,$index)
-    movdqa	%xmm5, 0x50($val,$index)
-
-    ret
-.size	secp256k1_scatter_w5,.-secp256k1_scatter_w5
+# void secp256k1_mul_pm(
+#   uint64_t res[4],
+#   uint64_t a[4],
+#   uint64_t b[4]);
+# res = a*b mod P, plain field elements
 
-################################################################################
-# void secp256k1_scatter_w7(uint64_t *val, uint64_t *in_t, int index);
-.globl	secp256k1_scatter_w7
-.type	secp256k1_scatter_w7,\@abi-omnipotent
+.globl	secp256k1_mul_pm
+.type	secp256k1_mul_pm,\@function,3
 .align	32
-secp256k1_scatter_w7:
-    movdqu	0x00($in_t), %xmm0
-    shl	\$6, $index
-    movdqu	0x10($in_t), %xmm1
-    movdqu	0x20($in_t), %xmm2
-    movdqu	0x30($in_t), %xmm3
-    movdqa	%xmm0, 0x00($val,$index)
-    movdqa	%xmm1, 0x10($val,$index)
-    movdqa	%xmm2, 0x20($val,$index)
-    movdqa	%xmm3, 0x30($val,$index)
-
-    ret
-.size	secp256k1_scatter_w7,.-secp256k1_scatter_w7
+secp256k1_mul_pm:
 ___
-}
-{{{
-########################################################################
-# This block implements higher level point_double, point_add and
-# point_add_affine. The key to performance in this case is to allow
-# out-of-order execution logic to overlap computations from next step
-# with tail processing from current step. By using tailored calling
-# sequence we minimize inter-step overhead to give processor better
+$code.=<<___	if ($addx);
+    mov	\$0x80100, %ecx
+    and	cpu_info+8(%rip), %ecx
+___
+$code.=<<___;
+    push	%rbp
+    push	%rbx
+    push	%r12
+    push	%r13
+    push	%r14
+    push	%r15
+___
+$code.=<<___	if ($addx);
+    cmp	\$0x80100, %ecx
+    je	.Lmul_pmx
+___
+$code.=<<___;
+    mov	$b_org, $b_ptr
+    mov	8*0($b_org), %rax
+    mov	8*0($a_ptr), $acc1
+    mov	8*1($a_ptr), $acc2
+    mov	8*2($a_ptr), $acc3
+    mov	8*3($a_ptr), $acc4
+
+    call	__secp256k1_mul_pmq
+___
+$code.=<<___	if ($addx);
+    jmp	.Lmul_pm_done
+
+.align	32
+.Lmul_pmx:
+    mov	$b_org, $b_ptr
+    mov	8*0($b_org), %rdx
+    mov	8*0($a_ptr), $acc1
+    mov	8*1($a_ptr), $acc2
+    mov	8*2($a_ptr), $acc3
+    mov	8*3($a_ptr), $acc4
+    lea	-128($a_ptr), $a_ptr	# control u-op density
+
+    call	__secp256k1_mul_pmx
+___
+$code.=<<___;
+.Lmul_pm_done:
+    pop	%r15
+    pop	%r14
+    pop	%r13
+    pop	%r12
+    pop	%rbx
+    pop	%rbp
+    ret
+.size	secp256k1_mul_pm,.-secp256k1_mul_pm
+
+.type	__secp256k1_mul_pmq,\@abi-omnipotent
+.align	32
+__secp256k1_mul_pmq:
+    ########################################################################
+    # Multiply a by b[0]
+
+    mov	%rax, $t1
+    mulq	$acc1
+    mov	%rax, $acc0
+    mov	$t1, %rax
+    mov	%rdx, $acc1
+
+    mulq	$acc2
+    add	%rax, $acc1
+    mov	$t1, %rax
+    adc	\$0, %rdx
+    mov	%rdx, $acc2
+
+    mulq	$acc3
+    add	%rax, $acc2
+    mov	$t1, %rax
+    adc	\$0, %rdx
+    mov	%rdx, $acc3
+
+    mulq	$acc4
+    add	%rax, $acc3
+     mov	8*1($b_ptr), %rax
+    adc	\$0, %rdx
+    mov	%rdx, $acc4
+___
+for (my $i=1; $i<4; $i++) {
+my ($r0,$r1,$r2,$r3,$r4)=($acc0,$acc1,$acc2,$acc3,$acc4,$acc5,$acc6,$acc7)[$i..$i+4];
+my $next = $i<3 ? "8*".($i+1)."($b_ptr)" : "";
+$code.=<<___;
+
+    ########################################################################
+    # Multiply a by b[$i]
+
+    mov	%rax, $t1
+    mulq	8*0($a_ptr)
+    add	%rax, $r0
+    mov	$t1, %rax
+    adc	\$0, %rdx
+    mov	%rdx, $t0
+
+    mulq	8*1($a_ptr)
+    add	$t0, $r1
+    adc	\$0, %rdx
+    add	%rax, $r1
+    mov	$t1, %rax
+    adc	\$0, %rdx
+    mov	%rdx, $t0
+
+    mulq	8*2($a_ptr)
+    add	$t0, $r2
+    adc	\$0, %rdx
+    add	%rax, $r2
+    mov	$t1, %rax
+    adc	\$0, %rdx
+    mov	%rdx, $t0
+
+    mulq	8*3($a_ptr)
+    add	$t0, $r3
+    adc	\$0, %rdx
+    add	%rax, $r3
+___
+$code.=<<___	if ($next);
+     mov	$next, %rax
+___
+$code.=<<___;
+    adc	\$0, %rdx
+    mov	%rdx, $r4
+___
+}
+$code.=<<___;
+
+    ########################################################################
+    # Reduction
+
+    `&pm_reduceq()`
+    mov	$acc6, $acc0			# result in "4-5-0-1" order
+    mov	$acc7, $acc1
+
+    ret
+.size	__secp256k1_mul_pmq,.-__secp256k1_mul_pmq
+
+################################################################################
+# void secp256k1_sqr_pm(
+#   uint64_t res[4],
+#   uint64_t a[4]);
+# res = a*a mod P, plain field elements
+
+.globl	secp256k1_sqr_pm
+.type	secp256k1_sqr_pm,\@function,2
+.align	32
+secp256k1_sqr_pm:
+___
+$code.=<<___	if ($addx);
+    mov	\$0x80100, %ecx
+    and	cpu_info+8(%rip), %ecx
+___
+$code.=<<___;
+    push	%rbp
+    push	%rbx
+    push	%r12
+    push	%r13
+    push	%r14
+    push	%r15
+___
+$code.=<<___	if ($addx);
+    cmp	\$0x80100, %ecx
+    je	.Lsqr_pmx
+___
+$code.=<<___;
+    mov	8*0($a_ptr), %rax
+    mov	8*1($a_ptr), $acc6
+    mov	8*2($a_ptr), $acc7
+    mov	8*3($a_ptr), $acc0
+
+    call	__secp256k1_sqr_pmq
+___
+$code.=<<___	if ($addx);
+    jmp	.Lsqr_pm_done
+
+.align	32
+.Lsqr_pmx:
+    mov	8*0($a_ptr), %rdx
+    mov	8*1($a_ptr), $acc6
+    mov	8*2($a_ptr), $acc7
+    mov	8*3($a_ptr), $acc0
+    lea	-128($a_ptr), $a_ptr	# control u-op density
+
+    call	__secp256k1_sqr_pmx
+___
+$code.=<<___;
+.Lsqr_pm_done:
+    pop	%r15
+    pop	%r14
+    pop	%r13
+    pop	%r12
+    pop	%rbx
+    pop	%rbp
+    ret
+.size	secp256k1_sqr_pm,.-secp256k1_sqr_pm
+
+.type	__secp256k1_sqr_pmq,\@abi-omnipotent
+.align	32
+__secp256k1_sqr_pmq:
+$sqr_bodyq
+    ##########################################
+    # Reduction
+
+    `&pm_reduceq()`
+
+    ret
+.size	__secp256k1_sqr_pmq,.-__secp256k1_sqr_pmq
+___
+
+if ($addx) {
+$code.=<<___;
+.type	__secp256k1_mul_pmx,\@abi-omnipotent
+.align	32
+__secp256k1_mul_pmx:
+    ########################################################################
+    # Multiply by b[0]
+
+    mulx	$acc1, $acc0, $acc1
+    mulx	$acc2, $t0, $acc2
+    xor	%eax, %eax		# cf=0
+    mulx	$acc3, $t1, $acc3
+    adc	$t0, $acc1
+    mulx	$acc4, $t0, $acc4
+    adc	$t1, $acc2
+    adc	$t0, $acc3
+     mov	8*1($b_ptr), %rdx
+    adc	\$0, $acc4
+___
+for (my $i=1; $i<4; $i++) {
+my ($r0,$r1,$r2,$r3,$r4)=($acc0,$acc1,$acc2,$acc3,$acc4,$acc5,$acc6,$acc7)[$i..$i+4];
+my $next = $i<3 ? "8*".($i+1)."($b_ptr)" : "";
+$code.=<<___;
+
+    ########################################################################
+    # Multiply by b[$i]
+
+    xor	$r4, $r4		# cf=0,of=0
+    mulx	8*0+128($a_ptr), $t0, $t1
+    adcx	$t0, $r0
+    adox	$t1, $r1
+
+    mulx	8*1+128($a_ptr), $t0, $t1
+    adcx	$t0, $r1
+    adox	$t1, $r2
+
+    mulx	8*2+128($a_ptr), $t0, $t1
+    adcx	$t0, $r2
+    adox	$t1, $r3
+
+    mulx	8*3+128($a_ptr), $t0, $t1
+___
+$code.=<<___	if ($next);
+     mov	$next, %rdx
+___
+$code.=<<___;
+    adcx	$t0, $r3
+    adox	$t1, $r4
+    adc	\$0, $r4
+___
+}
+$code.=<<___;
+
+    ########################################################################
+    # Reduction
+
+    `&pm_reducex("$t2")`
+    mov	$acc6, $acc0			# result in "4-5-0-1" order
+    mov	$acc7, $acc1
+
+    ret
+.size	__secp256k1_mul_pmx,.-__secp256k1_mul_pmx
+
+.type	__secp256k1_sqr_pmx,\@abi-omnipotent
+.align	32
+__secp256k1_sqr_pmx:
+$sqr_bodyx
+    ##########################################
+    # Reduction
+
+    `&pm_reducex("$a_ptr")`
+
+    ret
+.size	__secp256k1_sqr_pmx,.-__secp256k1_sqr_pmx
+___
+}
+}
+{
+my ($r_ptr,$in_ptr)=("%rdi","%rsi");
+my ($acc0,$acc1,$acc2,$acc3)=map("%r$_",(8..11));
+my ($t0,$t1,$t2)=("%rcx","%r12","%r13");
+
+$code.=<<___;
+################################################################################
+# void secp256k1_from_mont(
+#   uint64_t res[4],
+#   uint64_t in[4]);
+# This one performs Montgomery multiplication by 1, so we only need the reduction
+
+.globl	secp256k1_from_mont
+.type	secp256k1_from_mont,\@function,2
+.align	32
+secp256k1_from_mont:
+___
+$code.=<<___	if ($pm);
+    jmp	.Lreduce
+___
+$code.=<<___	if (!$pm);
+    push	%r12
+    push	%r13
+
+    mov	8*0($in_ptr), $acc0
+    mov	8*1($in_ptr), $acc1
+    mov	8*2($in_ptr), $acc2
+    mov	8*3($in_ptr), $acc3
+
+    mov	.LK+8*0(%rip), $t2
+    mov	.Lpoly_c+8*0(%rip), $t1
+    #########################################
+    # First iteration
+
+    mov $acc0, %rax
+    mulq $t2
+    mov %rax, $t0
+    mulq $t1
+    sub %rax, $acc0
+    sbb %rdx, $acc1
+    sbb \$0, $acc2
+    mov $t0, $acc0
+    sbb \$0, $acc3
+    sbb \$0, $acc0
+
+    ##########################################
+    # Second iteration
+
+    mov $acc1, %rax
+    mulq $t2
+    mov %rax, $t0
+    mulq $t1
+    sub %rax, $acc1
+    sbb %rdx, $acc2
+    sbb \$0, $acc3
+    mov $t0, $acc1
+    sbb \$0, $acc0
+    sbb \$0, $acc1
+
+    ##########################################
+    # Third iteration
+
+    mov $acc2, %rax
+    mulq $t2
+    mov %rax, $t0
+    mulq $t1
+    sub %rax, $acc2
+    sbb %rdx, $acc3
+    sbb \$0, $acc0
+    mov $t0, $acc2
+    sbb \$0, $acc1
+    sbb \$0, $acc2
+
+    ###########################################
+    # Last iteration
+
+    mov $acc3, %rax
+    mulq $t2
+    mov %rax, $t0
+    mulq $t1
+    sub %rax, $acc3
+    sbb %rdx, $acc0
+    sbb \$0, $acc1
+    mov $t0, $acc3
+    sbb \$0, $acc2
+    sbb \$0, $acc3
+    # now we have (acc3, acc2, acc1, acc0)
+
+    ###########################################
+    # Branch-less conditional subtraction
+    mov	$acc0, $t0
+    mov	$acc1, $in_ptr
+    mov	$acc2, %rax
+    mov	$acc3, %rdx
+
+    sub	.Lpoly+8*0(%rip), $acc0
+    sbb	.Lpoly+8*1(%rip), $acc1
+    sbb	.Lpoly+8*2(%rip), $acc2
+    sbb	.Lpoly+8*3(%rip), $acc3
+    sbb	$t2, $t2
+
+    cmovnz	$t0, $acc0
+    cmovnz	$in_ptr, $acc1
+     mov	$acc0, 8*0($r_ptr)
+    cmovnz	%rax, $acc2
+     mov	$acc1, 8*1($r_ptr)
+    cmovnz	%rdx, $acc3
+     mov	$acc2, 8*2($r_ptr)
+     mov	$acc3, 8*3($r_ptr)
+
+    pop	%r13
+    pop	%r12
+    ret
+___
+$code.=<<___;
+.size	secp256k1_from_mont,.-secp256k1_from_mont
+___
+}
+{
+################################################################################
+# Variable time modular inversion (safegcd, Bernstein-Yang divsteps), the
+# outer loop lives in C, these are the kernels which need 128-bit products.
+# Numbers are kept in 5 signed 62-bit limbs, matrix t is {u, v, q, r}.
+
+my ($eta,$f,$g,$t_ptr)=("%rax","%rsi","%rdx","%rdi");
+my ($u,$v,$q,$r)=map("%r$_",(8..11));
+my ($i,$m,$w)=("%rbx","%r12","%r13");
+
+$code.=<<___;
+################################################################################
+# int64_t secp256k1_divsteps_62_var(
+#   int64_t eta,
+#   uint64_t f0,
+#   uint64_t g0,
+#   int64_t t[4]);
+# Performs 62 divsteps on the low limbs of f and g, skipping runs of zeros
+# in g at once, returns the new eta(= -delta)
+
+.globl	secp256k1_divsteps_62_var
+.type	secp256k1_divsteps_62_var,\@function,4
+.align	32
+secp256k1_divsteps_62_var:
+    push	%rbx
+    push	%r12
+    push	%r13
+
+    mov	%rdi, $eta
+    mov	%rcx, $t_ptr
+    mov	\$1, $u
+    xor	$v, $v
+    xor	$q, $q
+    mov	\$1, $r
+    mov	\$62, $i
+
+.Ldivsteps_loop:
+    # zeros = ctz(g | (-1 << i)), the sentinel bit stops at i
+    mov	\$-1, $m
+    mov	%ebx, %ecx
+    shlq	%cl, $m
+    or	$g, $m
+    bsf	$m, %rcx
+    shrq	%cl, $g
+    shlq	%cl, $u
+    shlq	%cl, $v
+    sub	%rcx, $eta
+    sub	%rcx, $i
+    jz	.Ldivsteps_done
+
+    test	$eta, $eta
+    js	.Ldivsteps_swap
+
+    # eta >= 0 : cancel up to 4 bits of g
+    # limit = min(eta + 1, i), m = (2^limit - 1) & 15
+    lea	1($eta), %rcx
+    cmp	$i, %rcx
+    cmova	$i, %rcx
+    neg	%ecx
+    add	\$64, %ecx
+    mov	\$-1, $m
+    shrq	%cl, $m
+    and	\$15, $m
+    # w = (-(f + (((f + 1) & 4) << 1)) * g) & m
+    lea	1($f), $w
+    and	\$4, $w
+    lea	($f,$w,2), $w
+    neg	$w
+    imul	$g, $w
+    and	$m, $w
+    jmp	.Ldivsteps_update
+
+.Ldivsteps_swap:
+    # eta = -eta, (f, g) = (g, -f), (u, v, q, r) = (q, r, -u, -v)
+    neg	$eta
+    mov	$f, $m
+    mov	$g, $f
+    neg	$m
+    mov	$m, $g
+    mov	$u, $m
+    mov	$q, $u
+    neg	$m
+    mov	$m, $q
+    mov	$v, $m
+    mov	$r, $v
+    neg	$m
+    mov	$m, $r
+    # cancel up to 6 bits of g
+    # limit = min(eta + 1, i), m = (2^limit - 1) & 63
+    lea	1($eta), %rcx
+    cmp	$i, %rcx
+    cmova	$i, %rcx
+    neg	%ecx
+    add	\$64, %ecx
+    mov	\$-1, $m
+    shrq	%cl, $m
+    and	\$63, $m
+    # w = (f * g * (f * f - 2)) & m
+    mov	$f, $w
+    imul	$f, $w
+    sub	\$2, $w
+    imul	$f, $w
+    imul	$g, $w
+    and	$m, $w
+
+.Ldivsteps_update:
+    # g += f * w, q += u * w, r += v * w
+    mov	$f, $m
+    imul	$w, $m
+    add	$m, $g
+    mov	$u, $m
+    imul	$w, $m
+    add	$m, $q
+    mov	$v, $m
+    imul	$w, $m
+    add	$m, $r
+    jmp	.Ldivsteps_loop
+
+.Ldivsteps_done:
+    mov	$u, 8*0($t_ptr)
+    mov	$v, 8*1($t_ptr)
+    mov	$q, 8*2($t_ptr)
+    mov	$r, 8*3($t_ptr)
+
+    pop	%r13
+    pop	%r12
+    pop	%rbx
+    ret
+.size	secp256k1_divsteps_62_var,.-secp256k1_divsteps_62_var
+___
+}
+{
+my ($len,$f_ptr,$g_ptr,$i)=("%rdi","%rsi","%r8","%r9");
+my ($u,$v,$q,$r)=("%r10","%r11","%rbx","%rcx");
+my ($cf0,$cf1,$cg0,$cg1)=map("%r$_",(12..15));
+my $M62="%rbp";
+
+$code.=<<___;
+################################################################################
+# void secp256k1_update_fg_62_var(
+#   int len,
+#   int64_t f[5],
+#   int64_t g[5],
+#   const int64_t t[4]);
+# (f, g) = t * (f, g) / 2^62, only the low len limbs are used
+
+.globl	secp256k1_update_fg_62_var
+.type	secp256k1_update_fg_62_var,\@function,4
+.align	32
+secp256k1_update_fg_62_var:
+    push	%rbx
+    push	%rbp
+    push	%r12
+    push	%r13
+    push	%r14
+    push	%r15
+
+    movslq	%edi, $len
+    mov	%rdx, $g_ptr
+    mov	8*0(%rcx), $u
+    mov	8*1(%rcx), $v
+    mov	8*2(%rcx), $q
+    mov	8*3(%rcx), $r
+    mov	\$0x3fffffffffffffff, $M62
+
+    # cf = u * f0 + v * g0, cg = q * f0 + r * g0
+    mov	8*0($f_ptr), %rax
+    imul	$u
+    mov	%rax, $cf0
+    mov	%rdx, $cf1
+    mov	8*0($g_ptr), %rax
+    imul	$v
+    add	%rax, $cf0
+    adc	%rdx, $cf1
+    mov	8*0($f_ptr), %rax
+    imul	$q
+    mov	%rax, $cg0
+    mov	%rdx, $cg1
+    mov	8*0($g_ptr), %rax
+    imul	$r
+    add	%rax, $cg0
+    adc	%rdx, $cg1
+    # low 62 bits are zero
+    shrd	\$62, $cf1, $cf0
+    sar	\$62, $cf1
+    shrd	\$62, $cg1, $cg0
+    sar	\$62, $cg1
+
+    mov	\$1, $i
+.Lupdate_fg_loop:
+    cmp	$len, $i
+    jge	.Lupdate_fg_done
+
+    mov	($f_ptr,$i,8), %rax
+    imul	$u
+    add	%rax, $cf0
+    adc	%rdx, $cf1
+    mov	($g_ptr,$i,8), %rax
+    imul	$v
+    add	%rax, $cf0
+    adc	%rdx, $cf1
+    mov	($f_ptr,$i,8), %rax
+    imul	$q
+    add	%rax, $cg0
+    adc	%rdx, $cg1
+    mov	($g_ptr,$i,8), %rax
+    imul	$r
+    add	%rax, $cg0
+    adc	%rdx, $cg1
+
+    # f[i - 1] = cf mod 2^62, g[i - 1] = cg mod 2^62
+    mov	$cf0, %rax
+    and	$M62, %rax
+    mov	%rax, -8($f_ptr,$i,8)
+    mov	$cg0, %rax
+    and	$M62, %rax
+    mov	%rax, -8($g_ptr,$i,8)
+    shrd	\$62, $cf1, $cf0
+    sar	\$62, $cf1
+    shrd	\$62, $cg1, $cg0
+    sar	\$62, $cg1
+
+    inc	$i
+    jmp	.Lupdate_fg_loop
+
+.Lupdate_fg_done:
+    mov	$cf0, -8($f_ptr,$len,8)
+    mov	$cg0, -8($g_ptr,$len,8)
+
+    pop	%r15
+    pop	%r14
+    pop	%r13
+    pop	%r12
+    pop	%rbp
+    pop	%rbx
+    ret
+.size	secp256k1_update_fg_62_var,.-secp256k1_update_fg_62_var
+___
+}
+{
+my ($d_ptr,$e_ptr,$t_ptr,$m_ptr)=("%rdi","%rsi","%r8","%rcx");
+my ($md,$me,$cd0,$cd1,$ce0,$ce1,$M62)=map("%r$_",(9..15));
+my ($sd,$se)=("%rbx","%rbp");
+
+$code.=<<___;
+################################################################################
+# void secp256k1_update_de_62(
+#   int64_t d[5],
+#   int64_t e[5],
+#   const int64_t t[4],
+#   const SECP256K1_MODINFO *modinfo);
+# (d, e) = t * (d, e) / 2^62 mod modulus, a multiple of the modulus is added
+# so that the division is exact, d and e stay in range (-2*modulus, modulus)
+
+.globl	secp256k1_update_de_62
+.type	secp256k1_update_de_62,\@function,4
+.align	32
+secp256k1_update_de_62:
+    push	%rbx
+    push	%rbp
+    push	%r12
+    push	%r13
+    push	%r14
+    push	%r15
+
+    mov	%rdx, $t_ptr
+    mov	\$0x3fffffffffffffff, $M62
+
+    # md = (u & sd) + (v & se), me = (q & sd) + (r & se)
+    mov	8*4($d_ptr), $sd
+    mov	8*4($e_ptr), $se
+    sar	\$63, $sd
+    sar	\$63, $se
+    mov	8*0($t_ptr), $md
+    mov	8*1($t_ptr), %rax
+    and	$sd, $md
+    and	$se, %rax
+    add	%rax, $md
+    mov	8*2($t_ptr), $me
+    mov	8*3($t_ptr), %rax
+    and	$sd, $me
+    and	$se, %rax
+    add	%rax, $me
+
+    # cd = u * d0 + v * e0, ce = q * d0 + r * e0
+    mov	8*0($d_ptr), %rax
+    imulq	8*0($t_ptr)
+    mov	%rax, $cd0
+    mov	%rdx, $cd1
+    mov	8*0($e_ptr), %rax
+    imulq	8*1($t_ptr)
+    add	%rax, $cd0
+    adc	%rdx, $cd1
+    mov	8*0($d_ptr), %rax
+    imulq	8*2($t_ptr)
+    mov	%rax, $ce0
+    mov	%rdx, $ce1
+    mov	8*0($e_ptr), %rax
+    imulq	8*3($t_ptr)
+    add	%rax, $ce0
+    adc	%rdx, $ce1
+
+    # md -= (modulus_inv62 * cd + md) mod 2^62, the same for me
+    mov	8*5($m_ptr), %rax
+    imul	$cd0, %rax
+    add	$md, %rax
+    and	$M62, %rax
+    sub	%rax, $md
+    mov	8*5($m_ptr), %rax
+    imul	$ce0, %rax
+    add	$me, %rax
+    and	$M62, %rax
+    sub	%rax, $me
+
+    # cd += modulus * md, ce += modulus * me, low 62 bits are zero
+    mov	8*0($m_ptr), %rax
+    imul	$md
+    add	%rax, $cd0
+    adc	%rdx, $cd1
+    mov	8*0($m_ptr), %rax
+    imul	$me
+    add	%rax, $ce0
+    adc	%rdx, $ce1
+    shrd	\$62, $cd1, $cd0
+    sar	\$62, $cd1
+    shrd	\$62, $ce1, $ce0
+    sar	\$62, $ce1
+___
+for (my $k=1; $k<5; $k++) {
+my $o=8*($k-1);
+$code.=<<___;
+
+    # limb $k
+    mov	8*$k($d_ptr), %rax
+    imulq	8*0($t_ptr)
+    add	%rax, $cd0
+    adc	%rdx, $cd1
+    mov	8*$k($e_ptr), %rax
+    imulq	8*1($t_ptr)
+    add	%rax, $cd0
+    adc	%rdx, $cd1
+    mov	8*$k($m_ptr), %rax
+    imul	$md
+    add	%rax, $cd0
+    adc	%rdx, $cd1
+    mov	8*$k($d_ptr), %rax
+    imulq	8*2($t_ptr)
+    add	%rax, $ce0
+    adc	%rdx, $ce1
+    mov	8*$k($e_ptr), %rax
+    imulq	8*3($t_ptr)
+    add	%rax, $ce0
+    adc	%rdx, $ce1
+    mov	8*$k($m_ptr), %rax
+    imul	$me
+    add	%rax, $ce0
+    adc	%rdx, $ce1
+    mov	$cd0, %rax
+    and	$M62, %rax
+    mov	%rax, $o($d_ptr)
+    mov	$ce0, %rax
+    and	$M62, %rax
+    mov	%rax, $o($e_ptr)
+    shrd	\$62, $cd1, $cd0
+    sar	\$62, $cd1
+    shrd	\$62, $ce1, $ce0
+    sar	\$62, $ce1
+___
+}
+$code.=<<___;
+    mov	$cd0, 8*4($d_ptr)
+    mov	$ce0, 8*4($e_ptr)
+
+    pop	%r15
+    pop	%r14
+    pop	%r13
+    pop	%r12
+    pop	%rbp
+    pop	%rbx
+    ret
+.size	secp256k1_update_de_62,.-secp256k1_update_de_62
+___
+}
+{
+my ($val,$in_t,$index)=$win64?("%rcx","%rdx","%r8d"):("%rdi","%rsi","%edx");
+my ($ONE,$INDEX,$Ra,$Rb,$Rc,$Rd,$Re,$Rf)=map("%xmm$_",(0..7));
+my ($M0,$T0a,$T0b,$T0c,$T0d,$T0e,$T0f,$TMP0)=map("%xmm$_",(8..15));
+my ($M1,$T2a,$T2b,$TMP2,$M2,$T2a,$T2b,$TMP2)=map("%xmm$_",(8..15));
+
+$code.=<<___;
+################################################################################
+# void secp256k1_scatter_w5(uint64_t *val, uint64_t *in_t, int index);
+.globl	secp256k1_scatter_w5
+.type	secp256k1_scatter_w5,\@abi-omnipotent
+.align	32
+secp256k1_scatter_w5:
+    lea	-3($index,$index,2), $index
+    movdqa	0x00($in_t), %xmm0
+    shl	\$5, $index
+    movdqa	0x10($in_t), %xmm1
+    movdqa	0x20($in_t), %xmm2
+    movdqa	0x30($in_t), %xmm3
+    movdqa	0x40($in_t), %xmm4
+    movdqa	0x50($in_t), %xmm5
+    movdqa	%xmm0, 0x00($val,$index)
+    movdqa	%xmm1, 0x10($val,$index)
+    movdqa	%xmm2, 0x20($val,$index)
+    movdqa	%xmm3, 0x30($val,$index)
+    movdqa	%xmm4, 0x40($val,$index)
+    movdqa	%xmm5, 0x50($val,$index)
+
+    ret
+.size	secp256k1_scatter_w5,.-secp256k1_scatter_w5
+
+################################################################################
+# void secp256k1_scatter_w7(uint64_t *val, uint64_t *in_t, int index);
+.globl	secp256k1_scatter_w7
+.type	secp256k1_scatter_w7,\@abi-omnipotent
+.align	32
+secp256k1_scatter_w7:
+    movdqu	0x00($in_t), %xmm0
+    shl	\$6, $index
+    movdqu	0x10($in_t), %xmm1
+    movdqu	0x20($in_t), %xmm2
+    movdqu	0x30($in_t), %xmm3
+    movdqa	%xmm0, 0x00($val,$index)
+    movdqa	%xmm1, 0x10($val,$index)
+    movdqa	%xmm2, 0x20($val,$index)
+    movdqa	%xmm3, 0x30($val,$index)
+
+    ret
+.size	secp256k1_scatter_w7,.-secp256k1_scatter_w7
+___
+}
+{{{
+########################################################################
+# This block implements higher level point_double, point_add and
+# point_add_affine. The key to performance in this case is to allow
+# out-of-order execution logic to overlap computations from next step
+# with tail processing from current step. By using tailored calling
+# sequence we minimize inter-step overhead to give processor better
 # shot at overlapping operations...
 #
 # You will notice that input data is copied to stack. Trouble is that
@@ -1648,6 +2588,51 @@ my $bias = $src0 eq "%rax" ? 0 : -128;
     mov	8*3+$a, $acc0"
 }
 
+########################################################################
+# Bounds of the values inside the point formulas: "r" is fully reduced
+# (< p), "w" merely fits in 256 bits. The *_lazy helpers fold the carry
+# out of an addition back in with c = 2^256 - p instead of subtracting p
+# conditionally, so they return "w" values. fe_op names the helper for
+# every step and tracks the bound of its result; generation fails if a
+# "w" value reaches a subtrahend, a zero test or the caller's point.
+#
+my %fe_bound;
+
+# called from within the final eval of `...`, so plain die would be lost
+sub fe_fail { print STDERR "$0: @_\n"; exit(1); }
+
+sub fe_op () {
+my ($op,$r,@in) = @_;
+my @b = map { $fe_bound{$_} // (/^in/ ? "r" : fe_fail "$op: $_ is undefined") } @in;
+my $all = !grep { $_ ne "r" } @b;
+my $any = grep { $_ eq "r" } @b;
+
+    if ($op eq "begin")	{ %fe_bound = (); return ""; }
+    if ($op =~ /^(out|zero)$/) {
+	for ($r,@in) { $fe_bound{$_} eq "r" or fe_fail "$op: $_ is not reduced"; }
+	return "";
+    }
+    $fe_bound{$r} = $b[0];
+    return "" if ($op eq "div_by_2");
+
+    if ($op =~ /^(mul|sqr)$/) {
+	# Montgomery reduction of a product of two "w" values may
+	# leave p <= result < 2^256, pseudo-Mersenne one never does
+	$fe_bound{$r} = ($fe eq "pm" || $any) ? "r" : "w";
+	return "__secp256k1_${op}_$fe";
+    }
+    if ($op =~ /^sub/) {
+	$b[1] eq "r" or fe_fail "$op: unreduced subtrahend $in[1]";
+    } elsif ($op eq "add_to_lazy") {
+	$any or fe_fail "$op: both $in[0] and $in[1] are unreduced";
+	$fe_bound{$r} = "w";
+    } else {
+	$all or fe_fail "$op: unreduced input";
+	$fe_bound{$r} = $op =~ /_lazy$/ ? "w" : "r";
+    }
+    "__secp256k1_$op";
+}
+
                                     {
 ########################################################################
 # operate in 4-5-0-1 "name space" that matches multiplication output
@@ -1692,26 +2677,17 @@ __secp256k1_add_toq:
 __secp256k1_sub_fromq:
     sub	8*0($b_ptr), $a0
     sbb	8*1($b_ptr), $a1
-     mov	$a0, $t0
     sbb	8*2($b_ptr), $a2
     sbb	8*3($b_ptr), $a3
-     mov	$a1, $t1
     sbb	$t4, $t4
 
-    add	.Lpoly+8*0(%rip), $a0
-     mov	$a2, $t2
-    adc	.Lpoly+8*1(%rip), $a1
-    adc	.Lpoly+8*2(%rip), $a2
-     mov	$a3, $t3
-    adc	.Lpoly+8*3(%rip), $a3
-    test	$t4, $t4
-
-    cmovz	$t0, $a0
-    cmovz	$t1, $a1
+    and	.Lpoly_c(%rip), $t4	# a-b+p = a-b-c mod 2^256, can't borrow
+    sub	$t4, $a0
+    sbb	\$0, $a1
     mov	$a0, 8*0($r_ptr)
-    cmovz	$t2, $a2
+    sbb	\$0, $a2
     mov	$a1, 8*1($r_ptr)
-    cmovz	$t3, $a3
+    sbb	\$0, $a3
     mov	$a2, 8*2($r_ptr)
     mov	$a3, 8*3($r_ptr)
 
@@ -1723,24 +2699,19 @@ __secp256k1_sub_fromq:
 __secp256k1_subq:
     sub	$a0, $t0
     sbb	$a1, $t1
-     mov	$t0, $a0
     sbb	$a2, $t2
     sbb	$a3, $t3
-     mov	$t1, $a1
     sbb	$t4, $t4
 
-    add	.Lpoly+8*0(%rip), $t0
+    and	.Lpoly_c(%rip), $t4
+    sub	$t4, $t0
+    sbb	\$0, $t1
+     mov	$t0, $a0
+    sbb	\$0, $t2
+     mov	$t1, $a1
+    sbb	\$0, $t3
      mov	$t2, $a2
-    adc	.Lpoly+8*1(%rip), $t1
-    adc	.Lpoly+8*2(%rip), $t2
      mov	$t3, $a3
-    adc	.Lpoly+8*3(%rip), $t3
-    test	$t4, $t4
-
-    cmovnz	$t0, $a0
-    cmovnz	$t1, $a1
-    cmovnz	$t2, $a2
-    cmovnz	$t3, $a3
 
     ret
 .size	__secp256k1_subq,.-__secp256k1_subq
@@ -1776,12 +2747,61 @@ __secp256k1_mul_by_2q:
 
     ret
 .size	__secp256k1_mul_by_2q,.-__secp256k1_mul_by_2q
+
+.type	__secp256k1_add_to_lazyq,\@abi-omnipotent
+.align	32
+__secp256k1_add_to_lazyq:
+    add	8*0($b_ptr), $a0
+    adc	8*1($b_ptr), $a1
+    adc	8*2($b_ptr), $a2
+    adc	8*3($b_ptr), $a3
+    sbb	$t4, $t4
+
+    and	.Lpoly_c(%rip), $t4	# fold 2^256 back as c
+    add	$t4, $a0
+    adc	\$0, $a1
+    mov	$a0, 8*0($r_ptr)
+    adc	\$0, $a2
+    mov	$a1, 8*1($r_ptr)
+    adc	\$0, $a3
+    mov	$a2, 8*2($r_ptr)
+    mov	$a3, 8*3($r_ptr)
+
+    ret
+.size	__secp256k1_add_to_lazyq,.-__secp256k1_add_to_lazyq
+
+.type	__secp256k1_mul_by_2_lazyq,\@abi-omnipotent
+.align	32
+__secp256k1_mul_by_2_lazyq:
+    add	$a0, $a0		# a0:a3+a0:a3
+    adc	$a1, $a1
+    adc	$a2, $a2
+    adc	$a3, $a3
+    sbb	$t4, $t4
+
+    and	.Lpoly_c(%rip), $t4	# fold 2^256 back as c
+    add	$t4, $a0
+    adc	\$0, $a1
+    mov	$a0, 8*0($r_ptr)
+    adc	\$0, $a2
+    mov	$a1, 8*1($r_ptr)
+    adc	\$0, $a3
+    mov	$a2, 8*2($r_ptr)
+    mov	$a3, 8*3($r_ptr)
+
+    ret
+.size	__secp256k1_mul_by_2_lazyq,.-__secp256k1_mul_by_2_lazyq
 ___
                                     }
 sub gen_double () {
     my $x = shift;
     my ($src0,$sfx,$bias);
     my ($S,$M,$Zsqr,$in_x,$tmp0)=map(32*$_,(0..4));
+    # rounds left, in the alignment padding of the frame
+    my $count = 32*5;
+    # the pseudo-Mersenne kernels take any 256-bit input, so S and
+    # M may stay partially reduced up to the next squaring
+    my $lazy = $fe eq "pm" ? "_lazy" : "";
 
     if ($x ne "x") {
     $src0 = "%rax";
@@ -1799,6 +2819,29 @@ $code.=<<___	if ($addx);
     and	cpu_info+8(%rip), %ecx
     cmp	\$0x80100, %ecx
     je	.Lpoint_doublex
+___
+$code.=<<___;
+    push	%rbp
+    push	%rbx
+    push	%r12
+    push	%r13
+    push	%r14
+    push	%r15
+    sub	\$32*5+8, %rsp
+    movl	\$1, $count(%rsp)
+    jmp	.Lpoint_double_shortcut$x
+.size	secp256k1_point_dbl,.-secp256k1_point_dbl
+
+.globl	secp256k1_point_dbl_n
+.type	secp256k1_point_dbl_n,\@function,3
+.align	32
+secp256k1_point_dbl_n:
+___
+$code.=<<___	if ($addx);
+    mov	\$0x80100, %ecx
+    and	cpu_info+8(%rip), %ecx
+    cmp	\$0x80100, %ecx
+    je	.Lpoint_double_nx
 ___
     } else {
     $src0 = "%rdx";
@@ -1810,6 +2853,21 @@ $code.=<<___;
 .align	32
 secp256k1_point_dblx:
 .Lpoint_doublex:
+    push	%rbp
+    push	%rbx
+    push	%r12
+    push	%r13
+    push	%r14
+    push	%r15
+    sub	\$32*5+8, %rsp
+    movl	\$1, $count(%rsp)
+    jmp	.Lpoint_double_shortcut$x
+.size	secp256k1_point_dblx,.-secp256k1_point_dblx
+
+.type	secp256k1_point_dbl_nx,\@function,3
+.align	32
+secp256k1_point_dbl_nx:
+.Lpoint_double_nx:
 ___
     }
 $code.=<<___;
@@ -1820,8 +2878,27 @@ $code.=<<___;
     push	%r14
     push	%r15
     sub	\$32*5+8, %rsp
+    mov	%edx, $count(%rsp)
+    test	%edx, %edx
+    jg	.Lpoint_double_shortcut$x
+
+    movdqu	0x00($a_ptr), %xmm0		# n <= 0, r = a
+    movdqu	0x10($a_ptr), %xmm1
+    movdqu	0x20($a_ptr), %xmm2
+    movdqu	0x30($a_ptr), %xmm3
+    movdqu	0x40($a_ptr), %xmm4
+    movdqu	0x50($a_ptr), %xmm5
+    movdqu	%xmm0, 0x00($r_ptr)
+    movdqu	%xmm1, 0x10($r_ptr)
+    movdqu	%xmm2, 0x20($r_ptr)
+    movdqu	%xmm3, 0x30($r_ptr)
+    movdqu	%xmm4, 0x40($r_ptr)
+    movdqu	%xmm5, 0x50($r_ptr)
+    jmp	.Lpoint_double_done$x
 
+.align	32
 .Lpoint_double_shortcut$x:
+    `&fe_op("begin")`
     movdqu	0x00($a_ptr), %xmm0		# copy	*(POINT256 *)$a_ptr.x
     mov	$a_ptr, $b_ptr			# backup copy
     movdqu	0x10($a_ptr), %xmm1
@@ -1840,11 +2917,11 @@ $code.=<<___;
     movq	$acc3, %xmm2
 
     lea	$S(%rsp), $r_ptr
-    call	__secp256k1_mul_by_2$x	# p256_mul_by_2(S, in_y);
+    call	`&fe_op("mul_by_2$lazy", "S", "in_y")`$x	# p256_mul_by_2(S, in_y);
 
     `&load_for_sqr("$S(%rsp)", "$src0")`
     lea	$S(%rsp), $r_ptr
-    call	__secp256k1_sqr_mont$x	# p256_sqr_mont(S, S);
+    call	`&fe_op("sqr", "S", "S")`$x	# p256_sqr_mont(S, S);
 
     mov	0x20($b_ptr), $src0		# $b_ptr is still valid
     mov	0x40+8*0($b_ptr), $acc1
@@ -1854,23 +2931,23 @@ $code.=<<___;
     lea	0x40-$bias($b_ptr), $a_ptr
     lea	0x20($b_ptr), $b_ptr
     movq	%xmm2, $r_ptr
-    call	__secp256k1_mul_mont$x	# p256_mul_mont(res_z, in_z, in_y);
-    call	__secp256k1_mul_by_2$x	# p256_mul_by_2(res_z, res_z);
+    call	`&fe_op("mul", "res_z", "in_z", "in_y")`$x	# p256_mul_mont(res_z, in_z, in_y);
+    call	`&fe_op("mul_by_2", "res_z", "res_z")`$x	# p256_mul_by_2(res_z, res_z);
 
     `&load_for_sqr("$in_x(%rsp)", "$src0")`
     lea	$M(%rsp), $r_ptr
-    call    __secp256k1_sqr_mont$x	# p256_sqr_mont(M, in_x);
+    call	`&fe_op("sqr", "M", "in_x")`$x	# p256_sqr_mont(M, in_x);
     mov $acc6, $acc0
     mov $acc7, $acc1
     lea	$tmp0(%rsp), $r_ptr
-    call	__secp256k1_mul_by_2$x
+    call	`&fe_op("mul_by_2$lazy", "tmp0", "M")`$x
     lea	$M(%rsp), $b_ptr
     lea	$M(%rsp), $r_ptr
-    call	__secp256k1_add_to$x		# p256_mul_by_3(M, M);
+    call	`&fe_op("add_to$lazy", "M", "tmp0", "M")`$x	# p256_mul_by_3(M, M);
 
     `&load_for_sqr("$S(%rsp)", "$src0")`
     movq	%xmm1, $r_ptr
-    call	__secp256k1_sqr_mont$x	# p256_sqr_mont(res_y, S);
+    call	`&fe_op("sqr", "res_y", "S")`$x	# p256_sqr_mont(res_y, S);
 ___
 {
 ######## secp256k1_div_by_2(res_y, res_y); ##########################
@@ -1880,6 +2957,7 @@ my ($poly1,$poly3)=($a_ptr,$t1);
 my ($a0,$a1,$a2,$a3,$t3,$t4,$t1)=($acc4,$acc5,$acc6,$acc7,$acc0,$acc1,$acc2);
 
 $code.=<<___;
+    `&fe_op("div_by_2", "res_y", "res_y")`
     xor	$t4, $t4
     mov	$a0, $t0
     add	.Lpoly+8*0(%rip), $a0
@@ -1923,28 +3001,28 @@ ___
 $code.=<<___;
     `&load_for_mul("$S(%rsp)", "$in_x(%rsp)", "$src0")`
     lea	$S(%rsp), $r_ptr
-    call	__secp256k1_mul_mont$x	# p256_mul_mont(S, S, in_x);
+    call	`&fe_op("mul", "S", "S", "in_x")`$x	# p256_mul_mont(S, S, in_x);
 
     lea	$tmp0(%rsp), $r_ptr
-    call	__secp256k1_mul_by_2$x	# p256_mul_by_2(tmp0, S);
+    call	`&fe_op("mul_by_2", "tmp0", "S")`$x	# p256_mul_by_2(tmp0, S);
 
     `&load_for_sqr("$M(%rsp)", "$src0")`
     movq	%xmm0, $r_ptr
-    call	__secp256k1_sqr_mont$x	# p256_sqr_mont(res_x, M);
+    call	`&fe_op("sqr", "res_x", "M")`$x	# p256_sqr_mont(res_x, M);
 
     lea	$tmp0(%rsp), $b_ptr
     mov	$acc6, $acc0			# harmonize sqr output and sub input
     mov	$acc7, $acc1
     mov	$a_ptr, $poly1
     mov	$t1, $poly3
-    call	__secp256k1_sub_from$x	# p256_sub(res_x, res_x, tmp0);
+    call	`&fe_op("sub_from", "res_x", "res_x", "tmp0")`$x	# p256_sub(res_x, res_x, tmp0);
 
     mov	$S+8*0(%rsp), $t0
     mov	$S+8*1(%rsp), $t1
     mov	$S+8*2(%rsp), $t2
     mov	$S+8*3(%rsp), $acc2		# "4-5-0-1" order
     lea	$S(%rsp), $r_ptr
-    call	__secp256k1_sub$x		# p256_sub(S, S, res_x);
+    call	`&fe_op("sub", "S", "S", "res_x")`$x	# p256_sub(S, S, res_x);
 
     mov	$M(%rsp), $src0
     lea	$M(%rsp), $b_ptr
@@ -1960,12 +3038,20 @@ $code.=<<___;
     mov	$acc1, $S+8*3(%rsp)
     mov	$acc6, $acc1
     lea	$S(%rsp), $r_ptr
-    call	__secp256k1_mul_mont$x	# p256_mul_mont(S, S, M);
+    call	`&fe_op("mul", "S", "S", "M")`$x	# p256_mul_mont(S, S, M);
 
     movq	%xmm1, $b_ptr
     movq	%xmm1, $r_ptr
-    call	__secp256k1_sub_from$x	# p256_sub(res_y, S, res_y);
+    call	`&fe_op("sub_from", "res_y", "S", "res_y")`$x	# p256_sub(res_y, S, res_y);
+    `&fe_op("out", "res_x", "res_y", "res_z")`
+
+    decl	$count(%rsp)
+    jz	.Lpoint_double_done$x
+    movq	%xmm0, $r_ptr			# next round doubles res in place
+    mov	$r_ptr, $a_ptr
+    jmp	.Lpoint_double_shortcut$x
 
+.Lpoint_double_done$x:
     add	\$32*5+8, %rsp
     pop	%r15
     pop	%r14
@@ -1974,7 +3060,7 @@ $code.=<<___;
     pop	%rbx
     pop	%rbp
     ret
-.size	secp256k1_point_dbl$sfx,.-secp256k1_point_dbl$sfx
+.size	secp256k1_point_dbl_n$sfx,.-secp256k1_point_dbl_n$sfx
 ___
 }
 &gen_double("q");
@@ -2026,6 +3112,7 @@ $code.=<<___;
     push	%r14
     push	%r15
     sub	\$32*18+8, %rsp
+    `&fe_op("begin")`
 
     movdqu	0x00($a_ptr), %xmm0		# copy	*(POINT256 *)$a_ptr
     movdqu	0x10($a_ptr), %xmm1
@@ -2071,7 +3158,7 @@ $code.=<<___;
      mov	$acc7, $in2_z+8*2(%rsp)
      mov	$acc0, $in2_z+8*3(%rsp)
     lea	$Z2sqr(%rsp), $r_ptr		# Z2^2
-    call	__secp256k1_sqr_mont$x	# p256_sqr_mont(Z2sqr, in2_z);
+    call	`&fe_op("sqr", "Z2sqr", "in2_z")`$x	# p256_sqr_mont(Z2sqr, in2_z);
 
     pcmpeqd	%xmm4, %xmm5
     pshufd	\$0xb1, %xmm1, %xmm4
@@ -2090,28 +3177,29 @@ $code.=<<___;
 
     lea	0x40-$bias($b_ptr), $a_ptr
     lea	$Z1sqr(%rsp), $r_ptr		# Z1^2
-    call	__secp256k1_sqr_mont$x	# p256_sqr_mont(Z1sqr, in1_z);
+    call	`&fe_op("sqr", "Z1sqr", "in1_z")`$x	# p256_sqr_mont(Z1sqr, in1_z);
 
     `&load_for_mul("$Z2sqr(%rsp)", "$in2_z(%rsp)", "$src0")`
     lea	$S1(%rsp), $r_ptr		# S1 = Z2^3
-    call	__secp256k1_mul_mont$x	# p256_mul_mont(S1, Z2sqr, in2_z);
+    call	`&fe_op("mul", "S1", "Z2sqr", "in2_z")`$x	# p256_mul_mont(S1, Z2sqr, in2_z);
 
     `&load_for_mul("$Z1sqr(%rsp)", "$in1_z(%rsp)", "$src0")`
     lea	$S2(%rsp), $r_ptr		# S2 = Z1^3
-    call	__secp256k1_mul_mont$x	# p256_mul_mont(S2, Z1sqr, in1_z);
+    call	`&fe_op("mul", "S2", "Z1sqr", "in1_z")`$x	# p256_mul_mont(S2, Z1sqr, in1_z);
 
     `&load_for_mul("$S1(%rsp)", "$in1_y(%rsp)", "$src0")`
     lea	$S1(%rsp), $r_ptr		# S1 = Y1*Z2^3
-    call	__secp256k1_mul_mont$x	# p256_mul_mont(S1, S1, in1_y);
+    call	`&fe_op("mul", "S1", "S1", "in1_y")`$x	# p256_mul_mont(S1, S1, in1_y);
 
     `&load_for_mul("$S2(%rsp)", "$in2_y(%rsp)", "$src0")`
     lea	$S2(%rsp), $r_ptr		# S2 = Y2*Z1^3
-    call	__secp256k1_mul_mont$x	# p256_mul_mont(S2, S2, in2_y);
+    call	`&fe_op("mul", "S2", "S2", "in2_y")`$x	# p256_mul_mont(S2, S2, in2_y);
 
     lea	$S1(%rsp), $b_ptr
     lea	$R(%rsp), $r_ptr		# R = S2 - S1
-    call	__secp256k1_sub_from$x	# p256_sub(R, S2, S1);
+    call	`&fe_op("sub_from", "R", "S2", "S1")`$x	# p256_sub(R, S2, S1);
 
+    `&fe_op("zero", "R")`
     or	$acc5, $acc4			# see if result is zero
     movdqa	%xmm4, %xmm2
     or	$acc0, $acc4
@@ -2121,16 +3209,17 @@ $code.=<<___;
 
     `&load_for_mul("$Z2sqr(%rsp)", "$in1_x(%rsp)", "$src0")`
     lea	$U1(%rsp), $r_ptr		# U1 = X1*Z2^2
-    call	__secp256k1_mul_mont$x	# p256_mul_mont(U1, in1_x, Z2sqr);
+    call	`&fe_op("mul", "U1", "in1_x", "Z2sqr")`$x	# p256_mul_mont(U1, in1_x, Z2sqr);
 
     `&load_for_mul("$Z1sqr(%rsp)", "$in2_x(%rsp)", "$src0")`
     lea	$U2(%rsp), $r_ptr		# U2 = X2*Z1^2
-    call	__secp256k1_mul_mont$x	# p256_mul_mont(U2, in2_x, Z1sqr);
+    call	`&fe_op("mul", "U2", "in2_x", "Z1sqr")`$x	# p256_mul_mont(U2, in2_x, Z1sqr);
 
     lea	$U1(%rsp), $b_ptr
     lea	$H(%rsp), $r_ptr		# H = U2 - U1
-    call	__secp256k1_sub_from$x	# p256_sub(H, U2, U1);
+    call	`&fe_op("sub_from", "H", "U2", "U1")`$x	# p256_sub(H, U2, U1);
 
+    `&fe_op("zero", "H")`
     or	$acc5, $acc4			# see if result is zero
     or	$acc0, $acc4
     or	$acc1, $acc4
@@ -2159,33 +3248,34 @@ $code.=<<___;
     movq	%xmm1, $a_ptr			# restore $a_ptr
     movq	%xmm0, $r_ptr			# restore $r_ptr
     add	\$`32*(18-5)`, %rsp		# difference in frame sizes
+    movl	\$1, 32*5(%rsp)			# one round of point_dbl_n
     jmp	.Lpoint_double_shortcut$x
 
 .align	32
 .Ladd_proceed$x:
     `&load_for_sqr("$R(%rsp)", "$src0")`
     lea	$Rsqr(%rsp), $r_ptr		# R^2
-    call	__secp256k1_sqr_mont$x	# p256_sqr_mont(Rsqr, R);
+    call	`&fe_op("sqr", "Rsqr", "R")`$x	# p256_sqr_mont(Rsqr, R);
 
     `&load_for_mul("$H(%rsp)", "$in1_z(%rsp)", "$src0")`
     lea	$res_z(%rsp), $r_ptr		# Z3 = H*Z1*Z2
-    call	__secp256k1_mul_mont$x	# p256_mul_mont(res_z, H, in1_z);
+    call	`&fe_op("mul", "res_z", "H", "in1_z")`$x	# p256_mul_mont(res_z, H, in1_z);
 
     `&load_for_sqr("$H(%rsp)", "$src0")`
     lea	$Hsqr(%rsp), $r_ptr		# H^2
-    call	__secp256k1_sqr_mont$x	# p256_sqr_mont(Hsqr, H);
+    call	`&fe_op("sqr", "Hsqr", "H")`$x	# p256_sqr_mont(Hsqr, H);
 
     `&load_for_mul("$res_z(%rsp)", "$in2_z(%rsp)", "$src0")`
     lea	$res_z(%rsp), $r_ptr		# Z3 = H*Z1*Z2
-    call	__secp256k1_mul_mont$x	# p256_mul_mont(res_z, res_z, in2_z);
+    call	`&fe_op("mul", "res_z", "res_z", "in2_z")`$x	# p256_mul_mont(res_z, res_z, in2_z);
 
     `&load_for_mul("$Hsqr(%rsp)", "$H(%rsp)", "$src0")`
     lea	$Hcub(%rsp), $r_ptr		# H^3
-    call	__secp256k1_mul_mont$x	# p256_mul_mont(Hcub, Hsqr, H);
+    call	`&fe_op("mul", "Hcub", "Hsqr", "H")`$x	# p256_mul_mont(Hcub, Hsqr, H);
 
     `&load_for_mul("$Hsqr(%rsp)", "$U1(%rsp)", "$src0")`
     lea	$U2(%rsp), $r_ptr		# U1*H^2
-    call	__secp256k1_mul_mont$x	# p256_mul_mont(U2, U1, Hsqr);
+    call	`&fe_op("mul", "U2", "U1", "Hsqr")`$x	# p256_mul_mont(U2, U1, Hsqr);
 ___
 {
 #######################################################################
@@ -2197,7 +3287,7 @@ my ($poly1, $poly3)=($acc6,$acc7);
 $code.=<<___;
     #lea	$U2(%rsp), $a_ptr
     #lea	$Hsqr(%rsp), $r_ptr	# 2*U1*H^2
-    #call	__secp256k1_mul_by_2	# secp256k1_mul_by_2(Hsqr, U2);
+    #call	`&fe_op("mul_by_2", "Hsqr", "U2")`	# secp256k1_mul_by_2(Hsqr, U2);
 
     xor	$t4, $t4
     add	$acc0, $acc0		# a0:a3+a0:a3
@@ -2226,11 +3316,11 @@ $code.=<<___;
     cmovc	$t3, $acc3
     mov	8*3($a_ptr), $t3
 
-    call	__secp256k1_sub$x		# p256_sub(res_x, Rsqr, Hsqr);
+    call	`&fe_op("sub", "res_x", "Rsqr", "Hsqr")`$x	# p256_sub(res_x, Rsqr, Hsqr);
 
     lea	$Hcub(%rsp), $b_ptr
     lea	$res_x(%rsp), $r_ptr
-    call	__secp256k1_sub_from$x	# p256_sub(res_x, res_x, Hcub);
+    call	`&fe_op("sub_from", "res_x", "res_x", "Hcub")`$x	# p256_sub(res_x, res_x, Hcub);
 
     mov	$U2+8*0(%rsp), $t0
     mov	$U2+8*1(%rsp), $t1
@@ -2238,7 +3328,7 @@ $code.=<<___;
     mov	$U2+8*3(%rsp), $t3
     lea	$res_y(%rsp), $r_ptr
 
-    call	__secp256k1_sub$x		# p256_sub(res_y, U2, res_x);
+    call	`&fe_op("sub", "res_y", "U2", "res_x")`$x	# p256_sub(res_y, U2, res_x);
 
     mov	$acc0, 8*0($r_ptr)		# save the result, as
     mov	$acc1, 8*1($r_ptr)		# __secp256k1_sub doesn't
@@ -2249,15 +3339,16 @@ ___
 $code.=<<___;
     `&load_for_mul("$S1(%rsp)", "$Hcub(%rsp)", "$src0")`
     lea	$S2(%rsp), $r_ptr
-    call	__secp256k1_mul_mont$x	# p256_mul_mont(S2, S1, Hcub);
+    call	`&fe_op("mul", "S2", "S1", "Hcub")`$x	# p256_mul_mont(S2, S1, Hcub);
 
     `&load_for_mul("$R(%rsp)", "$res_y(%rsp)", "$src0")`
     lea	$res_y(%rsp), $r_ptr
-    call	__secp256k1_mul_mont$x	# p256_mul_mont(res_y, R, res_y);
+    call	`&fe_op("mul", "res_y", "R", "res_y")`$x	# p256_mul_mont(res_y, R, res_y);
 
     lea	$S2(%rsp), $b_ptr
     lea	$res_y(%rsp), $r_ptr
-    call	__secp256k1_sub_from$x	# p256_sub(res_y, res_y, S2);
+    call	`&fe_op("sub_from", "res_y", "res_y", "S2")`$x	# p256_sub(res_y, res_y, S2);
+    `&fe_op("out", "res_x", "res_y", "res_z")`
 
     movq	%xmm0, $r_ptr		# restore $r_ptr
 
@@ -2328,16 +3419,16 @@ sub gen_add_affine () {
     $bias = 0;
 
 $code.=<<___;
-.globl	secp256k1_point_add_affine
-.type	secp256k1_point_add_affine,\@function,3
+.globl	secp256k1_point_add_affine_lookup
+.type	secp256k1_point_add_affine_lookup,\@function,3
 .align	32
-secp256k1_point_add_affine:
+secp256k1_point_add_affine_lookup:
 ___
 $code.=<<___	if ($addx);
     mov	\$0x80100, %ecx
     and	cpu_info+8(%rip), %ecx
     cmp	\$0x80100, %ecx
-    je	.Lpoint_add_affinex
+    je	.Lpoint_add_affine_lookupx
 ___
     } else {
     $src0 = "%rdx";
@@ -2345,6 +3436,99 @@ ___
     $bias = 128;
 
 $code.=<<___;
+.type	secp256k1_point_add_affine_lookupx,\@function,3
+.align	32
+secp256k1_point_add_affine_lookupx:
+.Lpoint_add_affine_lookupx:
+___
+    }
+$code.=<<___;
+    push	%rbp
+    push	%rbx
+    push	%r12
+    push	%r13
+    push	%r14
+    push	%r15
+    sub	\$8, %rsp
+    call	__secp256k1_point_add_affine_lookup$x
+    add	\$8, %rsp
+    pop	%r15
+    pop	%r14
+    pop	%r13
+    pop	%r12
+    pop	%rbx
+    pop	%rbp
+    ret
+.size	secp256k1_point_add_affine_lookup$sfx,.-secp256k1_point_add_affine_lookup$sfx
+
+.type	__secp256k1_point_add_affine_lookup$x,\@abi-omnipotent
+.align	32
+__secp256k1_point_add_affine_lookup$x:
+    sub	\$32*15+8, %rsp
+
+    # in2 = digit * row, digit = 2*|d| + sign as from _booth_recode_w7,
+    # row[|d| - 1] is loaded directly, |d| = 0 gives (0, 0)
+    mov	%edx, %eax
+    shr	\$1, %eax			# |d|
+    and	\$1, %edx			# sign
+    lea	-1(%rax), %rcx
+    cmp	\$1, %eax
+    cmovc	%rax, %rcx			# |d| = 0 reads row[0]
+    sbb	%r8, %r8
+    not	%r8				# all ones if |d| != 0
+    and	%r8d, %edx			# -0 stays 0
+    shl	\$6, %rcx
+    movq	%r8, %xmm4
+    punpcklqdq	%xmm4, %xmm4
+    movdqu	0x00($a_ptr,%rcx), %xmm0
+    movdqu	0x10($a_ptr,%rcx), %xmm1
+    movdqu	0x20($a_ptr,%rcx), %xmm2
+    movdqu	0x30($a_ptr,%rcx), %xmm3
+    pand	%xmm4, %xmm0
+    pand	%xmm4, %xmm1
+    pand	%xmm4, %xmm2
+    pand	%xmm4, %xmm3
+    movdqa	%xmm0, $in2_x(%rsp)
+    movdqa	%xmm1, $in2_x+0x10(%rsp)
+    movdqa	%xmm2, $in2_y(%rsp)
+    movdqa	%xmm3, $in2_y+0x10(%rsp)
+
+    mov	.Lpoly+8*0(%rip), $acc0		# P - y
+    mov	.Lpoly+8*1(%rip), $acc1
+    mov	.Lpoly+8*2(%rip), $acc2
+    mov	.Lpoly+8*3(%rip), $acc3
+    sub	$in2_y+8*0(%rsp), $acc0
+    sbb	$in2_y+8*1(%rsp), $acc1
+    sbb	$in2_y+8*2(%rsp), $acc2
+    sbb	$in2_y+8*3(%rsp), $acc3
+    test	%edx, %edx
+    jz	.Ladda_lookup_pos$x
+    mov	$acc0, $in2_y+8*0(%rsp)
+    mov	$acc1, $in2_y+8*1(%rsp)
+    mov	$acc2, $in2_y+8*2(%rsp)
+    mov	$acc3, $in2_y+8*3(%rsp)
+.Ladda_lookup_pos$x:
+    mov	$r_ptr, $a_ptr			# r += in2
+    lea	$in2_x(%rsp), $b_org
+    jmp	.Lpoint_add_affine_body$x
+.size	__secp256k1_point_add_affine_lookup$x,.-__secp256k1_point_add_affine_lookup$x
+___
+
+    if ($x ne "x") {
+$code.=<<___;
+.globl	secp256k1_point_add_affine
+.type	secp256k1_point_add_affine,\@function,3
+.align	32
+secp256k1_point_add_affine:
+___
+$code.=<<___	if ($addx);
+    mov	\$0x80100, %ecx
+    and	cpu_info+8(%rip), %ecx
+    cmp	\$0x80100, %ecx
+    je	.Lpoint_add_affinex
+___
+    } else {
+$code.=<<___;
 .type	secp256k1_point_add_affinex,\@function,3
 .align	32
 secp256k1_point_add_affinex:
@@ -2358,7 +3542,26 @@ $code.=<<___;
     push	%r13
     push	%r14
     push	%r15
+    sub	\$8, %rsp
+    call	__secp256k1_point_add_affine$x
+    add	\$8, %rsp
+    pop	%r15
+    pop	%r14
+    pop	%r13
+    pop	%r12
+    pop	%rbx
+    pop	%rbp
+    ret
+.size	secp256k1_point_add_affine$sfx,.-secp256k1_point_add_affine$sfx
+
+# the frame is set up here and not by the callers, so the lookup entry and
+# the generator ladder reuse it without saving registers every time
+.type	__secp256k1_point_add_affine$x,\@abi-omnipotent
+.align	32
+__secp256k1_point_add_affine$x:
     sub	\$32*15+8, %rsp
+.Lpoint_add_affine_body$x:
+    `&fe_op("begin")`
 
     movdqu	0x00($a_ptr), %xmm0	# copy	*(POINT256 *)$a_ptr
     mov	$b_org, $b_ptr		# reassign
@@ -2399,7 +3602,7 @@ $code.=<<___;
 
     lea	0x40-$bias($a_ptr), $a_ptr	# $a_ptr is still valid
     lea	$Z1sqr(%rsp), $r_ptr		# Z1^2
-    call	__secp256k1_sqr_mont$x	# p256_sqr_mont(Z1sqr, in1_z);
+    call	`&fe_op("sqr", "Z1sqr", "in1_z")`$x	# p256_sqr_mont(Z1sqr, in1_z);
 
     pcmpeqd	%xmm4, %xmm5
     pshufd	\$0xb1, %xmm3, %xmm4
@@ -2419,43 +3622,43 @@ $code.=<<___;
     lea	$Z1sqr-$bias(%rsp), $a_ptr
     mov	$acc7, $acc4
     lea	$U2(%rsp), $r_ptr		# U2 = X2*Z1^2
-    call	__secp256k1_mul_mont$x	# p256_mul_mont(U2, Z1sqr, in2_x);
+    call	`&fe_op("mul", "U2", "Z1sqr", "in2_x")`$x	# p256_mul_mont(U2, Z1sqr, in2_x);
 
     lea	$in1_x(%rsp), $b_ptr
     lea	$H(%rsp), $r_ptr		# H = U2 - U1
-    call	__secp256k1_sub_from$x	# p256_sub(H, U2, in1_x);
+    call	`&fe_op("sub_from", "H", "U2", "in1_x")`$x	# p256_sub(H, U2, in1_x);
 
     `&load_for_mul("$Z1sqr(%rsp)", "$in1_z(%rsp)", "$src0")`
     lea	$S2(%rsp), $r_ptr		# S2 = Z1^3
-    call	__secp256k1_mul_mont$x	# p256_mul_mont(S2, Z1sqr, in1_z);
+    call	`&fe_op("mul", "S2", "Z1sqr", "in1_z")`$x	# p256_mul_mont(S2, Z1sqr, in1_z);
 
     `&load_for_mul("$H(%rsp)", "$in1_z(%rsp)", "$src0")`
     lea	$res_z(%rsp), $r_ptr		# Z3 = H*Z1*Z2
-    call	__secp256k1_mul_mont$x	# p256_mul_mont(res_z, H, in1_z);
+    call	`&fe_op("mul", "res_z", "H", "in1_z")`$x	# p256_mul_mont(res_z, H, in1_z);
 
     `&load_for_mul("$S2(%rsp)", "$in2_y(%rsp)", "$src0")`
     lea	$S2(%rsp), $r_ptr		# S2 = Y2*Z1^3
-    call	__secp256k1_mul_mont$x	# p256_mul_mont(S2, S2, in2_y);
+    call	`&fe_op("mul", "S2", "S2", "in2_y")`$x	# p256_mul_mont(S2, S2, in2_y);
 
     lea	$in1_y(%rsp), $b_ptr
     lea	$R(%rsp), $r_ptr		# R = S2 - S1
-    call	__secp256k1_sub_from$x	# p256_sub(R, S2, in1_y);
+    call	`&fe_op("sub_from", "R", "S2", "in1_y")`$x	# p256_sub(R, S2, in1_y);
 
     `&load_for_sqr("$H(%rsp)", "$src0")`
     lea	$Hsqr(%rsp), $r_ptr		# H^2
-    call	__secp256k1_sqr_mont$x	# p256_sqr_mont(Hsqr, H);
+    call	`&fe_op("sqr", "Hsqr", "H")`$x	# p256_sqr_mont(Hsqr, H);
 
     `&load_for_sqr("$R(%rsp)", "$src0")`
     lea	$Rsqr(%rsp), $r_ptr		# R^2
-    call	__secp256k1_sqr_mont$x	# p256_sqr_mont(Rsqr, R);
+    call	`&fe_op("sqr", "Rsqr", "R")`$x	# p256_sqr_mont(Rsqr, R);
 
     `&load_for_mul("$H(%rsp)", "$Hsqr(%rsp)", "$src0")`
     lea	$Hcub(%rsp), $r_ptr		# H^3
-    call	__secp256k1_mul_mont$x	# p256_mul_mont(Hcub, Hsqr, H);
+    call	`&fe_op("mul", "Hcub", "Hsqr", "H")`$x	# p256_mul_mont(Hcub, Hsqr, H);
 
     `&load_for_mul("$Hsqr(%rsp)", "$in1_x(%rsp)", "$src0")`
     lea	$U2(%rsp), $r_ptr		# U1*H^2
-    call	__secp256k1_mul_mont$x	# p256_mul_mont(U2, in1_x, Hsqr);
+    call	`&fe_op("mul", "U2", "in1_x", "Hsqr")`$x	# p256_mul_mont(U2, in1_x, Hsqr);
 ___
 {
 #######################################################################
@@ -2467,7 +3670,7 @@ my ($poly1, $poly3)=($acc6,$acc7);
 $code.=<<___;
     #lea	$U2(%rsp), $a_ptr
     #lea	$Hsqr(%rsp), $r_ptr	# 2*U1*H^2
-    #call	__secp256k1_mul_by_2	# secp256k1_mul_by_2(Hsqr, U2);
+    #call	`&fe_op("mul_by_2", "Hsqr", "U2")`	# secp256k1_mul_by_2(Hsqr, U2);
 
     xor	$t4, $t4
     add	$acc0, $acc0		# a0:a3+a0:a3
@@ -2496,11 +3699,11 @@ $code.=<<___;
     cmovc	$t3, $acc3
     mov	8*3($a_ptr), $t3
 
-    call	__secp256k1_sub$x		# p256_sub(res_x, Rsqr, Hsqr);
+    call	`&fe_op("sub", "res_x", "Rsqr", "Hsqr")`$x	# p256_sub(res_x, Rsqr, Hsqr);
 
     lea	$Hcub(%rsp), $b_ptr
     lea	$res_x(%rsp), $r_ptr
-    call	__secp256k1_sub_from$x	# p256_sub(res_x, res_x, Hcub);
+    call	`&fe_op("sub_from", "res_x", "res_x", "Hcub")`$x	# p256_sub(res_x, res_x, Hcub);
 
     mov	$U2+8*0(%rsp), $t0
     mov	$U2+8*1(%rsp), $t1
@@ -2508,7 +3711,7 @@ $code.=<<___;
     mov	$U2+8*3(%rsp), $t3
     lea	$H(%rsp), $r_ptr
 
-    call	__secp256k1_sub$x		# p256_sub(H, U2, res_x);
+    call	`&fe_op("sub", "H", "U2", "res_x")`$x	# p256_sub(H, U2, res_x);
 
     mov	$acc0, 8*0($r_ptr)		# save the result, as
     mov	$acc1, 8*1($r_ptr)		# __secp256k1_sub doesn't
@@ -2519,15 +3722,16 @@ ___
 $code.=<<___;
     `&load_for_mul("$Hcub(%rsp)", "$in1_y(%rsp)", "$src0")`
     lea	$S2(%rsp), $r_ptr
-    call	__secp256k1_mul_mont$x	# p256_mul_mont(S2, Hcub, in1_y);
+    call	`&fe_op("mul", "S2", "Hcub", "in1_y")`$x	# p256_mul_mont(S2, Hcub, in1_y);
 
     `&load_for_mul("$H(%rsp)", "$R(%rsp)", "$src0")`
     lea	$H(%rsp), $r_ptr
-    call	__secp256k1_mul_mont$x	# p256_mul_mont(H, H, R);
+    call	`&fe_op("mul", "H", "H", "R")`$x	# p256_mul_mont(H, H, R);
 
     lea	$S2(%rsp), $b_ptr
     lea	$res_y(%rsp), $r_ptr
-    call	__secp256k1_sub_from$x	# p256_sub(res_y, H, S2);
+    call	`&fe_op("sub_from", "res_y", "H", "S2")`$x	# p256_sub(res_y, H, S2);
+    `&fe_op("out", "res_x", "res_y", "res_z")`
 
     movq	%xmm0, $r_ptr		# restore $r_ptr
     movq    %xmm5, %r15
@@ -2540,35 +3744,316 @@ $code.=<<___;
     movdqu $res_y(%rsp), %xmm4
     movdqu $res_y+0x10(%rsp), %xmm5
 
-    cmp \$0, %r15
-    je .adda_in2inf$x
-# in1inf
-    movdqu .LONE_mont(%rip), %xmm0
-    movdqu .LONE_mont+0x10(%rip), %xmm1
-    movdqu $in2_x(%rsp), %xmm2
-    movdqu $in2_x+0x10(%rsp), %xmm3
-    movdqu $in2_y(%rsp), %xmm4
-    movdqu $in2_y+0x10(%rsp), %xmm5
+    cmp \$0, %r15
+    je .adda_in2inf$x
+# in1inf
+    movdqu .LONE_mont(%rip), %xmm0
+    movdqu .LONE_mont+0x10(%rip), %xmm1
+    movdqu $in2_x(%rsp), %xmm2
+    movdqu $in2_x+0x10(%rsp), %xmm3
+    movdqu $in2_y(%rsp), %xmm4
+    movdqu $in2_y+0x10(%rsp), %xmm5
+
+.adda_in2inf$x:
+    cmp \$0, %r14
+    je .adda_set_res$x
+    movdqu $in1_z(%rsp), %xmm0
+    movdqu $in1_z+0x10(%rsp), %xmm1
+    movdqu $in1_x(%rsp), %xmm2
+    movdqu $in1_x+0x10(%rsp), %xmm3
+    movdqu $in1_y(%rsp), %xmm4
+    movdqu $in1_y+0x10(%rsp), %xmm5
+
+.adda_set_res$x:
+    movdqu %xmm0, 0x40($r_ptr)
+    movdqu %xmm1, 0x50($r_ptr)
+    movdqu %xmm2, 0x00($r_ptr)
+    movdqu %xmm3, 0x10($r_ptr)
+    movdqu %xmm4, 0x20($r_ptr)
+    movdqu %xmm5, 0x30($r_ptr)
+
+    add	\$32*15+8, %rsp
+    ret
+.size	__secp256k1_point_add_affine$x,.-__secp256k1_point_add_affine$x
+___
+}
+
+########################################################################
+# kG with the w7 comb table: Booth recoding of the 37 windows, the fetch
+# of row[i] and the mixed add all stay in assembly. The accumulator lives
+# in this frame and every add goes through __secp256k1_point_add_affine_lookup,
+# so registers are saved once per call instead of once per window.
+#
+# All digits are recoded up front, so the entries of windows i+1..i+$pf
+# are known and prefetched while window i is added. Table entries are
+# 64-byte aligned, one prefetch per entry.
+sub gen_mul_gen () {
+    my $x = shift;
+    my $sfx = $x eq "x" ? "x" : "";
+    my ($acc,$scl,$rp,$tbl,$idx,$dig)=(0,96,136,144,152,160);
+    my $frame = 200;
+
+    if ($x ne "x") {
+$code.=<<___;
+.globl	secp256k1_ecmult_gen_w7
+.type	secp256k1_ecmult_gen_w7,\@function,3
+.align	32
+secp256k1_ecmult_gen_w7:
+___
+$code.=<<___	if ($addx);
+    mov	\$0x80100, %ecx
+    and	cpu_info+8(%rip), %ecx
+    cmp	\$0x80100, %ecx
+    je	.Lecmult_gen_w7x
+___
+    } else {
+$code.=<<___;
+.type	secp256k1_ecmult_gen_w7x,\@function,3
+.align	32
+secp256k1_ecmult_gen_w7x:
+.Lecmult_gen_w7x:
+___
+    }
+$code.=<<___;
+    push	%rbp
+    push	%rbx
+    push	%r12
+    push	%r13
+    push	%r14
+    push	%r15
+    sub	\$$frame, %rsp
+
+    pxor	%xmm0, %xmm0			# acc = infinity
+    movdqa	%xmm0, $acc+0x00(%rsp)
+    movdqa	%xmm0, $acc+0x10(%rsp)
+    movdqa	%xmm0, $acc+0x20(%rsp)
+    movdqa	%xmm0, $acc+0x30(%rsp)
+    movdqa	%xmm0, $acc+0x40(%rsp)
+    movdqa	%xmm0, $acc+0x50(%rsp)
+
+    mov	8*0(%rsi), %r8			# scalar bytes, zero padded so that
+    mov	8*1(%rsi), %r9			# the last window may read a byte past
+    mov	8*2(%rsi), %r10
+    mov	8*3(%rsi), %r11
+    mov	%r8, $scl+8*0(%rsp)
+    mov	%r9, $scl+8*1(%rsp)
+    mov	%r10, $scl+8*2(%rsp)
+    mov	%r11, $scl+8*3(%rsp)
+    movq	\$0, $scl+8*4(%rsp)
+    mov	%rdi, $rp(%rsp)
+    mov	%rdx, $tbl(%rsp)
+
+    # digits[j] = _booth_recode_w7(window j), j = 0 .. 36
+    movzbl	$scl(%rsp), %eax		# first window, (byte0 << 1) & 0xff
+    add	%eax, %eax
+    and	\$0xff, %eax
+    xor	%r8d, %r8d
+    jmp	.Lgen_w7_recode$x
+
+.align	16
+.Lgen_w7_window$x:
+    lea	-1(,%r8,8), %ecx
+    sub	%r8d, %ecx			# 7*j - 1
+    mov	%ecx, %r10d
+    shr	\$3, %r10d
+    and	\$7, %ecx
+    movzwl	$scl(%rsp,%r10), %eax
+    shrl	%cl, %eax
+    and	\$0xff, %eax
+
+.Lgen_w7_recode$x:
+    mov	%eax, %edx
+    shr	\$7, %edx			# sign
+    mov	%edx, %r11d
+    neg	%r11d
+    mov	\$0xff, %r9d
+    sub	%eax, %r9d
+    xor	%eax, %r9d
+    and	%r11d, %r9d
+    xor	%r9d, %eax
+    mov	%eax, %r9d
+    and	\$1, %r9d
+    shr	\$1, %eax
+    add	%r9d, %eax			# |d|
+    lea	(%rdx,%rax,2), %edx
+    mov	%dl, $dig(%rsp,%r8)
+___
+$code.=<<___	if ($pf > 0);
+    cmp	\$$pf, %r8d			# entries of the first windows
+    jae	.Lgen_w7_next$x
+    mov	%r8, %r10
+    shl	\$12, %r10
+    add	$tbl(%rsp), %r10
+    shl	\$6, %eax
+    prefetcht0	-64(%r10,%rax)
+.Lgen_w7_next$x:
+___
+$code.=<<___;
+    inc	%r8d
+    cmp	\$37, %r8d
+    jne	.Lgen_w7_window$x
+
+    movl	\$0, $idx(%rsp)
+.align	16
+.Lgen_w7_loop$x:
+___
+$code.=<<___	if ($pf > 0);
+    mov	$idx(%rsp), %r8d		# prefetch row[i + $pf][|d| - 1]
+    add	\$$pf, %r8d
+    cmp	\$37, %r8d
+    jae	.Lgen_w7_add$x
+    movzbl	$dig(%rsp,%r8), %eax
+    shr	\$1, %eax
+    shl	\$6, %eax
+    shl	\$12, %r8
+    add	$tbl(%rsp), %r8
+    prefetcht0	-64(%r8,%rax)
+.Lgen_w7_add$x:
+___
+$code.=<<___;
+    mov	$idx(%rsp), %esi		# acc += digits[i] * row[i]
+    movzbl	$dig(%rsp,%rsi), %edx
+    shl	\$12, %rsi
+    add	$tbl(%rsp), %rsi
+    lea	$acc(%rsp), %rdi
+    call	__secp256k1_point_add_affine_lookup$x
+    incl	$idx(%rsp)
+    cmpl	\$37, $idx(%rsp)
+    jne	.Lgen_w7_loop$x
+
+    mov	$rp(%rsp), %rdi
+    movdqa	$acc+0x00(%rsp), %xmm0
+    movdqa	$acc+0x10(%rsp), %xmm1
+    movdqa	$acc+0x20(%rsp), %xmm2
+    movdqa	$acc+0x30(%rsp), %xmm3
+    movdqa	$acc+0x40(%rsp), %xmm4
+    movdqa	$acc+0x50(%rsp), %xmm5
+    movdqu	%xmm0, 0x00(%rdi)
+    movdqu	%xmm1, 0x10(%rdi)
+    movdqu	%xmm2, 0x20(%rdi)
+    movdqu	%xmm3, 0x30(%rdi)
+    movdqu	%xmm4, 0x40(%rdi)
+    movdqu	%xmm5, 0x50(%rdi)
+
+    add	\$$frame, %rsp
+    pop	%r15
+    pop	%r14
+    pop	%r13
+    pop	%r12
+    pop	%rbx
+    pop	%rbp
+    ret
+.size	secp256k1_ecmult_gen_w7$sfx,.-secp256k1_ecmult_gen_w7$sfx
+___
+}
 
-.adda_in2inf$x:
-    cmp \$0, %r14
-    je .adda_set_res$x
-    movdqu $in1_z(%rsp), %xmm0
-    movdqu $in1_z+0x10(%rsp), %xmm1
-    movdqu $in1_x(%rsp), %xmm2
-    movdqu $in1_x+0x10(%rsp), %xmm3
-    movdqu $in1_y(%rsp), %xmm4
-    movdqu $in1_y+0x10(%rsp), %xmm5
+&gen_add_affine("q");
+&gen_mul_gen("q");
 
-.adda_set_res$x:
-    movdqu %xmm0, 0x40($r_ptr)
-    movdqu %xmm1, 0x50($r_ptr)
-    movdqu %xmm2, 0x00($r_ptr)
-    movdqu %xmm3, 0x10($r_ptr)
-    movdqu %xmm4, 0x20($r_ptr)
-    movdqu %xmm5, 0x30($r_ptr)
+########################################################################
+# Exponentiation by a fixed addition chain without leaving assembly.
+# Every step is "dst = src^(2^n)" or "dst = a*b" on 32-byte slots of
+# the frame, the squarings of a step run back to back in registers.
+# The input is copied to slot "a" so that the result may alias it.
+#
+my @pow_slots = qw(a x2 x3 x6 x11 x22 x44 x88 t);
+my @pow_head = (
+    "sqr x2 a 1",	"mul x2 x2 a",		# 2^2 - 1
+    "sqr x3 x2 1",	"mul x3 x3 a",		# 2^3 - 1
+    "sqr x6 x3 3",	"mul x6 x6 x3",		# 2^6 - 1
+    "sqr t x6 3",	"mul t t x3",		# 2^9 - 1
+    "sqr x11 t 2",	"mul x11 x11 x2",	# 2^11 - 1
+    "sqr x22 x11 11",	"mul x22 x22 x11",	# 2^22 - 1
+    "sqr x44 x22 22",	"mul x44 x44 x22",	# 2^44 - 1
+    "sqr x88 x44 44",	"mul x88 x88 x44",	# 2^88 - 1
+    "sqr t x88 88",	"mul t t x88",		# 2^176 - 1
+    "sqr t t 44",	"mul t t x44",		# 2^220 - 1
+    "sqr t t 3",	"mul t t x3",		# 2^223 - 1
+    "sqr t t 23",	"mul t t x22");
+# p - 2 = 1{223} 0 1{22} 0000 1 0 11 0 1
+my @pow_inverse = (@pow_head,
+    "sqr t t 5",	"mul t t a",
+    "sqr t t 3",	"mul t t x2",
+    "sqr t t 2",	"mul res t a");
+# (p + 1)/4 = 1{223} 0 1{22} 0000 11 00
+my @pow_sqrt = (@pow_head,
+    "sqr t t 6",	"mul t t x2",
+    "sqr res t 2");
+
+sub gen_pow () {
+    my ($x,$name,@chain) = @_;
+    my ($src0,$sfx,$bias) = $x eq "x" ? ("%rdx","x",128) : ("%rax","",0);
+    my %slot = map { ($pow_slots[$_], 32*$_) } (0..$#pow_slots);
+    my $res = 32*@pow_slots;
+    my $frame = $res+8;
+    my $i = 0;
 
-    add	\$32*15+8, %rsp
+    if ($x ne "x") {
+$code.=<<___;
+.globl	$name
+.type	$name,\@function,2
+.align	32
+$name:
+___
+$code.=<<___	if ($addx);
+    mov	\$0x80100, %ecx
+    and	cpu_info+8(%rip), %ecx
+    cmp	\$0x80100, %ecx
+    je	.L${name}x
+___
+    } else {
+$code.=<<___;
+.type	${name}x,\@function,2
+.align	32
+${name}x:
+.L${name}x:
+___
+    }
+$code.=<<___;
+    push	%rbp
+    push	%rbx
+    push	%r12
+    push	%r13
+    push	%r14
+    push	%r15
+    sub	\$$frame, %rsp
+
+    movdqu	0x00($a_ptr), %xmm0
+    movdqu	0x10($a_ptr), %xmm1
+    mov	$r_ptr, $res(%rsp)
+    movdqa	%xmm0, $slot{a}(%rsp)
+    movdqa	%xmm1, $slot{a}+0x10(%rsp)
+___
+    foreach (@chain) {
+	my ($op,$dst,$a,$b) = split;
+	my $to = $dst eq "res" ? "	mov	$res(%rsp), $r_ptr"
+			       : "	lea	$slot{$dst}(%rsp), $r_ptr";
+	if ($op eq "mul") {
+$code.=<<___;
+    `&load_for_mul("$slot{$a}(%rsp)", "$slot{$b}(%rsp)", "$src0")`
+$to
+    call	__secp256k1_mul_$fe$x
+___
+	    next;
+	}
+	$i++;
+$code.=<<___;
+    `&load_for_sqr("$slot{$a}(%rsp)", "$src0")`
+$to
+    mov	\$$b, %ebx
+.L${name}_sqr$i$x:
+    call	__secp256k1_sqr_$fe$x
+    lea	-$bias($r_ptr), $a_ptr
+    mov	$acc7, $acc0
+    mov	$acc6, $acc7
+    mov	$acc5, $acc6
+    mov	$acc4, $src0
+    dec	%ebx
+    jnz	.L${name}_sqr$i$x
+___
+    }
+$code.=<<___;
+    add	\$$frame, %rsp
     pop	%r15
     pop	%r14
     pop	%r13
@@ -2576,10 +4061,11 @@ $code.=<<___;
     pop	%rbx
     pop	%rbp
     ret
-.size	secp256k1_point_add_affine$sfx,.-secp256k1_point_add_affine$sfx
+.size	$name$sfx,.-$name$sfx
 ___
 }
-&gen_add_affine("q");
+&gen_pow("q", "secp256k1_mod_inverse", @pow_inverse);
+&gen_pow("q", "secp256k1_mod_sqrt_pow", @pow_sqrt);
 
 ########################################################################
 # AD*X magic
@@ -2612,100 +4098,320 @@ __secp256k1_add_tox:
     sbb	.Lpoly+8*3(%rip), $a3
     sbb	\$0, $t4
 
-    cmovc	$t0, $a0
-    cmovc	$t1, $a1
+    cmovc	$t0, $a0
+    cmovc	$t1, $a1
+    mov	$a0, 8*0($r_ptr)
+    cmovc	$t2, $a2
+    mov	$a1, 8*1($r_ptr)
+    cmovc	$t3, $a3
+    mov	$a2, 8*2($r_ptr)
+    mov	$a3, 8*3($r_ptr)
+
+    ret
+.size	__secp256k1_add_tox,.-__secp256k1_add_tox
+
+.type	__secp256k1_sub_fromx,\@abi-omnipotent
+.align	32
+__secp256k1_sub_fromx:
+    sub	8*0($b_ptr), $a0
+    sbb	8*1($b_ptr), $a1
+    sbb	8*2($b_ptr), $a2
+    sbb	8*3($b_ptr), $a3
+    sbb	$t4, $t4
+
+    and	.Lpoly_c(%rip), $t4	# a-b+p = a-b-c mod 2^256, can't borrow
+    sub	$t4, $a0
+    sbb	\$0, $a1
+    mov	$a0, 8*0($r_ptr)
+    sbb	\$0, $a2
+    mov	$a1, 8*1($r_ptr)
+    sbb	\$0, $a3
+    mov	$a2, 8*2($r_ptr)
+    mov	$a3, 8*3($r_ptr)
+
+    ret
+.size	__secp256k1_sub_fromx,.-__secp256k1_sub_fromx
+
+.type	__secp256k1_subx,\@abi-omnipotent
+.align	32
+__secp256k1_subx:
+    sub	$a0, $t0
+    sbb	$a1, $t1
+    sbb	$a2, $t2
+    sbb	$a3, $t3
+    sbb	$t4, $t4
+
+    and	.Lpoly_c(%rip), $t4
+    sub	$t4, $t0
+    sbb	\$0, $t1
+     mov	$t0, $a0
+    sbb	\$0, $t2
+     mov	$t1, $a1
+    sbb	\$0, $t3
+     mov	$t2, $a2
+     mov	$t3, $a3
+
+    ret
+.size	__secp256k1_subx,.-__secp256k1_subx
+
+.type	__secp256k1_mul_by_2x,\@abi-omnipotent
+.align	32
+__secp256k1_mul_by_2x:
+    xor	$t4, $t4
+    adc	$a0, $a0		# a0:a3+a0:a3
+    adc	$a1, $a1
+     mov	$a0, $t0
+    adc	$a2, $a2
+    adc	$a3, $a3
+     mov	$a1, $t1
+    adc	\$0, $t4
+
+    xor	$t3, $t3
+    sub	.Lpoly+8*0(%rip), $a0
+     mov	$a2, $t2
+    sbb	.Lpoly+8*1(%rip), $a1
+    sbb	.Lpoly+8*2(%rip), $a2
+     mov	$a3, $t3
+    sbb	.Lpoly+8*3(%rip), $a3
+    sbb	\$0, $t4
+
+    cmovc	$t0, $a0
+    cmovc	$t1, $a1
+    mov	$a0, 8*0($r_ptr)
+    cmovc	$t2, $a2
+    mov	$a1, 8*1($r_ptr)
+    cmovc	$t3, $a3
+    mov	$a2, 8*2($r_ptr)
+    mov	$a3, 8*3($r_ptr)
+
+    ret
+.size	__secp256k1_mul_by_2x,.-__secp256k1_mul_by_2x
+
+.type	__secp256k1_add_to_lazyx,\@abi-omnipotent
+.align	32
+__secp256k1_add_to_lazyx:
+    add	8*0($b_ptr), $a0
+    adc	8*1($b_ptr), $a1
+    adc	8*2($b_ptr), $a2
+    adc	8*3($b_ptr), $a3
+    sbb	$t4, $t4
+
+    and	.Lpoly_c(%rip), $t4	# fold 2^256 back as c
+    add	$t4, $a0
+    adc	\$0, $a1
+    mov	$a0, 8*0($r_ptr)
+    adc	\$0, $a2
+    mov	$a1, 8*1($r_ptr)
+    adc	\$0, $a3
+    mov	$a2, 8*2($r_ptr)
+    mov	$a3, 8*3($r_ptr)
+
+    ret
+.size	__secp256k1_add_to_lazyx,.-__secp256k1_add_to_lazyx
+
+.type	__secp256k1_mul_by_2_lazyx,\@abi-omnipotent
+.align	32
+__secp256k1_mul_by_2_lazyx:
+    add	$a0, $a0		# a0:a3+a0:a3
+    adc	$a1, $a1
+    adc	$a2, $a2
+    adc	$a3, $a3
+    sbb	$t4, $t4
+
+    and	.Lpoly_c(%rip), $t4	# fold 2^256 back as c
+    add	$t4, $a0
+    adc	\$0, $a1
+    mov	$a0, 8*0($r_ptr)
+    adc	\$0, $a2
+    mov	$a1, 8*1($r_ptr)
+    adc	\$0, $a3
+    mov	$a2, 8*2($r_ptr)
+    mov	$a3, 8*3($r_ptr)
+
+    ret
+.size	__secp256k1_mul_by_2_lazyx,.-__secp256k1_mul_by_2_lazyx
+___
+                                    }
+&gen_double("x");
+&gen_add("x");
+&gen_add_affine("x");
+&gen_mul_gen("x");
+&gen_pow("x", "secp256k1_mod_inverse", @pow_inverse);
+&gen_pow("x", "secp256k1_mod_sqrt_pow", @pow_sqrt);
+}
+}}}
+{
+################################################################################
+# Scalar arithmetic modulo the group order N
+
+my ($r_ptr,$a_ptr,$b_org,$b_ptr)=("%rdi","%rsi","%rdx","%rbx");
+my ($a0,$a1,$a2,$a3)=map("%r$_",(8..11));
+my ($t0,$t1,$t2,$t3,$t4)=("%rax","%rdx","%rcx","%r12","%r13");
+
+$code.=<<___;
+
+################################################################################
+# void secp256k1_scalar_add(uint64_t res[4], uint64_t a[4], uint64_t b[4]);
+.globl	secp256k1_scalar_add
+.type	secp256k1_scalar_add,\@function,3
+.align	32
+secp256k1_scalar_add:
+    push	%r12
+    push	%r13
+
+    mov	8*0($a_ptr), $a0
+    xor	$t4, $t4
+    mov	8*1($a_ptr), $a1
+    mov	8*2($a_ptr), $a2
+    mov	8*3($a_ptr), $a3
+    lea	.Lord(%rip), $a_ptr
+
+    add	8*0($b_org), $a0
+    adc	8*1($b_org), $a1
+     mov	$a0, $t0
+    adc	8*2($b_org), $a2
+    adc	8*3($b_org), $a3
+     mov	$a1, $t1
+    adc	\$0, $t4
+
+    sub	8*0($a_ptr), $a0
+     mov	$a2, $t2
+    sbb	8*1($a_ptr), $a1
+    sbb	8*2($a_ptr), $a2
+     mov	$a3, $t3
+    sbb	8*3($a_ptr), $a3
+    sbb	\$0, $t4
+
+    cmovc	$t0, $a0
+    cmovc	$t1, $a1
+    mov	$a0, 8*0($r_ptr)
+    cmovc	$t2, $a2
+    mov	$a1, 8*1($r_ptr)
+    cmovc	$t3, $a3
+    mov	$a2, 8*2($r_ptr)
+    mov	$a3, 8*3($r_ptr)
+
+    pop %r13
+    pop %r12
+    ret
+.size	secp256k1_scalar_add,.-secp256k1_scalar_add
+
+################################################################################
+# void secp256k1_scalar_sub(uint64_t res[4], uint64_t a[4], uint64_t b[4]);
+.globl	secp256k1_scalar_sub
+.type	secp256k1_scalar_sub,\@function,3
+.align	32
+secp256k1_scalar_sub:
+    push	%r12
+    push	%r13
+
+    mov	8*0($a_ptr), $a0
+    xor	$t4, $t4
+    mov	8*1($a_ptr), $a1
+    mov	8*2($a_ptr), $a2
+    mov	8*3($a_ptr), $a3
+    lea	.Lord(%rip), $a_ptr
+
+    sub	8*0($b_org), $a0
+    sbb	8*1($b_org), $a1
+     mov	$a0, $t0
+    sbb	8*2($b_org), $a2
+    sbb	8*3($b_org), $a3
+     mov	$a1, $t1
+    sbb	\$0, $t4
+
+    add	8*0($a_ptr), $a0
+     mov	$a2, $t2
+    adc	8*1($a_ptr), $a1
+    adc	8*2($a_ptr), $a2
+     mov	$a3, $t3
+    adc	8*3($a_ptr), $a3
+    test	$t4, $t4
+
+    cmovz	$t0, $a0
+    cmovz	$t1, $a1
     mov	$a0, 8*0($r_ptr)
-    cmovc	$t2, $a2
+    cmovz	$t2, $a2
     mov	$a1, 8*1($r_ptr)
-    cmovc	$t3, $a3
+    cmovz	$t3, $a3
     mov	$a2, 8*2($r_ptr)
     mov	$a3, 8*3($r_ptr)
 
+    pop %r13
+    pop %r12
     ret
-.size	__secp256k1_add_tox,.-__secp256k1_add_tox
+.size	secp256k1_scalar_sub,.-secp256k1_scalar_sub
 
-.type	__secp256k1_sub_fromx,\@abi-omnipotent
+################################################################################
+# void secp256k1_scalar_neg(uint64_t res[4], uint64_t a[4]);
+.globl	secp256k1_scalar_neg
+.type	secp256k1_scalar_neg,\@function,2
 .align	32
-__secp256k1_sub_fromx:
+secp256k1_scalar_neg:
+    push	%r12
+    push	%r13
+
+    xor	$a0, $a0
+    xor	$a1, $a1
+    xor	$a2, $a2
+    xor	$a3, $a3
     xor	$t4, $t4
-    sbb	8*0($b_ptr), $a0
-    sbb	8*1($b_ptr), $a1
+
+    sub	8*0($a_ptr), $a0
+    sbb	8*1($a_ptr), $a1
+    sbb	8*2($a_ptr), $a2
      mov	$a0, $t0
-    sbb	8*2($b_ptr), $a2
-    sbb	8*3($b_ptr), $a3
+    sbb	8*3($a_ptr), $a3
+    lea	.Lord(%rip), $a_ptr
      mov	$a1, $t1
     sbb	\$0, $t4
 
-    xor	$t3, $t3
-    add	.Lpoly+8*0(%rip), $a0
+    add	8*0($a_ptr), $a0
      mov	$a2, $t2
-    adc	.Lpoly+8*1(%rip), $a1
-    adc	.Lpoly+8*2(%rip), $a2
+    adc	8*1($a_ptr), $a1
+    adc	8*2($a_ptr), $a2
      mov	$a3, $t3
-    adc	.Lpoly+8*3(%rip), $a3
+    adc	8*3($a_ptr), $a3
+    test	$t4, $t4
 
-    bt	\$0, $t4
-    cmovnc	$t0, $a0
-    cmovnc	$t1, $a1
+    cmovz	$t0, $a0
+    cmovz	$t1, $a1
     mov	$a0, 8*0($r_ptr)
-    cmovnc	$t2, $a2
+    cmovz	$t2, $a2
     mov	$a1, 8*1($r_ptr)
-    cmovnc	$t3, $a3
+    cmovz	$t3, $a3
     mov	$a2, 8*2($r_ptr)
     mov	$a3, 8*3($r_ptr)
 
+    pop %r13
+    pop %r12
     ret
-.size	__secp256k1_sub_fromx,.-__secp256k1_sub_fromx
+.size	secp256k1_scalar_neg,.-secp256k1_scalar_neg
 
-.type	__secp256k1_subx,\@abi-omnipotent
+################################################################################
+# void secp256k1_scalar_reduce(uint64_t res[4], uint64_t a[4]);
+# a < 2^256 < 2N, so one conditional subtraction is enough
+.globl	secp256k1_scalar_reduce
+.type	secp256k1_scalar_reduce,\@function,2
 .align	32
-__secp256k1_subx:
-    xor	$t4, $t4
-    sbb	$a0, $t0
-    sbb	$a1, $t1
-     mov	$t0, $a0
-    sbb	$a2, $t2
-    sbb	$a3, $t3
-     mov	$t1, $a1
-    sbb	\$0, $t4
-
-    xor	$a3 ,$a3
-    add	.Lpoly+8*0(%rip), $t0
-     mov	$t2, $a2
-    adc	.Lpoly+8*1(%rip), $t1
-    adc	.Lpoly+8*2(%rip), $t2
-     mov	$t3, $a3
-    adc	.Lpoly+8*3(%rip), $t3
-
-    bt	\$0, $t4
-    cmovc	$t0, $a0
-    cmovc	$t1, $a1
-    cmovc	$t2, $a2
-    cmovc	$t3, $a3
+secp256k1_scalar_reduce:
+    push	%r12
+    push	%r13
 
-    ret
-.size	__secp256k1_subx,.-__secp256k1_subx
+    mov	8*0($a_ptr), $a0
+    mov	8*1($a_ptr), $a1
+    mov	8*2($a_ptr), $a2
+    mov	8*3($a_ptr), $a3
+    lea	.Lord(%rip), $a_ptr
 
-.type	__secp256k1_mul_by_2x,\@abi-omnipotent
-.align	32
-__secp256k1_mul_by_2x:
-    xor	$t4, $t4
-    adc	$a0, $a0		# a0:a3+a0:a3
-    adc	$a1, $a1
      mov	$a0, $t0
-    adc	$a2, $a2
-    adc	$a3, $a3
+    sub	8*0($a_ptr), $a0
      mov	$a1, $t1
-    adc	\$0, $t4
-
-    xor	$t3, $t3
-    sub	.Lpoly+8*0(%rip), $a0
+    sbb	8*1($a_ptr), $a1
      mov	$a2, $t2
-    sbb	.Lpoly+8*1(%rip), $a1
-    sbb	.Lpoly+8*2(%rip), $a2
+    sbb	8*2($a_ptr), $a2
      mov	$a3, $t3
-    sbb	.Lpoly+8*3(%rip), $a3
-    sbb	\$0, $t4
+    sbb	8*3($a_ptr), $a3
 
     cmovc	$t0, $a0
     cmovc	$t1, $a1
@@ -2716,15 +4422,455 @@ __secp256k1_mul_by_2x:
     mov	$a2, 8*2($r_ptr)
     mov	$a3, 8*3($r_ptr)
 
+    pop %r13
+    pop %r12
     ret
-.size	__secp256k1_mul_by_2x,.-__secp256k1_mul_by_2x
+.size	secp256k1_scalar_reduce,.-secp256k1_scalar_reduce
 ___
-                                    }
-&gen_double("x");
-&gen_add("x");
-&gen_add_affine("x");
 }
-}}}
+{
+# Montgomery multiplication modulo N. N has no special form in the low
+# limbs, so the 512-bit product (or square) is computed first, then the
+# low half is Montgomery reduced in place and the high half is added,
+# a*b < N^2 gives a result below 2N.
+
+my ($r_ptr,$a_ptr,$b_org,$b_ptr)=("%rdi","%rsi","%rdx","%rbx");
+my @t=map("%r$_",(8..15));
+my ($m,$c)=("%rcx","%rbp");
+
+# t = a * b[i], row i of the schoolbook product
+sub ord_mul_row () {
+my ($x,$i)=@_;
+my $code;
+    if ($x eq "") {
+        $code.="    mov	8*$i($b_ptr), $m\n";
+        for (my $j=0; $j<4; $j++) {
+            my $k=$i+$j;
+            $code.="    mov	8*$j($a_ptr), %rax\n";
+            $code.="    mulq	$m\n";
+            if ($i==0) {
+                if ($j==0) {
+                    $code.="    mov	%rax, $t[0]\n";
+                } else {
+                    $code.="    add	%rax, $t[$k]\n";
+                    $code.="    adc	\$0, %rdx\n";
+                }
+                $code.="    mov	%rdx, $t[$k+1]\n";
+            } else {
+                if ($j>0) {
+                    $code.="    add	$c, %rax\n";
+                    $code.="    adc	\$0, %rdx\n";
+                }
+                $code.="    add	%rax, $t[$k]\n";
+                $code.="    adc	\$0, %rdx\n";
+                $code.="    mov	%rdx, $c\n";
+            }
+        }
+        $code.="    mov	$c, $t[$i+4]\n" if ($i>0);
+    } else {
+        $code.="    mov	8*$i($b_ptr), %rdx\n";
+        if ($i==0) {
+            $code.=<<___;
+    mulx	8*0($a_ptr), $t[0], $t[1]
+    mulx	8*1($a_ptr), %rax, $t[2]
+    add	%rax, $t[1]
+    mulx	8*2($a_ptr), %rax, $t[3]
+    adc	%rax, $t[2]
+    mulx	8*3($a_ptr), %rax, $t[4]
+    adc	%rax, $t[3]
+    adc	\$0, $t[4]
+___
+        } else {
+            $code.="    xor	$t[$i+4], $t[$i+4]\n";
+            for (my $j=0; $j<4; $j++) {
+                my $k=$i+$j;
+                $code.="    mulx	8*$j($a_ptr), %rax, $c\n";
+                $code.="    adcx	%rax, $t[$k]\n";
+                $code.="    adox	$c, $t[$k+1]\n";
+            }
+            $code.="    mov	\$0, %eax\n";
+            $code.="    adcx	%rax, $t[$i+4]\n";
+        }
+    }
+    return $code;
+}
+
+# t = a^2, off-diagonal products are doubled and the squares added
+sub ord_sqr_body () {
+my $x=shift;
+my $code;
+    if ($x eq "") {
+        $code.=<<___;
+    mov	8*0($a_ptr), $m
+    mov	8*1($a_ptr), %rax
+    mulq	$m
+    mov	%rax, $t[1]
+    mov	%rdx, $t[2]
+    mov	8*2($a_ptr), %rax
+    mulq	$m
+    add	%rax, $t[2]
+    adc	\$0, %rdx
+    mov	%rdx, $t[3]
+    mov	8*3($a_ptr), %rax
+    mulq	$m
+    add	%rax, $t[3]
+    adc	\$0, %rdx
+    mov	%rdx, $t[4]
+
+    mov	8*1($a_ptr), $m
+    mov	8*2($a_ptr), %rax
+    mulq	$m
+    add	%rax, $t[3]
+    adc	\$0, %rdx
+    mov	%rdx, $c
+    mov	8*3($a_ptr), %rax
+    mulq	$m
+    add	$c, %rax
+    adc	\$0, %rdx
+    add	%rax, $t[4]
+    adc	\$0, %rdx
+    mov	%rdx, $t[5]
+
+    mov	8*2($a_ptr), %rax
+    mulq	8*3($a_ptr)
+    add	%rax, $t[5]
+    adc	\$0, %rdx
+    mov	%rdx, $t[6]
+
+    xor	$t[7], $t[7]
+    add	$t[1], $t[1]
+    adc	$t[2], $t[2]
+    adc	$t[3], $t[3]
+    adc	$t[4], $t[4]
+    adc	$t[5], $t[5]
+    adc	$t[6], $t[6]
+    adc	\$0, $t[7]
+
+    mov	8*0($a_ptr), %rax
+    mulq	%rax
+    mov	%rax, $t[0]
+    mov	%rdx, $c
+    mov	8*1($a_ptr), %rax
+    mulq	%rax
+    add	$c, $t[1]
+    adc	%rax, $t[2]
+    adc	\$0, %rdx
+    mov	%rdx, $c
+    mov	8*2($a_ptr), %rax
+    mulq	%rax
+    add	$c, $t[3]
+    adc	%rax, $t[4]
+    adc	\$0, %rdx
+    mov	%rdx, $c
+    mov	8*3($a_ptr), %rax
+    mulq	%rax
+    add	$c, $t[5]
+    adc	%rax, $t[6]
+    adc	%rdx, $t[7]
+___
+    } else {
+        $code.=<<___;
+    mov	8*0($a_ptr), %rdx
+    mulx	8*1($a_ptr), $t[1], $t[2]
+    mulx	8*2($a_ptr), %rax, $t[3]
+    add	%rax, $t[2]
+    mulx	8*3($a_ptr), %rax, $t[4]
+    adc	%rax, $t[3]
+    adc	\$0, $t[4]
+
+    mov	8*1($a_ptr), %rdx
+    xor	$t[5], $t[5]
+    mulx	8*2($a_ptr), %rax, $c
+    adcx	%rax, $t[3]
+    adox	$c, $t[4]
+    mulx	8*3($a_ptr), %rax, $c
+    adcx	%rax, $t[4]
+    adox	$c, $t[5]
+    mov	\$0, %eax
+    adcx	%rax, $t[5]
+
+    mov	8*2($a_ptr), %rdx
+    mulx	8*3($a_ptr), %rax, $t[6]
+    add	%rax, $t[5]
+    adc	\$0, $t[6]
+
+    xor	$t[7], $t[7]
+    add	$t[1], $t[1]
+    adc	$t[2], $t[2]
+    adc	$t[3], $t[3]
+    adc	$t[4], $t[4]
+    adc	$t[5], $t[5]
+    adc	$t[6], $t[6]
+    adc	\$0, $t[7]
+
+    mov	8*0($a_ptr), %rdx
+    mulx	%rdx, $t[0], $c
+    mov	8*1($a_ptr), %rdx
+    mulx	%rdx, %rax, $m
+    add	$c, $t[1]
+    adc	%rax, $t[2]
+    adc	$m, $t[3]
+    mov	8*2($a_ptr), %rdx
+    mulx	%rdx, %rax, $m
+    adc	%rax, $t[4]
+    adc	$m, $t[5]
+    mov	8*3($a_ptr), %rdx
+    mulx	%rdx, %rax, $m
+    adc	%rax, $t[6]
+    adc	$m, $t[7]
+___
+    }
+    return $code;
+}
+
+# Montgomery reduce t[0..3], add t[4..7], subtract N if needed, store to r_ptr
+sub ord_reduce () {
+my $x=shift;
+my $code;
+my @u=@t[0..3];
+    for (my $i=0; $i<4; $i++) {
+        $code.="    ###### reduction round $i\n";
+        if ($x eq "") {
+            $code.=<<___;
+    mov	$u[0], $m
+    imulq	.LordK(%rip), $m
+    mov	.Lord+8*0(%rip), %rax
+    mulq	$m
+    add	$u[0], %rax
+    adc	\$0, %rdx
+    mov	%rdx, $c
+___
+            for (my $j=1; $j<4; $j++) {
+                $code.=<<___;
+    mov	.Lord+8*$j(%rip), %rax
+    mulq	$m
+    add	$c, %rax
+    adc	\$0, %rdx
+    add	%rax, $u[$j]
+    adc	\$0, %rdx
+    mov	%rdx, $c
+___
+            }
+            $code.="    mov	$c, $u[0]\n";
+        } else {
+            $code.=<<___;
+    mov	$u[0], %rdx
+    imulq	.LordK(%rip), %rdx
+    xor	%eax, %eax
+    mulx	.Lord+8*0(%rip), %rax, $c
+    adcx	$u[0], %rax
+    adox	$c, $u[1]
+    mulx	.Lord+8*1(%rip), %rax, $c
+    adcx	%rax, $u[1]
+    adox	$c, $u[2]
+    mulx	.Lord+8*2(%rip), %rax, $c
+    adcx	%rax, $u[2]
+    adox	$c, $u[3]
+    mulx	.Lord+8*3(%rip), %rax, $u[0]
+    adcx	%rax, $u[3]
+    mov	\$0, %eax
+    adox	%rax, $u[0]
+    adcx	%rax, $u[0]
+___
+        }
+        push(@u,shift(@u));
+    }
+    $code.=<<___;
+    ###### add the high half, result < 2N
+    xor	$c, $c
+    add	$t[4], $t[0]
+    adc	$t[5], $t[1]
+    adc	$t[6], $t[2]
+    adc	$t[7], $t[3]
+    adc	\$0, $c
+
+    mov	$t[0], $t[4]
+    mov	$t[1], $t[5]
+    mov	$t[2], $t[6]
+    mov	$t[3], $t[7]
+    sub	.Lord+8*0(%rip), $t[0]
+    sbb	.Lord+8*1(%rip), $t[1]
+    sbb	.Lord+8*2(%rip), $t[2]
+    sbb	.Lord+8*3(%rip), $t[3]
+    sbb	\$0, $c
+
+    cmovc	$t[4], $t[0]
+    cmovc	$t[5], $t[1]
+    mov	$t[0], 8*0($r_ptr)
+    cmovc	$t[6], $t[2]
+    mov	$t[1], 8*1($r_ptr)
+    cmovc	$t[7], $t[3]
+    mov	$t[2], 8*2($r_ptr)
+    mov	$t[3], 8*3($r_ptr)
+___
+    return $code;
+}
+
+$code.=<<___;
+
+################################################################################
+# void secp256k1_scalar_to_mont(
+#   uint64_t res[4],
+#   uint64_t in[4]);
+.globl	secp256k1_scalar_to_mont
+.type	secp256k1_scalar_to_mont,\@function,2
+.align	32
+secp256k1_scalar_to_mont:
+    lea	.LRR_ord(%rip), $b_org
+    jmp	.Lord_mul_mont
+.size	secp256k1_scalar_to_mont,.-secp256k1_scalar_to_mont
+
+################################################################################
+# void secp256k1_scalar_from_mont(
+#   uint64_t res[4],
+#   uint64_t in[4]);
+.globl	secp256k1_scalar_from_mont
+.type	secp256k1_scalar_from_mont,\@function,2
+.align	32
+secp256k1_scalar_from_mont:
+    lea	.Lord_one(%rip), $b_org
+    jmp	.Lord_mul_mont
+.size	secp256k1_scalar_from_mont,.-secp256k1_scalar_from_mont
+
+################################################################################
+# void secp256k1_scalar_mul_mont(
+#   uint64_t res[4],
+#   uint64_t a[4],
+#   uint64_t b[4]);
+.globl	secp256k1_scalar_mul_mont
+.type	secp256k1_scalar_mul_mont,\@function,3
+.align	32
+secp256k1_scalar_mul_mont:
+.Lord_mul_mont:
+___
+$code.=<<___	if ($addx);
+    mov	\$0x80100, %ecx
+    and	cpu_info+8(%rip), %ecx
+___
+$code.=<<___;
+    push	%rbp
+    push	%rbx
+    push	%r12
+    push	%r13
+    push	%r14
+    push	%r15
+
+    mov	$b_org, $b_ptr
+___
+$code.=<<___	if ($addx);
+    cmp	\$0x80100, %ecx
+    je	.Lord_mul_montx
+___
+$code.=<<___;
+    call	__secp256k1_ord_mul_montq
+___
+$code.=<<___	if ($addx);
+    jmp	.Lord_mul_mont_done
+
+.align	32
+.Lord_mul_montx:
+    call	__secp256k1_ord_mul_montx
+___
+$code.=<<___;
+.Lord_mul_mont_done:
+    pop	%r15
+    pop	%r14
+    pop	%r13
+    pop	%r12
+    pop	%rbx
+    pop	%rbp
+    ret
+.size	secp256k1_scalar_mul_mont,.-secp256k1_scalar_mul_mont
+
+################################################################################
+# void secp256k1_scalar_sqr_mont(
+#   uint64_t res[4],
+#   uint64_t a[4],
+#   int rep);
+# res = a^(2^rep) in Montgomery domain, rep >= 1
+.globl	secp256k1_scalar_sqr_mont
+.type	secp256k1_scalar_sqr_mont,\@function,3
+.align	32
+secp256k1_scalar_sqr_mont:
+___
+$code.=<<___	if ($addx);
+    mov	\$0x80100, %ecx
+    and	cpu_info+8(%rip), %ecx
+___
+$code.=<<___;
+    push	%rbp
+    push	%rbx
+    push	%r12
+    push	%r13
+    push	%r14
+    push	%r15
+
+    mov	%edx, %ebx
+___
+$code.=<<___	if ($addx);
+    cmp	\$0x80100, %ecx
+    je	.Lord_sqr_montx
+___
+$code.=<<___;
+.Lord_sqr_loopq:
+    call	__secp256k1_ord_sqr_montq
+    mov	$r_ptr, $a_ptr
+    dec	%ebx
+    jnz	.Lord_sqr_loopq
+___
+$code.=<<___	if ($addx);
+    jmp	.Lord_sqr_mont_done
+
+.align	32
+.Lord_sqr_montx:
+.Lord_sqr_loopx:
+    call	__secp256k1_ord_sqr_montx
+    mov	$r_ptr, $a_ptr
+    dec	%ebx
+    jnz	.Lord_sqr_loopx
+___
+$code.=<<___;
+.Lord_sqr_mont_done:
+    pop	%r15
+    pop	%r14
+    pop	%r13
+    pop	%r12
+    pop	%rbx
+    pop	%rbp
+    ret
+.size	secp256k1_scalar_sqr_mont,.-secp256k1_scalar_sqr_mont
+___
+
+for my $x ("", "x") {
+    next if ($x eq "x" && !$addx);
+    my $sfx = $x eq "" ? "q" : "x";
+    $code.=<<___;
+
+.type	__secp256k1_ord_mul_mont$sfx,\@abi-omnipotent
+.align	32
+__secp256k1_ord_mul_mont$sfx:
+___
+    for (my $i=0; $i<4; $i++) {
+        $code.="    ###### a * b[$i]\n";
+        $code.=&ord_mul_row($x,$i);
+    }
+    $code.=&ord_reduce($x);
+    $code.=<<___;
+    ret
+.size	__secp256k1_ord_mul_mont$sfx,.-__secp256k1_ord_mul_mont$sfx
+
+.type	__secp256k1_ord_sqr_mont$sfx,\@abi-omnipotent
+.align	32
+__secp256k1_ord_sqr_mont$sfx:
+___
+    $code.=&ord_sqr_body($x);
+    $code.=&ord_reduce($x);
+    $code.=<<___;
+    ret
+.size	__secp256k1_ord_sqr_mont$sfx,.-__secp256k1_ord_sqr_mont$sfx
+___
+}
+}
 
 $code =~ s/\`([^\`]*)\`/eval $1/gem;
 print $code;
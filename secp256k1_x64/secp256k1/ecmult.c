@@ -0,0 +1,495 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright 2020 Meng-Shan Jiang                                             *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License");            *
+ * you may not use this file except in compliance with the License.           *
+ * You may obtain a copy of the License at                                    *
+ *                                                                            *
+ *    http://www.apache.org/licenses/LICENSE-2.0                              *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ *                                                                            *
+ *****************************************************************************/
+
+#include <string.h>
+#include <secp256k1_x64/fp256.h>
+#include <secp256k1_x64/secp256k1.h>
+#include "secp256k1_lcl.h"
+#include "field_lcl.h"
+
+/* wNAF window of the variable point, 8 odd multiples */
+#define WNAF_WINDOW         5
+#define WNAF_TABLE_SIZE     (1 << (WNAF_WINDOW - 2))
+/* largest window of secp256k1_scalar_mul_point_var */
+#define WNAF_MAX_WINDOW     8
+#define WNAF_MAX_TABLE_SIZE (1 << (WNAF_MAX_WINDOW - 2))
+
+/* points per Strauss chunk, bounds the scratch memory */
+#define STRAUSS_MAX_POINTS  128
+/* Pippenger from this many points on, Strauss below */
+#define PIPPENGER_MIN_POINTS    256
+/* largest bucket window, 2^(c-1) buckets */
+#define PIPPENGER_MAX_WINDOW    14
+
+/* a += b, for the last generator window where a = b can happen mod n, the
+ * GLV ladder where the two halves can meet, and sums over several points
+ * where inputs may repeat or cancel
+ */
+static void point_add_affine_var(POINT256 *a, const POINT256_AFFINE *b)
+{
+    BN_ULONG z2[P256_LIMBS], t[P256_LIMBS];
+
+    if (!secp256k1_point_is_at_infinity(a) && !fp256_is_zero(b->X)) {
+        secp256k1_fe_sqr(z2, a->Z);
+        secp256k1_fe_mul(t, b->X, z2);
+        if (fp256_cmp(t, a->X) == 0) {
+            secp256k1_fe_mul(z2, z2, a->Z);
+            secp256k1_fe_mul(t, b->Y, z2);
+            if (fp256_cmp(t, a->Y) == 0)
+                secp256k1_point_dbl(a, a);
+            else
+                fp256_set_word(a->Z, 0);
+            return;
+        }
+    }
+
+    secp256k1_point_add_affine(a, a, b);
+}
+
+/* Booth w7 digits of the generator scalar, one per precomputed row */
+void secp256k1_booth_w7_digits(unsigned int digits[37], const BN_ULONG scalar[P256_LIMBS])
+{
+    int i;
+    unsigned char p_str[33] = { 0 };
+    unsigned int idx = 0;
+    const unsigned int window_size = 7;
+    const unsigned int mask = (1 << (window_size + 1)) - 1;
+    unsigned int wvalue;
+
+    for (i = 0; i < 32; i += 8) {
+        BN_ULONG d = scalar[i / 8];
+
+        p_str[i + 0] = (unsigned char)d;
+        p_str[i + 1] = (unsigned char)(d >> 8);
+        p_str[i + 2] = (unsigned char)(d >> 16);
+        p_str[i + 3] = (unsigned char)(d >>= 24);
+        d >>= 8;
+        p_str[i + 4] = (unsigned char)d;
+        p_str[i + 5] = (unsigned char)(d >> 8);
+        p_str[i + 6] = (unsigned char)(d >> 16);
+        p_str[i + 7] = (unsigned char)(d >> 24);
+    }
+    p_str[32] = 0;
+
+    /* First window */
+    wvalue = (p_str[0] << 1) & mask;
+    idx += window_size;
+    digits[0] = _booth_recode_w7(wvalue);
+
+    for (i = 1; i < 37; i++) {
+        unsigned int off = (idx - 1) / 8;
+        wvalue = p_str[off] | p_str[off + 1] << 8;
+        wvalue = (wvalue >> ((idx - 1) % 8)) & mask;
+        idx += window_size;
+        digits[i] = _booth_recode_w7(wvalue);
+    }
+}
+
+/* r = u*G with the w7 generator table, rows need no doublings in between */
+static void ecmult_gen_var(POINT256 *r, const BN_ULONG u[P256_LIMBS])
+{
+    POINT256_AFFINE t;
+    unsigned int digits[37];
+    int j;
+
+    secp256k1_booth_w7_digits(digits, u);
+    memset(r, 0, sizeof(POINT256));
+
+    for (j = 0; j < 36; j++) {
+        if (digits[j] > 1)
+            secp256k1_point_add_affine_lookup(r, secp256k1_precomp[j], digits[j]);
+    }
+
+    if (digits[36] > 1) {
+        t = secp256k1_precomp[36][(digits[36] >> 1) - 1];
+        if (digits[36] & 1)
+            secp256k1_neg(t.Y, t.Y);
+        point_add_affine_var(r, &t);
+    }
+}
+
+/* r = k*Q with k = k1 + k2*lambda, both halves in width-w NAF over one
+ * affine table of odd multiples of Q and its image under lambda, about
+ * 130 doublings. k < N.
+ */
+static void ecmult_glv_wnaf_var(POINT256 *r, const BN_ULONG k[P256_LIMBS],
+                                const POINT256 *Q, int w)
+{
+    POINT256_AFFINE table[2][WNAF_MAX_TABLE_SIZE];
+    POINT256 scratch[WNAF_MAX_TABLE_SIZE];
+    POINT256_AFFINE t;
+    BN_ULONG k12[2][P256_LIMBS];
+    int wnaf[2][257];
+    int neg[2];
+    int i, j, d, top = -1;
+    int n = 1 << (w - 2);
+
+    memset(r, 0, sizeof(POINT256));
+    if (fp256_is_zero(k) || secp256k1_point_is_at_infinity(Q))
+        return;
+
+    secp256k1_scalar_split_lambda(k12[0], k12[1], k);
+
+    /* table[1][i] = lambda*table[0][i], one field mul per entry, table[1]
+     * is the inversion scratch until then
+     */
+    secp256k1_odd_multiples_affine(table[0], Q, n, scratch, (BN_ULONG (*)[P256_LIMBS])table[1]);
+    for (i = 0; i < n; i++) {
+        secp256k1_fe_mul(table[1][i].X, table[0][i].X, secp256k1_beta);
+        fp256_copy(table[1][i].Y, table[0][i].Y);
+    }
+
+    for (j = 0; j < 2; j++) {
+        /* negative halves flip the sign of their digits */
+        neg[j] = (k12[j][2] | k12[j][3]) != 0;
+        if (neg[j])
+            secp256k1_scalar_neg(k12[j], k12[j]);
+
+        secp256k1_wnaf(wnaf[j], k12[j], w);
+        for (i = 256; i > top; i--) {
+            if (wnaf[j][i] != 0) {
+                top = i;
+                break;
+            }
+        }
+    }
+
+    for (i = top; i >= 0; i--) {
+        if (i != top)
+            secp256k1_point_dbl(r, r);
+
+        for (j = 0; j < 2; j++) {
+            d = wnaf[j][i];
+            if (d == 0)
+                continue;
+
+            t = table[j][(d < 0 ? -d : d) >> 1];
+            if ((d < 0) ^ neg[j])
+                secp256k1_neg(t.Y, t.Y);
+            /* the two halves meet in r, r = +-t is possible */
+            point_add_affine_var(r, &t);
+        }
+    }
+}
+
+/* r = u1*G + u2*Q, u2*Q with GLV + wNAF, u1*G from the generator table */
+void secp256k1_scalar_mul_double_var(POINT256 *r, const BN_ULONG u1[P256_LIMBS],
+                                     const BN_ULONG u2[P256_LIMBS], const POINT256 *Q)
+{
+    POINT256 accq, accg;
+
+    ecmult_glv_wnaf_var(&accq, u2, Q, WNAF_WINDOW);
+    ecmult_gen_var(&accg, u1);
+    secp256k1_point_add(r, &accq, &accg);
+}
+
+int secp256k1_scalar_mul_point_var(POINT256 *r, const BN_ULONG scalar[P256_LIMBS],
+                                   const POINT256 *point, int w)
+{
+    BN_ULONG s[P256_LIMBS];
+
+    if (r == NULL || scalar == NULL || point == NULL)
+        return CRYPTO_ERR;
+
+    if (w == 0)
+        w = WNAF_WINDOW;
+    if (w < 2 || w > WNAF_MAX_WINDOW)
+        return CRYPTO_ERR;
+
+    /* s = scalar mod n */
+    secp256k1_scalar_reduce(s, scalar);
+    ecmult_glv_wnaf_var(r, s, point, w);
+
+    return CRYPTO_OK;
+}
+
+/* Strauss: every point gets its own wNAF table, all tables share one
+ * chain of doublings. Tables of a chunk are made affine with a single
+ * inversion.
+ */
+typedef struct {
+    POINT256 *jac;
+    POINT256_AFFINE *aff;
+    BN_ULONG (*zs)[P256_LIMBS];
+    int (*wnaf)[257];
+} STRAUSS_SCRATCH;
+
+static void strauss_chunk(POINT256 *r, const BN_ULONG (*scalars)[P256_LIMBS],
+                          const POINT256 *points, size_t n, STRAUSS_SCRATCH *s)
+{
+    POINT256 d;
+    POINT256_AFFINE t;
+    size_t i, k, m = n * WNAF_TABLE_SIZE;
+    int j, top = -1, started = 0, digit;
+
+    /* odd multiples in jacobian coordinate */
+    for (i = 0; i < n; i++) {
+        POINT256 *tab = s->jac + i * WNAF_TABLE_SIZE;
+
+        tab[0] = points[i];
+        secp256k1_point_dbl(&d, &points[i]);
+        for (k = 1; k < WNAF_TABLE_SIZE; k++)
+            secp256k1_point_add(&tab[k], &tab[k - 1], &d);
+    }
+
+    /* one inversion for the whole chunk, infinity becomes (0, 0) */
+    secp256k1_point_to_affine_mont_batch(s->aff, s->jac, m, s->zs);
+
+    for (i = 0; i < n; i++) {
+        secp256k1_wnaf(s->wnaf[i], scalars[i], WNAF_WINDOW);
+        for (j = 256; j > top; j--) {
+            if (s->wnaf[i][j] != 0) {
+                top = j;
+                break;
+            }
+        }
+    }
+
+    memset(r, 0, sizeof(POINT256));
+
+    for (j = top; j >= 0; j--) {
+        if (started)
+            secp256k1_point_dbl(r, r);
+
+        for (i = 0; i < n; i++) {
+            digit = s->wnaf[i][j];
+            if (digit == 0)
+                continue;
+
+            t = s->aff[i * WNAF_TABLE_SIZE + ((digit < 0 ? -digit : digit) >> 1)];
+            if (digit < 0)
+                secp256k1_neg(t.Y, t.Y);
+            /* repeated or opposite input points meet here */
+            point_add_affine_var(r, &t);
+            started = 1;
+        }
+    }
+}
+
+static size_t strauss_scratch_size(size_t n)
+{
+    size_t chunk = n < STRAUSS_MAX_POINTS ? n : STRAUSS_MAX_POINTS;
+
+    return chunk * (WNAF_TABLE_SIZE * (sizeof(POINT256) + sizeof(POINT256_AFFINE) +
+                                       P256_LIMBS * sizeof(BN_ULONG)) +
+                    257 * sizeof(int));
+}
+
+static void strauss_var(POINT256 *r, const BN_ULONG (*scalars)[P256_LIMBS],
+                        const POINT256 *points, size_t n, unsigned char *buf)
+{
+    STRAUSS_SCRATCH s;
+    POINT256 acc;
+    size_t i, chunk, m;
+
+    chunk = n < STRAUSS_MAX_POINTS ? n : STRAUSS_MAX_POINTS;
+    m = chunk * WNAF_TABLE_SIZE;
+
+    s.jac = (POINT256*)buf;
+    s.aff = (POINT256_AFFINE*)(s.jac + m);
+    s.zs = (BN_ULONG (*)[P256_LIMBS])(s.aff + m);
+    s.wnaf = (int (*)[257])(s.zs + m);
+
+    for (i = 0; i < n; i += chunk) {
+        if (chunk > n - i)
+            chunk = n - i;
+        strauss_chunk(&acc, scalars + i, points + i, chunk, &s);
+        secp256k1_point_add(r, r, &acc);
+    }
+}
+
+/* Pippenger(bucket method): both GLV halves of every scalar are cut into
+ * signed c-bit digits, for each window the points are dropped into 2^(c-1)
+ * buckets with mixed additions and the buckets are summed with a running sum.
+ */
+typedef struct {
+    POINT256_AFFINE *aff;
+    BN_ULONG (*k)[2];
+    BN_ULONG (*zs)[P256_LIMBS];
+    POINT256 *buckets;
+} PIPPENGER_SCRATCH;
+
+/* windows needed for c-bit signed digits of a 128-bit scalar */
+#define PIPPENGER_WINDOWS(c)    ((129 + (c) - 1) / (c))
+
+/* window minimizing windows * (additions + bucket sums), 2m points */
+static int pippenger_window(size_t n)
+{
+    size_t cost, best = (size_t)-1;
+    int c, best_c = 2;
+
+    for (c = 2; c <= PIPPENGER_MAX_WINDOW; c++) {
+        cost = PIPPENGER_WINDOWS(c) * (2 * n + ((size_t)1 << c));
+        if (cost < best) {
+            best = cost;
+            best_c = c;
+        }
+    }
+
+    return best_c;
+}
+
+static size_t pippenger_scratch_size(size_t n)
+{
+    return 2 * n * (sizeof(POINT256_AFFINE) + 2 * sizeof(BN_ULONG)) +
+           n * P256_LIMBS * sizeof(BN_ULONG) +
+           ((size_t)1 << (pippenger_window(n) - 1)) * sizeof(POINT256);
+}
+
+/* signed digit of window w, bits [w*c - 1, w*c + c - 1] Booth recoded */
+static int pippenger_digit(const BN_ULONG k[2], int w, int c)
+{
+    int pos = w * c - 1, len = c + 1, off;
+    BN_ULONG v;
+
+    if (pos < 0) {
+        pos = 0;
+        len = c;
+    }
+
+    off = pos & 63;
+    v = (pos < 128) ? k[pos >> 6] >> off : 0;
+    if (off + len > 64 && pos < 64)
+        v |= k[1] << (64 - off);
+    v &= ((BN_ULONG)1 << len) - 1;
+    if (w == 0)
+        v <<= 1;
+
+    return (int)(v >> 1) + (int)(v & 1) - (int)((v >> c) << c);
+}
+
+static void pippenger_var(POINT256 *r, const BN_ULONG (*scalars)[P256_LIMBS],
+                          const POINT256 *points, size_t n, unsigned char *buf)
+{
+    PIPPENGER_SCRATCH s;
+    POINT256_AFFINE t;
+    POINT256 acc, sum, total;
+    BN_ULONG k[2][P256_LIMBS];
+    size_t i, m = 2 * n;
+    int c, w, windows, nb, b, d, j;
+
+    c = pippenger_window(n);
+    windows = PIPPENGER_WINDOWS(c);
+    nb = 1 << (c - 1);
+
+    s.aff = (POINT256_AFFINE*)buf;
+    s.k = (BN_ULONG (*)[2])(s.aff + m);
+    s.zs = (BN_ULONG (*)[P256_LIMBS])(s.k + m);
+    s.buckets = (POINT256*)(s.zs + n);
+
+    /* points to affine in aff[0 .. n-1] with one inversion, infinity
+     * becomes (0, 0)
+     */
+    secp256k1_point_to_affine_mont_batch(s.aff, points, n, s.zs);
+
+    /* point i moves to aff[2i], walking down reads aff[i] before it is
+     * overwritten
+     */
+    for (i = n; i-- > 0;) {
+        POINT256_AFFINE *a = &s.aff[2 * i];
+
+        t = s.aff[i];
+        a[0] = t;
+
+        /* a[1] = lambda*a[0] */
+        secp256k1_fe_mul(a[1].X, a[0].X, secp256k1_beta);
+        fp256_copy(a[1].Y, a[0].Y);
+
+        secp256k1_scalar_reduce(k[0], scalars[i]);
+        if (secp256k1_point_is_at_infinity(&points[i]))
+            fp256_set_word(k[0], 0);
+        secp256k1_scalar_split_lambda(k[0], k[1], k[0]);
+
+        /* negative halves negate their point */
+        for (j = 0; j < 2; j++) {
+            if (k[j][2] | k[j][3]) {
+                secp256k1_scalar_neg(k[j], k[j]);
+                secp256k1_neg(a[j].Y, a[j].Y);
+            }
+            s.k[2 * i + j][0] = k[j][0];
+            s.k[2 * i + j][1] = k[j][1];
+        }
+    }
+
+    memset(&acc, 0, sizeof(POINT256));
+
+    for (w = windows - 1; w >= 0; w--) {
+        secp256k1_point_dbl_n(&acc, &acc, c);
+
+        memset(s.buckets, 0, nb * sizeof(POINT256));
+        for (i = 0; i < m; i++) {
+            d = pippenger_digit(s.k[i], w, c);
+            if (d == 0)
+                continue;
+
+            t = s.aff[i];
+            if (d < 0)
+                secp256k1_neg(t.Y, t.Y);
+            /* the same point can land in the same bucket twice */
+            point_add_affine_var(&s.buckets[(d < 0 ? -d : d) - 1], &t);
+        }
+
+        /* sum(b * bucket[b - 1]) */
+        memset(&sum, 0, sizeof(POINT256));
+        memset(&total, 0, sizeof(POINT256));
+        for (b = nb - 1; b >= 0; b--) {
+            secp256k1_point_add(&sum, &sum, &s.buckets[b]);
+            secp256k1_point_add(&total, &total, &sum);
+        }
+        secp256k1_point_add(&acc, &acc, &total);
+    }
+
+    secp256k1_point_add(r, r, &acc);
+}
+
+size_t secp256k1_multi_scalar_mul_scratch_size(size_t n)
+{
+    if (n < PIPPENGER_MIN_POINTS)
+        return strauss_scratch_size(n);
+
+    return pippenger_scratch_size(n);
+}
+
+int secp256k1_ecmult_multi_var(POINT256 *r, const BN_ULONG g_scalar[P256_LIMBS],
+                               const BN_ULONG (*scalars)[P256_LIMBS],
+                               const POINT256 *points, size_t n, void *scratch)
+{
+    if (r == NULL || (n > 0 && (scalars == NULL || points == NULL || scratch == NULL)))
+        return CRYPTO_ERR;
+
+    if (g_scalar != NULL)
+        ecmult_gen_var(r, g_scalar);
+    else
+        memset(r, 0, sizeof(POINT256));
+
+    if (n == 0)
+        return CRYPTO_OK;
+
+    if (n < PIPPENGER_MIN_POINTS)
+        strauss_var(r, scalars, points, n, (unsigned char*)scratch);
+    else
+        pippenger_var(r, scalars, points, n, (unsigned char*)scratch);
+
+    return CRYPTO_OK;
+}
+
+int secp256k1_multi_scalar_mul(POINT256 *r, const BN_ULONG (*scalars)[P256_LIMBS],
+                               const POINT256 *points, size_t n, void *scratch)
+{
+    return secp256k1_ecmult_multi_var(r, NULL, scalars, points, n, scratch);
+}
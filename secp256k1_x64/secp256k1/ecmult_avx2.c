@@ -0,0 +1,831 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright 2020 Meng-Shan Jiang                                             *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License");            *
+ * you may not use this file except in compliance with the License.           *
+ * You may obtain a copy of the License at                                    *
+ *                                                                            *
+ *    http://www.apache.org/licenses/LICENSE-2.0                              *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ *                                                                            *
+ *****************************************************************************/
+
+/*
+ * Four independent scalar multiplications in the 4 lanes of AVX2 registers.
+ * A field element is 10 limbs of 26 bits(the top one 22 bits), limb i of
+ * the 4 lanes is one __m256i, so vpmuludq does 4 limb products at once.
+ * Elements are kept weakly reduced(limbs < 2^26 + 2^18, value < 2p), only
+ * zero tests and output reduce fully. Values are plain, not montgomery.
+ *
+ * The lanes carry secret scalars. Table entries are picked by scanning the
+ * whole window with compare masks, special cases of the additions are
+ * blended in, and nothing branches on lane data.
+ *
+ * This file is built with -mavx2, callers check runtime_has_avx2() first.
+ */
+
+#include <string.h>
+#include <secp256k1_x64/crypto.h>
+#include <secp256k1_x64/fp256.h>
+#include <secp256k1_x64/secp256k1.h>
+#include "secp256k1_lcl.h"
+
+#if defined(HAVE_IMMINTRIN_H) && defined(__AVX2__)
+
+# include <immintrin.h>
+
+# define M26    0x3ffffff
+# define M22    0x3fffff
+
+typedef struct {
+    __m256i v[10];
+} FE4;
+
+/* inf : all ones in the lanes holding the point at infinity */
+typedef struct {
+    FE4 X;
+    FE4 Y;
+    FE4 Z;
+    __m256i inf;
+} POINT256_X4;
+
+typedef struct {
+    FE4 X;
+    FE4 Y;
+    __m256i inf;
+} POINT256_AFFINE_X4;
+
+/* generator table of secp256k1_precomp in plain 10x26 limbs */
+typedef struct {
+    uint32_t x[10];
+    uint32_t y[10];
+} GEN_ENTRY_X4;
+
+static GEN_ENTRY_X4 *gen_table_x4 = NULL;
+static volatile int gen_table_x4_ready = 0;
+
+/* 2p, limbs of p are 0x3fffc2f, 0x3ffffbf, 0x3ffffff * 7, 0x3fffff */
+static const uint32_t P2_LIMBS[10] = {
+    0x7fff85e, 0x7ffff7e, 0x7fffffe, 0x7fffffe, 0x7fffffe,
+    0x7fffffe, 0x7fffffe, 0x7fffffe, 0x7fffffe, 0x7ffffe
+};
+
+static const uint32_t P_LIMBS[10] = {
+    0x3fffc2f, 0x3ffffbf, 0x3ffffff, 0x3ffffff, 0x3ffffff,
+    0x3ffffff, 0x3ffffff, 0x3ffffff, 0x3ffffff, 0x3fffff
+};
+
+/*
+ * One carry from every limb to the next, in parallel. The carry out of the
+ * top limb(bit 256) is folded back with 2^256 = 2^32 + 0x3d1 mod p.
+ */
+static inline void fe4_carry(FE4 *r, const __m256i x[10])
+{
+    const __m256i m26 = _mm256_set1_epi64x(M26);
+    const __m256i m22 = _mm256_set1_epi64x(M22);
+    __m256i c[10];
+    int i;
+
+    for (i = 0; i < 9; i++)
+        c[i] = _mm256_srli_epi64(x[i], 26);
+    c[9] = _mm256_srli_epi64(x[9], 22);
+
+    r->v[0] = _mm256_add_epi64(_mm256_and_si256(x[0], m26),
+                               _mm256_mul_epu32(c[9], _mm256_set1_epi64x(0x3d1)));
+    r->v[1] = _mm256_add_epi64(_mm256_add_epi64(_mm256_and_si256(x[1], m26), c[0]),
+                               _mm256_slli_epi64(c[9], 6));
+    for (i = 2; i < 9; i++)
+        r->v[i] = _mm256_add_epi64(_mm256_and_si256(x[i], m26), c[i - 1]);
+    r->v[9] = _mm256_add_epi64(_mm256_and_si256(x[9], m22), c[8]);
+}
+
+/* t is the 19-limb product of two weakly reduced elements */
+static inline void fe4_reduce(FE4 *r, const __m256i t[19])
+{
+    const __m256i m26 = _mm256_set1_epi64x(M26);
+    const __m256i k = _mm256_set1_epi64x(0x3d10);
+    __m256i u[20], x[10];
+    int i;
+
+    /* limbs < 2^26 + 2^30 afterwards, vpmuludq takes 32 bits */
+    u[0] = _mm256_and_si256(t[0], m26);
+    for (i = 1; i < 19; i++)
+        u[i] = _mm256_add_epi64(_mm256_and_si256(t[i], m26), _mm256_srli_epi64(t[i - 1], 26));
+    u[19] = _mm256_srli_epi64(t[18], 26);
+
+    /* 2^260 = 0x400 * 2^26 + 0x3d10 mod p */
+    for (i = 0; i < 10; i++)
+        x[i] = _mm256_add_epi64(u[i], _mm256_mul_epu32(u[10 + i], k));
+    for (i = 0; i < 9; i++)
+        x[i + 1] = _mm256_add_epi64(x[i + 1], _mm256_slli_epi64(u[10 + i], 10));
+    /* u[19] * 0x400 lands on 2^260 again */
+    x[0] = _mm256_add_epi64(x[0], _mm256_mul_epu32(u[19], _mm256_set1_epi64x(0xf44000)));
+    x[1] = _mm256_add_epi64(x[1], _mm256_slli_epi64(u[19], 20));
+
+    /* after one carry only limbs 0 and 1 can be above 2^26 + 2^18 */
+    fe4_carry(r, x);
+    r->v[1] = _mm256_add_epi64(r->v[1], _mm256_srli_epi64(r->v[0], 26));
+    r->v[0] = _mm256_and_si256(r->v[0], m26);
+    r->v[2] = _mm256_add_epi64(r->v[2], _mm256_srli_epi64(r->v[1], 26));
+    r->v[1] = _mm256_and_si256(r->v[1], m26);
+}
+
+/* product columns one at a time, each sum stays in a register */
+static inline void fe4_mul(FE4 *r, const FE4 *a, const FE4 *b)
+{
+    __m256i t[19], acc;
+    int i, k;
+
+# pragma GCC unroll 19
+    for (k = 0; k < 19; k++) {
+        acc = _mm256_setzero_si256();
+# pragma GCC unroll 10
+        for (i = (k < 10 ? 0 : k - 9); i <= (k < 10 ? k : 9); i++)
+            acc = _mm256_add_epi64(acc, _mm256_mul_epu32(a->v[i], b->v[k - i]));
+        t[k] = acc;
+    }
+
+    fe4_reduce(r, t);
+}
+
+static inline void fe4_sqr(FE4 *r, const FE4 *a)
+{
+    __m256i t[19], d[10], acc;
+    int i, k;
+
+    for (i = 0; i < 10; i++)
+        d[i] = _mm256_add_epi64(a->v[i], a->v[i]);
+
+    /* a_i*a_j twice for i < j, once for i = j */
+# pragma GCC unroll 19
+    for (k = 0; k < 19; k++) {
+        acc = _mm256_setzero_si256();
+# pragma GCC unroll 10
+        for (i = (k < 10 ? 0 : k - 9); 2 * i < k; i++)
+            acc = _mm256_add_epi64(acc, _mm256_mul_epu32(d[i], a->v[k - i]));
+        if ((k & 1) == 0)
+            acc = _mm256_add_epi64(acc, _mm256_mul_epu32(a->v[k / 2], a->v[k / 2]));
+        t[k] = acc;
+    }
+
+    fe4_reduce(r, t);
+}
+
+static inline void fe4_add(FE4 *r, const FE4 *a, const FE4 *b)
+{
+    __m256i x[10];
+    int i;
+
+    for (i = 0; i < 10; i++)
+        x[i] = _mm256_add_epi64(a->v[i], b->v[i]);
+    fe4_carry(r, x);
+}
+
+/* r = a - b + 2p, every limb of 2p is above the limb of b */
+static inline void fe4_sub(FE4 *r, const FE4 *a, const FE4 *b)
+{
+    __m256i x[10];
+    int i;
+
+    for (i = 0; i < 10; i++)
+        x[i] = _mm256_sub_epi64(_mm256_add_epi64(a->v[i], _mm256_set1_epi64x(P2_LIMBS[i])), b->v[i]);
+    fe4_carry(r, x);
+}
+
+static inline void fe4_neg(FE4 *r, const FE4 *a)
+{
+    __m256i x[10];
+    int i;
+
+    for (i = 0; i < 10; i++)
+        x[i] = _mm256_sub_epi64(_mm256_set1_epi64x(P2_LIMBS[i]), a->v[i]);
+    fe4_carry(r, x);
+}
+
+/* r = a*w, w <= 8 */
+static inline void fe4_mul_small(FE4 *r, const FE4 *a, int w)
+{
+    __m256i x[10];
+    int i;
+
+    for (i = 0; i < 10; i++)
+        x[i] = _mm256_mul_epu32(a->v[i], _mm256_set1_epi64x(w));
+    fe4_carry(r, x);
+}
+
+/* r = mask ? b : a, lane by lane */
+static inline void fe4_blend(FE4 *r, const FE4 *a, const FE4 *b, __m256i mask)
+{
+    int i;
+
+    for (i = 0; i < 10; i++)
+        r->v[i] = _mm256_blendv_epi8(a->v[i], b->v[i], mask);
+}
+
+/* limbs of exactly 26(22) bits, value < 2^256 */
+static void fe4_normalize(FE4 *r)
+{
+    const __m256i m26 = _mm256_set1_epi64x(M26);
+    const __m256i m22 = _mm256_set1_epi64x(M22);
+    __m256i c;
+    int i, pass;
+
+    /* the second fold adds nothing, the value is below 2^256 by then */
+    for (pass = 0; pass < 2; pass++) {
+        for (i = 0; i < 9; i++) {
+            c = _mm256_srli_epi64(r->v[i], 26);
+            r->v[i] = _mm256_and_si256(r->v[i], m26);
+            r->v[i + 1] = _mm256_add_epi64(r->v[i + 1], c);
+        }
+        c = _mm256_srli_epi64(r->v[9], 22);
+        r->v[9] = _mm256_and_si256(r->v[9], m22);
+        r->v[0] = _mm256_add_epi64(r->v[0], _mm256_mul_epu32(c, _mm256_set1_epi64x(0x3d1)));
+        r->v[1] = _mm256_add_epi64(r->v[1], _mm256_slli_epi64(c, 6));
+    }
+}
+
+/* all ones in the lanes where a = 0 mod p */
+static __m256i fe4_is_zero(const FE4 *a)
+{
+    FE4 t = *a;
+    __m256i z, p;
+    int i;
+
+    fe4_normalize(&t);
+
+    z = _mm256_setzero_si256();
+    p = _mm256_setzero_si256();
+    for (i = 0; i < 10; i++) {
+        z = _mm256_or_si256(z, t.v[i]);
+        p = _mm256_or_si256(p, _mm256_xor_si256(t.v[i], _mm256_set1_epi64x(P_LIMBS[i])));
+    }
+
+    return _mm256_or_si256(_mm256_cmpeq_epi64(z, _mm256_setzero_si256()),
+                           _mm256_cmpeq_epi64(p, _mm256_setzero_si256()));
+}
+
+static void fe4_set_one(FE4 *r)
+{
+    int i;
+
+    r->v[0] = _mm256_set1_epi64x(1);
+    for (i = 1; i < 10; i++)
+        r->v[i] = _mm256_setzero_si256();
+}
+
+/* lane l of r = a[l], a[l] < p */
+static void fe4_load(FE4 *r, const BN_ULONG a[4][P256_LIMBS])
+{
+    const __m256i m26 = _mm256_set1_epi64x(M26);
+    __m256i w[4];
+    int i;
+
+    for (i = 0; i < 4; i++)
+        w[i] = _mm256_set_epi64x(a[3][i], a[2][i], a[1][i], a[0][i]);
+
+    r->v[0] = _mm256_and_si256(w[0], m26);
+    r->v[1] = _mm256_and_si256(_mm256_srli_epi64(w[0], 26), m26);
+    r->v[2] = _mm256_and_si256(_mm256_or_si256(_mm256_srli_epi64(w[0], 52), _mm256_slli_epi64(w[1], 12)), m26);
+    r->v[3] = _mm256_and_si256(_mm256_srli_epi64(w[1], 14), m26);
+    r->v[4] = _mm256_and_si256(_mm256_or_si256(_mm256_srli_epi64(w[1], 40), _mm256_slli_epi64(w[2], 24)), m26);
+    r->v[5] = _mm256_and_si256(_mm256_srli_epi64(w[2], 2), m26);
+    r->v[6] = _mm256_and_si256(_mm256_srli_epi64(w[2], 28), m26);
+    r->v[7] = _mm256_and_si256(_mm256_or_si256(_mm256_srli_epi64(w[2], 54), _mm256_slli_epi64(w[3], 10)), m26);
+    r->v[8] = _mm256_and_si256(_mm256_srli_epi64(w[3], 16), m26);
+    r->v[9] = _mm256_srli_epi64(w[3], 42);
+}
+
+/* r[l] = lane l of a, fully reduced */
+static void fe4_store(BN_ULONG r[4][P256_LIMBS], const FE4 *a)
+{
+    FE4 t = *a;
+    uint64_t l[10][4], s[P256_LIMBS], c, mask;
+    int i, j;
+
+    fe4_normalize(&t);
+    for (i = 0; i < 10; i++)
+        _mm256_storeu_si256((__m256i *)l[i], t.v[i]);
+
+    for (j = 0; j < 4; j++) {
+        r[j][0] = l[0][j] | (l[1][j] << 26) | (l[2][j] << 52);
+        r[j][1] = (l[2][j] >> 12) | (l[3][j] << 14) | (l[4][j] << 40);
+        r[j][2] = (l[4][j] >> 24) | (l[5][j] << 2) | (l[6][j] << 28) | (l[7][j] << 54);
+        r[j][3] = (l[7][j] >> 10) | (l[8][j] << 16) | (l[9][j] << 42);
+
+        /* value in [p, 2^256) : subtract p, i.e. keep r + 2^256 - p when
+         * that carries out
+         */
+        c = 0x1000003d1ULL;
+        for (i = 0; i < P256_LIMBS; i++) {
+            s[i] = r[j][i] + c;
+            c = s[i] < c;
+        }
+        mask = 0 - c;
+        for (i = 0; i < P256_LIMBS; i++)
+            r[j][i] = (s[i] & mask) | (r[j][i] & ~mask);
+    }
+}
+
+/* jacobian doubling, a = 0(dbl-2009-l), 2M + 5S */
+static void point4_dbl(POINT256_X4 *r, const POINT256_X4 *a)
+{
+    FE4 A, B, C, D, E, F, t;
+
+    fe4_sqr(&A, &a->X);
+    fe4_sqr(&B, &a->Y);
+    fe4_sqr(&C, &B);
+
+    fe4_add(&t, &a->X, &B);
+    fe4_sqr(&t, &t);
+    fe4_sub(&t, &t, &A);
+    fe4_sub(&t, &t, &C);
+    fe4_add(&D, &t, &t);
+
+    fe4_mul_small(&E, &A, 3);
+    fe4_sqr(&F, &E);
+
+    fe4_mul(&r->Z, &a->Y, &a->Z);
+    fe4_add(&r->Z, &r->Z, &r->Z);
+
+    fe4_add(&t, &D, &D);
+    fe4_sub(&r->X, &F, &t);
+
+    fe4_sub(&t, &D, &r->X);
+    fe4_mul(&t, &E, &t);
+    fe4_mul_small(&C, &C, 8);
+    fe4_sub(&r->Y, &t, &C);
+
+    r->inf = a->inf;
+}
+
+/*
+ * Lanes where neither input is at infinity and H = 0 are either a doubling
+ * (R = 0) or a sum at infinity, the masks are computed for all lanes. dbl
+ * is 2*a, NULL if the caller never adds a point to itself.
+ */
+static void point4_add_finish(POINT256_X4 *r, const POINT256_X4 *sum, const POINT256_X4 *a,
+                              const FE4 *H, const FE4 *R, __m256i b_inf,
+                              const FE4 *bX, const FE4 *bY, const FE4 *bZ,
+                              const POINT256_X4 *dbl)
+{
+    POINT256_X4 out;
+    __m256i both, h0, r0, dbl_mask, zero_mask;
+
+    both = _mm256_andnot_si256(_mm256_or_si256(a->inf, b_inf), _mm256_set1_epi64x(-1));
+    h0 = _mm256_and_si256(fe4_is_zero(H), both);
+    r0 = fe4_is_zero(R);
+    zero_mask = _mm256_andnot_si256(r0, h0);
+
+    /* r may be a */
+    out = *sum;
+    if (dbl != NULL) {
+        dbl_mask = _mm256_and_si256(h0, r0);
+        fe4_blend(&out.X, &out.X, &dbl->X, dbl_mask);
+        fe4_blend(&out.Y, &out.Y, &dbl->Y, dbl_mask);
+        fe4_blend(&out.Z, &out.Z, &dbl->Z, dbl_mask);
+    }
+
+    fe4_blend(&out.X, &out.X, &a->X, b_inf);
+    fe4_blend(&out.Y, &out.Y, &a->Y, b_inf);
+    fe4_blend(&out.Z, &out.Z, &a->Z, b_inf);
+
+    fe4_blend(&out.X, &out.X, bX, a->inf);
+    fe4_blend(&out.Y, &out.Y, bY, a->inf);
+    fe4_blend(&out.Z, &out.Z, bZ, a->inf);
+
+    out.inf = _mm256_or_si256(_mm256_and_si256(a->inf, b_inf), zero_mask);
+    *r = out;
+}
+
+/* complete jacobian addition(add-2007-bl), 12M + 4S, plus the doubling of a */
+static void point4_add(POINT256_X4 *r, const POINT256_X4 *a, const POINT256_X4 *b)
+{
+    POINT256_X4 s, d;
+    FE4 Z1Z1, Z2Z2, U1, U2, S1, S2, H, R, HH, HHH, V, t;
+
+    fe4_sqr(&Z1Z1, &a->Z);
+    fe4_sqr(&Z2Z2, &b->Z);
+    fe4_mul(&U1, &a->X, &Z2Z2);
+    fe4_mul(&U2, &b->X, &Z1Z1);
+    fe4_mul(&S1, &a->Y, &b->Z);
+    fe4_mul(&S1, &S1, &Z2Z2);
+    fe4_mul(&S2, &b->Y, &a->Z);
+    fe4_mul(&S2, &S2, &Z1Z1);
+    fe4_sub(&H, &U2, &U1);
+    fe4_sub(&R, &S2, &S1);
+
+    fe4_sqr(&HH, &H);
+    fe4_mul(&HHH, &H, &HH);
+    fe4_mul(&V, &U1, &HH);
+
+    fe4_sqr(&s.X, &R);
+    fe4_sub(&s.X, &s.X, &HHH);
+    fe4_add(&t, &V, &V);
+    fe4_sub(&s.X, &s.X, &t);
+
+    fe4_sub(&t, &V, &s.X);
+    fe4_mul(&t, &R, &t);
+    fe4_mul(&S1, &S1, &HHH);
+    fe4_sub(&s.Y, &t, &S1);
+
+    fe4_mul(&s.Z, &a->Z, &b->Z);
+    fe4_mul(&s.Z, &s.Z, &H);
+
+    point4_dbl(&d, a);
+    point4_add_finish(r, &s, a, &H, &R, b->inf, &b->X, &b->Y, &b->Z, &d);
+}
+
+/* mixed addition, b affine, 8M + 3S. Infinity and a = -b are handled,
+ * a = b is not: the only caller is the w7 generator ladder, where the
+ * accumulator never equals the table entry(|acc| < 2^(7i-1) <= |entry|
+ * below the top window, s < 2^256 rules out the top one).
+ */
+static void point4_add_affine(POINT256_X4 *r, const POINT256_X4 *a, const POINT256_AFFINE_X4 *b)
+{
+    POINT256_X4 s;
+    FE4 Z1Z1, U2, S2, H, R, HH, HHH, V, t, one;
+
+    fe4_sqr(&Z1Z1, &a->Z);
+    fe4_mul(&U2, &b->X, &Z1Z1);
+    fe4_mul(&S2, &b->Y, &a->Z);
+    fe4_mul(&S2, &S2, &Z1Z1);
+    fe4_sub(&H, &U2, &a->X);
+    fe4_sub(&R, &S2, &a->Y);
+
+    fe4_sqr(&HH, &H);
+    fe4_mul(&HHH, &H, &HH);
+    fe4_mul(&V, &a->X, &HH);
+
+    fe4_sqr(&s.X, &R);
+    fe4_sub(&s.X, &s.X, &HHH);
+    fe4_add(&t, &V, &V);
+    fe4_sub(&s.X, &s.X, &t);
+
+    fe4_sub(&t, &V, &s.X);
+    fe4_mul(&t, &R, &t);
+    fe4_mul(&HHH, &a->Y, &HHH);
+    fe4_sub(&s.Y, &t, &HHH);
+
+    fe4_mul(&s.Z, &a->Z, &H);
+
+    fe4_set_one(&one);
+    point4_add_finish(r, &s, a, &H, &R, b->inf, &b->X, &b->Y, &one, NULL);
+}
+
+/* lane l of p = points[l], jacobian(mont) */
+static void point4_load(POINT256_X4 *r, const POINT256 *points)
+{
+    BN_ULONG x[4][P256_LIMBS], y[4][P256_LIMBS], z[4][P256_LIMBS];
+    int64_t inf[4];
+    int l;
+
+    for (l = 0; l < 4; l++) {
+        secp256k1_from_mont(x[l], points[l].X);
+        secp256k1_from_mont(y[l], points[l].Y);
+        secp256k1_from_mont(z[l], points[l].Z);
+        inf[l] = 0 - (int64_t)secp256k1_point_is_at_infinity(&points[l]);
+    }
+
+    fe4_load(&r->X, (const BN_ULONG (*)[P256_LIMBS])x);
+    fe4_load(&r->Y, (const BN_ULONG (*)[P256_LIMBS])y);
+    fe4_load(&r->Z, (const BN_ULONG (*)[P256_LIMBS])z);
+    r->inf = _mm256_set_epi64x(inf[3], inf[2], inf[1], inf[0]);
+}
+
+static void point4_store(POINT256 *r, const POINT256_X4 *a)
+{
+    BN_ULONG x[4][P256_LIMBS], y[4][P256_LIMBS], z[4][P256_LIMBS];
+    uint64_t inf[4];
+    int i, l;
+
+    fe4_store(x, &a->X);
+    fe4_store(y, &a->Y);
+    fe4_store(z, &a->Z);
+    _mm256_storeu_si256((__m256i *)inf, a->inf);
+
+    /* lanes at infinity are cleared */
+    for (l = 0; l < 4; l++) {
+        secp256k1_to_mont(r[l].X, x[l]);
+        secp256k1_to_mont(r[l].Y, y[l]);
+        secp256k1_to_mont(r[l].Z, z[l]);
+        for (i = 0; i < P256_LIMBS; i++) {
+            r[l].X[i] &= ~inf[l];
+            r[l].Y[i] &= ~inf[l];
+            r[l].Z[i] &= ~inf[l];
+        }
+    }
+}
+
+/* secp256k1_precomp in plain limbs, built on first use */
+static int gen_table_x4_init(void)
+{
+    GEN_ENTRY_X4 *table;
+    BN_ULONG t[4][P256_LIMBS];
+    uint64_t l[10][4];
+    FE4 f;
+    int i, j, k, e, c;
+
+    if (gen_table_x4_ready)
+        return CRYPTO_OK;
+
+    if (CRYPTO_crit_enter() != 0)
+        return CRYPTO_ERR;
+
+    if (gen_table_x4_ready) {
+        CRYPTO_crit_leave();
+        return CRYPTO_OK;
+    }
+
+    if ((table = CRYPTO_malloc(37 * 64 * sizeof(GEN_ENTRY_X4))) == NULL) {
+        CRYPTO_crit_leave();
+        return CRYPTO_ERR;
+    }
+
+    /* 4 entries at a time, x and y */
+    for (e = 0; e < 37 * 64; e += 4) {
+        for (c = 0; c < 2; c++) {
+            for (k = 0; k < 4; k++) {
+                const POINT256_AFFINE *p = &secp256k1_precomp[(e + k) / 64][(e + k) % 64];
+                secp256k1_from_mont(t[k], c == 0 ? p->X : p->Y);
+            }
+            fe4_load(&f, (const BN_ULONG (*)[P256_LIMBS])t);
+            for (i = 0; i < 10; i++)
+                _mm256_storeu_si256((__m256i *)l[i], f.v[i]);
+            for (k = 0; k < 4; k++)
+                for (j = 0; j < 10; j++) {
+                    if (c == 0)
+                        table[e + k].x[j] = (uint32_t)l[j][k];
+                    else
+                        table[e + k].y[j] = (uint32_t)l[j][k];
+                }
+        }
+    }
+
+    gen_table_x4 = table;
+    gen_table_x4_ready = 1;
+
+    if (CRYPTO_crit_leave() != 0)
+        return CRYPTO_ERR;
+
+    return CRYPTO_OK;
+}
+
+void secp256k1_gen_table_x4_free(void)
+{
+    gen_table_x4_ready = 0;
+    CRYPTO_free(gen_table_x4);
+    gen_table_x4 = NULL;
+}
+
+/* lane l of t = row[d[l] - 1], d[l] = 0 gives 0. All 64 entries are read,
+ * each lane keeps the one whose compare mask is set.
+ */
+static void gen4_select(POINT256_AFFINE_X4 *t, const GEN_ENTRY_X4 *row, const uint32_t d[4])
+{
+    GEN_ENTRY_X4 sel[4];
+    __m256i acc[4][2], dv[4], m, e0, e1, k;
+    __m128i acc2[4], e2;
+    int i, j, l;
+
+    for (l = 0; l < 4; l++) {
+        acc[l][0] = acc[l][1] = _mm256_setzero_si256();
+        acc2[l] = _mm_setzero_si128();
+        dv[l] = _mm256_set1_epi32((int)d[l]);
+    }
+
+    k = _mm256_set1_epi32(1);
+    for (i = 0; i < 64; i++) {
+        e0 = _mm256_loadu_si256((const __m256i *)&row[i]);
+        e1 = _mm256_loadu_si256((const __m256i *)&row[i] + 1);
+        e2 = _mm_loadu_si128((const __m128i *)&row[i] + 4);
+        for (l = 0; l < 4; l++) {
+            m = _mm256_cmpeq_epi32(k, dv[l]);
+            acc[l][0] = _mm256_or_si256(acc[l][0], _mm256_and_si256(e0, m));
+            acc[l][1] = _mm256_or_si256(acc[l][1], _mm256_and_si256(e1, m));
+            acc2[l] = _mm_or_si128(acc2[l], _mm_and_si128(e2, _mm256_castsi256_si128(m)));
+        }
+        k = _mm256_add_epi32(k, _mm256_set1_epi32(1));
+    }
+
+    for (l = 0; l < 4; l++) {
+        _mm256_storeu_si256((__m256i *)&sel[l], acc[l][0]);
+        _mm256_storeu_si256((__m256i *)&sel[l] + 1, acc[l][1]);
+        _mm_storeu_si128((__m128i *)&sel[l] + 4, acc2[l]);
+    }
+
+    for (j = 0; j < 10; j++) {
+        t->X.v[j] = _mm256_set_epi64x(sel[3].x[j], sel[2].x[j], sel[1].x[j], sel[0].x[j]);
+        t->Y.v[j] = _mm256_set_epi64x(sel[3].y[j], sel[2].y[j], sel[1].y[j], sel[0].y[j]);
+    }
+    memset(sel, 0, sizeof(sel));
+}
+
+int secp256k1_scalar_mul_gen_x4_avx2(POINT256 r[4], const BN_ULONG (*scalars)[P256_LIMBS])
+{
+    POINT256_X4 acc;
+    POINT256_AFFINE_X4 t;
+    unsigned char p_str[4][33] = { { 0 } };
+    const unsigned int window_size = 7;
+    const unsigned int mask = (1 << (window_size + 1)) - 1;
+    unsigned int wvalue, idx = 0, off;
+    uint32_t digit[4];
+    int64_t zero[4], sign[4];
+    __m256i neg;
+    int i, l;
+
+    if (gen_table_x4_init() != CRYPTO_OK)
+        return CRYPTO_ERR;
+
+    for (l = 0; l < 4; l++)
+        for (i = 0; i < 32; i++)
+            p_str[l][i] = (unsigned char)(scalars[l][i / 8] >> (8 * (i % 8)));
+
+    memset(&acc, 0, sizeof(acc));
+    acc.inf = _mm256_set1_epi64x(-1);
+
+    for (i = 0; i < 37; i++) {
+        off = (idx - 1) / 8;
+        for (l = 0; l < 4; l++) {
+            if (i == 0) {
+                wvalue = (p_str[l][0] << 1) & mask;
+            } else {
+                wvalue = p_str[l][off] | p_str[l][off + 1] << 8;
+                wvalue = (wvalue >> ((idx - 1) % 8)) & mask;
+            }
+            wvalue = _booth_recode_w7(wvalue);
+
+            /* |digit|, 0 selects nothing and the lane is masked as infinity */
+            digit[l] = wvalue >> 1;
+            zero[l] = 0 - (int64_t)(digit[l] == 0);
+            sign[l] = 0 - (int64_t)(wvalue & 1);
+        }
+        idx += window_size;
+
+        gen4_select(&t, gen_table_x4 + i * 64, digit);
+        t.inf = _mm256_set_epi64x(zero[3], zero[2], zero[1], zero[0]);
+
+        neg = _mm256_set_epi64x(sign[3], sign[2], sign[1], sign[0]);
+        {
+            FE4 ny;
+            fe4_neg(&ny, &t.Y);
+            fe4_blend(&t.Y, &t.Y, &ny, neg);
+        }
+
+        point4_add_affine(&acc, &acc, &t);
+    }
+
+    point4_store(r, &acc);
+    memset(p_str, 0, sizeof(p_str));
+    memset(digit, 0, sizeof(digit));
+    return CRYPTO_OK;
+}
+
+/* r += digit * table, one digit per lane, neg flips the sign of a lane.
+ * Lane l of entry |digit| - 1 is picked by scanning all 16 entries.
+ */
+static void point4_add_w5(POINT256_X4 *r, const POINT256_X4 *table,
+                          const unsigned int wvalue[4], const int neg[4])
+{
+    POINT256_X4 t;
+    FE4 ny;
+    int64_t digit[4], zero[4], sign[4];
+    __m256i dv, m, k;
+    unsigned int d;
+    int i, j, l;
+
+    for (l = 0; l < 4; l++) {
+        d = _booth_recode_w5(wvalue[l]);
+        digit[l] = d >> 1;
+        zero[l] = 0 - (int64_t)(digit[l] == 0);
+        sign[l] = 0 - (int64_t)((d & 1) ^ neg[l]);
+    }
+    dv = _mm256_set_epi64x(digit[3], digit[2], digit[1], digit[0]);
+
+    memset(&t, 0, sizeof(t));
+    k = _mm256_set1_epi64x(1);
+    for (i = 0; i < 16; i++) {
+        m = _mm256_cmpeq_epi64(k, dv);
+        for (j = 0; j < 10; j++) {
+            t.X.v[j] = _mm256_or_si256(t.X.v[j], _mm256_and_si256(table[i].X.v[j], m));
+            t.Y.v[j] = _mm256_or_si256(t.Y.v[j], _mm256_and_si256(table[i].Y.v[j], m));
+            t.Z.v[j] = _mm256_or_si256(t.Z.v[j], _mm256_and_si256(table[i].Z.v[j], m));
+        }
+        t.inf = _mm256_or_si256(t.inf, _mm256_and_si256(table[i].inf, m));
+        k = _mm256_add_epi64(k, _mm256_set1_epi64x(1));
+    }
+    t.inf = _mm256_or_si256(t.inf, _mm256_set_epi64x(zero[3], zero[2], zero[1], zero[0]));
+
+    fe4_neg(&ny, &t.Y);
+    fe4_blend(&t.Y, &t.Y, &ny, _mm256_set_epi64x(sign[3], sign[2], sign[1], sign[0]));
+
+    point4_add(r, r, &t);
+}
+
+/* same joint GLV w5 ladder as secp256k1_scalar_mul_point */
+int secp256k1_scalar_mul_point_x4_avx2(POINT256 r[4], const BN_ULONG (*scalars)[P256_LIMBS],
+                                       const POINT256 *points)
+{
+    POINT256_X4 acc, table[2][16];
+    BN_ULONG s[P256_LIMBS], k[2][P256_LIMBS], beta[4][P256_LIMBS];
+    unsigned char p_str[2][4][18] = { { { 0 } } };
+    const unsigned int window_size = 5;
+    const unsigned int mask = (1 << (window_size + 1)) - 1;
+    unsigned int wvalue[4], idx, off;
+    int neg[2][4];
+    FE4 b;
+    int i, j, l;
+
+    for (l = 0; l < 4; l++) {
+        /* s = scalar mod n */
+        secp256k1_scalar_reduce(s, scalars[l]);
+        secp256k1_scalar_split_lambda(k[0], k[1], s);
+
+        for (j = 0; j < 2; j++) {
+            BN_ULONG nk[P256_LIMBS], mask;
+
+            /* k = |k|, selected without a branch */
+            neg[j][l] = (k[j][2] | k[j][3]) != 0;
+            mask = 0 - (BN_ULONG)neg[j][l];
+            secp256k1_scalar_neg(nk, k[j]);
+            for (i = 0; i < P256_LIMBS; i++)
+                k[j][i] = (nk[i] & mask) | (k[j][i] & ~mask);
+            for (i = 0; i < 16; i++)
+                p_str[j][l][i] = (unsigned char)(k[j][i / 8] >> (8 * (i % 8)));
+        }
+
+        secp256k1_from_mont(beta[l], secp256k1_beta);
+    }
+    memset(k, 0, sizeof(k));
+
+    /* table[0][i] = (i + 1)*point, table[1][i] = lambda*table[0][i] */
+    point4_load(&table[0][0], points);
+    point4_dbl(&table[0][1], &table[0][0]);
+    for (i = 2; i < 16; i++)
+        point4_add(&table[0][i], &table[0][i - 1], &table[0][0]);
+
+    fe4_load(&b, (const BN_ULONG (*)[P256_LIMBS])beta);
+    for (i = 0; i < 16; i++) {
+        table[1][i] = table[0][i];
+        fe4_mul(&table[1][i].X, &table[0][i].X, &b);
+    }
+
+    memset(&acc, 0, sizeof(acc));
+    acc.inf = _mm256_set1_epi64x(-1);
+
+    /* windows at bit 5*i, i = 25 .. 1, bits 128 and 129 are zero */
+    for (i = 25; i > 0; i--) {
+        idx = window_size * i;
+        off = (idx - 1) / 8;
+
+        for (j = 0; j < 2; j++) {
+            for (l = 0; l < 4; l++) {
+                wvalue[l] = p_str[j][l][off] | p_str[j][l][off + 1] << 8;
+                wvalue[l] = (wvalue[l] >> ((idx - 1) % 8)) & mask;
+            }
+            point4_add_w5(&acc, table[j], wvalue, neg[j]);
+        }
+
+        point4_dbl(&acc, &acc);
+        point4_dbl(&acc, &acc);
+        point4_dbl(&acc, &acc);
+        point4_dbl(&acc, &acc);
+        point4_dbl(&acc, &acc);
+    }
+
+    /* Final window */
+    for (j = 0; j < 2; j++) {
+        for (l = 0; l < 4; l++)
+            wvalue[l] = (p_str[j][l][0] << 1) & mask;
+        point4_add_w5(&acc, table[j], wvalue, neg[j]);
+    }
+
+    point4_store(r, &acc);
+    memset(p_str, 0, sizeof(p_str));
+    return CRYPTO_OK;
+}
+
+#else
+
+/* no AVX2 at build time, callers fall back to one point at a time */
+void secp256k1_gen_table_x4_free(void)
+{
+}
+
+int secp256k1_scalar_mul_gen_x4_avx2(POINT256 r[4], const BN_ULONG (*scalars)[P256_LIMBS])
+{
+    return CRYPTO_ERR;
+}
+
+int secp256k1_scalar_mul_point_x4_avx2(POINT256 r[4], const BN_ULONG (*scalars)[P256_LIMBS],
+                                       const POINT256 *points)
+{
+    return CRYPTO_ERR;
+}
+
+#endif
@@ -0,0 +1,372 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright 2020 Meng-Shan Jiang                                             *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License");            *
+ * you may not use this file except in compliance with the License.           *
+ * You may obtain a copy of the License at                                    *
+ *                                                                            *
+ *    http://www.apache.org/licenses/LICENSE-2.0                              *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ *                                                                            *
+ *****************************************************************************/
+
+/*
+ * Configurable generator table for secp256k1_scalar_mul_gen. The default
+ * Booth w7 table lives in secp256k1.c(secp256k1_precomp) and is always
+ * kept, variable time code and verification use it. Any other geometry
+ * is built here into secp256k1_gen_table.
+ */
+
+#include <string.h>
+#include <secp256k1_x64/crypto.h>
+#include <secp256k1_x64/fp256.h>
+#include <secp256k1_x64/secp256k1.h>
+#include "secp256k1_lcl.h"
+
+#define ALIGNPTR(p,N)   ((unsigned char *)p+N-(size_t)p%N)
+
+#define GEN_MIN_WINDOW      4
+#define GEN_MAX_WINDOW      8
+#define GEN_MAX_TEETH       8
+/* spacing*blocks <= 256/teeth + blocks */
+#define GEN_MAX_COMB_STEPS  512
+
+/* NULL : secp256k1_scalar_mul_gen uses the default w7 table */
+const POINT256_AFFINE *secp256k1_gen_table = NULL;
+
+static unsigned char *gen_table_storage = NULL;
+static SECP256K1_GEN_CONFIG gen_config = { SECP256K1_GEN_BOOTH, 7, 0, 0 };
+/* booth : rows, comb : spacing between teeth */
+static int gen_rows;
+static int gen_spacing;
+/* comb : (2^(blocks*teeth*spacing) - 1) mod N */
+static BN_ULONG gen_comb_offset[P256_LIMBS];
+/* comb : bit i set, step i may add a point to itself */
+static BN_ULONG gen_comb_dbl[GEN_MAX_COMB_STEPS / 64];
+
+/* r = a/2 mod N */
+static void scalar_half(BN_ULONG r[P256_LIMBS], const BN_ULONG a[P256_LIMBS])
+{
+    BN_ULONG n[P256_LIMBS], t[P256_LIMBS];
+    BN_ULONG mask = 0 - (a[0] & 1);
+    BN_ULONG c = 0, s;
+    int i;
+
+    secp256k1_get_order(n);
+    for (i = 0; i < P256_LIMBS; i++) {
+        s = a[i] + c;
+        c = s < c;
+        t[i] = s + (n[i] & mask);
+        c |= t[i] < s;
+    }
+
+    for (i = 0; i < P256_LIMBS - 1; i++)
+        r[i] = (t[i] >> 1) | (t[i + 1] << (BN_BYTES * 8 - 1));
+    r[P256_LIMBS - 1] = (t[P256_LIMBS - 1] >> 1) | (c << (BN_BYTES * 8 - 1));
+}
+
+/* normalize n jacobian points(mont) into table */
+static int gen_table_normalize(POINT256_AFFINE *table, const POINT256 *jac, size_t n)
+{
+    BN_ULONG (*z)[P256_LIMBS];
+
+    if ((z = CRYPTO_malloc(n * sizeof(BN_ULONG) * P256_LIMBS)) == NULL)
+        return CRYPTO_ERR;
+
+    secp256k1_point_to_affine_mont_batch(table, jac, n, z);
+
+    CRYPTO_free(z);
+    return CRYPTO_OK;
+}
+
+/* row i holds k*2^(w*i)*G, k = 1 .. 2^(w-1) */
+static void gen_booth_table(POINT256 *jac, int w, int rows)
+{
+    POINT256 base;
+    int i, k, m = 1 << (w - 1);
+
+    secp256k1_get_generator(&base);
+    for (i = 0; i < rows; i++) {
+        POINT256 *row = jac + i * m;
+
+        row[0] = base;
+        for (k = 1; k < m; k++)
+            secp256k1_point_add(&row[k], &row[k - 1], &base);
+        secp256k1_point_dbl(&base, &row[m - 1]);
+    }
+}
+
+/*
+ * Lim-Lee comb with signed teeth. Block b covers teeth*spacing bits, its
+ * teeth are spacing bits apart. Entry idx of block b is
+ * T[t-1] + sum((bit m of idx) ? T[m] : -T[m]), T[m] = 2^((b*teeth+m)*spacing)*G,
+ * the other half of the combinations is the negation of this one.
+ */
+static void gen_comb_table(POINT256 *jac, int teeth, int blocks, int spacing)
+{
+    POINT256 tooth[GEN_MAX_TEETH], base, t;
+    int b, m, k, idx, hb, n = 1 << (teeth - 1);
+
+    secp256k1_get_generator(&base);
+    for (b = 0; b < blocks; b++) {
+        POINT256 *block = jac + b * n;
+
+        for (m = 0; m < teeth; m++) {
+            tooth[m] = base;
+            for (k = 0; k < spacing; k++)
+                secp256k1_point_dbl(&base, &base);
+        }
+
+        block[0] = tooth[teeth - 1];
+        for (m = 0; m < teeth - 1; m++) {
+            t = tooth[m];
+            secp256k1_neg(t.Y, t.Y);
+            secp256k1_point_add(&block[0], &block[0], &t);
+        }
+
+        for (idx = 1; idx < n; idx++) {
+            for (hb = teeth - 2; ((idx >> hb) & 1) == 0; hb--)
+                ;
+            secp256k1_point_dbl(&t, &tooth[hb]);
+            secp256k1_point_add(&block[idx], &block[idx ^ (1 << hb)], &t);
+        }
+    }
+}
+
+/*
+ * Before the add of block b in column j the accumulator is a signed sum
+ * of 2^(p-j) over the positions p already done, the table entry a signed
+ * sum over the teeth of block b. The exponents are distinct, so if all of
+ * them are below 256 and their bits form a number below N, the two points
+ * can't be equal and point_add_affine is fine. Any other step is marked,
+ * it can't double.
+ */
+static void gen_comb_mark(int teeth, int blocks, int spacing)
+{
+    BN_ULONG n[P256_LIMBS], e[P256_LIMBS];
+    int b, bb, j, jp, m, pos, high, step = 0;
+
+    secp256k1_get_order(n);
+    memset(gen_comb_dbl, 0, sizeof(gen_comb_dbl));
+    for (j = spacing - 1; j >= 0; j--) {
+        for (b = 0; b < blocks; b++, step++) {
+            fp256_set_word(e, 0);
+            high = 0;
+            for (bb = 0; bb < blocks; bb++) {
+                for (m = 0; m < teeth; m++) {
+                    for (jp = (bb > b ? j + 1 : j); jp < spacing; jp++) {
+                        pos = (bb * teeth + m) * spacing + jp - j;
+                        if (pos >= 256)
+                            high = 1;
+                        else
+                            e[pos / 64] |= (BN_ULONG)1 << (pos % 64);
+                    }
+                }
+            }
+
+            if (high || fp256_cmp(e, n) >= 0)
+                gen_comb_dbl[step / 64] |= (BN_ULONG)1 << (step % 64);
+        }
+    }
+}
+
+int secp256k1_precompute_table_config(const SECP256K1_GEN_CONFIG *config)
+{
+    POINT256 *jac = NULL;
+    unsigned char *storage = NULL;
+    POINT256_AFFINE *table;
+    size_t entries;
+    int i, rows = 0, spacing = 0;
+    int ret = CRYPTO_ERR;
+
+    if (config == NULL)
+        return CRYPTO_ERR;
+
+    if (config->method == SECP256K1_GEN_BOOTH) {
+        if (config->window < GEN_MIN_WINDOW || config->window > GEN_MAX_WINDOW)
+            return CRYPTO_ERR;
+        rows = 256 / config->window + 1;
+        entries = (size_t)rows << (config->window - 1);
+    } else if (config->method == SECP256K1_GEN_COMB) {
+        if (config->teeth < 1 || config->teeth > GEN_MAX_TEETH ||
+            config->blocks < 1 || config->teeth * config->blocks > 256)
+            return CRYPTO_ERR;
+        spacing = (256 + config->teeth * config->blocks - 1) / (config->teeth * config->blocks);
+        entries = (size_t)config->blocks << (config->teeth - 1);
+    } else {
+        return CRYPTO_ERR;
+    }
+
+    /* the default table is always there */
+    if (config->method == SECP256K1_GEN_BOOTH && config->window == 7) {
+        secp256k1_gen_table = NULL;
+        CRYPTO_free(gen_table_storage);
+        gen_table_storage = NULL;
+        gen_config = *config;
+        return CRYPTO_OK;
+    }
+
+    if ((jac = CRYPTO_malloc(entries * sizeof(POINT256))) == NULL)
+        goto end;
+    if ((storage = CRYPTO_malloc(entries * sizeof(POINT256_AFFINE) + 64)) == NULL)
+        goto end;
+    table = (POINT256_AFFINE *)ALIGNPTR(storage, 64);
+
+    if (config->method == SECP256K1_GEN_BOOTH)
+        gen_booth_table(jac, config->window, rows);
+    else
+        gen_comb_table(jac, config->teeth, config->blocks, spacing);
+
+    if (gen_table_normalize(table, jac, entries) != CRYPTO_OK)
+        goto end;
+
+    if (config->method == SECP256K1_GEN_COMB) {
+        BN_ULONG one[P256_LIMBS];
+
+        fp256_set_word(one, 1);
+        fp256_set_word(gen_comb_offset, 1);
+        for (i = 0; i < config->teeth * config->blocks * spacing; i++)
+            secp256k1_scalar_add(gen_comb_offset, gen_comb_offset, gen_comb_offset);
+        secp256k1_scalar_sub(gen_comb_offset, gen_comb_offset, one);
+        gen_comb_mark(config->teeth, config->blocks, spacing);
+    }
+
+    CRYPTO_free(gen_table_storage);
+    gen_table_storage = storage;
+    storage = NULL;
+    secp256k1_gen_table = table;
+    gen_config = *config;
+    gen_rows = rows;
+    gen_spacing = spacing;
+    ret = CRYPTO_OK;
+
+end:
+    CRYPTO_free(jac);
+    CRYPTO_free(storage);
+    return ret;
+}
+
+size_t secp256k1_precompute_table_size()
+{
+    if (gen_config.method == SECP256K1_GEN_COMB)
+        return ((size_t)gen_config.blocks << (gen_config.teeth - 1)) * sizeof(POINT256_AFFINE);
+
+    return ((size_t)(256 / gen_config.window + 1) << (gen_config.window - 1)) * sizeof(POINT256_AFFINE);
+}
+
+void secp256k1_gen_table_free()
+{
+    secp256k1_gen_table = NULL;
+    CRYPTO_free(gen_table_storage);
+    gen_table_storage = NULL;
+    gen_config.method = SECP256K1_GEN_BOOTH;
+    gen_config.window = 7;
+}
+
+/* same loop as secp256k1_scalar_mul_gen, any window */
+static void ecmult_gen_booth(POINT256 *r, const BN_ULONG s[P256_LIMBS])
+{
+    POINT256_AFFINE t;
+    unsigned char p_str[34] = { 0 };
+    const int w = gen_config.window;
+    const unsigned int mask = (1 << (w + 1)) - 1;
+    const int m = 1 << (w - 1);
+    unsigned int idx = 0, off, wvalue;
+    int i;
+
+    for (i = 0; i < 32; i++)
+        p_str[i] = (unsigned char)(s[i / 8] >> (8 * (i % 8)));
+
+    memset(r, 0, sizeof(POINT256));
+    for (i = 0; i < gen_rows; i++) {
+        if (i == 0) {
+            wvalue = (p_str[0] << 1) & mask;
+        } else {
+            off = (idx - 1) / 8;
+            wvalue = p_str[off] | p_str[off + 1] << 8;
+            wvalue = (wvalue >> ((idx - 1) % 8)) & mask;
+        }
+        idx += w;
+
+        wvalue = _booth_recode_w(wvalue, w);
+
+        if (wvalue > 1)
+            t = secp256k1_gen_table[i * m + (wvalue >> 1) - 1];
+        else
+            memset(&t, 0, sizeof(t));
+
+        if (wvalue & 1)
+            secp256k1_neg(t.Y, t.Y);
+
+        secp256k1_point_add_affine(r, r, &t);
+    }
+}
+
+/* s = sum((2*v_i - 1)*2^i), v = (s + 2^bits - 1)/2 mod N, every comb
+ * position has a non-zero signed tooth.
+ */
+static void ecmult_gen_comb(POINT256 *r, const BN_ULONG s[P256_LIMBS])
+{
+    POINT256_AFFINE t;
+    POINT256 tj;
+    BN_ULONG v[P256_LIMBS];
+    const int teeth = gen_config.teeth;
+    const int blocks = gen_config.blocks;
+    const int n = 1 << (teeth - 1);
+    unsigned int bits, sign;
+    int b, j, m, pos, step = 0;
+
+    secp256k1_scalar_add(v, s, gen_comb_offset);
+    scalar_half(v, v);
+
+    memset(r, 0, sizeof(POINT256));
+    for (j = gen_spacing - 1; j >= 0; j--) {
+        if (j != gen_spacing - 1)
+            secp256k1_point_dbl(r, r);
+
+        for (b = 0; b < blocks; b++) {
+            bits = 0;
+            for (m = 0; m < teeth; m++) {
+                pos = (b * teeth + m) * gen_spacing + j;
+                if (pos < 256)
+                    bits |= (unsigned int)((v[pos / 64] >> (pos % 64)) & 1) << m;
+            }
+
+            sign = bits >> (teeth - 1);
+            bits = (sign ? bits : ~bits) & (n - 1);
+
+            t = secp256k1_gen_table[b * n + bits];
+            if (!sign)
+                secp256k1_neg(t.Y, t.Y);
+
+            if ((gen_comb_dbl[step / 64] >> (step % 64)) & 1) {
+                /* r may equal t, e.g. the last step */
+                fp256_copy(tj.X, t.X);
+                fp256_copy(tj.Y, t.Y);
+                fp256_copy(tj.Z, secp256k1_one);
+                secp256k1_point_add(r, r, &tj);
+            } else {
+                secp256k1_point_add_affine(r, r, &t);
+            }
+            step++;
+        }
+    }
+
+    memset(v, 0, sizeof(v));
+    memset(&t, 0, sizeof(t));
+    memset(&tj, 0, sizeof(tj));
+}
+
+void secp256k1_ecmult_gen_table(POINT256 *r, const BN_ULONG s[P256_LIMBS])
+{
+    if (gen_config.method == SECP256K1_GEN_COMB)
+        ecmult_gen_comb(r, s);
+    else
+        ecmult_gen_booth(r, s);
+}
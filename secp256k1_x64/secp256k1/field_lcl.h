@@ -0,0 +1,364 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright 2020 Meng-Shan Jiang                                             *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License");            *
+ * you may not use this file except in compliance with the License.           *
+ * You may obtain a copy of the License at                                    *
+ *                                                                            *
+ *    http://www.apache.org/licenses/LICENSE-2.0                              *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ *                                                                            *
+ *****************************************************************************/
+
+/* Field arithmetic for the C-level code.
+ *
+ * secp256k1_fe_* call the asm *_mont functions by default. With
+ * -DENABLE_INLINE_FIELD=ON they are the static inline functions below, the
+ * compiler then sees through them and can schedule independent field ops
+ * together. Products are unsigned __int128, the reduction uses mulx/adcx when
+ * the compiler targets BMI2 and ADX(e.g. -march=native). The representation
+ * follows the asm one : montgomery, or plain with SECP256K1_PSEUDO_MERSENNE.
+ */
+
+#ifndef HEADER_SECP256K1_FIELD_LCL_H
+#define HEADER_SECP256K1_FIELD_LCL_H
+
+#include <stdint.h>
+#include <secp256k1_x64/secp256k1.h>
+
+#if defined(__SIZEOF_INT128__) && defined(HAVE_IMMINTRIN_H)
+# define SECP256K1_HAVE_INLINE_FIELD
+#endif
+
+#ifdef SECP256K1_HAVE_INLINE_FIELD
+
+# include <immintrin.h>
+
+# ifdef __cplusplus
+extern "C" {
+# endif
+
+static const uint64_t fe_p[P256_LIMBS] = {
+    0xFFFFFFFEFFFFFC2FULL, 0xFFFFFFFFFFFFFFFFULL,
+    0xFFFFFFFFFFFFFFFFULL, 0xFFFFFFFFFFFFFFFFULL
+};
+
+/* 2^256 mod P */
+# define FE_C   0x1000003D1ULL
+/* -P^-1 mod 2^64 */
+# define FE_K0  0xD838091DD2253531ULL
+
+# ifndef SECP256K1_PSEUDO_MERSENNE
+/* 2^512 mod P */
+static const BN_ULONG fe_rr[P256_LIMBS] = {
+    0x000007A2000E90A1ULL, 0x0000000000000001ULL, 0, 0
+};
+# endif
+
+/* lo of a*b, *hi gets the high word */
+static inline uint64_t fe_mulw(uint64_t *hi, uint64_t a, uint64_t b)
+{
+# ifdef __BMI2__
+    unsigned long long h;
+    uint64_t lo = _mulx_u64(a, b, &h);
+
+    *hi = h;
+    return lo;
+# else
+    unsigned __int128 t = (unsigned __int128)a * b;
+
+    *hi = (uint64_t)(t >> 64);
+    return (uint64_t)t;
+# endif
+}
+
+static inline unsigned char fe_adc(unsigned char c, uint64_t a, uint64_t b, uint64_t *r)
+{
+    unsigned long long t;
+
+# ifdef __ADX__
+    c = _addcarryx_u64(c, a, b, &t);
+# else
+    c = _addcarry_u64(c, a, b, &t);
+# endif
+    *r = t;
+    return c;
+}
+
+static inline unsigned char fe_sbb(unsigned char c, uint64_t a, uint64_t b, uint64_t *r)
+{
+    unsigned long long t;
+
+    c = _subborrow_u64(c, a, b, &t);
+    *r = t;
+    return c;
+}
+
+/* (c0, c1, c2) += a * b, plain C carries here give better code than
+ * the mulx/adc intrinsics with gcc.
+ */
+static inline void fe_muladd(uint64_t *c0, uint64_t *c1, uint64_t *c2, uint64_t a, uint64_t b)
+{
+    unsigned __int128 t = (unsigned __int128)a * b;
+    uint64_t th = (uint64_t)(t >> 64), tl = (uint64_t)t;
+
+    *c0 += tl;
+    th += (*c0 < tl);
+    *c1 += th;
+    *c2 += (*c1 < th);
+}
+
+/* (c0, c1, c2) += 2 * a * b */
+static inline void fe_muladd2(uint64_t *c0, uint64_t *c1, uint64_t *c2, uint64_t a, uint64_t b)
+{
+    fe_muladd(c0, c1, c2, a, b);
+    fe_muladd(c0, c1, c2, a, b);
+}
+
+/* t[k] = (c0, c1, c2) low word, shift the accumulator down */
+# define FE_COL_OUT(k) do { t[k] = c0; c0 = c1; c1 = c2; c2 = 0; } while (0)
+
+/* t = a * b, 512 bits, one column at a time */
+static inline void fe_mul_wide(uint64_t t[8], const BN_ULONG a[P256_LIMBS], const BN_ULONG b[P256_LIMBS])
+{
+    uint64_t c0 = 0, c1 = 0, c2 = 0;
+
+    fe_muladd(&c0, &c1, &c2, a[0], b[0]);
+    FE_COL_OUT(0);
+    fe_muladd(&c0, &c1, &c2, a[0], b[1]);
+    fe_muladd(&c0, &c1, &c2, a[1], b[0]);
+    FE_COL_OUT(1);
+    fe_muladd(&c0, &c1, &c2, a[0], b[2]);
+    fe_muladd(&c0, &c1, &c2, a[1], b[1]);
+    fe_muladd(&c0, &c1, &c2, a[2], b[0]);
+    FE_COL_OUT(2);
+    fe_muladd(&c0, &c1, &c2, a[0], b[3]);
+    fe_muladd(&c0, &c1, &c2, a[1], b[2]);
+    fe_muladd(&c0, &c1, &c2, a[2], b[1]);
+    fe_muladd(&c0, &c1, &c2, a[3], b[0]);
+    FE_COL_OUT(3);
+    fe_muladd(&c0, &c1, &c2, a[1], b[3]);
+    fe_muladd(&c0, &c1, &c2, a[2], b[2]);
+    fe_muladd(&c0, &c1, &c2, a[3], b[1]);
+    FE_COL_OUT(4);
+    fe_muladd(&c0, &c1, &c2, a[2], b[3]);
+    fe_muladd(&c0, &c1, &c2, a[3], b[2]);
+    FE_COL_OUT(5);
+    fe_muladd(&c0, &c1, &c2, a[3], b[3]);
+    t[6] = c0;
+    t[7] = c1;
+}
+
+/* t = a^2, 512 bits, cross products doubled in the accumulator */
+static inline void fe_sqr_wide(uint64_t t[8], const BN_ULONG a[P256_LIMBS])
+{
+    uint64_t c0 = 0, c1 = 0, c2 = 0;
+
+    fe_muladd(&c0, &c1, &c2, a[0], a[0]);
+    FE_COL_OUT(0);
+    fe_muladd2(&c0, &c1, &c2, a[0], a[1]);
+    FE_COL_OUT(1);
+    fe_muladd2(&c0, &c1, &c2, a[0], a[2]);
+    fe_muladd(&c0, &c1, &c2, a[1], a[1]);
+    FE_COL_OUT(2);
+    fe_muladd2(&c0, &c1, &c2, a[0], a[3]);
+    fe_muladd2(&c0, &c1, &c2, a[1], a[2]);
+    FE_COL_OUT(3);
+    fe_muladd2(&c0, &c1, &c2, a[1], a[3]);
+    fe_muladd(&c0, &c1, &c2, a[2], a[2]);
+    FE_COL_OUT(4);
+    fe_muladd2(&c0, &c1, &c2, a[2], a[3]);
+    FE_COL_OUT(5);
+    fe_muladd(&c0, &c1, &c2, a[3], a[3]);
+    t[6] = c0;
+    t[7] = c1;
+}
+
+# undef FE_COL_OUT
+
+/* r = (top*2^256 + a) - P if that does not borrow, a otherwise */
+static inline void fe_final_sub(BN_ULONG r[P256_LIMBS], const uint64_t a[P256_LIMBS], uint64_t top)
+{
+    uint64_t s[P256_LIMBS], mask;
+    unsigned char bf = 0;
+    int i;
+
+    for (i = 0; i < P256_LIMBS; i++)
+        bf = fe_sbb(bf, a[i], fe_p[i], &s[i]);
+
+    mask = 0 - (uint64_t)(bf & (top ^ 1));
+    for (i = 0; i < P256_LIMBS; i++)
+        r[i] = (a[i] & mask) | (s[i] & ~mask);
+}
+
+/* r = t mod P, t is overwritten */
+static inline void fe_reduce_wide(BN_ULONG r[P256_LIMBS], uint64_t t[8])
+{
+    uint64_t hi;
+    unsigned char cf;
+    int j;
+# ifdef SECP256K1_PSEUDO_MERSENNE
+    uint64_t lo, c;
+
+    /* fold the high half with 2^256 = C, twice */
+    c = 0;
+    for (j = 0; j < P256_LIMBS; j++) {
+        lo = fe_mulw(&hi, t[j + 4], FE_C);
+        cf = fe_adc(0, lo, c, &lo);
+        hi += cf;
+        cf = fe_adc(0, t[j], lo, &t[j]);
+        c = hi + cf;
+    }
+
+    lo = fe_mulw(&hi, c, FE_C);
+    cf = fe_adc(0, t[0], lo, &t[0]);
+    cf = fe_adc(cf, t[1], hi, &t[1]);
+    cf = fe_adc(cf, t[2], 0, &t[2]);
+    cf = fe_adc(cf, t[3], 0, &t[3]);
+
+    fe_final_sub(r, t, cf);
+# else
+    uint64_t m, top = 0;
+    unsigned char bf;
+    int i;
+
+    /* m*P = m*2^256 - m*C and the low word of m*C is t[i], so each
+     * round only subtracts the high word of m*C and adds m at t[i+4].
+     * m - bf does not wrap, bf = 1 needs m*C >= 2^64.
+     */
+    for (i = 0; i < P256_LIMBS; i++) {
+        m = t[i] * FE_K0;
+        fe_mulw(&hi, m, FE_C);
+        bf = fe_sbb(0, t[i + 1], hi, &t[i + 1]);
+        bf = fe_sbb(bf, t[i + 2], 0, &t[i + 2]);
+        bf = fe_sbb(bf, t[i + 3], 0, &t[i + 3]);
+        cf = fe_adc(0, t[i + 4], m - bf, &t[i + 4]);
+        for (j = i + 5; j < 8; j++)
+            cf = fe_adc(cf, t[j], 0, &t[j]);
+        top += cf;
+    }
+
+    fe_final_sub(r, t + 4, top);
+# endif
+}
+
+static inline void fe_mul_inline(BN_ULONG r[P256_LIMBS], const BN_ULONG a[P256_LIMBS], const BN_ULONG b[P256_LIMBS])
+{
+    uint64_t t[8];
+
+    fe_mul_wide(t, a, b);
+    fe_reduce_wide(r, t);
+}
+
+static inline void fe_sqr_inline(BN_ULONG r[P256_LIMBS], const BN_ULONG a[P256_LIMBS])
+{
+    uint64_t t[8];
+
+    fe_sqr_wide(t, a);
+    fe_reduce_wide(r, t);
+}
+
+/* r = a^(2^n), r = a if n <= 0 */
+static inline void fe_sqr_n_inline(BN_ULONG r[P256_LIMBS], const BN_ULONG a[P256_LIMBS], int n)
+{
+    BN_ULONG t[P256_LIMBS];
+    int i;
+
+    for (i = 0; i < P256_LIMBS; i++)
+        t[i] = a[i];
+    for (; n > 0; n--)
+        fe_sqr_inline(t, t);
+    for (i = 0; i < P256_LIMBS; i++)
+        r[i] = t[i];
+}
+
+static inline void fe_from_mont_inline(BN_ULONG r[P256_LIMBS], const BN_ULONG a[P256_LIMBS])
+{
+# ifdef SECP256K1_PSEUDO_MERSENNE
+    fe_final_sub(r, (const uint64_t*)a, 0);
+# else
+    uint64_t t[8] = { a[0], a[1], a[2], a[3], 0, 0, 0, 0 };
+
+    fe_reduce_wide(r, t);
+# endif
+}
+
+static inline void fe_to_mont_inline(BN_ULONG r[P256_LIMBS], const BN_ULONG a[P256_LIMBS])
+{
+# ifdef SECP256K1_PSEUDO_MERSENNE
+    fe_final_sub(r, (const uint64_t*)a, 0);
+# else
+    fe_mul_inline(r, a, fe_rr);
+# endif
+}
+
+/* r = a^(P-2), same addition chain as secp256k1_mod_inverse */
+static inline void fe_inv_inline(BN_ULONG r[P256_LIMBS], const BN_ULONG a[P256_LIMBS])
+{
+    BN_ULONG x2[P256_LIMBS], x3[P256_LIMBS], x6[P256_LIMBS], x11[P256_LIMBS];
+    BN_ULONG x22[P256_LIMBS], x44[P256_LIMBS], x88[P256_LIMBS], t[P256_LIMBS];
+
+    fe_sqr_inline(x2, a);
+    fe_mul_inline(x2, x2, a);
+    fe_sqr_inline(x3, x2);
+    fe_mul_inline(x3, x3, a);
+    fe_sqr_n_inline(x6, x3, 3);
+    fe_mul_inline(x6, x6, x3);
+    fe_sqr_n_inline(t, x6, 3);
+    fe_mul_inline(t, t, x3);
+    fe_sqr_n_inline(x11, t, 2);
+    fe_mul_inline(x11, x11, x2);
+    fe_sqr_n_inline(x22, x11, 11);
+    fe_mul_inline(x22, x22, x11);
+    fe_sqr_n_inline(x44, x22, 22);
+    fe_mul_inline(x44, x44, x22);
+    fe_sqr_n_inline(x88, x44, 44);
+    fe_mul_inline(x88, x88, x44);
+    fe_sqr_n_inline(t, x88, 88);
+    fe_mul_inline(t, t, x88);
+    fe_sqr_n_inline(t, t, 44);
+    fe_mul_inline(t, t, x44);
+    fe_sqr_n_inline(t, t, 3);
+    fe_mul_inline(t, t, x3);
+    fe_sqr_n_inline(t, t, 23);
+    fe_mul_inline(t, t, x22);
+    fe_sqr_n_inline(t, t, 5);
+    fe_mul_inline(t, t, a);
+    fe_sqr_n_inline(t, t, 3);
+    fe_mul_inline(t, t, x2);
+    fe_sqr_n_inline(t, t, 2);
+    fe_mul_inline(r, t, a);
+}
+
+# ifdef __cplusplus
+}
+# endif
+
+#endif /* SECP256K1_HAVE_INLINE_FIELD */
+
+#ifdef SECP256K1_INLINE_FIELD
+# ifndef SECP256K1_HAVE_INLINE_FIELD
+#  error "ENABLE_INLINE_FIELD needs unsigned __int128 and immintrin.h"
+# endif
+# define secp256k1_fe_mul         fe_mul_inline
+# define secp256k1_fe_sqr         fe_sqr_inline
+# define secp256k1_fe_sqr_n       fe_sqr_n_inline
+# define secp256k1_fe_from_mont   fe_from_mont_inline
+# define secp256k1_fe_to_mont     fe_to_mont_inline
+# define secp256k1_fe_inv         fe_inv_inline
+#else
+# define secp256k1_fe_mul         secp256k1_mul_mont
+# define secp256k1_fe_sqr         secp256k1_sqr_mont
+# define secp256k1_fe_sqr_n       secp256k1_sqr_mont_n
+# define secp256k1_fe_from_mont   secp256k1_from_mont
+# define secp256k1_fe_to_mont     secp256k1_to_mont
+# define secp256k1_fe_inv         secp256k1_mod_inverse
+#endif
+
+#endif
@@ -0,0 +1,155 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright 2020 Meng-Shan Jiang                                             *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License");            *
+ * you may not use this file except in compliance with the License.           *
+ * You may obtain a copy of the License at                                    *
+ *                                                                            *
+ *    http://www.apache.org/licenses/LICENSE-2.0                              *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,         *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ *                                                                            *
+ *****************************************************************************/
+
+/*
+ * Variable time modular inversion based on the safegcd algorithm of
+ * D. J. Bernstein and B.-Y. Yang, "Fast constant-time gcd computation and
+ * modular inversion", with the variable time divstep batching used by
+ * libsecp256k1. Only for public inputs, running time leaks the input.
+ */
+
+#include <secp256k1_x64/secp256k1.h>
+#include "secp256k1_lcl.h"
+
+#define M62 ((int64_t)(UINT64_MAX >> 2))
+
+/* p = 2^256 - 2^32 - 977 */
+const SECP256K1_MODINFO secp256k1_p_modinfo = {
+    { -(int64_t)0x1000003D1ULL, 0, 0, 0, 256 },
+    0x27C7F6E22DDACACFULL
+};
+
+/* n, the group order */
+const SECP256K1_MODINFO secp256k1_n_modinfo = {
+    { 0x3FD25E8CD0364141LL, 0x2ABB739ABD2280EELL, -0x15LL, 0, 256 },
+    0x34F20099AA774EC1ULL
+};
+
+#ifndef SECP256K1_PSEUDO_MERSENNE
+/* (R^3 mod p), turns (aR)^-1 into (a^-1)R with one montgomery multiplication */
+static const BN_ULONG RRR[P256_LIMBS] = {
+    0x002bb1e33795f671ULL, 0x0000000100000b73ULL, 0, 0
+};
+#endif
+
+static void to_signed62(int64_t r[5], const BN_ULONG a[P256_LIMBS])
+{
+    r[0] =  a[0] & M62;
+    r[1] = (a[0] >> 62 | a[1] << 2) & M62;
+    r[2] = (a[1] >> 60 | a[2] << 4) & M62;
+    r[3] = (a[2] >> 58 | a[3] << 6) & M62;
+    r[4] =  a[3] >> 56;
+}
+
+static void from_signed62(BN_ULONG r[P256_LIMBS], const int64_t a[5])
+{
+    r[0] = (BN_ULONG)a[0]      | (BN_ULONG)a[1] << 62;
+    r[1] = (BN_ULONG)a[1] >> 2 | (BN_ULONG)a[2] << 60;
+    r[2] = (BN_ULONG)a[2] >> 4 | (BN_ULONG)a[3] << 58;
+    r[3] = (BN_ULONG)a[3] >> 6 | (BN_ULONG)a[4] << 56;
+}
+
+/* bring r from (-2*modulus, modulus) to [0, modulus), negate it if sign < 0 */
+static void normalize_62(int64_t r[5], int64_t sign, const SECP256K1_MODINFO *modinfo)
+{
+    int64_t cond_add, cond_negate;
+    int i;
+
+    cond_add = r[4] >> 63;
+    for (i = 0; i < 5; i++)
+        r[i] += modinfo->modulus[i] & cond_add;
+    cond_negate = sign >> 63;
+    for (i = 0; i < 5; i++)
+        r[i] = (r[i] ^ cond_negate) - cond_negate;
+    for (i = 0; i < 4; i++) {
+        r[i + 1] += r[i] >> 62;
+        r[i] &= M62;
+    }
+
+    cond_add = r[4] >> 63;
+    for (i = 0; i < 5; i++)
+        r[i] += modinfo->modulus[i] & cond_add;
+    for (i = 0; i < 4; i++) {
+        r[i + 1] += r[i] >> 62;
+        r[i] &= M62;
+    }
+}
+
+void secp256k1_modinv_var(BN_ULONG r[P256_LIMBS], const BN_ULONG a[P256_LIMBS],
+                          const SECP256K1_MODINFO *modinfo)
+{
+    int64_t d[5] = { 0, 0, 0, 0, 0 };
+    int64_t e[5] = { 1, 0, 0, 0, 0 };
+    int64_t f[5];
+    int64_t g[5];
+    int64_t t[4];
+    int64_t eta = -1;
+    int64_t cond, fn, gn;
+    int i, len = 5;
+
+    for (i = 0; i < 5; i++)
+        f[i] = modinfo->modulus[i];
+    to_signed62(g, a);
+
+    for (;;) {
+        eta = secp256k1_divsteps_62_var(eta, (uint64_t)f[0], (uint64_t)g[0], t);
+        secp256k1_update_de_62(d, e, t, modinfo);
+        secp256k1_update_fg_62_var(len, f, g, t);
+
+        /* g = 0 means f = gcd = +-1 */
+        if (g[0] == 0) {
+            cond = 0;
+            for (i = 1; i < len; i++)
+                cond |= g[i];
+            if (cond == 0)
+                break;
+        }
+
+        /* drop the top limb once both f and g fit in one limb less */
+        fn = f[len - 1];
+        gn = g[len - 1];
+        cond = ((int64_t)len - 2) >> 63;
+        cond |= fn ^ (fn >> 63);
+        cond |= gn ^ (gn >> 63);
+        if (cond == 0) {
+            f[len - 2] |= (int64_t)((uint64_t)fn << 62);
+            g[len - 2] |= (int64_t)((uint64_t)gn << 62);
+            len--;
+        }
+    }
+
+    normalize_62(d, f[len - 1], modinfo);
+    from_signed62(r, d);
+}
+
+/* in = aR mod p
+ * r  = (a^-1)R mod p
+ */
+void secp256k1_mod_inverse_var(BN_ULONG r[P256_LIMBS], const BN_ULONG in[P256_LIMBS])
+{
+#ifndef SECP256K1_PSEUDO_MERSENNE
+    BN_ULONG t[P256_LIMBS];
+
+    /* t = (aR)^-1 = (a^-1)R^-1, r = t * R^3 * R^-1 */
+    secp256k1_modinv_var(t, in, &secp256k1_p_modinfo);
+    secp256k1_mul_mont(r, t, RRR);
+#else
+    /* R = 1 */
+    secp256k1_modinv_var(r, in, &secp256k1_p_modinfo);
+#endif
+}
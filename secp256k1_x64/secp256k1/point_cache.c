@@ -0,0 +1,316 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright 2020 Meng-Shan Jiang                                             *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License");            *
+ * you may not use this file except in compliance with the License.           *
+ * You may obtain a copy of the License at                                    *
+ *                                                                            *
+ *    http://www.apache.org/licenses/LICENSE-2.0                              *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ *                                                                            *
+ *****************************************************************************/
+
+/*
+ * LRU cache of prepared points for secp256k1_scalar_mul_point. Entries are
+ * keyed by the affine coordinates(mont) of the input point, only points
+ * with Z = 1 are looked up so a lookup never costs an inversion.
+ * A point is admitted on its second miss, building a prepared point costs
+ * more than the table of secp256k1_scalar_mul_point and one-off points
+ * would only churn the cache.
+ * Entries are reference counted, a multiplication keeps using its table
+ * after the entry has been evicted by another thread.
+ */
+
+#include <string.h>
+#include <secp256k1_x64/crypto.h>
+#include <secp256k1_x64/fp256.h>
+#include <secp256k1_x64/secp256k1.h>
+#include "secp256k1_lcl.h"
+
+#define CACHE_MIN_BUCKETS   16
+/* seen hashes per bucket, keeps collisions from blocking admission */
+#define CACHE_SEEN_RATIO    16
+
+typedef struct cache_entry_st CACHE_ENTRY;
+
+struct cache_entry_st {
+    BN_ULONG x[P256_LIMBS];
+    BN_ULONG y[P256_LIMBS];
+    SECP256K1_PREPARED_POINT *pp;
+    /* hash chain */
+    CACHE_ENTRY *next;
+    /* LRU list, head is the most recently used */
+    CACHE_ENTRY *lru_prev;
+    CACHE_ENTRY *lru_next;
+    int refs;
+    /* unlinked, freed by the last user */
+    int dead;
+};
+
+/* everything below is protected by CRYPTO_crit_enter/CRYPTO_crit_leave,
+ * except cache_budget which is read without the lock as a fast check.
+ */
+static volatile size_t cache_budget = 0;
+static int cache_window;
+static size_t cache_entry_size;
+static CACHE_ENTRY **cache_buckets = NULL;
+/* hashes of points missed once, CACHE_SEEN_RATIO per bucket */
+static BN_ULONG *cache_seen = NULL;
+static size_t cache_nbuckets;
+static CACHE_ENTRY *lru_head = NULL;
+static CACHE_ENTRY *lru_tail = NULL;
+static SECP256K1_POINT_CACHE_STATS cache_stats;
+
+static BN_ULONG cache_hash(const BN_ULONG x[P256_LIMBS], const BN_ULONG y[P256_LIMBS])
+{
+    BN_ULONG h = x[0] ^ (x[1] << 1) ^ (y[0] << 2);
+
+    h ^= h >> 29;
+    h *= 0xbf58476d1ce4e5b9ULL;
+    h ^= h >> 32;
+    return h;
+}
+
+#define BUCKET(h)   ((size_t)(h) & (cache_nbuckets - 1))
+#define SEEN(h)     ((size_t)((h) >> 24) & (cache_nbuckets * CACHE_SEEN_RATIO - 1))
+
+static void entry_free(CACHE_ENTRY *e)
+{
+    secp256k1_prepared_point_free(e->pp);
+    CRYPTO_free(e);
+}
+
+static void lru_unlink(CACHE_ENTRY *e)
+{
+    if (e->lru_prev != NULL)
+        e->lru_prev->lru_next = e->lru_next;
+    else
+        lru_head = e->lru_next;
+
+    if (e->lru_next != NULL)
+        e->lru_next->lru_prev = e->lru_prev;
+    else
+        lru_tail = e->lru_prev;
+}
+
+static void lru_push_head(CACHE_ENTRY *e)
+{
+    e->lru_prev = NULL;
+    e->lru_next = lru_head;
+    if (lru_head != NULL)
+        lru_head->lru_prev = e;
+    else
+        lru_tail = e;
+    lru_head = e;
+}
+
+/* remove e from the cache, free it now or when its last user is done */
+static void entry_evict(CACHE_ENTRY *e)
+{
+    CACHE_ENTRY **p = &cache_buckets[BUCKET(cache_hash(e->x, e->y))];
+
+    while (*p != e)
+        p = &(*p)->next;
+    *p = e->next;
+    lru_unlink(e);
+
+    cache_stats.entries--;
+    cache_stats.bytes -= cache_entry_size;
+
+    e->dead = 1;
+    if (e->refs == 0)
+        entry_free(e);
+}
+
+static CACHE_ENTRY *cache_find(const BN_ULONG x[P256_LIMBS], const BN_ULONG y[P256_LIMBS],
+                               BN_ULONG h)
+{
+    CACHE_ENTRY *e;
+
+    for (e = cache_buckets[BUCKET(h)]; e != NULL; e = e->next) {
+        if (memcmp(e->x, x, sizeof(e->x)) == 0 && memcmp(e->y, y, sizeof(e->y)) == 0)
+            return e;
+    }
+
+    return NULL;
+}
+
+/* evict every entry and release the buckets, lock held */
+static void cache_flush(void)
+{
+    while (lru_tail != NULL)
+        entry_evict(lru_tail);
+
+    CRYPTO_free(cache_buckets);
+    cache_buckets = NULL;
+    cache_seen = NULL;
+    cache_nbuckets = 0;
+}
+
+int secp256k1_point_cache_config(size_t budget, int w)
+{
+    CACHE_ENTRY **buckets = NULL;
+    size_t entry_size = 0, nbuckets = 0;
+
+    if (budget != 0) {
+        /* 0 : window not supported by secp256k1_prepared_point_new */
+        if ((entry_size = secp256k1_prepared_point_mem_size(w)) == 0)
+            return CRYPTO_ERR;
+        entry_size += sizeof(CACHE_ENTRY);
+        if (budget < entry_size)
+            return CRYPTO_ERR;
+
+        for (nbuckets = CACHE_MIN_BUCKETS; nbuckets < budget / entry_size; nbuckets <<= 1)
+            ;
+        /* buckets, then the seen hashes */
+        if ((buckets = CRYPTO_malloc(nbuckets * (sizeof(CACHE_ENTRY *) +
+                                                 CACHE_SEEN_RATIO * sizeof(BN_ULONG)))) == NULL)
+            return CRYPTO_ERR;
+        memset(buckets, 0, nbuckets * (sizeof(CACHE_ENTRY *) + CACHE_SEEN_RATIO * sizeof(BN_ULONG)));
+    }
+
+    if (CRYPTO_crit_enter() != 0) {
+        CRYPTO_free(buckets);
+        return CRYPTO_ERR;
+    }
+
+    cache_flush();
+    memset(&cache_stats, 0, sizeof(cache_stats));
+    cache_buckets = buckets;
+    cache_seen = (BN_ULONG *)(buckets + nbuckets);
+    cache_nbuckets = nbuckets;
+    cache_window = w;
+    cache_entry_size = entry_size;
+    cache_budget = budget;
+    cache_stats.budget = budget;
+
+    if (CRYPTO_crit_leave() != 0)
+        return CRYPTO_ERR;
+
+    return CRYPTO_OK;
+}
+
+int secp256k1_point_cache_stats(SECP256K1_POINT_CACHE_STATS *stats)
+{
+    if (stats == NULL)
+        return CRYPTO_ERR;
+
+    if (CRYPTO_crit_enter() != 0)
+        return CRYPTO_ERR;
+    *stats = cache_stats;
+    if (CRYPTO_crit_leave() != 0)
+        return CRYPTO_ERR;
+
+    return CRYPTO_OK;
+}
+
+/* take a reference on the entry of (x, y), a new one is built on its
+ * second miss. NULL : not cached.
+ */
+static CACHE_ENTRY *cache_acquire(const BN_ULONG x[P256_LIMBS], const BN_ULONG y[P256_LIMBS],
+                                  const POINT256 *point)
+{
+    CACHE_ENTRY *e, *n = NULL;
+    BN_ULONG h = cache_hash(x, y);
+    int w;
+
+    if (CRYPTO_crit_enter() != 0)
+        return NULL;
+
+    if (cache_budget == 0) {
+        CRYPTO_crit_leave();
+        return NULL;
+    }
+
+    if ((e = cache_find(x, y, h)) != NULL) {
+        cache_stats.hits++;
+        e->refs++;
+        lru_unlink(e);
+        lru_push_head(e);
+        CRYPTO_crit_leave();
+        return e;
+    }
+    cache_stats.misses++;
+    if (cache_seen[SEEN(h)] != h) {
+        cache_seen[SEEN(h)] = h;
+        CRYPTO_crit_leave();
+        return NULL;
+    }
+    cache_seen[SEEN(h)] = 0;
+    w = cache_window;
+    CRYPTO_crit_leave();
+
+    /* build the table without holding the lock */
+    if ((n = CRYPTO_malloc(sizeof(CACHE_ENTRY))) == NULL)
+        return NULL;
+    memset(n, 0, sizeof(CACHE_ENTRY));
+    fp256_copy(n->x, x);
+    fp256_copy(n->y, y);
+    n->refs = 1;
+    if ((n->pp = secp256k1_prepared_point_new(point, w)) == NULL) {
+        CRYPTO_free(n);
+        return NULL;
+    }
+
+    if (CRYPTO_crit_enter() != 0) {
+        entry_free(n);
+        return NULL;
+    }
+
+    /* disabled, reconfigured or inserted by another thread meanwhile,
+     * n is still used once and freed by cache_release.
+     */
+    if (cache_budget == 0 || cache_window != w || cache_find(x, y, h) != NULL) {
+        n->dead = 1;
+        CRYPTO_crit_leave();
+        return n;
+    }
+
+    while (cache_stats.bytes + cache_entry_size > cache_budget && lru_tail != NULL) {
+        entry_evict(lru_tail);
+        cache_stats.evictions++;
+    }
+
+    n->next = cache_buckets[BUCKET(h)];
+    cache_buckets[BUCKET(h)] = n;
+    lru_push_head(n);
+    cache_stats.entries++;
+    cache_stats.bytes += cache_entry_size;
+
+    CRYPTO_crit_leave();
+    return n;
+}
+
+static void cache_release(CACHE_ENTRY *e)
+{
+    int last;
+
+    CRYPTO_crit_enter();
+    last = --e->refs == 0 && e->dead;
+    CRYPTO_crit_leave();
+
+    if (last)
+        entry_free(e);
+}
+
+int secp256k1_point_cache_mul(POINT256 *r, const BN_ULONG scalar[P256_LIMBS], const POINT256 *point)
+{
+    CACHE_ENTRY *e;
+    int ret;
+
+    if (cache_budget == 0 || fp256_cmp(point->Z, secp256k1_one) != 0)
+        return CRYPTO_ERR;
+
+    if ((e = cache_acquire(point->X, point->Y, point)) == NULL)
+        return CRYPTO_ERR;
+
+    ret = secp256k1_scalar_mul_prepared(r, scalar, e->pp);
+    cache_release(e);
+    return ret;
+}
@@ -0,0 +1,88 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright 2020 Meng-Shan Jiang                                             *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License");            *
+ * you may not use this file except in compliance with the License.           *
+ * You may obtain a copy of the License at                                    *
+ *                                                                            *
+ *    http://www.apache.org/licenses/LICENSE-2.0                              *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ *                                                                            *
+ *****************************************************************************/
+
+/*
+ * Build time generator of the Booth w7 generator table, used when
+ * ENABLE_STATIC_PRECOMP is on. It is linked against the library sources
+ * compiled without the embedded table, computes the table at runtime and
+ * dumps it as a C source file.
+ *
+ * usage : secp256k1_precomp_gen <output.c>
+ */
+
+#include <stdio.h>
+#include <secp256k1_x64/crypto.h>
+#include <secp256k1_x64/secp256k1.h>
+#include "secp256k1_lcl.h"
+
+static void print_limbs(FILE *fp, const BN_ULONG a[P256_LIMBS])
+{
+    fprintf(fp, "{0x%016llxULL, 0x%016llxULL, 0x%016llxULL, 0x%016llxULL}",
+            (unsigned long long)a[0], (unsigned long long)a[1],
+            (unsigned long long)a[2], (unsigned long long)a[3]);
+}
+
+int main(int argc, char **argv)
+{
+    FILE *fp;
+    int j, k;
+
+    if (argc != 2) {
+        fprintf(stderr, "usage : %s <output.c>\n", argv[0]);
+        return -1;
+    }
+
+    if (CRYPTO_init() == CRYPTO_ERR)
+        return -1;
+
+    if ((fp = fopen(argv[1], "w")) == NULL) {
+        fprintf(stderr, "can not open %s\n", argv[1]);
+        return -1;
+    }
+
+    fprintf(fp, "/* generated by secp256k1_precomp_gen, do not edit */\n\n");
+    fprintf(fp, "#include <secp256k1_x64/secp256k1.h>\n\n");
+    fprintf(fp, "#if defined(__GNUC__)\n");
+    fprintf(fp, "# define ALIGN64        __attribute((aligned(64)))\n");
+    fprintf(fp, "#elif defined(_MSC_VER)\n");
+    fprintf(fp, "# define ALIGN64        __declspec(align(64))\n");
+    fprintf(fp, "#else\n");
+    fprintf(fp, "# define ALIGN64\n");
+    fprintf(fp, "#endif\n\n");
+    fprintf(fp, "/* k*(2^(7*j))*G for row j and entry k - 1, in montgomery domain */\n");
+    fprintf(fp, "ALIGN64 const PRECOMP256_ROW secp256k1_precomp_table[37] = {\n");
+
+    for (j = 0; j < 37; j++) {
+        fprintf(fp, "    {\n");
+        for (k = 0; k < 64; k++) {
+            fprintf(fp, "        {");
+            print_limbs(fp, secp256k1_precomp[j][k].X);
+            fprintf(fp, ",\n         ");
+            print_limbs(fp, secp256k1_precomp[j][k].Y);
+            fprintf(fp, "}%s\n", k == 63 ? "" : ",");
+        }
+        fprintf(fp, "    }%s\n", j == 36 ? "" : ",");
+    }
+    fprintf(fp, "};\n");
+
+    if (fclose(fp) != 0)
+        return -1;
+
+    CRYPTO_deinit();
+    return 0;
+}
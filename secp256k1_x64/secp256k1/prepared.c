@@ -0,0 +1,287 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright 2020 Meng-Shan Jiang                                             *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License");            *
+ * you may not use this file except in compliance with the License.           *
+ * You may obtain a copy of the License at                                    *
+ *                                                                            *
+ *    http://www.apache.org/licenses/LICENSE-2.0                              *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ *                                                                            *
+ *****************************************************************************/
+
+/*
+ * Prepared points: the GLV Booth tables of secp256k1_scalar_mul_point are
+ * built once, normalized to affine, and reused by every multiplication.
+ */
+
+#include <string.h>
+#include <secp256k1_x64/crypto.h>
+#include <secp256k1_x64/fp256.h>
+#include <secp256k1_x64/secp256k1.h>
+#include "secp256k1_lcl.h"
+#include "field_lcl.h"
+
+#define ALIGNPTR(p,N)   ((unsigned char *)p+N-(size_t)p%N)
+
+#define PREPARED_WINDOW         6
+#define PREPARED_MIN_WINDOW     4
+#define PREPARED_MAX_WINDOW     8
+/* serialized form : version, window, then 2^(w-1) entries of x||y, big endian */
+#define PREPARED_VERSION        1
+#define PREPARED_HEADER_SIZE    2
+
+struct secp256k1_prepared_point_st {
+    int w;
+    /* k*point and k*lambda*point, k = 1 .. 2^(w-1), affine(mont) */
+    POINT256_AFFINE *table[2];
+};
+
+size_t secp256k1_prepared_point_mem_size(int w)
+{
+    if (w == 0)
+        w = PREPARED_WINDOW;
+    if (w < PREPARED_MIN_WINDOW || w > PREPARED_MAX_WINDOW)
+        return 0;
+
+    return sizeof(SECP256K1_PREPARED_POINT) + ((size_t)2 << (w - 1)) * sizeof(POINT256_AFFINE) + 64;
+}
+
+static SECP256K1_PREPARED_POINT *prepared_alloc(int w)
+{
+    SECP256K1_PREPARED_POINT *pp;
+    unsigned char *tables;
+    size_t m = (size_t)1 << (w - 1);
+
+    pp = CRYPTO_malloc(secp256k1_prepared_point_mem_size(w));
+    if (pp == NULL)
+        return NULL;
+
+    /* tables follow the header, 64-byte aligned */
+    tables = (unsigned char *)(pp + 1);
+    pp->w = w;
+    pp->table[0] = (POINT256_AFFINE *)ALIGNPTR(tables, 64);
+    pp->table[1] = pp->table[0] + m;
+    return pp;
+}
+
+/* table[1] = lambda * table[0], one field mul per entry */
+static void prepared_lambda_table(SECP256K1_PREPARED_POINT *pp)
+{
+    int i, m = 1 << (pp->w - 1);
+
+    for (i = 0; i < m; i++) {
+        secp256k1_fe_mul(pp->table[1][i].X, pp->table[0][i].X, secp256k1_beta);
+        fp256_copy(pp->table[1][i].Y, pp->table[0][i].Y);
+    }
+}
+
+SECP256K1_PREPARED_POINT *secp256k1_prepared_point_new(const POINT256 *point, int w)
+{
+    SECP256K1_PREPARED_POINT *pp = NULL;
+    POINT256 *jac = NULL;
+    BN_ULONG (*scratch)[P256_LIMBS];
+    int k, m;
+
+    if (point == NULL || secp256k1_point_is_at_infinity(point))
+        return NULL;
+
+    if (w == 0)
+        w = PREPARED_WINDOW;
+    if (w < PREPARED_MIN_WINDOW || w > PREPARED_MAX_WINDOW)
+        return NULL;
+    m = 1 << (w - 1);
+
+    if ((jac = CRYPTO_malloc(m * (sizeof(POINT256) + sizeof(BN_ULONG) * P256_LIMBS))) == NULL)
+        goto err;
+    scratch = (BN_ULONG (*)[P256_LIMBS])(jac + m);
+
+    if ((pp = prepared_alloc(w)) == NULL)
+        goto err;
+
+    jac[0] = *point;
+    secp256k1_point_dbl(&jac[1], point);
+    for (k = 2; k < m; k++)
+        secp256k1_point_add(&jac[k], &jac[k - 1], point);
+    secp256k1_point_to_affine_mont_batch(pp->table[0], jac, m, scratch);
+    prepared_lambda_table(pp);
+
+    CRYPTO_free(jac);
+    return pp;
+
+err:
+    CRYPTO_free(jac);
+    CRYPTO_free(pp);
+    return NULL;
+}
+
+void secp256k1_prepared_point_free(SECP256K1_PREPARED_POINT *pp)
+{
+    CRYPTO_free(pp);
+}
+
+/* r += digit * table, digit is Booth recoded, neg flips its sign */
+static void prepared_add(POINT256 *r, const POINT256_AFFINE *table,
+                         unsigned int wvalue, int w, int neg)
+{
+    POINT256 t;
+
+    wvalue = _booth_recode_w(wvalue, w);
+
+    if (wvalue > 1) {
+        memcpy(&t, table + (wvalue >> 1) - 1, sizeof(POINT256_AFFINE));
+        fp256_copy(t.Z, secp256k1_one);
+    } else {
+        memset(&t, 0, sizeof(POINT256));
+    }
+
+    if ((wvalue & 1) ^ neg)
+        secp256k1_neg(t.Y, t.Y);
+
+    /* complete addition, the sum may meet the table entry */
+    secp256k1_point_add(r, r, &t);
+}
+
+/* same joint GLV ladder as secp256k1_scalar_mul_point, window w */
+int secp256k1_scalar_mul_prepared(POINT256 *r, const BN_ULONG scalar[P256_LIMBS],
+                                  const SECP256K1_PREPARED_POINT *pp)
+{
+    int i, j;
+    unsigned char p_str[2][18] = { { 0 } };
+    unsigned int wvalue, idx, off, mask;
+    BN_ULONG s[P256_LIMBS];
+    BN_ULONG k[2][P256_LIMBS];
+    int neg[2];
+
+    if (r == NULL || scalar == NULL || pp == NULL)
+        return CRYPTO_ERR;
+
+    mask = (1 << (pp->w + 1)) - 1;
+
+    /* s = scalar mod n */
+    secp256k1_scalar_reduce(s, scalar);
+    secp256k1_scalar_split_lambda(k[0], k[1], s);
+
+    /* negative halves flip the sign of their digits */
+    for (j = 0; j < 2; j++) {
+        neg[j] = (k[j][2] | k[j][3]) != 0;
+        if (neg[j])
+            secp256k1_scalar_neg(k[j], k[j]);
+
+        for (i = 0; i < 16; i++)
+            p_str[j][i] = (unsigned char)(k[j][i / 8] >> (8 * (i % 8)));
+    }
+
+    memset(r, 0, sizeof(POINT256));
+
+    /* windows at bit w*i, the top one has a zero sign bit */
+    for (i = 129 / pp->w; i > 0; i--) {
+        idx = pp->w * i;
+        off = (idx - 1) / 8;
+
+        for (j = 0; j < 2; j++) {
+            wvalue = p_str[j][off] | p_str[j][off + 1] << 8;
+            wvalue = (wvalue >> ((idx - 1) % 8)) & mask;
+            prepared_add(r, pp->table[j], wvalue, pp->w, neg[j]);
+        }
+
+        secp256k1_point_dbl_n(r, r, pp->w);
+    }
+
+    /* Final window */
+    for (j = 0; j < 2; j++) {
+        wvalue = (p_str[j][0] << 1) & mask;
+        prepared_add(r, pp->table[j], wvalue, pp->w, neg[j]);
+    }
+
+    memset(k, 0, sizeof(k));
+    memset(p_str, 0, sizeof(p_str));
+    return CRYPTO_OK;
+}
+
+size_t secp256k1_prepared_point_serialized_size(const SECP256K1_PREPARED_POINT *pp)
+{
+    if (pp == NULL)
+        return 0;
+
+    return PREPARED_HEADER_SIZE + ((size_t)64 << (pp->w - 1));
+}
+
+int secp256k1_prepared_point_serialize(unsigned char *out, size_t *outlen,
+                                       const SECP256K1_PREPARED_POINT *pp)
+{
+    BN_ULONG t[P256_LIMBS];
+    size_t len;
+    int i, m;
+
+    if (out == NULL || outlen == NULL || pp == NULL)
+        return CRYPTO_ERR;
+
+    len = secp256k1_prepared_point_serialized_size(pp);
+    if (*outlen < len)
+        return CRYPTO_ERR;
+
+    out[0] = PREPARED_VERSION;
+    out[1] = (unsigned char)pp->w;
+    out += PREPARED_HEADER_SIZE;
+
+    /* canonical coordinates, independent of the field representation */
+    m = 1 << (pp->w - 1);
+    for (i = 0; i < m; i++) {
+        secp256k1_fe_from_mont(t, pp->table[0][i].X);
+        fp256_get_bytes(out, t);
+        secp256k1_fe_from_mont(t, pp->table[0][i].Y);
+        fp256_get_bytes(out + 32, t);
+        out += 64;
+    }
+
+    *outlen = len;
+    return CRYPTO_OK;
+}
+
+SECP256K1_PREPARED_POINT *secp256k1_prepared_point_load(const unsigned char *in, size_t inlen)
+{
+    SECP256K1_PREPARED_POINT *pp;
+    BN_ULONG p[P256_LIMBS], x[P256_LIMBS], y[P256_LIMBS];
+    POINT256 t;
+    int i, w, m;
+
+    if (in == NULL || inlen < PREPARED_HEADER_SIZE || in[0] != PREPARED_VERSION)
+        return NULL;
+
+    w = in[1];
+    if (w < PREPARED_MIN_WINDOW || w > PREPARED_MAX_WINDOW)
+        return NULL;
+    m = 1 << (w - 1);
+    if (inlen != PREPARED_HEADER_SIZE + (size_t)64 * m)
+        return NULL;
+
+    if ((pp = prepared_alloc(w)) == NULL)
+        return NULL;
+
+    /* every entry must be a curve point, which entries they are is not checked */
+    secp256k1_get_p(p);
+    in += PREPARED_HEADER_SIZE;
+    for (i = 0; i < m; i++) {
+        fp256_set_bytes(x, (unsigned char *)in, 32);
+        fp256_set_bytes(y, (unsigned char *)in + 32, 32);
+        if (fp256_cmp(x, p) >= 0 || fp256_cmp(y, p) >= 0 ||
+            secp256k1_point_set_affine(&t, x, y) != CRYPTO_OK) {
+            CRYPTO_free(pp);
+            return NULL;
+        }
+
+        fp256_copy(pp->table[0][i].X, t.X);
+        fp256_copy(pp->table[0][i].Y, t.Y);
+        in += 64;
+    }
+    prepared_lambda_table(pp);
+
+    return pp;
+}
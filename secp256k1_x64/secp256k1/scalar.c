@@ -0,0 +1,199 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright 2020 Meng-Shan Jiang                                             *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License");            *
+ * you may not use this file except in compliance with the License.           *
+ * You may obtain a copy of the License at                                    *
+ *                                                                            *
+ *    http://www.apache.org/licenses/LICENSE-2.0                              *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,         *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ *                                                                            *
+ *****************************************************************************/
+
+#include <secp256k1_x64/fp256.h>
+#include <secp256k1_x64/secp256k1.h>
+#include "secp256k1_lcl.h"
+#if defined(_MSC_VER)
+# include <intrin.h>
+#endif
+
+/* R^3 mod N */
+static const BN_ULONG RRR_ord[P256_LIMBS] = {
+    0x7bc0cfe0e9ff41edULL, 0x0017648444d4322cULL,
+    0xb1b31347f1d0b2daULL, 0x555d800c18ef116dULL
+};
+
+/* low 128 bits of N - 2, the high 128 bits are 2^127 - 1 followed by a zero bit */
+static const BN_ULONG N_MINUS_2_LO[2] = {
+    0xbfd25e8cd036413fULL, 0xbaaedce6af48a03bULL
+};
+
+/* GLV constants, k = k1 + k2*lambda mod N
+ * g1 = round(2^384 * b2 / N), g2 = round(2^384 * (-b1) / N)
+ */
+static const BN_ULONG G1[P256_LIMBS] = {
+    0xe893209a45dbb031ULL, 0x3daa8a1471e8ca7fULL,
+    0xe86c90e49284eb15ULL, 0x3086d221a7d46bcdULL
+};
+
+static const BN_ULONG G2[P256_LIMBS] = {
+    0x1571b4ae8ac47f71ULL, 0x221208ac9df506c6ULL,
+    0x6f547fa90abfe4c4ULL, 0xe4437ed6010e8828ULL
+};
+
+/* -b1, -b2 and -lambda, in Montgomery domain */
+static const BN_ULONG MINUS_B1_MONT[P256_LIMBS] = {
+    0xc50468d00ad9263cULL, 0x1b1c8205faa6ed42ULL,
+    0x1571b4ae8ac47f71ULL, 0x221208ac9df506c6ULL
+};
+
+static const BN_ULONG MINUS_B2_MONT[P256_LIMBS] = {
+    0x0cac5e506a144696ULL, 0x1e8a8dc5f3ba5939ULL,
+    0x176cdf65ba244fceULL, 0xc25575eb8e173580ULL
+};
+
+static const BN_ULONG MINUS_LAMBDA_MONT[P256_LIMBS] = {
+    0xcf54734f06a3d4a3ULL, 0x8e1af5392b820beeULL,
+    0x8c5699f9ad96826dULL, 0xacd7bfe87aa729c6ULL
+};
+
+/* hi:lo = a * b */
+static inline BN_ULONG mul_64x64(BN_ULONG *hi, BN_ULONG a, BN_ULONG b)
+{
+#if defined(__SIZEOF_INT128__)
+    unsigned __int128 t = (unsigned __int128)a * b;
+
+    *hi = (BN_ULONG)(t >> 64);
+    return (BN_ULONG)t;
+#elif defined(_MSC_VER)
+    return _umul128(a, b, hi);
+#else
+# error "64x64 multiplication is not supported"
+#endif
+}
+
+/* r = round(a * b / 2^384) */
+static void scalar_mul_shift_384(BN_ULONG r[P256_LIMBS], const BN_ULONG a[P256_LIMBS],
+                                 const BN_ULONG b[P256_LIMBS])
+{
+    BN_ULONG t[2 * P256_LIMBS] = { 0 };
+    BN_ULONG lo, hi, c;
+    int i, j;
+
+    for (i = 0; i < P256_LIMBS; i++) {
+        c = 0;
+        for (j = 0; j < P256_LIMBS; j++) {
+            lo = mul_64x64(&hi, a[i], b[j]);
+            lo += c;
+            hi += (lo < c);
+            t[i + j] += lo;
+            hi += (t[i + j] < lo);
+            c = hi;
+        }
+        t[i + P256_LIMBS] = c;
+    }
+
+    /* round with bit 383 */
+    c = t[5] >> 63;
+    r[0] = t[6] + c;
+    r[1] = t[7] + (r[0] < c);
+    r[2] = 0;
+    r[3] = 0;
+}
+
+void secp256k1_scalar_split_lambda(BN_ULONG k1[P256_LIMBS], BN_ULONG k2[P256_LIMBS],
+                                   const BN_ULONG k[P256_LIMBS])
+{
+    BN_ULONG c1[P256_LIMBS];
+    BN_ULONG c2[P256_LIMBS];
+
+    /* k2 = -(c1*b1 + c2*b2), k1 = k - k2*lambda */
+    scalar_mul_shift_384(c1, k, G1);
+    scalar_mul_shift_384(c2, k, G2);
+    secp256k1_scalar_mul_mont(c1, c1, MINUS_B1_MONT);
+    secp256k1_scalar_mul_mont(c2, c2, MINUS_B2_MONT);
+    secp256k1_scalar_add(k2, c1, c2);
+    secp256k1_scalar_mul_mont(c1, k2, MINUS_LAMBDA_MONT);
+    secp256k1_scalar_add(k1, c1, k);
+}
+
+void secp256k1_scalar_reduce_wide(BN_ULONG res[P256_LIMBS], const BN_ULONG a[2 * P256_LIMBS])
+{
+    BN_ULONG lo[P256_LIMBS];
+    BN_ULONG hi[P256_LIMBS];
+
+    /* a = hi * 2^256 + lo, hi * 2^256 = mont(hi, 2^512) */
+    secp256k1_scalar_reduce(lo, a);
+    secp256k1_scalar_reduce(hi, a + P256_LIMBS);
+    secp256k1_scalar_to_mont(hi, hi);
+    secp256k1_scalar_add(res, hi, lo);
+}
+
+/* in = aR mod n
+ * r  = (a^-1)R mod n
+ * Fermat's little theorem, r = a^(n-2) computed in Montgomery domain
+ */
+void secp256k1_scalar_inverse(BN_ULONG r[P256_LIMBS], const BN_ULONG in[P256_LIMBS])
+{
+    BN_ULONG u[16][P256_LIMBS];
+    BN_ULONG x8[P256_LIMBS];
+    BN_ULONG x16[P256_LIMBS];
+    BN_ULONG x32[P256_LIMBS];
+    BN_ULONG t[P256_LIMBS];
+    unsigned int w;
+    int i;
+
+    /* u[i] = in^i */
+    fp256_copy(u[1], in);
+    for (i = 2; i < 16; i++)
+        secp256k1_scalar_mul_mont(u[i], u[i - 1], in);
+
+    /* xk = in^(2^k - 1) */
+    secp256k1_scalar_sqr_mont(x8, u[15], 4);
+    secp256k1_scalar_mul_mont(x8, x8, u[15]);
+    secp256k1_scalar_sqr_mont(x16, x8, 8);
+    secp256k1_scalar_mul_mont(x16, x16, x8);
+    secp256k1_scalar_sqr_mont(x32, x16, 16);
+    secp256k1_scalar_mul_mont(x32, x32, x16);
+    secp256k1_scalar_sqr_mont(t, x32, 32);
+    secp256k1_scalar_mul_mont(t, t, x32);  // 2^64 - 1
+    secp256k1_scalar_sqr_mont(t, t, 32);
+    secp256k1_scalar_mul_mont(t, t, x32);  // 2^96 - 1
+    secp256k1_scalar_sqr_mont(t, t, 16);
+    secp256k1_scalar_mul_mont(t, t, x16);  // 2^112 - 1
+    secp256k1_scalar_sqr_mont(t, t, 8);
+    secp256k1_scalar_mul_mont(t, t, x8);   // 2^120 - 1
+    secp256k1_scalar_sqr_mont(t, t, 4);
+    secp256k1_scalar_mul_mont(t, t, u[15]); // 2^124 - 1
+    secp256k1_scalar_sqr_mont(t, t, 3);
+    secp256k1_scalar_mul_mont(t, t, u[7]);  // 2^127 - 1
+    secp256k1_scalar_sqr_mont(t, t, 1);
+
+    /* fixed 4-bit windows over the low 128 bits, the exponent is public */
+    for (i = 124; i >= 0; i -= 4) {
+        w = (unsigned int)(N_MINUS_2_LO[i / 64] >> (i % 64)) & 0xf;
+        secp256k1_scalar_sqr_mont(t, t, 4);
+        if (w != 0)
+            secp256k1_scalar_mul_mont(t, t, u[w]);
+    }
+
+    fp256_copy(r, t);
+}
+
+/* in = aR mod n
+ * r  = (a^-1)R mod n
+ */
+void secp256k1_scalar_inverse_var(BN_ULONG r[P256_LIMBS], const BN_ULONG in[P256_LIMBS])
+{
+    BN_ULONG t[P256_LIMBS];
+
+    /* t = (aR)^-1 = (a^-1)R^-1, r = t * R^3 * R^-1 */
+    secp256k1_modinv_var(t, in, &secp256k1_n_modinfo);
+    secp256k1_scalar_mul_mont(r, t, RRR_ord);
+}
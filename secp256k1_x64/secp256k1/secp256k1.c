@@ -60,6 +60,8 @@
 #include <secp256k1_x64/cpuid.h>
 #include <secp256k1_x64/fp256.h>
 #include <secp256k1_x64/secp256k1.h>
+#include "secp256k1_lcl.h"
+#include "field_lcl.h"
 
 #if defined(__GNUC__)
 # define ALIGN32        __attribute((aligned(32)))
@@ -71,8 +73,13 @@
 
 #define ALIGNPTR(p,N)   ((unsigned char *)p+N-(size_t)p%N)
 
+#ifdef SECP256K1_STATIC_PRECOMP
+/* table generated at build time, see precomp_gen.c */
+const PRECOMP256_ROW *secp256k1_precomp = secp256k1_precomp_table;
+#else
 unsigned char *secp256k1_precomp_storage = NULL;
-PRECOMP256_ROW *secp256k1_precomp = NULL;
+const PRECOMP256_ROW *secp256k1_precomp = NULL;
+#endif
 
 static const BN_ULONG secp256k1_P[4] = 
 {
@@ -81,9 +88,10 @@ static const BN_ULONG secp256k1_P[4] =
 
 static const BN_ULONG secp256k1_N[4] = 
 {
-    0xbfd25e8cd0364141ULL, 0xbaaedce6af48a03bULL, 0xffffffffffffffffULL, 0xffffffffffffffffULL
+    0xbfd25e8cd0364141ULL, 0xbaaedce6af48a03bULL, 0xfffffffffffffffeULL, 0xffffffffffffffffULL
 };
 
+#ifndef SECP256K1_PSEUDO_MERSENNE
 /* generator affine coordinate, in montgomery domain */
 static const POINT256 secp256k1_G = 
 {
@@ -93,10 +101,35 @@ static const POINT256 secp256k1_G =
 };
 
 /* one converted into montgomery domain */
-static const BN_ULONG ONE[P256_LIMBS] = {
+const BN_ULONG secp256k1_one[P256_LIMBS] = {
     0x00000001000003d1ULL, 0ULL, 0ULL, 0ULL
 };
 
+/* beta, cube root of unity mod p, in montgomery domain */
+const BN_ULONG secp256k1_beta[P256_LIMBS] = {
+    0x58a4361c8e81894eULL, 0x03fde1631c4b80afULL,
+    0xf8e98978d02e3905ULL, 0x7a4a36aebcbb3d53ULL
+};
+#else
+/* generator affine coordinate */
+static const POINT256 secp256k1_G = 
+{
+    {0x59f2815b16f81798ULL, 0x029bfcdb2dce28d9ULL, 0x55a06295ce870b07ULL, 0x79be667ef9dcbbacULL},
+    {0x9c47d08ffb10d4b8ULL, 0xfd17b448a6855419ULL, 0x5da4fbfc0e1108a8ULL, 0x483ada7726a3c465ULL},
+    {1ULL, 0ULL, 0ULL, 0ULL}
+};
+
+const BN_ULONG secp256k1_one[P256_LIMBS] = {
+    1ULL, 0ULL, 0ULL, 0ULL
+};
+
+/* beta, cube root of unity mod p */
+const BN_ULONG secp256k1_beta[P256_LIMBS] = {
+    0xc1396c28719501eeULL, 0x9cf0497512f58995ULL,
+    0x6e64479eac3434e9ULL, 0x7ae96a2b657c0710ULL
+};
+#endif
+
 int secp256k1_get_p(BN_ULONG r[P256_LIMBS])
 {
     if (r == NULL)
@@ -174,17 +207,17 @@ int secp256k1_point_cmp(const POINT256 *a, const POINT256 *b)
     if (secp256k1_point_is_at_infinity(b) == 1)
         return -1;
 
-    secp256k1_sqr_mont(u1, a->Z);
-    secp256k1_sqr_mont(u2, b->Z);
-    secp256k1_mul_mont(t1, a->X, u2);
-    secp256k1_mul_mont(t2, b->X, u1);
+    secp256k1_fe_sqr(u1, a->Z);
+    secp256k1_fe_sqr(u2, b->Z);
+    secp256k1_fe_mul(t1, a->X, u2);
+    secp256k1_fe_mul(t2, b->X, u1);
     if (fp256_cmp(t1, t2) != 0)
         return -1;
 
-    secp256k1_mul_mont(u1, u1, a->Z);
-    secp256k1_mul_mont(u2, u2, b->Z);
-    secp256k1_mul_mont(t1, a->Y, u2);
-    secp256k1_mul_mont(t2, b->Y, u1);
+    secp256k1_fe_mul(u1, u1, a->Z);
+    secp256k1_fe_mul(u2, u2, b->Z);
+    secp256k1_fe_mul(t1, a->Y, u2);
+    secp256k1_fe_mul(t2, b->Y, u1);
     if (fp256_cmp(t1, t2) != 0)
         return -1;
 
@@ -207,16 +240,16 @@ int secp256k1_point_is_on_curve(const POINT256 *a)
         return 1;
 
     /* X^3 */
-    secp256k1_sqr_mont(X3, a->X);
-    secp256k1_mul_mont(X3, X3, a->X);
+    secp256k1_fe_sqr(X3, a->X);
+    secp256k1_fe_mul(X3, X3, a->X);
 
     /* Y^2 */
-    secp256k1_sqr_mont(Y2, a->Y);
+    secp256k1_fe_sqr(Y2, a->Y);
 
     /* b * Z^6 */
-    secp256k1_sqr_mont(Z6, a->Z);
-    secp256k1_mul_mont(Z6, Z6, a->Z);
-    secp256k1_sqr_mont(Z6, Z6);
+    secp256k1_fe_sqr(Z6, a->Z);
+    secp256k1_fe_mul(Z6, Z6, a->Z);
+    secp256k1_fe_sqr(Z6, Z6);
     secp256k1_mul_word(Z6, Z6, 7); // b = 7
 
     /* X^3 + b*Z^6 */
@@ -226,115 +259,142 @@ int secp256k1_point_is_on_curve(const POINT256 *a)
     return (fp256_cmp(Y2, Z6) == 0);
 }
 
-/* Recode window to a signed digit, see ecp_nistputil.c for details */
-static inline unsigned int _booth_recode_w5(unsigned int in)
+/* Montgomery's trick: scratch[i] holds the product of all non-zero
+ * elements up to i, so a single inversion of the last product is
+ * enough to recover every inverse while walking backwards.
+ * Element i of in and r is at in + i*is and r + i*rs, so the Z of an
+ * array of points can be inverted in place. Every batch inversion of the
+ * library goes through here.
+ */
+static void fe_inverse_batch(BN_ULONG *r, size_t rs, const BN_ULONG *in, size_t is,
+                             size_t n, BN_ULONG (*scratch)[P256_LIMBS])
 {
-    unsigned int s, d;
+    BN_ULONG inv[P256_LIMBS];
+    BN_ULONG t[P256_LIMBS];
+    size_t i;
+
+    fp256_copy(inv, secp256k1_one);
+    for (i = 0; i < n; i++) {
+        if (!fp256_is_zero(in + i * is))
+            secp256k1_fe_mul(inv, inv, in + i * is);
+        fp256_copy(scratch[i], inv);
+    }
 
-    s = ~((in >> 5) - 1);
-    d = (1 << 6) - in - 1;
-    d = (d & s) | (in & ~s);
-    d = (d >> 1) + (d & 1);
+    secp256k1_mod_inverse_var(inv, inv);
 
-    return (d << 1) + (s & 1);
+    for (i = n; i-- > 0;) {
+        if (fp256_is_zero(in + i * is)) {
+            fp256_set_word(r + i * rs, 0);
+            continue;
+        }
+
+        if (i > 0)
+            secp256k1_fe_mul(t, inv, scratch[i - 1]);
+        else
+            fp256_copy(t, inv);
+        secp256k1_fe_mul(inv, inv, in + i * is);
+        fp256_copy(r + i * rs, t);
+    }
 }
 
-static inline unsigned int _booth_recode_w7(unsigned int in)
+int secp256k1_mod_inverse_batch(BN_ULONG (*r)[P256_LIMBS], const BN_ULONG (*in)[P256_LIMBS],
+                                size_t n, BN_ULONG (*scratch)[P256_LIMBS])
 {
-    unsigned int s, d;
+    if (r == NULL || in == NULL || scratch == NULL)
+        return CRYPTO_ERR;
 
-    s = ~((in >> 7) - 1);
-    d = (1 << 8) - in - 1;
-    d = (d & s) | (in & ~s);
-    d = (d >> 1) + (d & 1);
+    if (n > 0)
+        fe_inverse_batch(r[0], P256_LIMBS, in[0], P256_LIMBS, n, scratch);
 
-    return (d << 1) + (s & 1);
+    return CRYPTO_OK;
 }
 
-static inline BN_ULONG is_zero(BN_ULONG in)
+/* x + i*stride, y + i*stride = affine coordinate(mont) of points[i],
+ * infinity becomes (0, 0). 1/Z is written to x first, then replaced.
+ */
+static void points_to_affine_mont(BN_ULONG *x, BN_ULONG *y, size_t stride, const POINT256 *points,
+                                  size_t n, BN_ULONG (*scratch)[P256_LIMBS])
 {
-    return in == 0UL;
+    BN_ULONG z_inv2[P256_LIMBS];
+    BN_ULONG z_inv3[P256_LIMBS];
+    size_t i;
+
+    fe_inverse_batch(x, stride, points[0].Z, sizeof(POINT256) / sizeof(BN_ULONG), n, scratch);
+
+    for (i = 0; i < n; i++) {
+        secp256k1_fe_sqr(z_inv2, x + i * stride);
+        secp256k1_fe_mul(z_inv3, z_inv2, x + i * stride);
+        secp256k1_fe_mul(x + i * stride, z_inv2, points[i].X);
+        secp256k1_fe_mul(y + i * stride, z_inv3, points[i].Y);
+    }
+}
+
+/* square root, p = 3 mod 4 so r = in^((p+1)/4) */
+int secp256k1_mod_sqrt(BN_ULONG r[P256_LIMBS], const BN_ULONG in[P256_LIMBS])
+{
+    BN_ULONG t[P256_LIMBS], a[P256_LIMBS];
+
+    fp256_copy(a, in);
+    secp256k1_mod_sqrt_pow(r, a);
+
+    /* in is a square iff r^2 = in */
+    secp256k1_fe_sqr(t, r);
+    return fp256_cmp(t, a) == 0 ? CRYPTO_OK : CRYPTO_ERR;
 }
 
-/* in = aR mod p
- * r  = (a^-1)R mod p
- * TODO : implement lehmer exgcd in assembly ?
+/* width-w NAF of a 256-bit scalar, every non-zero digit is odd and
+ * in (-2^(w-1), 2^(w-1)), any w consecutive digits hold at most one
+ * non-zero digit. wnaf must hold 257 digits.
  */
-void secp256k1_mod_inverse(BN_ULONG r[P256_LIMBS], const BN_ULONG in[P256_LIMBS])
-{
-    BN_ULONG a1[P256_LIMBS];
-    BN_ULONG a2[P256_LIMBS];
-    BN_ULONG a3[P256_LIMBS];
-    BN_ULONG a4[P256_LIMBS];
-    BN_ULONG a5[P256_LIMBS];
-    BN_ULONG a6[P256_LIMBS];
-    int i;
+void secp256k1_wnaf(int wnaf[257], const BN_ULONG scalar[P256_LIMBS], int w)
+{
+    int bit = 0, carry = 0, now, word, off;
+    BN_ULONG v;
 
-    a6[0] = in[0]; a6[1] = in[1]; a6[2] = in[2]; a6[3] = in[3];
-    secp256k1_sqr_mont(a1, in);     // a1 = 2
-    secp256k1_mul_mont(a2, a1, in); // a2 = 2^2 - 1
-    secp256k1_sqr_mont(a3, a2);     
-    secp256k1_sqr_mont(a3, a3);
-    secp256k1_mul_mont(a3, a3, a2); // a3 = 2^4 - 1
-    secp256k1_sqr_mont(a4, a3);
-    secp256k1_mul_mont(r, a4, a3);  // 0x2d
-    secp256k1_sqr_mont(a4, a4);
-    secp256k1_sqr_mont(a4, a4);
-    secp256k1_sqr_mont(a4, a4);
-    secp256k1_mul_mont(a4, a4, a3); // a4 = 2^8 - 1
-    secp256k1_sqr_mont(a5, a4);
-    for (i = 0; i < 7; i++) {
-        secp256k1_sqr_mont(a5, a5);
-    }
-    secp256k1_mul_mont(a5, a5, a4); // a5 = 2^16 - 1
-
-    secp256k1_sqr_mont(a4, a4);
-    secp256k1_mul_mont(a4, a4, a6);
-    secp256k1_sqr_mont(a4, a4);     // a4 = 2^10 - 2
-
-    secp256k1_sqr_mont(a6, a5);
-    secp256k1_sqr_mont(a6, a6);
-    secp256k1_sqr_mont(a6, a6);
-    secp256k1_sqr_mont(a6, a6);
-    secp256k1_mul_mont(a6, a6, a3); // 2^20 - 1
-    secp256k1_sqr_mont(a6, a6);
-    secp256k1_sqr_mont(a6, a6);
-    secp256k1_mul_mont(a6, a6, a2); // 2^22 - 1
-    for (i = 0; i < 10; i++) {
-        secp256k1_sqr_mont(a6, a6);
-    }
-    secp256k1_mul_mont(r, r, a6);   // 0xfffffc00
-    secp256k1_mul_mont(a6, a6, a4); // 2^32 - 2 
-    secp256k1_mul_mont(a5, a6, a1); // 2^32
-    for (i = 0; i < 32; i++) {
-        secp256k1_sqr_mont(a6, a6);
-    }
-    secp256k1_mul_mont(r, r, a6);   // 0xffffffffe00000000
-    secp256k1_mul_mont(a6, a6, a5); // 2^64 - 2^32 
-    for (i = 0; i < 32; i++) {
-        secp256k1_sqr_mont(a6, a6);
-    }
-    secp256k1_mul_mont(r, r, a6);   // 2^96 - 2^64
-    for (i = 0; i < 32; i++) {
-        secp256k1_sqr_mont(a6, a6);
-    }
-    secp256k1_mul_mont(r, r, a6);   // 2^128 - 2^96
-    for (i = 0; i < 32; i++) {
-        secp256k1_sqr_mont(a6, a6);
-    }
-    secp256k1_mul_mont(r, r, a6);   // 2^160 - 2^128
-    for (i = 0; i < 32; i++) {
-        secp256k1_sqr_mont(a6, a6);
-    }
-    secp256k1_mul_mont(r, r, a6);   // 2^192 - 2^160
-    for (i = 0; i < 32; i++) {
-        secp256k1_sqr_mont(a6, a6);
-    }
-    secp256k1_mul_mont(r, r, a6);   // 2^224 - 2^192
-    for (i = 0; i < 32; i++) {
-        secp256k1_sqr_mont(a6, a6);
+    memset(wnaf, 0, 257 * sizeof(int));
+
+    while (bit < 256) {
+        if ((int)((scalar[bit >> 6] >> (bit & 63)) & 1) == carry) {
+            bit++;
+            continue;
+        }
+
+        now = w;
+        if (now > 256 - bit)
+            now = 256 - bit;
+
+        /* bits [bit, bit + now) */
+        off = bit & 63;
+        v = scalar[bit >> 6] >> off;
+        if (off + now > 64)
+            v |= scalar[(bit >> 6) + 1] << (64 - off);
+        word = (int)(v & ((1U << now) - 1)) + carry;
+
+        carry = (word >> (w - 1)) & 1;
+        word -= carry << w;
+        wnaf[bit] = word;
+        bit += now;
     }
-    secp256k1_mul_mont(r, r, a6);   // 2^256 - 2^224
+    wnaf[256] = carry;
+}
+
+/* table[i] = (2i+1)*point in affine coordinate(mont), i = 0 .. n-1,
+ * point must not be at infinity, scratch must hold n points and zs n
+ * field elements.
+ */
+void secp256k1_odd_multiples_affine(POINT256_AFFINE *table, const POINT256 *point,
+                                    int n, POINT256 *scratch, BN_ULONG (*zs)[P256_LIMBS])
+{
+    POINT256 dbl;
+    int i;
+
+    secp256k1_point_copy(&scratch[0], point);
+    if (n > 1)
+        secp256k1_point_dbl(&dbl, point);
+    for (i = 1; i < n; i++)
+        secp256k1_point_add(&scratch[i], &scratch[i - 1], &dbl);
+
+    secp256k1_point_to_affine_mont_batch(table, scratch, n, zs);
 }
 
 int secp256k1_precompute_table_gen()
@@ -345,7 +405,15 @@ int secp256k1_precompute_table_gen()
      * implicit value of infinity at index zero. We use window of size 7, and
      * therefore require ceil(256/7) = 37 tables.
      */
-    POINT256 P, T;
+#ifdef SECP256K1_STATIC_PRECOMP
+    /* embedded in .rodata, nothing to compute */
+    return CRYPTO_OK;
+#else
+    PRECOMP256_ROW *table;
+    POINT256 *jac = NULL;
+    POINT256 base[37];
+    POINT256_AFFINE base_aff[37];
+    BN_ULONG (*scratch)[P256_LIMBS] = NULL;
     int ret = CRYPTO_ERR;
     int i, j, k;
 
@@ -353,173 +421,86 @@ int secp256k1_precompute_table_gen()
     if (secp256k1_precomp_storage != NULL)
         return CRYPTO_OK;
 
+    if ((jac = malloc(37 * 64 * sizeof(POINT256))) == NULL)
+        goto end;
+    if ((scratch = malloc(37 * 64 * sizeof(BN_ULONG) * P256_LIMBS)) == NULL)
+        goto end;
     if ((secp256k1_precomp_storage =
         malloc(37 * 64 * sizeof(POINT256_AFFINE) + 64)) == NULL) {
         goto end;
     }
-    secp256k1_precomp = (void *)ALIGNPTR(secp256k1_precomp_storage, 64);
+    table = (void *)ALIGNPTR(secp256k1_precomp_storage, 64);
+
+    /* row bases 2^(7*j)*G, made affine with one inversion */
+    secp256k1_point_copy(&base[0], &secp256k1_G);
+    for (j = 1; j < 37; j++) {
+        secp256k1_point_dbl(&base[j], &base[j - 1]);
+        for (i = 1; i < 7; i++)
+            secp256k1_point_dbl(&base[j], &base[j]);
+    }
+    secp256k1_point_to_affine_mont_batch(base_aff, base, 37, scratch);
 
     /*
      * The zero entry is implicitly infinity, and we skip it, storing other
-     * values with -1 offset.
+     * values with -1 offset. Rows stay in jacobian coordinate and all
+     * of them are made affine with one more inversion.
      */
-    secp256k1_point_copy(&T, &secp256k1_G);
-
-    for (k = 0; k < 64; k++) {
-        secp256k1_point_copy(&P, &T);
-        for (j = 0; j < 37; j++) {
-            POINT256_AFFINE temp;
-
-            secp256k1_point_get_affine(temp.X, temp.Y, &P);
-            secp256k1_to_mont(temp.X, temp.X);
-            secp256k1_to_mont(temp.Y, temp.Y);
-            secp256k1_scatter_w7(secp256k1_precomp[j], &temp, k);
-            for (i = 0; i < 7; i++) {
-                secp256k1_point_dbl(&P, &P);
-            }
-        }
-        secp256k1_point_add(&T, &T, &secp256k1_G);
+    for (j = 0; j < 37; j++) {
+        POINT256 *row = jac + 64 * j;
+
+        secp256k1_point_copy(&row[0], &base[j]);
+        secp256k1_point_dbl(&row[1], &base[j]);
+        for (k = 2; k < 64; k++)
+            secp256k1_point_add_affine(&row[k], &row[k - 1], &base_aff[j]);
     }
+    secp256k1_point_to_affine_mont_batch(table[0], jac, 37 * 64, scratch);
 
+    secp256k1_precomp = table;
     ret = CRYPTO_OK;
 end:
+    if (ret != CRYPTO_OK) {
+        free(secp256k1_precomp_storage);
+        secp256k1_precomp_storage = NULL;
+    }
+    free(jac);
+    free(scratch);
     return ret;
+#endif
 }
 
 /* r = scalar*G */
 int secp256k1_scalar_mul_gen(POINT256 *r, BN_ULONG scalar[P256_LIMBS])
 {
-    int i = 0;
-    int ret = CRYPTO_ERR;
-    unsigned char p_str[33] = { 0 };
     BN_ULONG s[P256_LIMBS];
-    unsigned int idx = 0;
-    const unsigned int window_size = 7;
-    const unsigned int mask = (1 << (window_size + 1)) - 1;
-    unsigned int wvalue;
-    ALIGN32 union {
-        POINT256 p;
-        POINT256_AFFINE a;
-    } t, p;
-
-    /* s = scalar mod p */
-    secp256k1_reduce(s, scalar);
-
-    for (i = 0; i < 32; i += 8) {
-        BN_ULONG d = s[i / 8];
-
-        p_str[i + 0] = (unsigned char)d;
-        p_str[i + 1] = (unsigned char)(d >> 8);
-        p_str[i + 2] = (unsigned char)(d >> 16);
-        p_str[i + 3] = (unsigned char)(d >>= 24);
-        d >>= 8;
-        p_str[i + 4] = (unsigned char)d;
-        p_str[i + 5] = (unsigned char)(d >> 8);
-        p_str[i + 6] = (unsigned char)(d >> 16);
-        p_str[i + 7] = (unsigned char)(d >> 24);
-    }
-    p_str[32] = 0;
-
-    {
-        BN_ULONG infty;
-
-        /* First window */
-        wvalue = (p_str[0] << 1) & mask;
-        idx += window_size;
-
-        wvalue = _booth_recode_w7(wvalue);
-
-        if (wvalue > 1)
-            memcpy(&p.a, secp256k1_precomp[0] + (wvalue >> 1) - 1, 64);
-        else
-            memset(&p.a, 0, 64);
-        
-        if (wvalue & 1)  
-            secp256k1_neg(p.p.Y, p.p.Y);
-
-        
-        infty = (p.p.X[0] | p.p.X[1] | p.p.X[2] | p.p.X[3] |
-                    p.p.Y[0] | p.p.Y[1] | p.p.Y[2] | p.p.Y[3]);
-
-        infty = 0 - is_zero(infty);
-        infty = ~infty;
-
-        p.p.Z[0] = ONE[0] & infty;
-        p.p.Z[1] = ONE[1] & infty;
-        p.p.Z[2] = ONE[2] & infty;
-        p.p.Z[3] = ONE[3] & infty;
-
-        for (i = 1; i < 37; i++) {
-            unsigned int off = (idx - 1) / 8;
-            wvalue = p_str[off] | p_str[off + 1] << 8;
-            wvalue = (wvalue >> ((idx - 1) % 8)) & mask;
-            idx += window_size;
 
-            wvalue = _booth_recode_w7(wvalue);
+    /* s = scalar mod n */
+    secp256k1_scalar_reduce(s, scalar);
 
-            if (wvalue > 1)
-                memcpy(&t.a, secp256k1_precomp[i] + (wvalue >> 1) - 1, 64);
-            else
-                memset(&t.a, 0, 64);
-
-            if (wvalue & 1)  
-                secp256k1_neg(t.p.Y, t.p.Y);
-
-            secp256k1_point_add_affine(&p.p, &p.p, &t.a);
-        }
+    /* table built by secp256k1_precompute_table_config */
+    if (secp256k1_gen_table != NULL) {
+        secp256k1_ecmult_gen_table(r, s);
+        return CRYPTO_OK;
     }
-    *r = p.p;
 
-    ret = CRYPTO_OK;
-    return ret;
+    /* recoding, fetches and adds of the 37 windows run in asm */
+    secp256k1_ecmult_gen_w7(r, s, secp256k1_precomp);
+    return CRYPTO_OK;
 }
 
 /* r = scalar * point */
-int secp256k1_scalar_mul_point(POINT256 *r, BN_ULONG scalar[P256_LIMBS], POINT256 *point)
+/* table[i - 1] = i*point, i = 1 .. 16 */
+static void point_table_w5(POINT256 *table, const POINT256 *point)
 {
-    int i;
-    int ret = CRYPTO_ERR;
-    unsigned int idx;
-    unsigned char p_str[33] = { 0 };
-    const unsigned int window_size = 5;
-    const unsigned int mask = (1 << (window_size + 1)) - 1;
-    unsigned int wvalue;
-    BN_ULONG s[P256_LIMBS];
-    POINT256 *temp;
-    POINT256 *table = NULL;
-    unsigned char table_storage[2080];
-
-    table = (void*)ALIGNPTR(table_storage, 64);
-    temp = table + 16;
-
+    POINT256 temp[5];
     POINT256 *row = table;
 
-    /* s = scalar mod p */
-    secp256k1_reduce(s, scalar);
-
-    for (i = 0; i < 32; i += 8) {
-        BN_ULONG d = s[i / 8];
-
-        p_str[i + 0] = (unsigned char)d;
-        p_str[i + 1] = (unsigned char)(d >> 8);
-        p_str[i + 2] = (unsigned char)(d >> 16);
-        p_str[i + 3] = (unsigned char)(d >>= 24);
-        d >>= 8;
-        p_str[i + 4] = (unsigned char)d;
-        p_str[i + 5] = (unsigned char)(d >> 8);
-        p_str[i + 6] = (unsigned char)(d >> 16);
-        p_str[i + 7] = (unsigned char)(d >> 24);
-    }
-    p_str[32] = 0;
-    
-    if (secp256k1_point_copy(temp, point) == CRYPTO_ERR) 
-        goto end;
+    secp256k1_point_copy(&temp[0], point);
 
     /*
-        * row[0] is implicitly (0,0,0) (the point at infinity), therefore it
-        * is not stored. All other values are actually stored with an offset
-        * of -1 in table.
-        */
+     * row[0] is implicitly (0,0,0) (the point at infinity), therefore it
+     * is not stored. All other values are actually stored with an offset
+     * of -1 in table.
+     */
 
     secp256k1_scatter_w5  (row, &temp[0], 1);
     secp256k1_point_dbl(&temp[1], &temp[0]);              /*1+1=2  */
@@ -552,74 +533,209 @@ int secp256k1_scalar_mul_point(POINT256 *r, BN_ULONG scalar[P256_LIMBS], POINT25
     secp256k1_scatter_w5  (row, &temp[2], 9);
     secp256k1_point_dbl(&temp[1], &temp[1]);              /*2*8=16 */
     secp256k1_scatter_w5  (row, &temp[1], 16);
+}
 
-    idx = 255;
-    wvalue = p_str[(idx - 1) / 8];
-    wvalue = (wvalue >> ((idx - 1) % 8)) & mask;
+/* r += digit * table, digit is Booth recoded */
+static void point_add_w5(POINT256 *r, const POINT256 *table, unsigned int wvalue)
+{
+    POINT256 t;
+
+    wvalue = _booth_recode_w5(wvalue);
 
-    /*
-     * We gather to temp[0], because we know it's position relative
-     * to table
-     */
     if (wvalue > 1)
-        memcpy(&temp[0], table + (_booth_recode_w5(wvalue) >> 1) - 1, 96);
+        memcpy(&t, table + (wvalue >> 1) - 1, sizeof(POINT256));
     else
-        memset(&temp[0], 0, 96);
-    memcpy(r, &temp[0], sizeof(temp[0]));
-    secp256k1_point_dbl(r, r);
-    secp256k1_point_dbl(r, r);
-    secp256k1_point_dbl(r, r);
-    secp256k1_point_dbl(r, r);
-    secp256k1_point_dbl(r, r);
-    idx -= window_size;
-
-    while (idx >= 5) {
-        unsigned int off = (idx - 1) / 8;
+        memset(&t, 0, sizeof(POINT256));
 
-        wvalue = p_str[off] | p_str[off + 1] << 8;
-        wvalue = (wvalue >> ((idx - 1) % 8)) & mask;
+    if (wvalue & 1)
+        secp256k1_neg(t.Y, t.Y);
 
-        wvalue = _booth_recode_w5(wvalue);
+    secp256k1_point_add(r, r, &t);
+}
 
-        if (wvalue > 1)
-            memcpy(&temp[0], table + (wvalue >> 1) - 1, 96);
-        else
-            memset(&temp[0], 0, 96);
+/*
+ * GLV: s = k1 + k2*lambda with |k1|, |k2| < 2^128 and lambda*(x, y) = (beta*x, y),
+ * so r = k1*point + k2*(lambda*point) is one joint w5 ladder over 130 bits,
+ * half the doublings of a 256-bit ladder.
+ */
+int secp256k1_scalar_mul_point(POINT256 *r, BN_ULONG scalar[P256_LIMBS], POINT256 *point)
+{
+    int i, j;
+    int ret = CRYPTO_ERR;
+    unsigned char p_str[2][18] = { { 0 } };
+    const unsigned int window_size = 5;
+    const unsigned int mask = (1 << (window_size + 1)) - 1;
+    unsigned int wvalue;
+    BN_ULONG s[P256_LIMBS];
+    BN_ULONG k[2][P256_LIMBS];
+    POINT256 *table[2];
+    unsigned char table_storage[2 * 16 * sizeof(POINT256) + 64];
 
-        if (wvalue & 1)  
-            secp256k1_neg(temp[0].Y, temp[0].Y);
+    if (r == NULL || scalar == NULL || point == NULL)
+        goto end;
+
+    if (secp256k1_point_cache_mul(r, scalar, point) == CRYPTO_OK)
+        return CRYPTO_OK;
 
-        secp256k1_point_add(r, r, &temp[0]);
+    table[0] = (void*)ALIGNPTR(table_storage, 64);
+    table[1] = table[0] + 16;
 
-        idx -= window_size;
+    /* s = scalar mod n */
+    secp256k1_scalar_reduce(s, scalar);
+    secp256k1_scalar_split_lambda(k[0], k[1], s);
 
-        secp256k1_point_dbl(r, r);
-        secp256k1_point_dbl(r, r);
-        secp256k1_point_dbl(r, r);
-        secp256k1_point_dbl(r, r);
-        secp256k1_point_dbl(r, r);
+    /* table[1] = lambda * table[0], one field mul per entry */
+    point_table_w5(table[0], point);
+    for (i = 0; i < 16; i++) {
+        fp256_copy(table[1][i].Y, table[0][i].Y);
+        fp256_copy(table[1][i].Z, table[0][i].Z);
+        secp256k1_fe_mul(table[1][i].X, table[0][i].X, secp256k1_beta);
     }
 
-    /* Final window */
-    wvalue = p_str[0];
-    wvalue = (wvalue << 1) & mask;
-    wvalue = _booth_recode_w5(wvalue);
+    /* negative halves use the negated table */
+    for (j = 0; j < 2; j++) {
+        if (k[j][2] | k[j][3]) {
+            secp256k1_scalar_neg(k[j], k[j]);
+            for (i = 0; i < 16; i++)
+                secp256k1_neg(table[j][i].Y, table[j][i].Y);
+        }
 
-    if (wvalue > 1)
-        memcpy(&temp[0], table + (wvalue >> 1) - 1, 96);
-    else
-        memset(&temp[0], 0, 96);
+        for (i = 0; i < 16; i += 8) {
+            BN_ULONG d = k[j][i / 8];
+
+            p_str[j][i + 0] = (unsigned char)d;
+            p_str[j][i + 1] = (unsigned char)(d >> 8);
+            p_str[j][i + 2] = (unsigned char)(d >> 16);
+            p_str[j][i + 3] = (unsigned char)(d >>= 24);
+            d >>= 8;
+            p_str[j][i + 4] = (unsigned char)d;
+            p_str[j][i + 5] = (unsigned char)(d >> 8);
+            p_str[j][i + 6] = (unsigned char)(d >> 16);
+            p_str[j][i + 7] = (unsigned char)(d >> 24);
+        }
+    }
+
+    memset(r, 0, sizeof(POINT256));
+
+    /* windows at bit 5*i, i = 25 .. 1, bits 128 and 129 are zero */
+    for (i = 25; i > 0; i--) {
+        unsigned int idx = window_size * i;
+        unsigned int off = (idx - 1) / 8;
+
+        for (j = 0; j < 2; j++) {
+            wvalue = p_str[j][off] | p_str[j][off + 1] << 8;
+            wvalue = (wvalue >> ((idx - 1) % 8)) & mask;
+            point_add_w5(r, table[j], wvalue);
+        }
 
-    if (wvalue & 1)  
-        secp256k1_neg(temp[0].Y, temp[0].Y);
+        secp256k1_point_dbl_n(r, r, window_size);
+    }
 
-    secp256k1_point_add(r, r, &temp[0]);
+    /* Final window */
+    for (j = 0; j < 2; j++) {
+        wvalue = p_str[j][0];
+        wvalue = (wvalue << 1) & mask;
+        point_add_w5(r, table[j], wvalue);
+    }
 
     ret = CRYPTO_OK;
 end:
     return ret;
 }
 
+int secp256k1_scalar_mul_gen_x4(POINT256 r[4], const BN_ULONG (*scalars)[P256_LIMBS])
+{
+    BN_ULONG k[P256_LIMBS];
+    int i;
+
+    if (r == NULL || scalars == NULL)
+        return CRYPTO_ERR;
+
+    /* the AVX2 engine(secp256k1_scalar_mul_gen_x4_avx2) is slower than
+     * four calls on the cores measured so far, speed compares the two. It
+     * is not dispatched to until it wins.
+     */
+    for (i = 0; i < 4; i++) {
+        fp256_copy(k, scalars[i]);
+        if (secp256k1_scalar_mul_gen(&r[i], k) != CRYPTO_OK)
+            return CRYPTO_ERR;
+    }
+    memset(k, 0, sizeof(k));
+
+    return CRYPTO_OK;
+}
+
+/* accumulators per pass of secp256k1_scalar_mul_gen_batch, 1.5KB of points
+ * next to the 4KB row
+ */
+#define GEN_BATCH 16
+
+int secp256k1_scalar_mul_gen_batch(POINT256 *r, const BN_ULONG (*k)[P256_LIMBS], size_t n)
+{
+    BN_ULONG s[P256_LIMBS];
+    unsigned int digits[GEN_BATCH][37];
+    size_t i, l, m;
+    int j;
+
+    if (n == 0)
+        return CRYPTO_OK;
+    if (r == NULL || k == NULL)
+        return CRYPTO_ERR;
+
+    /* table built by secp256k1_precompute_table_config */
+    if (secp256k1_gen_table != NULL) {
+        for (i = 0; i < n; i++) {
+            secp256k1_scalar_reduce(s, k[i]);
+            secp256k1_ecmult_gen_table(&r[i], s);
+        }
+        memset(s, 0, sizeof(s));
+        return CRYPTO_OK;
+    }
+
+    for (i = 0; i < n; i += GEN_BATCH) {
+        m = (n - i < GEN_BATCH) ? n - i : GEN_BATCH;
+
+        for (l = 0; l < m; l++) {
+            secp256k1_scalar_reduce(s, k[i + l]);
+            secp256k1_booth_w7_digits(digits[l], s);
+        }
+        /* accumulators start at infinity */
+        memset(&r[i], 0, m * sizeof(POINT256));
+
+        for (j = 0; j < 37; j++)
+            for (l = 0; l < m; l++)
+                secp256k1_point_add_affine_lookup(&r[i + l], secp256k1_precomp[j], digits[l][j]);
+    }
+    memset(s, 0, sizeof(s));
+    memset(digits, 0, sizeof(digits));
+
+    return CRYPTO_OK;
+}
+
+int secp256k1_scalar_mul_point_x4(POINT256 r[4], const BN_ULONG (*scalars)[P256_LIMBS],
+                                  const POINT256 points[4])
+{
+    BN_ULONG k[P256_LIMBS];
+    POINT256 p;
+    int i;
+
+    if (r == NULL || scalars == NULL || points == NULL)
+        return CRYPTO_ERR;
+
+    /* not dispatched to secp256k1_scalar_mul_point_x4_avx2, see
+     * secp256k1_scalar_mul_gen_x4
+     */
+    for (i = 0; i < 4; i++) {
+        fp256_copy(k, scalars[i]);
+        p = points[i];
+        if (secp256k1_scalar_mul_point(&r[i], k, &p) != CRYPTO_OK)
+            return CRYPTO_ERR;
+    }
+    memset(k, 0, sizeof(k));
+
+    return CRYPTO_OK;
+}
+
 int secp256k1_point_get_affine(BN_ULONG x[P256_LIMBS], BN_ULONG y[P256_LIMBS], const POINT256 *point)
 {
     BN_ULONG z_inv2[P256_LIMBS];
@@ -633,30 +749,61 @@ int secp256k1_point_get_affine(BN_ULONG x[P256_LIMBS], BN_ULONG y[P256_LIMBS], c
     if (secp256k1_point_is_at_infinity(point))
         return CRYPTO_ERR;
 
-    secp256k1_mod_inverse(z_inv3, point->Z);
-    secp256k1_sqr_mont(z_inv2, z_inv3);
-    secp256k1_mul_mont(x_aff, z_inv2, point->X);
+    secp256k1_mod_inverse_var(z_inv3, point->Z);
+    secp256k1_fe_sqr(z_inv2, z_inv3);
+    secp256k1_fe_mul(x_aff, z_inv2, point->X);
 
     if (x != NULL)
-        secp256k1_from_mont(x, x_aff);
+        secp256k1_fe_from_mont(x, x_aff);
 
     if (y != NULL) {
-        secp256k1_mul_mont(z_inv3, z_inv3, z_inv2);
-        secp256k1_mul_mont(y_aff, z_inv3, point->Y);
-        secp256k1_from_mont(y, y_aff);
+        secp256k1_fe_mul(z_inv3, z_inv3, z_inv2);
+        secp256k1_fe_mul(y_aff, z_inv3, point->Y);
+        secp256k1_fe_from_mont(y, y_aff);
     }
 
     return CRYPTO_OK;
 }
 
+int secp256k1_point_get_affine_batch(BN_ULONG (*x)[P256_LIMBS], BN_ULONG (*y)[P256_LIMBS],
+                                     const POINT256 *points, size_t n,
+                                     BN_ULONG (*scratch)[P256_LIMBS])
+{
+    size_t i;
+
+    if (x == NULL || y == NULL || points == NULL || scratch == NULL)
+        return CRYPTO_ERR;
+
+    if (n == 0)
+        return CRYPTO_OK;
+
+    /* secp256k1_point_to_affine_mont_batch into the x and y arrays */
+    points_to_affine_mont(x[0], y[0], P256_LIMBS, points, n, scratch);
+    for (i = 0; i < n; i++) {
+        secp256k1_fe_from_mont(x[i], x[i]);
+        secp256k1_fe_from_mont(y[i], y[i]);
+    }
+
+    return CRYPTO_OK;
+}
+
+void secp256k1_point_to_affine_mont_batch(POINT256_AFFINE *r, const POINT256 *points, size_t n,
+                                         BN_ULONG (*scratch)[P256_LIMBS])
+{
+    if (n == 0)
+        return;
+
+    points_to_affine_mont(r[0].X, r[0].Y, sizeof(POINT256_AFFINE) / sizeof(BN_ULONG), points, n, scratch);
+}
+
 int secp256k1_point_set_affine(POINT256 *point, const BN_ULONG x[P256_LIMBS], const BN_ULONG y[P256_LIMBS])
 {
     if (point == NULL || x == NULL || y == NULL)
         return CRYPTO_ERR;
 
-    secp256k1_to_mont(point->X, x);
-    secp256k1_to_mont(point->Y, y);
-    fp256_copy(point->Z, ONE);
+    secp256k1_fe_to_mont(point->X, x);
+    secp256k1_fe_to_mont(point->Y, y);
+    fp256_copy(point->Z, secp256k1_one);
     if (secp256k1_point_is_on_curve(point) == 0)
         return CRYPTO_ERR;
 
@@ -665,7 +812,15 @@ int secp256k1_point_set_affine(POINT256 *point, const BN_ULONG x[P256_LIMBS], co
 
 void secp256k1_precompute_table_free()
 {
+    secp256k1_gen_table_free();
+    /* only ever built on AVX2 hosts */
+    if (runtime_has_avx2())
+        secp256k1_gen_table_x4_free();
+#ifndef SECP256K1_STATIC_PRECOMP
     CRYPTO_free(secp256k1_precomp_storage);
+    secp256k1_precomp_storage = NULL;
+    secp256k1_precomp = NULL;
+#endif
 }
 
 void secp256k1_point_print(POINT256 *point)
@@ -0,0 +1,158 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright 2020 Meng-Shan Jiang                                             *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License");            *
+ * you may not use this file except in compliance with the License.           *
+ * You may obtain a copy of the License at                                    *
+ *                                                                            *
+ *    http://www.apache.org/licenses/LICENSE-2.0                              *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,         *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ *                                                                            *
+ *****************************************************************************/
+
+#ifndef HEADER_SECP256K1_LCL_H
+#define HEADER_SECP256K1_LCL_H
+
+#include <stdint.h>
+#include <secp256k1_x64/secp256k1.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* modulus for variable time inversion, in 5 signed 62-bit limbs */
+typedef struct {
+    int64_t modulus[5];
+    /* modulus^-1 mod 2^62 */
+    uint64_t modulus_inv62;
+} SECP256K1_MODINFO;
+
+/* lambda*(x, y) = (beta*x, y), beta in Montgomery domain */
+extern const BN_ULONG secp256k1_beta[P256_LIMBS];
+/* one in the representation of field elements */
+extern const BN_ULONG secp256k1_one[P256_LIMBS];
+
+/* generator table for Booth w7, 37 rows of 64 affine points(mont) */
+extern const PRECOMP256_ROW *secp256k1_precomp;
+#ifdef SECP256K1_STATIC_PRECOMP
+/* generated at build time by precomp_gen.c */
+extern const PRECOMP256_ROW secp256k1_precomp_table[37];
+#endif
+/* Booth w7 digits of scalar, digits[j] selects the entry of row j */
+void secp256k1_booth_w7_digits(unsigned int digits[37], const BN_ULONG scalar[P256_LIMBS]);
+/* r = s*G with the w7 table in asm, s < N */
+void secp256k1_ecmult_gen_w7(POINT256 *r, const BN_ULONG s[P256_LIMBS], const PRECOMP256_ROW *table);
+/* generator table of another geometry, NULL when the default one is used */
+extern const POINT256_AFFINE *secp256k1_gen_table;
+/* r = s*G with secp256k1_gen_table, s < N */
+void secp256k1_ecmult_gen_table(POINT256 *r, const BN_ULONG s[P256_LIMBS]);
+void secp256k1_gen_table_free(void);
+
+/* AVX2 four-lane engine(ecmult_avx2.c), CRYPTO_ERR when it is not built */
+int secp256k1_scalar_mul_gen_x4_avx2(POINT256 r[4], const BN_ULONG (*scalars)[P256_LIMBS]);
+int secp256k1_scalar_mul_point_x4_avx2(POINT256 r[4], const BN_ULONG (*scalars)[P256_LIMBS],
+                                       const POINT256 *points);
+void secp256k1_gen_table_x4_free(void);
+
+/* r = in^((p+1)/4) in asm, shares its addition chain with secp256k1_mod_inverse */
+void secp256k1_mod_sqrt_pow(BN_ULONG r[P256_LIMBS], const BN_ULONG in[P256_LIMBS]);
+
+/* bytes allocated for a prepared point of window w, 0 if w is not supported */
+size_t secp256k1_prepared_point_mem_size(int w);
+/* r = scalar * point through the point cache, CRYPTO_ERR if the cache is
+ * disabled or not usable for point, the caller then does the work itself.
+ */
+int secp256k1_point_cache_mul(POINT256 *r, const BN_ULONG scalar[P256_LIMBS], const POINT256 *point);
+
+/* Recode window to a signed digit, see ecp_nistputil.c for details */
+static inline unsigned int _booth_recode_w5(unsigned int in)
+{
+    unsigned int s, d;
+
+    s = ~((in >> 5) - 1);
+    d = (1 << 6) - in - 1;
+    d = (d & s) | (in & ~s);
+    d = (d >> 1) + (d & 1);
+
+    return (d << 1) + (s & 1);
+}
+
+static inline unsigned int _booth_recode_w7(unsigned int in)
+{
+    unsigned int s, d;
+
+    s = ~((in >> 7) - 1);
+    d = (1 << 8) - in - 1;
+    d = (d & s) | (in & ~s);
+    d = (d >> 1) + (d & 1);
+
+    return (d << 1) + (s & 1);
+}
+
+/* _booth_recode_w5/_booth_recode_w7 for any window w */
+static inline unsigned int _booth_recode_w(unsigned int in, int w)
+{
+    unsigned int s, d;
+
+    s = ~((in >> w) - 1);
+    d = (1 << (w + 1)) - in - 1;
+    d = (d & s) | (in & ~s);
+    d = (d >> 1) + (d & 1);
+
+    return (d << 1) + (s & 1);
+}
+
+int secp256k1_point_is_at_infinity(const POINT256 *a);
+/* points to affine coordinate without leaving the montgomery domain, one
+ * inversion for n points, infinity becomes (0, 0). r must not alias points,
+ * scratch must hold n field elements.
+ */
+void secp256k1_point_to_affine_mont_batch(POINT256_AFFINE *r, const POINT256 *points, size_t n,
+                                         BN_ULONG (*scratch)[P256_LIMBS]);
+
+/* width-w NAF of a 256-bit scalar, wnaf must hold 257 digits */
+void secp256k1_wnaf(int wnaf[257], const BN_ULONG scalar[P256_LIMBS], int w);
+/* table[i] = (2i+1)*point in affine coordinate(mont), i = 0 .. n-1,
+ * scratch must hold n points and zs n field elements.
+ */
+void secp256k1_odd_multiples_affine(POINT256_AFFINE *table, const POINT256 *point,
+                                    int n, POINT256 *scratch, BN_ULONG (*zs)[P256_LIMBS]);
+
+/* r = u1*G + u2*Q in variable time, u1, u2 < N, only for public inputs */
+void secp256k1_scalar_mul_double_var(POINT256 *r, const BN_ULONG u1[P256_LIMBS],
+                                     const BN_ULONG u2[P256_LIMBS], const POINT256 *Q);
+
+/* r = g_scalar*G + sum(scalars[i]*points[i]) in variable time, g_scalar
+ * may be NULL, scratch holds secp256k1_multi_scalar_mul_scratch_size(n)
+ * bytes. only for public inputs.
+ */
+int secp256k1_ecmult_multi_var(POINT256 *r, const BN_ULONG g_scalar[P256_LIMBS],
+                               const BN_ULONG (*scalars)[P256_LIMBS],
+                               const POINT256 *points, size_t n, void *scratch);
+
+extern const SECP256K1_MODINFO secp256k1_p_modinfo;
+extern const SECP256K1_MODINFO secp256k1_n_modinfo;
+
+/* r = a^-1 mod modulus, a must be in [0, modulus), inverse of 0 is 0.
+ * plain integers, not in Montgomery domain.
+ */
+void secp256k1_modinv_var(BN_ULONG r[P256_LIMBS], const BN_ULONG a[P256_LIMBS],
+                          const SECP256K1_MODINFO *modinfo);
+
+/* safegcd kernels implemented in assembly, t = {u, v, q, r} */
+int64_t secp256k1_divsteps_62_var(int64_t eta, uint64_t f0, uint64_t g0, int64_t t[4]);
+void secp256k1_update_fg_62_var(int len, int64_t f[5], int64_t g[5], const int64_t t[4]);
+void secp256k1_update_de_62(int64_t d[5], int64_t e[5], const int64_t t[4],
+                            const SECP256K1_MODINFO *modinfo);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
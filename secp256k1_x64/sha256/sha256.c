@@ -0,0 +1,218 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright 2020 Meng-Shan Jiang                                             *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License");            *
+ * you may not use this file except in compliance with the License.           *
+ * You may obtain a copy of the License at                                    *
+ *                                                                            *
+ *    http://www.apache.org/licenses/LICENSE-2.0                              *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ *                                                                            *
+ *****************************************************************************/
+
+#include <string.h>
+#include <secp256k1_x64/sha256.h>
+
+static const uint32_t K256[64] = {
+    0x428a2f98UL, 0x71374491UL, 0xb5c0fbcfUL, 0xe9b5dba5UL, 0x3956c25bUL, 0x59f111f1UL, 0x923f82a4UL, 0xab1c5ed5UL,
+    0xd807aa98UL, 0x12835b01UL, 0x243185beUL, 0x550c7dc3UL, 0x72be5d74UL, 0x80deb1feUL, 0x9bdc06a7UL, 0xc19bf174UL,
+    0xe49b69c1UL, 0xefbe4786UL, 0x0fc19dc6UL, 0x240ca1ccUL, 0x2de92c6fUL, 0x4a7484aaUL, 0x5cb0a9dcUL, 0x76f988daUL,
+    0x983e5152UL, 0xa831c66dUL, 0xb00327c8UL, 0xbf597fc7UL, 0xc6e00bf3UL, 0xd5a79147UL, 0x06ca6351UL, 0x14292967UL,
+    0x27b70a85UL, 0x2e1b2138UL, 0x4d2c6dfcUL, 0x53380d13UL, 0x650a7354UL, 0x766a0abbUL, 0x81c2c92eUL, 0x92722c85UL,
+    0xa2bfe8a1UL, 0xa81a664bUL, 0xc24b8b70UL, 0xc76c51a3UL, 0xd192e819UL, 0xd6990624UL, 0xf40e3585UL, 0x106aa070UL,
+    0x19a4c116UL, 0x1e376c08UL, 0x2748774cUL, 0x34b0bcb5UL, 0x391c0cb3UL, 0x4ed8aa4aUL, 0x5b9cca4fUL, 0x682e6ff3UL,
+    0x748f82eeUL, 0x78a5636fUL, 0x84c87814UL, 0x8cc70208UL, 0x90befffaUL, 0xa4506cebUL, 0xbef9a3f7UL, 0xc67178f2UL
+};
+
+#define CH(x, y, z)  (((x) & (y)) ^ (~(x) & (z)))
+#define MAJ(x, y, z) (((x) & (y)) ^ ((x) & (z)) ^ ((y) & (z)))
+#define SIGMA0(x)   (ROTR32(x, 2) ^ ROTR32(x, 13) ^ ROTR32(x, 22))
+#define SIGMA1(x)   (ROTR32(x, 6) ^ ROTR32(x, 11) ^ ROTR32(x, 25))
+#define sigma0(x)   (ROTR32(x, 7) ^ ROTR32(x, 18) ^ ((x) >> 3))
+#define sigma1(x)   (ROTR32(x, 17) ^ ROTR32(x, 19) ^ ((x) >> 10))
+
+#define LOAD32_BE(p) \
+    (((uint32_t)(p)[0] << 24) | ((uint32_t)(p)[1] << 16) | ((uint32_t)(p)[2] << 8) | (uint32_t)(p)[3])
+
+#define STORE32_BE(p, v) do { \
+    (p)[0] = (unsigned char)((v) >> 24); \
+    (p)[1] = (unsigned char)((v) >> 16); \
+    (p)[2] = (unsigned char)((v) >> 8);  \
+    (p)[3] = (unsigned char)(v);         \
+} while (0)
+
+static void sha256_block(uint32_t h[8], const unsigned char block[SECP256K1_SHA256_BLOCK_SIZE])
+{
+    uint32_t w[64];
+    uint32_t a, b, c, d, e, f, g, k, t1, t2;
+    int i;
+
+    for (i = 0; i < 16; i++)
+        w[i] = LOAD32_BE(block + 4 * i);
+    for (i = 16; i < 64; i++)
+        w[i] = sigma1(w[i - 2]) + w[i - 7] + sigma0(w[i - 15]) + w[i - 16];
+
+    a = h[0]; b = h[1]; c = h[2]; d = h[3];
+    e = h[4]; f = h[5]; g = h[6]; k = h[7];
+
+    for (i = 0; i < 64; i++) {
+        t1 = k + SIGMA1(e) + CH(e, f, g) + K256[i] + w[i];
+        t2 = SIGMA0(a) + MAJ(a, b, c);
+        k = g; g = f; f = e; e = d + t1;
+        d = c; c = b; b = a; a = t1 + t2;
+    }
+
+    h[0] += a; h[1] += b; h[2] += c; h[3] += d;
+    h[4] += e; h[5] += f; h[6] += g; h[7] += k;
+}
+
+void secp256k1_sha256_init(SECP256K1_SHA256_CTX *ctx)
+{
+    ctx->h[0] = 0x6a09e667UL;
+    ctx->h[1] = 0xbb67ae85UL;
+    ctx->h[2] = 0x3c6ef372UL;
+    ctx->h[3] = 0xa54ff53aUL;
+    ctx->h[4] = 0x510e527fUL;
+    ctx->h[5] = 0x9b05688cUL;
+    ctx->h[6] = 0x1f83d9abUL;
+    ctx->h[7] = 0x5be0cd19UL;
+    ctx->bytes = 0;
+}
+
+void secp256k1_sha256_update(SECP256K1_SHA256_CTX *ctx, const unsigned char *data, size_t len)
+{
+    size_t used = (size_t)(ctx->bytes % SECP256K1_SHA256_BLOCK_SIZE);
+    size_t n;
+
+    ctx->bytes += len;
+
+    if (used != 0) {
+        n = SECP256K1_SHA256_BLOCK_SIZE - used;
+        if (n > len)
+            n = len;
+        memcpy(ctx->buf + used, data, n);
+        data += n;
+        len -= n;
+        if (used + n < SECP256K1_SHA256_BLOCK_SIZE)
+            return;
+        sha256_block(ctx->h, ctx->buf);
+    }
+
+    while (len >= SECP256K1_SHA256_BLOCK_SIZE) {
+        sha256_block(ctx->h, data);
+        data += SECP256K1_SHA256_BLOCK_SIZE;
+        len -= SECP256K1_SHA256_BLOCK_SIZE;
+    }
+
+    if (len > 0)
+        memcpy(ctx->buf, data, len);
+}
+
+void secp256k1_sha256_final(unsigned char digest[SECP256K1_SHA256_DIGEST_LENGTH], SECP256K1_SHA256_CTX *ctx)
+{
+    static const unsigned char pad[SECP256K1_SHA256_BLOCK_SIZE] = { 0x80 };
+    unsigned char len_be[8];
+    uint64_t bits = ctx->bytes << 3;
+    int i;
+
+    for (i = 0; i < 8; i++)
+        len_be[i] = (unsigned char)(bits >> (56 - 8 * i));
+
+    /* pad to 56 mod 64, then the 64-bit length */
+    secp256k1_sha256_update(ctx, pad, 1 + ((119 - (size_t)(ctx->bytes % SECP256K1_SHA256_BLOCK_SIZE))
+                                           % SECP256K1_SHA256_BLOCK_SIZE));
+    secp256k1_sha256_update(ctx, len_be, 8);
+
+    for (i = 0; i < 8; i++)
+        STORE32_BE(digest + 4 * i, ctx->h[i]);
+
+    memset(ctx, 0, sizeof(SECP256K1_SHA256_CTX));
+}
+
+void secp256k1_sha256(unsigned char digest[SECP256K1_SHA256_DIGEST_LENGTH], const unsigned char *data, size_t len)
+{
+    SECP256K1_SHA256_CTX ctx;
+
+    secp256k1_sha256_init(&ctx);
+    secp256k1_sha256_update(&ctx, data, len);
+    secp256k1_sha256_final(digest, &ctx);
+}
+
+void secp256k1_sha256_init_tagged(SECP256K1_SHA256_CTX *ctx, const unsigned char *tag, size_t taglen)
+{
+    unsigned char t[SECP256K1_SHA256_DIGEST_LENGTH];
+
+    secp256k1_sha256(t, tag, taglen);
+    secp256k1_sha256_init(ctx);
+    secp256k1_sha256_update(ctx, t, SECP256K1_SHA256_DIGEST_LENGTH);
+    secp256k1_sha256_update(ctx, t, SECP256K1_SHA256_DIGEST_LENGTH);
+}
+
+void secp256k1_sha256_tagged(unsigned char digest[SECP256K1_SHA256_DIGEST_LENGTH],
+                             const unsigned char *tag, size_t taglen,
+                             const unsigned char *data, size_t len)
+{
+    SECP256K1_SHA256_CTX ctx;
+
+    secp256k1_sha256_init_tagged(&ctx, tag, taglen);
+    secp256k1_sha256_update(&ctx, data, len);
+    secp256k1_sha256_final(digest, &ctx);
+}
+
+void secp256k1_hmac_sha256_init(SECP256K1_HMAC_SHA256_CTX *ctx, const unsigned char *key, size_t keylen)
+{
+    unsigned char k[SECP256K1_SHA256_BLOCK_SIZE];
+    int i;
+
+    memset(k, 0, SECP256K1_SHA256_BLOCK_SIZE);
+    if (keylen > SECP256K1_SHA256_BLOCK_SIZE)
+        secp256k1_sha256(k, key, keylen);
+    else if (keylen > 0)
+        memcpy(k, key, keylen);
+
+    for (i = 0; i < SECP256K1_SHA256_BLOCK_SIZE; i++)
+        k[i] ^= 0x36;
+    secp256k1_sha256_init(&ctx->inner);
+    secp256k1_sha256_update(&ctx->inner, k, SECP256K1_SHA256_BLOCK_SIZE);
+
+    /* 0x36 ^ 0x5c */
+    for (i = 0; i < SECP256K1_SHA256_BLOCK_SIZE; i++)
+        k[i] ^= 0x6a;
+    secp256k1_sha256_init(&ctx->outer);
+    secp256k1_sha256_update(&ctx->outer, k, SECP256K1_SHA256_BLOCK_SIZE);
+
+    memset(k, 0, SECP256K1_SHA256_BLOCK_SIZE);
+}
+
+void secp256k1_hmac_sha256_update(SECP256K1_HMAC_SHA256_CTX *ctx, const unsigned char *data, size_t len)
+{
+    secp256k1_sha256_update(&ctx->inner, data, len);
+}
+
+void secp256k1_hmac_sha256_final(unsigned char mac[SECP256K1_SHA256_DIGEST_LENGTH], SECP256K1_HMAC_SHA256_CTX *ctx)
+{
+    unsigned char t[SECP256K1_SHA256_DIGEST_LENGTH];
+
+    secp256k1_sha256_final(t, &ctx->inner);
+    secp256k1_sha256_update(&ctx->outer, t, SECP256K1_SHA256_DIGEST_LENGTH);
+    secp256k1_sha256_final(mac, &ctx->outer);
+
+    memset(t, 0, SECP256K1_SHA256_DIGEST_LENGTH);
+}
+
+void secp256k1_hmac_sha256(unsigned char mac[SECP256K1_SHA256_DIGEST_LENGTH],
+                           const unsigned char *key, size_t keylen,
+                           const unsigned char *data, size_t len)
+{
+    SECP256K1_HMAC_SHA256_CTX ctx;
+
+    secp256k1_hmac_sha256_init(&ctx, key, keylen);
+    secp256k1_hmac_sha256_update(&ctx, data, len);
+    secp256k1_hmac_sha256_final(mac, &ctx);
+}
@@ -16,8 +16,14 @@
  *                                                                            *
  *****************************************************************************/
 
+#include <secp256k1_x64/cpuid.h>
 #include "../test/test.h"
 #include "speed_lcl.h"
+#include "../secp256k1_x64/secp256k1/field_lcl.h"
+#include "../secp256k1_x64/secp256k1/secp256k1_lcl.h"
+#ifdef HAVE_IMMINTRIN_H
+# include <immintrin.h>
+#endif
 
 static void secp256k1_point_add_speed(void *p)
 {
@@ -130,18 +136,660 @@ static void secp256k1_scalar_mul_gen_speed(void *p)
     printf("secp256k1_scalar_mul_gen : %lu  op/s\n\n", N*1000000/total_time);
 }
 
+#ifdef HAVE_IMMINTRIN_H
+/* same as above, but the generator table is flushed from the caches before
+ * every call, as when other work evicts it between calls. Only the calls
+ * are counted.
+ */
+static void secp256k1_scalar_mul_gen_cold_speed(void *p)
+{
+    int64_t N;
+    uint64_t ticks = 0;
+    BN_ULONG scalar[P256_LIMBS];
+    POINT256 r;
+    const unsigned char *table = (const unsigned char *)secp256k1_precomp;
+
+    TEST_ARGS *args = (TEST_ARGS*)p;
+    N = args->N;
+
+    BENCH_VARS;
+
+    TIMER_START();
+
+    for (int64_t i = 0; i < N; i++) {
+        secp256k1_rand(scalar);
+        for (size_t j = 0; j < 37 * sizeof(PRECOMP256_ROW); j += 64)
+            _mm_clflush(table + j);
+        _mm_mfence();
+
+        COUNTER_START();
+        secp256k1_scalar_mul_gen(&r, scalar);
+        COUNTER_STOP();
+        ticks += TICKS();
+    }
+
+    TIMER_STOP();
+
+    printf("prefetch distance : %d windows\n", SECP256K1_GEN_PREFETCH);
+    printf("average cycles per op : %lu \n", (unsigned long)(ticks/N));
+    printf("secp256k1_scalar_mul_gen(flush included) : %lu  op/s\n\n", N*1000000/total_time);
+}
+#endif
+
+static void secp256k1_precompute_table_gen_speed(void *p)
+{
+    int64_t N;
+
+    TEST_ARGS *args = (TEST_ARGS*)p;
+    N = args->N;
+
+    BENCH_VARS;
+
+    COUNTER_START();
+    TIMER_START();
+    
+    /* what CRYPTO_init pays at startup */
+    for (int64_t i = 0; i < N; i++) {
+        secp256k1_precompute_table_free();
+        secp256k1_precompute_table_gen();
+    }
+    
+    COUNTER_STOP();
+    TIMER_STOP();
+
+    printf("average cycles per op : %lu \n", (TICKS()/N));
+    printf("average time per op : %lu us\n", total_time/N);
+    printf("secp256k1_precompute_table_gen : %lu  op/s\n", N*1000000/total_time);
+}
+
+static void secp256k1_scalar_mul_gen_config_speed(void *p)
+{
+    int64_t N;
+    BN_ULONG scalar[P256_LIMBS];
+    POINT256 r;
+    const SECP256K1_GEN_CONFIG configs[] = {
+        { SECP256K1_GEN_BOOTH, 4, 0, 0 },
+        { SECP256K1_GEN_BOOTH, 5, 0, 0 },
+        { SECP256K1_GEN_BOOTH, 6, 0, 0 },
+        { SECP256K1_GEN_BOOTH, 8, 0, 0 },
+        { SECP256K1_GEN_COMB,  0, 4, 16 },
+        { SECP256K1_GEN_COMB,  0, 5, 13 },
+        { SECP256K1_GEN_COMB,  0, 6, 11 },
+        { SECP256K1_GEN_COMB,  0, 6, 22 },
+        { SECP256K1_GEN_COMB,  0, 7, 19 },
+        { SECP256K1_GEN_COMB,  0, 8, 16 },
+        { SECP256K1_GEN_COMB,  0, 8, 32 },
+        /* default, restored at the end */
+        { SECP256K1_GEN_BOOTH, 7, 0, 0 },
+    };
+
+    TEST_ARGS *args = (TEST_ARGS*)p;
+    N = args->N;
+
+    /* setup */
+    secp256k1_rand(scalar);
+
+    for (int i = 0; i < sizeof(configs) / sizeof(SECP256K1_GEN_CONFIG); i++) {
+        if (secp256k1_precompute_table_config(&configs[i]) != CRYPTO_OK)
+            continue;
+
+        BENCH_VARS;
+
+        COUNTER_START();
+        TIMER_START();
+        
+        for (int64_t j = 0; j < N; j++)
+            secp256k1_scalar_mul_gen(&r, scalar);
+        
+        COUNTER_STOP();
+        TIMER_STOP();
+
+        if (configs[i].method == SECP256K1_GEN_BOOTH)
+            printf("booth w%d, ", configs[i].window);
+        else
+            printf("comb teeth %d blocks %d, ", configs[i].teeth, configs[i].blocks);
+        printf("table %lu bytes, average cycles per op : %lu \n",
+               (unsigned long)secp256k1_precompute_table_size(), (TICKS()/N));
+        printf("secp256k1_scalar_mul_gen : %lu  op/s\n\n", N*1000000/total_time);
+    }
+}
+
 static void secp256k1_scalar_mul_point_speed(void *p)
 {
     int64_t N;
     BN_ULONG scalar[P256_LIMBS];
-    POINT256 r, point;
+    POINT256 r, point;
+
+    TEST_ARGS *args = (TEST_ARGS*)p;
+    N = args->N;
+
+    /* setup */
+    secp256k1_rand(scalar);
+    secp256k1_get_generator(&point);
+
+    BENCH_VARS;
+
+    COUNTER_START();
+    TIMER_START();
+    
+    for (int64_t i = 0; i < N; i++)
+        secp256k1_scalar_mul_point(&r, scalar, &point);
+    
+    COUNTER_STOP();
+    TIMER_STOP();
+
+    printf("average cycles per op : %lu \n", (TICKS()/N));
+    printf("secp256k1_scalar_mul_point : %lu  op/s\n\n", N*1000000/total_time);
+}
+
+static void secp256k1_scalar_mul_gen_batch_speed(void *p)
+{
+    int64_t N;
+    BN_ULONG scalars[64][P256_LIMBS];
+    POINT256 r[64];
+
+    TEST_ARGS *args = (TEST_ARGS*)p;
+    N = args->N;
+
+    /* setup */
+    for (int i = 0; i < 64; i++)
+        secp256k1_rand(scalars[i]);
+
+    BENCH_VARS;
+
+    COUNTER_START();
+    TIMER_START();
+
+    for (int64_t i = 0; i < N; i++)
+        secp256k1_scalar_mul_gen_batch(r, (const BN_ULONG (*)[P256_LIMBS])scalars, 64);
+
+    COUNTER_STOP();
+    TIMER_STOP();
+
+    printf("batch 64, average cycles per point : %lu \n", (TICKS()/N/64));
+    printf("secp256k1_scalar_mul_gen_batch : %lu  points/s\n\n", 64*N*1000000/total_time);
+}
+
+/* four scalar calls against the AVX2 engine, per point */
+static void secp256k1_scalar_mul_x4_speed(void *p)
+{
+    int64_t N;
+    BN_ULONG scalars[4][P256_LIMBS], k[P256_LIMBS];
+    POINT256 r[4], points[4], q;
+    static const char *names[4] = {
+        "4 x secp256k1_scalar_mul_gen", "secp256k1_scalar_mul_gen_x4_avx2",
+        "4 x secp256k1_scalar_mul_point", "secp256k1_scalar_mul_point_x4_avx2"
+    };
+
+    TEST_ARGS *args = (TEST_ARGS*)p;
+    N = args->N;
+
+    /* setup */
+    for (int i = 0; i < 4; i++) {
+        secp256k1_rand(scalars[i]);
+        secp256k1_scalar_mul_gen(&points[i], scalars[i]);
+    }
+
+    for (int j = 0; j < 4; j++) {
+        BENCH_VARS;
+
+        /* the engine needs AVX2 */
+        if ((j & 1) == 1 && !runtime_has_avx2()) {
+            printf("%s : no avx2\n\n", names[j]);
+            continue;
+        }
+
+        COUNTER_START();
+        TIMER_START();
+
+        for (int64_t i = 0; i < N; i++) {
+            switch (j) {
+            case 0:
+                for (int l = 0; l < 4; l++) {
+                    fp256_copy(k, scalars[l]);
+                    secp256k1_scalar_mul_gen(&r[l], k);
+                }
+                break;
+            case 1:
+                secp256k1_scalar_mul_gen_x4_avx2(r, (const BN_ULONG (*)[P256_LIMBS])scalars);
+                break;
+            case 2:
+                for (int l = 0; l < 4; l++) {
+                    fp256_copy(k, scalars[l]);
+                    q = points[l];
+                    secp256k1_scalar_mul_point(&r[l], k, &q);
+                }
+                break;
+            default:
+                secp256k1_scalar_mul_point_x4_avx2(r, (const BN_ULONG (*)[P256_LIMBS])scalars, points);
+                break;
+            }
+        }
+
+        COUNTER_STOP();
+        TIMER_STOP();
+
+        printf("average cycles per point : %lu \n", (TICKS()/N/4));
+        printf("%s : %lu  points/s\n\n", names[j], 4*N*1000000/total_time);
+    }
+}
+
+static void secp256k1_scalar_mul_point_var_speed(void *p)
+{
+    int64_t N;
+    BN_ULONG scalar[P256_LIMBS];
+    POINT256 r, point;
+
+    TEST_ARGS *args = (TEST_ARGS*)p;
+    N = args->N;
+
+    /* setup */
+    secp256k1_rand(scalar);
+    secp256k1_get_generator(&point);
+
+    for (int w = 3; w <= 7; w++) {
+        BENCH_VARS;
+
+        COUNTER_START();
+        TIMER_START();
+        
+        for (int64_t i = 0; i < N; i++)
+            secp256k1_scalar_mul_point_var(&r, scalar, &point, w);
+        
+        COUNTER_STOP();
+        TIMER_STOP();
+
+        printf("w = %d, average cycles per op : %lu \n", w, (TICKS()/N));
+        printf("secp256k1_scalar_mul_point_var : %lu  op/s\n\n", N*1000000/total_time);
+    }
+}
+
+static void secp256k1_scalar_mul_prepared_speed(void *p)
+{
+    int64_t N;
+    BN_ULONG scalar[P256_LIMBS];
+    POINT256 r, point;
+    SECP256K1_PREPARED_POINT *pp;
+
+    TEST_ARGS *args = (TEST_ARGS*)p;
+    N = args->N;
+
+    /* setup */
+    secp256k1_rand(scalar);
+    secp256k1_get_generator(&point);
+
+    for (int w = 4; w <= 8; w++) {
+        pp = secp256k1_prepared_point_new(&point, w);
+
+        BENCH_VARS;
+
+        COUNTER_START();
+        TIMER_START();
+        
+        for (int64_t i = 0; i < N; i++)
+            secp256k1_scalar_mul_prepared(&r, scalar, pp);
+        
+        COUNTER_STOP();
+        TIMER_STOP();
+
+        printf("w = %d, serialized %lu bytes, average cycles per op : %lu \n", w,
+               (unsigned long)secp256k1_prepared_point_serialized_size(pp), (TICKS()/N));
+        printf("secp256k1_scalar_mul_prepared : %lu  op/s\n\n", N*1000000/total_time);
+        secp256k1_prepared_point_free(pp);
+    }
+}
+
+static void secp256k1_scalar_mul_point_cache_speed(void *p)
+{
+    int64_t N;
+    BN_ULONG scalar[P256_LIMBS], x[P256_LIMBS], y[P256_LIMBS];
+    POINT256 r, points[64];
+    SECP256K1_POINT_CACHE_STATS st;
+    /* number of distinct points, the cache holds 16 entries */
+    static const int keys[] = { 1, 16, 64 };
+
+    TEST_ARGS *args = (TEST_ARGS*)p;
+    N = args->N;
+
+    /* setup */
+    secp256k1_rand(scalar);
+    for (int i = 0; i < 64; i++) {
+        secp256k1_rand(x);
+        secp256k1_scalar_mul_gen(&r, x);
+        secp256k1_point_get_affine(x, y, &r);
+        secp256k1_point_set_affine(&points[i], x, y);
+    }
+
+    for (int j = 0; j < 3; j++) {
+        /* 16 entries of window 6 */
+        secp256k1_point_cache_config(16 * 4500, 0);
+
+        BENCH_VARS;
+
+        COUNTER_START();
+        TIMER_START();
+        
+        for (int64_t i = 0; i < N; i++)
+            secp256k1_scalar_mul_point(&r, scalar, &points[i % keys[j]]);
+        
+        COUNTER_STOP();
+        TIMER_STOP();
+
+        secp256k1_point_cache_stats(&st);
+        printf("%d points, hits %lu, misses %lu, average cycles per op : %lu \n", keys[j],
+               (unsigned long)st.hits, (unsigned long)st.misses, (TICKS()/N));
+        printf("secp256k1_scalar_mul_point(cache) : %lu  op/s\n\n", N*1000000/total_time);
+    }
+    secp256k1_point_cache_config(0, 0);
+}
+
+static void secp256k1_multi_scalar_mul_speed(void *p)
+{
+    int64_t N;
+    const size_t sizes[] = { 16, 64, 256, 1024, 8192, 32768 };
+    BN_ULONG (*scalars)[P256_LIMBS];
+    POINT256 r, *points;
+    void *scratch;
+
+    TEST_ARGS *args = (TEST_ARGS*)p;
+
+    /* setup */
+    scalars = (BN_ULONG (*)[P256_LIMBS])malloc(32768 * sizeof(BN_ULONG) * P256_LIMBS);
+    points = (POINT256*)malloc(32768 * sizeof(POINT256));
+    secp256k1_get_generator(&r);
+    for (int i = 0; i < 32768; i++) {
+        secp256k1_rand(scalars[i]);
+        secp256k1_point_add(&r, &r, &r);
+        points[i] = r;
+    }
+
+    for (int i = 0; i < sizeof(sizes) / sizeof(size_t); i++) {
+        /* same number of points in every run */
+        N = args->N / sizes[i] + 1;
+        scratch = malloc(secp256k1_multi_scalar_mul_scratch_size(sizes[i]));
+
+        BENCH_VARS;
+
+        COUNTER_START();
+        TIMER_START();
+        
+        for (int64_t j = 0; j < N; j++)
+            secp256k1_multi_scalar_mul(&r, (const BN_ULONG (*)[P256_LIMBS])scalars, points, sizes[i], scratch);
+        
+        COUNTER_STOP();
+        TIMER_STOP();
+
+        printf("n = %d, average cycles per point : %lu \n", (int)sizes[i], (TICKS()/(N*sizes[i])));
+        printf("secp256k1_multi_scalar_mul : %lu  points/s\n\n", N*sizes[i]*1000000/total_time);
+        free(scratch);
+    }
+
+    free(scalars);
+    free(points);
+}
+
+static void secp256k1_ecdsa_sign_speed(void *p)
+{
+    int64_t N;
+    BN_ULONG d[P256_LIMBS];
+    unsigned char seckey[32], msg[32], sig[64];
+
+    TEST_ARGS *args = (TEST_ARGS*)p;
+    N = args->N;
+
+    /* setup */
+    secp256k1_rand(d);
+    secp256k1_scalar_reduce(d, d);
+    fp256_get_bytes(seckey, d);
+    RAND_buf(msg, 32);
+
+    BENCH_VARS;
+
+    COUNTER_START();
+    TIMER_START();
+    
+    for (int64_t i = 0; i < N; i++) {
+        secp256k1_ecdsa_sign(sig, msg, seckey);
+        msg[0] = sig[0];
+    }
+    
+    COUNTER_STOP();
+    TIMER_STOP();
+
+    printf("average cycles per sign : %lu \n", (TICKS()/N));
+    printf("secp256k1_ecdsa_sign : %lu  op/s\n\n", N*1000000/total_time);
+}
+
+static void secp256k1_schnorrsig_sign_speed(void *p)
+{
+    int64_t N;
+    BN_ULONG d[P256_LIMBS];
+    unsigned char seckey[32], aux[32], msg[32], sig[64];
+
+    TEST_ARGS *args = (TEST_ARGS*)p;
+    N = args->N;
+
+    /* setup */
+    secp256k1_rand(d);
+    secp256k1_scalar_reduce(d, d);
+    fp256_get_bytes(seckey, d);
+    RAND_buf(aux, 32);
+    RAND_buf(msg, 32);
+
+    BENCH_VARS;
+
+    COUNTER_START();
+    TIMER_START();
+    
+    for (int64_t i = 0; i < N; i++) {
+        secp256k1_schnorrsig_sign(sig, msg, seckey, aux);
+        msg[0] = sig[0];
+    }
+    
+    COUNTER_STOP();
+    TIMER_STOP();
+
+    printf("average cycles per sign : %lu \n", (TICKS()/N));
+    printf("secp256k1_schnorrsig_sign : %lu  op/s\n\n", N*1000000/total_time);
+}
+
+static void secp256k1_schnorrsig_verify_speed(void *p)
+{
+    int64_t N;
+    BN_ULONG d[P256_LIMBS];
+    unsigned char seckey[32], pubkey[32], msg[32], sig[64];
+
+    TEST_ARGS *args = (TEST_ARGS*)p;
+    N = args->N;
+
+    /* setup */
+    secp256k1_rand(d);
+    secp256k1_scalar_reduce(d, d);
+    fp256_get_bytes(seckey, d);
+    RAND_buf(msg, 32);
+    secp256k1_xonly_pubkey_create(pubkey, seckey);
+    secp256k1_schnorrsig_sign(sig, msg, seckey, NULL);
+
+    BENCH_VARS;
+
+    COUNTER_START();
+    TIMER_START();
+    
+    for (int64_t i = 0; i < N; i++)
+        secp256k1_schnorrsig_verify(sig, msg, pubkey);
+    
+    COUNTER_STOP();
+    TIMER_STOP();
+
+    printf("average cycles per verify : %lu \n", (TICKS()/N));
+    printf("secp256k1_schnorrsig_verify : %lu  op/s\n\n", N*1000000/total_time);
+}
+
+#define SCHNORRSIG_BATCH_SIZE 1000
+
+static void secp256k1_schnorrsig_verify_batch_speed(void *p)
+{
+    int64_t N;
+    BN_ULONG d[P256_LIMBS];
+    unsigned char seckey[32];
+    unsigned char (*sig)[64], (*msg)[32], (*pubkey)[32];
+
+    TEST_ARGS *args = (TEST_ARGS*)p;
+    N = args->N;
+
+    /* setup */
+    sig = (unsigned char (*)[64])malloc(SCHNORRSIG_BATCH_SIZE * 64);
+    msg = (unsigned char (*)[32])malloc(SCHNORRSIG_BATCH_SIZE * 32);
+    pubkey = (unsigned char (*)[32])malloc(SCHNORRSIG_BATCH_SIZE * 32);
+    for (int i = 0; i < SCHNORRSIG_BATCH_SIZE; i++) {
+        secp256k1_rand(d);
+        secp256k1_scalar_reduce(d, d);
+        fp256_get_bytes(seckey, d);
+        RAND_buf(msg[i], 32);
+        secp256k1_xonly_pubkey_create(pubkey[i], seckey);
+        secp256k1_schnorrsig_sign(sig[i], msg[i], seckey, NULL);
+    }
+
+    BENCH_VARS;
+
+    COUNTER_START();
+    TIMER_START();
+    
+    for (int64_t i = 0; i < N; i++)
+        secp256k1_schnorrsig_verify_batch((const unsigned char (*)[64])sig, (const unsigned char (*)[32])msg,
+                                          (const unsigned char (*)[32])pubkey, SCHNORRSIG_BATCH_SIZE);
+    
+    COUNTER_STOP();
+    TIMER_STOP();
+
+    printf("average cycles per signature : %lu \n", (TICKS()/(N*SCHNORRSIG_BATCH_SIZE)));
+    printf("secp256k1_schnorrsig_verify_batch(%d) : %lu  op/s\n\n", SCHNORRSIG_BATCH_SIZE, N*1000000/total_time);
+
+    free(sig);
+    free(msg);
+    free(pubkey);
+}
+
+static void secp256k1_ecdsa_verify_speed(void *p)
+{
+    int64_t N;
+    BN_ULONG d[P256_LIMBS], k[P256_LIMBS], e[P256_LIMBS];
+    BN_ULONG r[P256_LIMBS], s[P256_LIMBS], x[P256_LIMBS], y[P256_LIMBS];
+    POINT256 R, pubkey;
+    unsigned char msg[32], sig[64];
+
+    TEST_ARGS *args = (TEST_ARGS*)p;
+    N = args->N;
+
+    /* setup, sig = (r, s), s = k^-1 * (e + r*d) */
+    secp256k1_rand(d);
+    secp256k1_rand(k);
+    secp256k1_rand(e);
+    secp256k1_scalar_reduce(d, d);
+    secp256k1_scalar_reduce(k, k);
+    secp256k1_scalar_reduce(e, e);
+    secp256k1_scalar_mul_gen(&pubkey, d);
+    secp256k1_scalar_mul_gen(&R, k);
+    secp256k1_point_get_affine(x, y, &R);
+    secp256k1_scalar_reduce(r, x);
+
+    secp256k1_scalar_to_mont(k, k);
+    secp256k1_scalar_inverse(k, k);
+    secp256k1_scalar_to_mont(s, r);
+    secp256k1_scalar_mul_mont(s, s, d);
+    secp256k1_scalar_add(s, s, e);
+    secp256k1_scalar_mul_mont(s, s, k);
+
+    fp256_get_bytes(msg, e);
+    fp256_get_bytes(sig, r);
+    fp256_get_bytes(sig + 32, s);
+
+    BENCH_VARS;
+
+    COUNTER_START();
+    TIMER_START();
+    
+    for (int64_t i = 0; i < N; i++)
+        secp256k1_ecdsa_verify(msg, sig, &pubkey);
+    
+    COUNTER_STOP();
+    TIMER_STOP();
+
+    printf("average cycles per verify : %lu \n", (TICKS()/N));
+    printf("secp256k1_ecdsa_verify : %lu  op/s\n\n", N*1000000/total_time);
+}
+
+static void secp256k1_point_get_affine_speed(void *p)
+{
+    int64_t N;
+    BN_ULONG x[P256_LIMBS], y[P256_LIMBS];
+    POINT256 r;
+
+    TEST_ARGS *args = (TEST_ARGS*)p;
+    N = args->N;
+
+    /* setup */
+    secp256k1_get_generator(&r);
+
+    BENCH_VARS;
+
+    COUNTER_START();
+    TIMER_START();
+    
+    for (int64_t i = 0; i < N; i++)
+        secp256k1_point_get_affine(x, y, &r);
+    
+    COUNTER_STOP();
+    TIMER_STOP();
+
+    printf("average cycles per op : %lu \n", (TICKS()/N));
+    printf("secp256k1_point_get_affine : %lu  op/s\n\n", N*1000000/total_time);
+}
+
+#define AFFINE_BATCH_SIZE 256
+
+static void secp256k1_point_get_affine_batch_speed(void *p)
+{
+    int64_t N;
+    static BN_ULONG x[AFFINE_BATCH_SIZE][P256_LIMBS], y[AFFINE_BATCH_SIZE][P256_LIMBS];
+    static BN_ULONG scratch[AFFINE_BATCH_SIZE][P256_LIMBS];
+    static POINT256 points[AFFINE_BATCH_SIZE];
+    BN_ULONG scalar[P256_LIMBS];
+
+    TEST_ARGS *args = (TEST_ARGS*)p;
+    N = args->N / AFFINE_BATCH_SIZE + 1;
+
+    /* setup */
+    for (int i = 0; i < AFFINE_BATCH_SIZE; i++) {
+        secp256k1_rand(scalar);
+        secp256k1_scalar_mul_gen(&points[i], scalar);
+    }
+
+    BENCH_VARS;
+
+    COUNTER_START();
+    TIMER_START();
+    
+    for (int64_t i = 0; i < N; i++)
+        secp256k1_point_get_affine_batch(x, y, points, AFFINE_BATCH_SIZE, scratch);
+    
+    COUNTER_STOP();
+    TIMER_STOP();
+
+    printf("average cycles per point : %lu \n", (TICKS()/(N*AFFINE_BATCH_SIZE)));
+    printf("secp256k1_point_get_affine_batch : %lu  point/s\n\n", N*AFFINE_BATCH_SIZE*1000000/total_time);
+}
+
+static void secp256k1_mod_inverse_speed(void *p)
+{
+    int64_t N;
+    BN_ULONG r[P256_LIMBS], a[P256_LIMBS];
 
     TEST_ARGS *args = (TEST_ARGS*)p;
     N = args->N;
 
     /* setup */
-    secp256k1_rand(scalar);
-    secp256k1_get_generator(&point);
+    secp256k1_rand(a);
 
     BENCH_VARS;
 
@@ -149,46 +797,103 @@ static void secp256k1_scalar_mul_point_speed(void *p)
     TIMER_START();
     
     for (int64_t i = 0; i < N; i++)
-        secp256k1_scalar_mul_point(&r, scalar, &point);
+        secp256k1_mod_inverse(r, a);
     
     COUNTER_STOP();
     TIMER_STOP();
 
     printf("average cycles per op : %lu \n", (TICKS()/N));
-    printf("secp256k1_scalar_mul_point : %lu  op/s\n\n", N*1000000/total_time);
+    printf("secp256k1_mod_inverse : %lu  op/s\n\n", N*1000000/total_time);
 }
 
-static void secp256k1_point_get_affine_speed(void *p)
+#ifdef SECP256K1_HAVE_INLINE_FIELD
+static void secp256k1_fe_mul_inline_speed(void *p)
 {
     int64_t N;
     BN_ULONG x[P256_LIMBS], y[P256_LIMBS];
-    POINT256 r;
 
     TEST_ARGS *args = (TEST_ARGS*)p;
     N = args->N;
 
     /* setup */
-    secp256k1_get_generator(&r);
+    secp256k1_rand(x);
+    secp256k1_rand(y);
 
     BENCH_VARS;
 
     COUNTER_START();
     TIMER_START();
     
+    /* feed the result back, the call would be hoisted out of the loop otherwise */
     for (int64_t i = 0; i < N; i++)
-        secp256k1_point_get_affine(x, y, &r);
+        fe_mul_inline(x, x, y);
     
     COUNTER_STOP();
     TIMER_STOP();
 
     printf("average cycles per op : %lu \n", (TICKS()/N));
-    printf("secp256k1_point_get_affine : %lu  op/s\n\n", N*1000000/total_time);
+    printf("fe_mul_inline : %lu  op/s\n\n", N*1000000/total_time);
 }
 
-static void secp256k1_mod_inverse_speed(void *p)
+static void secp256k1_fe_sqr_inline_speed(void *p)
 {
     int64_t N;
-    BN_ULONG r[P256_LIMBS], a[P256_LIMBS];
+    BN_ULONG x[P256_LIMBS];
+
+    TEST_ARGS *args = (TEST_ARGS*)p;
+    N = args->N;
+
+    /* setup */
+    secp256k1_rand(x);
+
+    BENCH_VARS;
+
+    COUNTER_START();
+    TIMER_START();
+    
+    /* feed the result back, the call would be hoisted out of the loop otherwise */
+    for (int64_t i = 0; i < N; i++)
+        fe_sqr_inline(x, x);
+    
+    COUNTER_STOP();
+    TIMER_STOP();
+
+    printf("average cycles per op : %lu \n", (TICKS()/N));
+    printf("fe_sqr_inline : %lu  op/s\n\n", N*1000000/total_time);
+}
+
+static void secp256k1_fe_inv_inline_speed(void *p)
+{
+    int64_t N;
+    BN_ULONG x[P256_LIMBS];
+
+    TEST_ARGS *args = (TEST_ARGS*)p;
+    N = args->N;
+
+    /* setup */
+    secp256k1_rand(x);
+
+    BENCH_VARS;
+
+    COUNTER_START();
+    TIMER_START();
+    
+    /* feed the result back, the call would be hoisted out of the loop otherwise */
+    for (int64_t i = 0; i < N; i++)
+        fe_inv_inline(x, x);
+    
+    COUNTER_STOP();
+    TIMER_STOP();
+
+    printf("average cycles per op : %lu \n", (TICKS()/N));
+    printf("fe_inv_inline : %lu  op/s\n\n", N*1000000/total_time);
+}
+#endif
+
+static void secp256k1_mod_inverse_var_speed(void *p)
+{
+    int64_t N;
+    BN_ULONG a[P256_LIMBS];
 
     TEST_ARGS *args = (TEST_ARGS*)p;
     N = args->N;
@@ -201,14 +906,15 @@ static void secp256k1_mod_inverse_speed(void *p)
     COUNTER_START();
     TIMER_START();
     
+    /* running time depends on input, so feed the result back */
     for (int64_t i = 0; i < N; i++)
-        secp256k1_mod_inverse(r, a);
+        secp256k1_mod_inverse_var(a, a);
     
     COUNTER_STOP();
     TIMER_STOP();
 
     printf("average cycles per op : %lu \n", (TICKS()/N));
-    printf("secp256k1_mod_inverse : %lu  op/s\n\n", N*1000000/total_time);
+    printf("secp256k1_mod_inverse_var : %lu  op/s\n\n", N*1000000/total_time);
 }
 
 static void secp256k1_mul_mont_speed(void *p)
@@ -264,6 +970,170 @@ static void secp256k1_sqr_mont_speed(void *p)
     printf("secp256k1_sqr_mont : %lu  op/s\n\n", N*1000000/total_time);
 }
 
+/* pseudo-Mersenne reduction, compare with secp256k1_mul_mont_speed */
+static void secp256k1_mul_pm_speed(void *p)
+{
+    int64_t N;
+    BN_ULONG r[P256_LIMBS], x[P256_LIMBS], y[P256_LIMBS];
+
+    TEST_ARGS *args = (TEST_ARGS*)p;
+    N = args->N;
+
+    /* setup */
+    secp256k1_rand(x);
+    secp256k1_rand(y);
+
+    BENCH_VARS;
+
+    COUNTER_START();
+    TIMER_START();
+    
+    for (int64_t i = 0; i < N; i++)
+        secp256k1_mul_pm(r, x, y);
+    
+    COUNTER_STOP();
+    TIMER_STOP();
+
+    printf("average cycles per op : %lu \n", (TICKS()/N));
+    printf("secp256k1_mul_pm : %lu  op/s\n\n", N*1000000/total_time);
+}
+
+static void secp256k1_sqr_pm_speed(void *p)
+{
+    int64_t N;
+    BN_ULONG r[P256_LIMBS], x[P256_LIMBS];
+
+    TEST_ARGS *args = (TEST_ARGS*)p;
+    N = args->N;
+
+    /* setup */
+    secp256k1_rand(x);
+
+    BENCH_VARS;
+
+    COUNTER_START();
+    TIMER_START();
+    
+    for (int64_t i = 0; i < N; i++)
+        secp256k1_sqr_pm(r, x);
+    
+    COUNTER_STOP();
+    TIMER_STOP();
+
+    printf("average cycles per op : %lu \n", (TICKS()/N));
+    printf("secp256k1_sqr_pm : %lu  op/s\n\n", N*1000000/total_time);
+}
+
+static void secp256k1_scalar_mul_mont_speed(void *p)
+{
+    int64_t N;
+    BN_ULONG r[P256_LIMBS], x[P256_LIMBS], y[P256_LIMBS];
+
+    TEST_ARGS *args = (TEST_ARGS*)p;
+    N = args->N;
+
+    /* setup */
+    secp256k1_rand(x);
+    secp256k1_rand(y);
+    secp256k1_scalar_reduce(x, x);
+    secp256k1_scalar_reduce(y, y);
+
+    BENCH_VARS;
+
+    COUNTER_START();
+    TIMER_START();
+    
+    for (int64_t i = 0; i < N; i++)
+        secp256k1_scalar_mul_mont(r, x, y);
+    
+    COUNTER_STOP();
+    TIMER_STOP();
+
+    printf("average cycles per op : %lu \n", (TICKS()/N));
+    printf("secp256k1_scalar_mul_mont : %lu  op/s\n\n", N*1000000/total_time);
+}
+
+static void secp256k1_scalar_sqr_mont_speed(void *p)
+{
+    int64_t N;
+    BN_ULONG r[P256_LIMBS], x[P256_LIMBS];
+
+    TEST_ARGS *args = (TEST_ARGS*)p;
+    N = args->N;
+
+    /* setup */
+    secp256k1_rand(x);
+    secp256k1_scalar_reduce(x, x);
+
+    BENCH_VARS;
+
+    COUNTER_START();
+    TIMER_START();
+    
+    for (int64_t i = 0; i < N; i++)
+        secp256k1_scalar_sqr_mont(r, x, 1);
+    
+    COUNTER_STOP();
+    TIMER_STOP();
+
+    printf("average cycles per op : %lu \n", (TICKS()/N));
+    printf("secp256k1_scalar_sqr_mont : %lu  op/s\n\n", N*1000000/total_time);
+}
+
+static void secp256k1_scalar_inverse_speed(void *p)
+{
+    int64_t N;
+    BN_ULONG r[P256_LIMBS], a[P256_LIMBS];
+
+    TEST_ARGS *args = (TEST_ARGS*)p;
+    N = args->N;
+
+    /* setup */
+    secp256k1_rand(a);
+    secp256k1_scalar_reduce(a, a);
+
+    BENCH_VARS;
+
+    COUNTER_START();
+    TIMER_START();
+    
+    for (int64_t i = 0; i < N; i++)
+        secp256k1_scalar_inverse(r, a);
+    
+    COUNTER_STOP();
+    TIMER_STOP();
+
+    printf("average cycles per op : %lu \n", (TICKS()/N));
+    printf("secp256k1_scalar_inverse : %lu  op/s\n\n", N*1000000/total_time);
+}
+
+static void secp256k1_scalar_inverse_var_speed(void *p)
+{
+    int64_t N;
+    BN_ULONG a[P256_LIMBS];
+
+    TEST_ARGS *args = (TEST_ARGS*)p;
+    N = args->N;
+
+    /* setup */
+    secp256k1_rand(a);
+    secp256k1_scalar_reduce(a, a);
+
+    BENCH_VARS;
+
+    COUNTER_START();
+    TIMER_START();
+    
+    for (int64_t i = 0; i < N; i++)
+        secp256k1_scalar_inverse_var(a, a);
+    
+    COUNTER_STOP();
+    TIMER_STOP();
+
+    printf("average cycles per op : %lu \n", (TICKS()/N));
+    printf("secp256k1_scalar_inverse_var : %lu  op/s\n\n", N*1000000/total_time);
+}
+
 void run_speed(void(*func)(void *), TEST_ARGS *args)
 {
     printf("=========== %s ===========\n", args->desp);
@@ -287,6 +1157,12 @@ int main(int argc, char **argv)
     // get_test_args(argc, argv, &args);
     args.ok = CRYPTO_OK;
 
+#ifdef SECP256K1_PSEUDO_MERSENNE
+    printf("field elements : plain, pseudo-Mersenne reduction\n\n");
+#else
+    printf("field elements : montgomery domain\n\n");
+#endif
+
     set_test_args(&args, 20000, 0, "secp256k1 point add affine");
     run_speed(secp256k1_point_add_affine_speed, &args);
 
@@ -299,21 +1175,100 @@ int main(int argc, char **argv)
     set_test_args(&args, 20000, 0, "secp256k1 scalar mul gen");
     run_speed(secp256k1_scalar_mul_gen_speed, &args);
 
+#ifdef HAVE_IMMINTRIN_H
+    set_test_args(&args, 5000, 0, "secp256k1 scalar mul gen cold cache");
+    run_speed(secp256k1_scalar_mul_gen_cold_speed, &args);
+#endif
+
+    set_test_args(&args, 200, 0, "secp256k1 precompute table gen");
+    run_speed(secp256k1_precompute_table_gen_speed, &args);
+
+    set_test_args(&args, 20000, 0, "secp256k1 scalar mul gen table configs");
+    run_speed(secp256k1_scalar_mul_gen_config_speed, &args);
+
     set_test_args(&args, 20000, 0, "secp256k1 scalar mul point");
     run_speed(secp256k1_scalar_mul_point_speed, &args);
 
+    set_test_args(&args, 5000, 0, "secp256k1 scalar mul x4");
+    run_speed(secp256k1_scalar_mul_x4_speed, &args);
+
+    set_test_args(&args, 500, 0, "secp256k1 scalar mul gen batch");
+    run_speed(secp256k1_scalar_mul_gen_batch_speed, &args);
+
+    set_test_args(&args, 20000, 0, "secp256k1 scalar mul point var");
+    run_speed(secp256k1_scalar_mul_point_var_speed, &args);
+
+    set_test_args(&args, 20000, 0, "secp256k1 scalar mul prepared");
+    run_speed(secp256k1_scalar_mul_prepared_speed, &args);
+
+    set_test_args(&args, 20000, 0, "secp256k1 scalar mul point cache");
+    run_speed(secp256k1_scalar_mul_point_cache_speed, &args);
+
+    set_test_args(&args, 100000, 0, "secp256k1 multi scalar mul");
+    run_speed(secp256k1_multi_scalar_mul_speed, &args);
+
+    set_test_args(&args, 20000, 0, "secp256k1 ecdsa verify");
+    run_speed(secp256k1_ecdsa_verify_speed, &args);
+
+    set_test_args(&args, 20000, 0, "secp256k1 ecdsa sign");
+    run_speed(secp256k1_ecdsa_sign_speed, &args);
+
+    set_test_args(&args, 20000, 0, "secp256k1 schnorrsig sign");
+    run_speed(secp256k1_schnorrsig_sign_speed, &args);
+
+    set_test_args(&args, 20000, 0, "secp256k1 schnorrsig verify");
+    run_speed(secp256k1_schnorrsig_verify_speed, &args);
+
+    set_test_args(&args, 20, 0, "secp256k1 schnorrsig verify batch");
+    run_speed(secp256k1_schnorrsig_verify_batch_speed, &args);
+
     set_test_args(&args, 20000, 0, "secp256k1 point get affine");
     run_speed(secp256k1_point_get_affine_speed, &args);
 
+    set_test_args(&args, 20000, 0, "secp256k1 point get affine batch");
+    run_speed(secp256k1_point_get_affine_batch_speed, &args);
+
     set_test_args(&args, 20000, 0, "secp256k1 mod inverse");
     run_speed(secp256k1_mod_inverse_speed, &args);
 
+    set_test_args(&args, 20000, 0, "secp256k1 mod inverse var");
+    run_speed(secp256k1_mod_inverse_var_speed, &args);
+
     set_test_args(&args, 20000, 0, "secp256k1 mul mont");
     run_speed(secp256k1_mul_mont_speed, &args);
 
     set_test_args(&args, 20000, 0, "secp256k1 sqr mont");
     run_speed(secp256k1_sqr_mont_speed, &args);
 
+#ifdef SECP256K1_HAVE_INLINE_FIELD
+    set_test_args(&args, 20000, 0, "secp256k1 fe inv inline");
+    run_speed(secp256k1_fe_inv_inline_speed, &args);
+
+    set_test_args(&args, 20000, 0, "secp256k1 fe mul inline");
+    run_speed(secp256k1_fe_mul_inline_speed, &args);
+
+    set_test_args(&args, 20000, 0, "secp256k1 fe sqr inline");
+    run_speed(secp256k1_fe_sqr_inline_speed, &args);
+#endif
+
+    set_test_args(&args, 20000, 0, "secp256k1 mul pm");
+    run_speed(secp256k1_mul_pm_speed, &args);
+
+    set_test_args(&args, 20000, 0, "secp256k1 sqr pm");
+    run_speed(secp256k1_sqr_pm_speed, &args);
+
+    set_test_args(&args, 20000, 0, "secp256k1 scalar mul mont");
+    run_speed(secp256k1_scalar_mul_mont_speed, &args);
+
+    set_test_args(&args, 20000, 0, "secp256k1 scalar sqr mont");
+    run_speed(secp256k1_scalar_sqr_mont_speed, &args);
+
+    set_test_args(&args, 20000, 0, "secp256k1 scalar inverse");
+    run_speed(secp256k1_scalar_inverse_speed, &args);
+
+    set_test_args(&args, 20000, 0, "secp256k1 scalar inverse var");
+    run_speed(secp256k1_scalar_inverse_var_speed, &args);
+
     CRYPTO_deinit();
     return 0;
 }
\ No newline at end of file
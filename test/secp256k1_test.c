@@ -16,7 +16,27 @@
  *                                                                            *
  *****************************************************************************/
 
+#include <secp256k1_x64/cpuid.h>
 #include "test.h"
+#include "../secp256k1_x64/secp256k1/field_lcl.h"
+#include "../secp256k1_x64/secp256k1/secp256k1_lcl.h"
+
+/* field elements of the test vectors are in montgomery domain */
+static void set_mont_hex(BN_ULONG r[P256_LIMBS], const char *hex)
+{
+#ifdef SECP256K1_PSEUDO_MERSENNE
+    /* 2^-256 mod P */
+    static const BN_ULONG R_INV[P256_LIMBS] = {
+        0xd838091d0868192aULL, 0xbcb223fedc24a059ULL,
+        0x9c46c2c295f2b761ULL, 0xc9bd190515538399ULL
+    };
+#endif
+
+    fp256_set_hex(r, (unsigned char*)hex, strlen(hex));
+#ifdef SECP256K1_PSEUDO_MERSENNE
+    secp256k1_mul_pm(r, r, R_INV);
+#endif
+}
 
 /********************** MUL G **********************/
 typedef struct
@@ -187,9 +207,9 @@ static int secp256k1_mul_g_test()
 
     for (i = 0; i < sizeof(mulg_test_vec) / sizeof(MULG_TEST_VEC); i++) {
         fp256_set_hex(scalar, (unsigned char*)mulg_test_vec[i].scalar, strlen((const char*)mulg_test_vec[i].scalar));
-        fp256_set_hex(r1.X, (unsigned char*)mulg_test_vec[i].x, strlen((const char*)mulg_test_vec[i].x));
-        fp256_set_hex(r1.Y, (unsigned char*)mulg_test_vec[i].y, strlen((const char*)mulg_test_vec[i].y));
-        fp256_set_hex(r1.Z, (unsigned char*)mulg_test_vec[i].z, strlen((const char*)mulg_test_vec[i].z));
+        set_mont_hex(r1.X, mulg_test_vec[i].x);
+        set_mont_hex(r1.Y, mulg_test_vec[i].y);
+        set_mont_hex(r1.Z, mulg_test_vec[i].z);
         
         if (secp256k1_point_is_on_curve(&r1) == 0) {
             printf("mul_g test %d, point r1 is not on curve\n", i+1);
@@ -212,6 +232,185 @@ static int secp256k1_mul_g_test()
     return CRYPTO_OK;
 }
 
+static int secp256k1_mul_g_config_test()
+{
+    int i, j, k;
+    POINT256 r1, r2;
+    BN_ULONG scalar[P256_LIMBS], rands[16][P256_LIMBS];
+    POINT256 expect[16];
+    const SECP256K1_GEN_CONFIG configs[] = {
+        { SECP256K1_GEN_BOOTH, 4, 0, 0 },
+        { SECP256K1_GEN_BOOTH, 5, 0, 0 },
+        { SECP256K1_GEN_BOOTH, 6, 0, 0 },
+        { SECP256K1_GEN_BOOTH, 8, 0, 0 },
+        { SECP256K1_GEN_COMB,  0, 1, 256 },
+        { SECP256K1_GEN_COMB,  0, 4, 8 },
+        { SECP256K1_GEN_COMB,  0, 5, 10 },
+        { SECP256K1_GEN_COMB,  0, 6, 11 },
+        { SECP256K1_GEN_COMB,  0, 8, 3 },
+        { SECP256K1_GEN_BOOTH, 7, 0, 0 },
+    };
+    const SECP256K1_GEN_CONFIG bad[] = {
+        { SECP256K1_GEN_BOOTH, 3, 0, 0 },
+        { SECP256K1_GEN_BOOTH, 9, 0, 0 },
+        { SECP256K1_GEN_COMB,  0, 9, 1 },
+        { SECP256K1_GEN_COMB,  0, 8, 33 },
+        { 2, 7, 0, 0 },
+    };
+
+    /* results with the default table */
+    for (k = 0; k < 16; k++) {
+        secp256k1_rand(rands[k]);
+        secp256k1_scalar_mul_gen(&expect[k], rands[k]);
+    }
+
+    for (i = 0; i < sizeof(bad) / sizeof(SECP256K1_GEN_CONFIG); i++) {
+        if (secp256k1_precompute_table_config(&bad[i]) != CRYPTO_ERR) {
+            printf("mul_g config test, bad config %d accepted\n", i + 1);
+            return CRYPTO_ERR;
+        }
+    }
+
+    for (j = 0; j < sizeof(configs) / sizeof(SECP256K1_GEN_CONFIG); j++) {
+        if (secp256k1_precompute_table_config(&configs[j]) != CRYPTO_OK) {
+            printf("mul_g config test, config %d fail\n", j + 1);
+            return CRYPTO_ERR;
+        }
+
+        for (i = 0; i < sizeof(mulg_test_vec) / sizeof(MULG_TEST_VEC); i++) {
+            fp256_set_hex(scalar, (unsigned char*)mulg_test_vec[i].scalar, strlen((const char*)mulg_test_vec[i].scalar));
+            set_mont_hex(r1.X, mulg_test_vec[i].x);
+            set_mont_hex(r1.Y, mulg_test_vec[i].y);
+            set_mont_hex(r1.Z, mulg_test_vec[i].z);
+
+            secp256k1_scalar_mul_gen(&r2, scalar);
+            if (secp256k1_point_cmp(&r1, &r2) != 0) {
+                printf("mul_g config test, config %d, vector %d fail\n", j + 1, i + 1);
+                goto fail;
+            }
+        }
+
+        for (k = 0; k < 16; k++) {
+            secp256k1_scalar_mul_gen(&r2, rands[k]);
+            if (secp256k1_point_cmp(&expect[k], &r2) != 0) {
+                printf("mul_g config test, config %d, random %d fail\n", j + 1, k + 1);
+                goto fail;
+            }
+        }
+    }
+
+    printf("mul_g config test pass\n");
+    return CRYPTO_OK;
+
+fail:
+    secp256k1_precompute_table_config(&configs[sizeof(configs) / sizeof(SECP256K1_GEN_CONFIG) - 1]);
+    return CRYPTO_ERR;
+}
+
+/*
+ * s such that the comb accumulator equals the table entry at the last
+ * step: -2*sum(D_p*2^p) over the teeth of the last block, D the signed
+ * digits(+-1 at every position) of N.
+ */
+static void comb_last_step_scalar(BN_ULONG s[P256_LIMBS], int teeth, int blocks)
+{
+    BN_ULONG v[P256_LIMBS], t[P256_LIMBS];
+    int m, pos, spacing = (256 + teeth * blocks - 1) / (teeth * blocks);
+
+    /* v = (N + 2^256 - 1)/2 = (N >> 1) + 2^255, D_p = 2*v_p - 1 */
+    secp256k1_get_order(t);
+    for (m = 0; m < P256_LIMBS - 1; m++)
+        v[m] = (t[m] >> 1) | (t[m + 1] << 63);
+    v[P256_LIMBS - 1] = (t[P256_LIMBS - 1] >> 1) | ((BN_ULONG)1 << 63);
+
+    fp256_set_word(s, 0);
+    for (m = 0; m < teeth; m++) {
+        pos = ((blocks - 1) * teeth + m) * spacing;
+        if (pos >= 256)
+            continue;
+        fp256_set_word(t, 0);
+        t[pos / 64] = (BN_ULONG)1 << (pos % 64);
+        secp256k1_scalar_add(t, t, t);
+        if ((v[pos / 64] >> (pos % 64)) & 1)
+            secp256k1_scalar_sub(s, s, t);
+        else
+            secp256k1_scalar_add(s, s, t);
+    }
+}
+
+/* the edge scalars of every comb geometry, through every geometry */
+static int secp256k1_mul_g_edge_test()
+{
+    int i, j, k, t, b, n = 0;
+    POINT256 r;
+    BN_ULONG scalars[96][P256_LIMBS];
+    POINT256 expect[96];
+    SECP256K1_GEN_CONFIG configs[48];
+    const SECP256K1_GEN_CONFIG w7 = { SECP256K1_GEN_BOOTH, 7, 0, 0 };
+    const SECP256K1_GEN_CONFIG ragged[] = {
+        { SECP256K1_GEN_COMB,  0, 5, 10 },
+        { SECP256K1_GEN_COMB,  0, 5, 13 },
+        { SECP256K1_GEN_COMB,  0, 6, 11 },
+        { SECP256K1_GEN_COMB,  0, 6, 22 },
+        { SECP256K1_GEN_COMB,  0, 7, 19 },
+        { SECP256K1_GEN_COMB,  0, 8, 3 },
+    };
+
+    for (k = 4; k <= 8; k++) {
+        configs[n].method = SECP256K1_GEN_BOOTH;
+        configs[n].window = k;
+        configs[n].teeth = configs[n].blocks = 0;
+        n++;
+    }
+    /* 1x1 .. 1x256, 2x1 .. 2x128, 4x1 .. 4x64, 8x1 .. 8x32 */
+    for (t = 1; t <= 8; t *= 2) {
+        for (b = 1; t * b <= 256; b *= 2) {
+            configs[n].method = SECP256K1_GEN_COMB;
+            configs[n].window = 0;
+            configs[n].teeth = t;
+            configs[n].blocks = b;
+            n++;
+        }
+    }
+    for (i = 0; i < sizeof(ragged) / sizeof(SECP256K1_GEN_CONFIG); i++)
+        configs[n++] = ragged[i];
+
+    /* s and -s for each comb geometry, expected points from the default table */
+    k = 0;
+    for (i = 0; i < n; i++) {
+        if (configs[i].method != SECP256K1_GEN_COMB)
+            continue;
+        comb_last_step_scalar(scalars[k], configs[i].teeth, configs[i].blocks);
+        secp256k1_scalar_neg(scalars[k + 1], scalars[k]);
+        k += 2;
+    }
+    for (j = 0; j < k; j++)
+        secp256k1_scalar_mul_gen(&expect[j], scalars[j]);
+
+    for (i = 0; i < n; i++) {
+        if (secp256k1_precompute_table_config(&configs[i]) != CRYPTO_OK) {
+            printf("mul_g edge test, config %d fail\n", i + 1);
+            goto fail;
+        }
+
+        for (j = 0; j < k; j++) {
+            secp256k1_scalar_mul_gen(&r, scalars[j]);
+            if (secp256k1_point_cmp(&expect[j], &r) != 0) {
+                printf("mul_g edge test, config %d, scalar %d fail\n", i + 1, j + 1);
+                goto fail;
+            }
+        }
+    }
+
+    secp256k1_precompute_table_config(&w7);
+    printf("mul_g edge test pass\n");
+    return CRYPTO_OK;
+
+fail:
+    secp256k1_precompute_table_config(&w7);
+    return CRYPTO_ERR;
+}
+
 /********************** MUL OTHER POINT **********************/
 typedef struct
 {
@@ -437,12 +636,12 @@ static int secp256k1_mul_p_test()
 
     for (i = 0; i < sizeof(mulp_test_vec) / sizeof(MULP_TEST_VEC); i++) {
         fp256_set_hex(scalar, (unsigned char*)mulp_test_vec[i].scalar, strlen((const char*)mulp_test_vec[i].scalar));
-        fp256_set_hex(r1.X, (unsigned char*)mulp_test_vec[i].rx, strlen((const char*)mulp_test_vec[i].rx));
-        fp256_set_hex(r1.Y, (unsigned char*)mulp_test_vec[i].ry, strlen((const char*)mulp_test_vec[i].ry));
-        fp256_set_hex(r1.Z, (unsigned char*)mulp_test_vec[i].rz, strlen((const char*)mulp_test_vec[i].rz));
-        fp256_set_hex(r2.X, (unsigned char*)mulp_test_vec[i].px, strlen((const char*)mulp_test_vec[i].px));
-        fp256_set_hex(r2.Y, (unsigned char*)mulp_test_vec[i].py, strlen((const char*)mulp_test_vec[i].py));
-        fp256_set_hex(r2.Z, (unsigned char*)mulp_test_vec[i].pz, strlen((const char*)mulp_test_vec[i].pz));
+        set_mont_hex(r1.X, mulp_test_vec[i].rx);
+        set_mont_hex(r1.Y, mulp_test_vec[i].ry);
+        set_mont_hex(r1.Z, mulp_test_vec[i].rz);
+        set_mont_hex(r2.X, mulp_test_vec[i].px);
+        set_mont_hex(r2.Y, mulp_test_vec[i].py);
+        set_mont_hex(r2.Z, mulp_test_vec[i].pz);
         
         if (secp256k1_point_is_on_curve(&r1) == 0) {
             printf("mul_p test %d, point r1 is not on curve\n", i+1);
@@ -534,9 +733,9 @@ static int secp256k1_coor_test()
     BN_ULONG x[P256_LIMBS], y[P256_LIMBS];
 
     for (i = 0; i < sizeof(coor_test_vec) / sizeof(COORDINATE_TEST_VEC); i++) {
-        fp256_set_hex(r1.X, (unsigned char*)coor_test_vec[i].X, strlen((const char*)coor_test_vec[i].X));
-        fp256_set_hex(r1.Y, (unsigned char*)coor_test_vec[i].Y, strlen((const char*)coor_test_vec[i].Y));
-        fp256_set_hex(r1.Z, (unsigned char*)coor_test_vec[i].Z, strlen((const char*)coor_test_vec[i].Z));
+        set_mont_hex(r1.X, coor_test_vec[i].X);
+        set_mont_hex(r1.Y, coor_test_vec[i].Y);
+        set_mont_hex(r1.Z, coor_test_vec[i].Z);
         fp256_set_hex(x, (unsigned char*)coor_test_vec[i].x, strlen((const char*)coor_test_vec[i].x));
         fp256_set_hex(y, (unsigned char*)coor_test_vec[i].y, strlen((const char*)coor_test_vec[i].y));
         
@@ -578,29 +777,1927 @@ static int secp256k1_coor_test()
     return CRYPTO_OK;
 }
 
-int main(int argc, char **argv)
+/********************** BATCH JACOBIAN - AFFINE **********************/
+#define BATCH_TEST_SIZE 17
+
+/* batch conversion must match one-by-one conversion, infinity included */
+static int secp256k1_coor_batch_test()
 {
-    int ret = 0;
-    if (CRYPTO_init() == CRYPTO_ERR)
-        return -1;
+    int i;
+    POINT256 points[BATCH_TEST_SIZE];
+    BN_ULONG x[BATCH_TEST_SIZE][P256_LIMBS], y[BATCH_TEST_SIZE][P256_LIMBS];
+    BN_ULONG a[BATCH_TEST_SIZE][P256_LIMBS], inv[BATCH_TEST_SIZE][P256_LIMBS];
+    BN_ULONG scratch[BATCH_TEST_SIZE][P256_LIMBS];
+    BN_ULONG x1[P256_LIMBS], y1[P256_LIMBS];
+    BN_ULONG scalar[P256_LIMBS];
 
-    // TEST_ARGS args;
-    // args.ok = 0;
-    // args.N = 12345;
-    // args.num_threads = 4;
-    // get_test_args(argc, argv, &args);
+    for (i = 0; i < BATCH_TEST_SIZE; i++) {
+        secp256k1_rand(scalar);
+        /* some points at infinity, including the first and the last one */
+        if (i == 0 || i == 5 || i == 6 || i == BATCH_TEST_SIZE - 1)
+            fp256_set_word(scalar, 0);
+        secp256k1_scalar_mul_gen(&points[i], scalar);
+    }
 
-    if (secp256k1_mul_g_test() == CRYPTO_ERR) {
-        ret = -1;
-        goto end;
+    if (secp256k1_point_get_affine_batch(x, y, points, BATCH_TEST_SIZE, scratch) == CRYPTO_ERR) {
+        printf("coor batch test, get affine batch fail\n");
+        return CRYPTO_ERR;
     }
 
-    if (secp256k1_mul_p_test() == CRYPTO_ERR) {
-        ret = -1;
-        goto end;
+    for (i = 0; i < BATCH_TEST_SIZE; i++) {
+        if (secp256k1_point_get_affine(x1, y1, &points[i]) == CRYPTO_ERR) {
+            fp256_set_word(x1, 0);
+            fp256_set_word(y1, 0);
+        }
+
+        if (fp256_cmp(x[i], x1) != 0 || fp256_cmp(y[i], y1) != 0) {
+            printf("coor batch test %d, compare affine fail\n", i+1);
+            return CRYPTO_ERR;
+        }
     }
 
-    if (secp256k1_coor_test() == CRYPTO_ERR) {
+    /* in-place batch inversion */
+    for (i = 0; i < BATCH_TEST_SIZE; i++) {
+        secp256k1_rand(a[i]);
+        if (i == 3)
+            fp256_set_word(a[i], 0);
+        fp256_copy(inv[i], a[i]);
+    }
+
+    if (secp256k1_mod_inverse_batch(inv, (const BN_ULONG (*)[P256_LIMBS])inv, BATCH_TEST_SIZE, scratch) == CRYPTO_ERR) {
+        printf("coor batch test, mod inverse batch fail\n");
+        return CRYPTO_ERR;
+    }
+
+    for (i = 0; i < BATCH_TEST_SIZE; i++) {
+        if (fp256_is_zero(a[i]))
+            fp256_set_word(x1, 0);
+        else
+            secp256k1_mod_inverse(x1, a[i]);
+
+        if (fp256_cmp(inv[i], x1) != 0) {
+            printf("coor batch test %d, compare inverse fail\n", i+1);
+            return CRYPTO_ERR;
+        }
+    }
+
+    printf("coor batch test pass\n");
+    return CRYPTO_OK;
+}
+
+/************************** DBL N, LOOKUP ***************************/
+/* point_dbl_n must match n point_dbl, point_add_affine_lookup must match
+ * the signed lookup plus point_add_affine done by hand
+ */
+static int secp256k1_point_dbl_n_lookup_test()
+{
+    int i, n;
+    unsigned int digit;
+    POINT256 a, r1, r2, t;
+    POINT256_AFFINE aff;
+    PRECOMP256_ROW row;
+    BN_ULONG z[P256_LIMBS], scalar[P256_LIMBS];
+
+    for (n = -1; n < 12; n++) {
+        secp256k1_rand(scalar);
+        secp256k1_scalar_mul_gen(&a, scalar);
+        r2 = a;
+        for (i = 0; i < n; i++)
+            secp256k1_point_dbl(&r2, &r2);
+
+        secp256k1_point_dbl_n(&r1, &a, n);
+        /* in-place */
+        secp256k1_point_dbl_n(&a, &a, n);
+        if (memcmp(&r1, &r2, sizeof(POINT256)) != 0 || memcmp(&a, &r2, sizeof(POINT256)) != 0) {
+            printf("point dbl n test %d fail\n", n);
+            return CRYPTO_ERR;
+        }
+    }
+
+    /* row[i] = (i + 1)*a in affine(mont) */
+    secp256k1_rand(scalar);
+    secp256k1_scalar_mul_gen(&a, scalar);
+    t = a;
+    for (i = 0; i < 64; i++) {
+        if (i > 0)
+            secp256k1_point_add(&t, &t, &a);
+        secp256k1_mod_inverse(z, t.Z);
+        secp256k1_sqr_mont(row[i].X, z);
+        secp256k1_mul_mont(row[i].Y, row[i].X, z);
+        secp256k1_mul_mont(row[i].X, row[i].X, t.X);
+        secp256k1_mul_mont(row[i].Y, row[i].Y, t.Y);
+    }
+
+    for (digit = 0; digit < 130; digit++) {
+        secp256k1_rand(scalar);
+        /* r at infinity once */
+        if (digit == 3)
+            fp256_set_word(scalar, 0);
+        secp256k1_scalar_mul_gen(&r1, scalar);
+        r2 = r1;
+
+        if (digit > 1) {
+            aff = row[(digit >> 1) - 1];
+            if (digit & 1)
+                secp256k1_neg(aff.Y, aff.Y);
+            secp256k1_point_add_affine(&r2, &r2, &aff);
+        }
+
+        secp256k1_point_add_affine_lookup(&r1, row, digit);
+        if (memcmp(&r1, &r2, sizeof(POINT256)) != 0) {
+            printf("point add affine lookup test %u fail\n", digit);
+            return CRYPTO_ERR;
+        }
+    }
+
+    printf("point dbl n lookup test pass\n");
+    return CRYPTO_OK;
+}
+
+/************************** MONT REDUCTION ***************************/
+/* sparse operands, the reduction has to borrow across zero limbs */
+static int secp256k1_mont_reduce_test()
+{
+    int i;
+    BN_ULONG a[P256_LIMBS], r1[P256_LIMBS], r2[P256_LIMBS];
+
+    for (i = 0; i < 13; i++) {
+        /* 0x1000003d1 * 2^(16*i) */
+        fp256_set_word(a, 0);
+        a[i / 4] = 0x1000003d1ULL << (16 * (i % 4));
+        if (i % 4 != 0 && i < 12)
+            a[i / 4 + 1] = 0x1000003d1ULL >> (64 - 16 * (i % 4));
+        secp256k1_sqr_mont(r1, a);
+        secp256k1_mul_mont(r2, a, a);
+        if (fp256_cmp(r1, r2) != 0) {
+            printf("sqr mont sparse test %d fail\n", i+1);
+            return CRYPTO_ERR;
+        }
+        secp256k1_from_mont(r1, a);
+        fp256_set_word(r2, 1);
+        secp256k1_mul_mont(r2, a, r2);
+        if (fp256_cmp(r1, r2) != 0) {
+            printf("from mont sparse test %d fail\n", i+1);
+            return CRYPTO_ERR;
+        }
+    }
+
+    printf("mont reduce test pass\n");
+    return CRYPTO_OK;
+}
+
+/************************** PSEUDO-MERSENNE ***************************/
+/* mul_pm/sqr_pm must agree with the field mul of the library representation */
+static int secp256k1_mul_pm_test()
+{
+    int i;
+    BN_ULONG a[P256_LIMBS], b[P256_LIMBS], r1[P256_LIMBS], r2[P256_LIMBS];
+
+    for (i = 0; i < 10000; i++) {
+        if (i < 4) {
+            /* operands close to p, the high half of the product is the largest */
+            secp256k1_get_p(a);
+            secp256k1_get_p(b);
+            a[0] -= i + 1;
+            b[0] -= 1;
+        } else {
+            secp256k1_rand(a);
+            secp256k1_rand(b);
+        }
+
+        secp256k1_mul_pm(r1, a, b);
+        secp256k1_to_mont(a, a);
+        secp256k1_to_mont(b, b);
+        secp256k1_mul_mont(r2, a, b);
+        secp256k1_from_mont(r2, r2);
+        if (fp256_cmp(r1, r2) != 0) {
+            printf("mul pm test %d fail\n", i+1);
+            return CRYPTO_ERR;
+        }
+
+        secp256k1_from_mont(a, a);
+        secp256k1_sqr_pm(r1, a);
+        secp256k1_to_mont(a, a);
+        secp256k1_sqr_mont(r2, a);
+        secp256k1_from_mont(r2, r2);
+        if (fp256_cmp(r1, r2) != 0) {
+            printf("sqr pm test %d fail\n", i+1);
+            return CRYPTO_ERR;
+        }
+    }
+
+    printf("mul pm test pass\n");
+    return CRYPTO_OK;
+}
+
+/************************** SQR N ***************************/
+/* n squarings in one call must match n calls of secp256k1_sqr_mont */
+static int secp256k1_sqr_mont_n_test()
+{
+    int i, j;
+    BN_ULONG a[P256_LIMBS], r1[P256_LIMBS], r2[P256_LIMBS];
+
+    for (i = 0; i < 300; i++) {
+        secp256k1_rand(a);
+        fp256_copy(r2, a);
+        for (j = 0; j < i; j++)
+            secp256k1_sqr_mont(r2, r2);
+
+        secp256k1_sqr_mont_n(r1, a, i);
+        /* in-place */
+        secp256k1_sqr_mont_n(a, a, i);
+        if (fp256_cmp(r1, r2) != 0 || fp256_cmp(a, r2) != 0) {
+            printf("sqr mont n test %d fail\n", i+1);
+            return CRYPTO_ERR;
+        }
+    }
+
+    /* the asm addition chain, a * a^-1 = 1, in-place */
+    for (i = 0; i < 100; i++) {
+        secp256k1_rand(a);
+        fp256_copy(r1, a);
+        secp256k1_mod_inverse(r1, r1);
+        secp256k1_mul_mont(r2, r1, a);
+        secp256k1_from_mont(r2, r2);
+        fp256_set_word(r1, 1);
+        if (fp256_cmp(r1, r2) != 0) {
+            printf("mod inverse test %d fail\n", i+1);
+            return CRYPTO_ERR;
+        }
+    }
+
+    printf("sqr mont n test pass\n");
+    return CRYPTO_OK;
+}
+
+/************************** INLINE FIELD ***************************/
+#ifdef SECP256K1_HAVE_INLINE_FIELD
+/* the inline C field functions must match the asm ones */
+static int secp256k1_field_inline_test()
+{
+    int i;
+    BN_ULONG a[P256_LIMBS], b[P256_LIMBS], r1[P256_LIMBS], r2[P256_LIMBS];
+
+    for (i = 0; i < 1000 + 4; i++) {
+        secp256k1_rand(a);
+        secp256k1_rand(b);
+        if (i == 1000)
+            fp256_set_word(a, 0);
+        else if (i == 1001)
+            fp256_set_word(a, 1);
+        else if (i >= 1002) {
+            /* P - 1, P - 2 */
+            secp256k1_get_p(a);
+            a[0] -= i - 1001;
+        }
+
+        secp256k1_mul_mont(r1, a, b);
+        fe_mul_inline(r2, a, b);
+        if (fp256_cmp(r1, r2) != 0)
+            goto fail;
+
+        secp256k1_sqr_mont(r1, a);
+        fe_sqr_inline(r2, a);
+        if (fp256_cmp(r1, r2) != 0)
+            goto fail;
+
+        secp256k1_sqr_mont_n(r1, a, i % 30);
+        fe_sqr_n_inline(r2, a, i % 30);
+        if (fp256_cmp(r1, r2) != 0)
+            goto fail;
+
+        secp256k1_from_mont(r1, a);
+        fe_from_mont_inline(r2, a);
+        if (fp256_cmp(r1, r2) != 0)
+            goto fail;
+
+        secp256k1_to_mont(r1, a);
+        fe_to_mont_inline(r2, a);
+        if (fp256_cmp(r1, r2) != 0)
+            goto fail;
+
+        if (i % 10 == 0) {
+            secp256k1_mod_inverse(r1, a);
+            fe_inv_inline(r2, a);
+            if (fp256_cmp(r1, r2) != 0)
+                goto fail;
+        }
+    }
+
+    printf("field inline test pass\n");
+    return CRYPTO_OK;
+fail:
+    printf("field inline test %d fail\n", i+1);
+    return CRYPTO_ERR;
+}
+#endif
+
+/************************** MOD INVERSE VAR ***************************/
+#define INVERSE_TEST_SIZE 1000
+
+/* variable time inversion must match the constant time one */
+static int secp256k1_mod_inverse_var_test()
+{
+    int i;
+    BN_ULONG a[P256_LIMBS], r1[P256_LIMBS], r2[P256_LIMBS];
+
+    for (i = 0; i < INVERSE_TEST_SIZE + 4; i++) {
+        if (i < INVERSE_TEST_SIZE)
+            secp256k1_rand(a);
+        else if (i == INVERSE_TEST_SIZE) {
+            /* 0 */
+            fp256_set_word(a, 0);
+        }
+        else if (i == INVERSE_TEST_SIZE + 1) {
+            /* 1, 2 */
+            fp256_set_word(a, 1);
+        }
+        else if (i == INVERSE_TEST_SIZE + 2)
+            fp256_set_word(a, 2);
+        else {
+            /* p - 1 */
+            secp256k1_get_p(a);
+            a[0]--;
+        }
+
+        secp256k1_mod_inverse(r1, a);
+        /* in-place */
+        fp256_copy(r2, a);
+        secp256k1_mod_inverse_var(r2, r2);
+
+        if (fp256_cmp(r1, r2) != 0) {
+            printf("mod inverse var test %d fail\n", i+1);
+            return CRYPTO_ERR;
+        }
+    }
+
+    printf("mod inverse var test pass\n");
+    return CRYPTO_OK;
+}
+
+/************************** SCALAR MOD N ***************************/
+typedef struct
+{
+    char *a;    /* hex */
+    char *b;    /* hex */
+    char *add;  /* (a + b) mod n */
+    char *sub;  /* (a - b) mod n */
+    char *neg;  /* -a mod n */
+    char *mul;  /* (a * b) mod n */
+    char *wide; /* (b * 2^256 + a) mod n */
+    char *inv;  /* a^-1 mod n */
+}SCALAR_TEST_VEC;
+
+static const SCALAR_TEST_VEC scalar_test_vec[] =
+{
+    /* 1 */
+    {
+        "1",
+        "2",
+        "3",
+        "fffffffffffffffffffffffffffffffebaaedce6af48a03bbfd25e8cd0364140",
+        "fffffffffffffffffffffffffffffffebaaedce6af48a03bbfd25e8cd0364140",
+        "2",
+        "28aa24632a16ebf88805b42e65f937d7f",
+        "1",
+    },
+    /* 2 */
+    {
+        "fffffffffffffffffffffffffffffffebaaedce6af48a03bbfd25e8cd0364140",
+        "fffffffffffffffffffffffffffffffebaaedce6af48a03bbfd25e8cd0364140",
+        "fffffffffffffffffffffffffffffffebaaedce6af48a03bbfd25e8cd036413f",
+        "0",
+        "1",
+        "1",
+        "fffffffffffffffffffffffffffffffd755db9cd5e9140777fa4bd19a06c8281",
+        "fffffffffffffffffffffffffffffffebaaedce6af48a03bbfd25e8cd0364140",
+    },
+    /* 3 */
+    {
+        "0",
+        "5",
+        "5",
+        "fffffffffffffffffffffffffffffffebaaedce6af48a03bbfd25e8cd036413c",
+        "0",
+        "0",
+        "65a95af7e9394ded540e4273feef0b9bb",
+        "0",
+    },
+    /* 4 */
+    {
+        "795b929e9a9a80fdea7b5bf55eb561a4216363698b529b4a97b750923ceb3ffd",
+        "781f9c58d6645fa9e8a8529f035efa259b08923d10c67fd994b2b8fda02f34a6",
+        "f17b2ef770fee0a7d323ae9462145bc9bc6bf5a69c191b242c6a098fdd1a74a3",
+        "13bf645c436215401d309565b56677e865ad12c7a8c1b71030497949cbc0b57",
+        "86a46d6165657f021584a40aa14a9e5a994b797d23f604f1281b0dfa934b0144",
+        "4376ba691a031bd083eed17c477ed5a572292738f5b176745bd8bdef37ecb3eb",
+        "a8cef70e61380b7ab708e3329fef57d410adfd27995d050fb2b5bdda3bfad5d5",
+        "ad0fbd8979b7a123a5f9226d270929989e68265a88115aae4e1f9d19b4e4d846",
+    },
+    /* 5 */
+    {
+        "8a7d43b578633074b7970386fee29476311624273bfd1d338d0038ec42650644",
+        "3b5f3d86268ecc45dc6bf1e1a399f82a65aa9c8279f248b08cb4a0d7d6225675",
+        "c5dc813b9ef1fcba9402f568a27c8ca096c0c0a9b5ef65e419b4d9c418875cb9",
+        "4f1e062f51d4642edb2b11a55b489c4bcb6b87a4c20ad483004b98146c42afcf",
+        "7582bc4a879ccf8b4868fc79011d6b888998b8bf734b830832d225a08dd13afd",
+        "e3dfc70052cd4a5e96968ac798504eb7a0035801e853cce516154d73d84d5b6c",
+        "f1c6008cd67df7bc7d3321109b3da0a9bcc575ac599f33d24707ae2b7a3bc75b",
+        "e5097bb6decd48069e01db6b7fab2af57019de99f5796685def69df5498f9e03",
+    },
+    /* 6 */
+    {
+        "ffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffff",
+        "3e0a813bdc2ae9963d2e49085ef3430ed038db4de38378426d0b944a2863a7f",
+        "3e0a813bdc2ae9963d2e49085ef34323254b0ce2eef974866fe5ab7d24ff93d",
+        "fc1f57ec423d51669c2d1b6f7a10cbcf12fc724b21c7c87bd92f46bb5d79c580",
+        "fffffffffffffffffffffffffffffffd755db9cd5e9140777fa4bd19a06c8283",
+        "9995b524a22bfb46ca6f461a9be202e2c41b0ec1c79c1c1615c2561270549e02",
+        "9d765d385feea9e02e422aab21d13714f66fbf8ff68bb35e7cc0b0ca42a4973f",
+        "1a2f66582f865803fc36e5fd38feed2cd04dd978f7b69d07f178ad1b6c2151c8",
+    },
+    /* 7 */
+    {
+        "fffffffffffffffffffffffffffffffebaaedce6af48a03bbfd25e8cd0364141",
+        "fffffffffffffffffffffffffffffffebaaedce6af48a03bbfd25e8cd0364142",
+        "1",
+        "fffffffffffffffffffffffffffffffebaaedce6af48a03bbfd25e8cd0364140",
+        "0",
+        "0",
+        "14551231950b75fc4402da1732fc9bebf",
+        "0",
+    },
+};
+
+static int secp256k1_scalar_test()
+{
+    int i;
+    BN_ULONG a[P256_LIMBS], b[P256_LIMBS], r[P256_LIMBS], r1[P256_LIMBS];
+    BN_ULONG am[P256_LIMBS], bm[P256_LIMBS];
+    BN_ULONG wide[2 * P256_LIMBS];
+
+    for (i = 0; i < sizeof(scalar_test_vec) / sizeof(SCALAR_TEST_VEC); i++) {
+        fp256_set_hex(wide, (unsigned char*)scalar_test_vec[i].a, strlen((const char*)scalar_test_vec[i].a));
+        fp256_set_hex(wide + P256_LIMBS, (unsigned char*)scalar_test_vec[i].b, strlen((const char*)scalar_test_vec[i].b));
+
+        /* a, b mod n */
+        secp256k1_scalar_reduce(a, wide);
+        secp256k1_scalar_reduce(b, wide + P256_LIMBS);
+
+        fp256_set_hex(r1, (unsigned char*)scalar_test_vec[i].add, strlen((const char*)scalar_test_vec[i].add));
+        secp256k1_scalar_add(r, a, b);
+        if (fp256_cmp(r, r1) != 0) {
+            printf("scalar test %d, add fail\n", i+1);
+            return CRYPTO_ERR;
+        }
+
+        fp256_set_hex(r1, (unsigned char*)scalar_test_vec[i].sub, strlen((const char*)scalar_test_vec[i].sub));
+        secp256k1_scalar_sub(r, a, b);
+        if (fp256_cmp(r, r1) != 0) {
+            printf("scalar test %d, sub fail\n", i+1);
+            return CRYPTO_ERR;
+        }
+
+        fp256_set_hex(r1, (unsigned char*)scalar_test_vec[i].neg, strlen((const char*)scalar_test_vec[i].neg));
+        secp256k1_scalar_neg(r, a);
+        if (fp256_cmp(r, r1) != 0) {
+            printf("scalar test %d, neg fail\n", i+1);
+            return CRYPTO_ERR;
+        }
+
+        fp256_set_hex(r1, (unsigned char*)scalar_test_vec[i].wide, strlen((const char*)scalar_test_vec[i].wide));
+        secp256k1_scalar_reduce_wide(r, wide);
+        if (fp256_cmp(r, r1) != 0) {
+            printf("scalar test %d, reduce wide fail\n", i+1);
+            return CRYPTO_ERR;
+        }
+
+        /* montgomery mul, sqr */
+        fp256_set_hex(r1, (unsigned char*)scalar_test_vec[i].mul, strlen((const char*)scalar_test_vec[i].mul));
+        secp256k1_scalar_to_mont(am, a);
+        secp256k1_scalar_to_mont(bm, b);
+        secp256k1_scalar_mul_mont(r, am, bm);
+        secp256k1_scalar_from_mont(r, r);
+        if (fp256_cmp(r, r1) != 0) {
+            printf("scalar test %d, mul fail\n", i+1);
+            return CRYPTO_ERR;
+        }
+
+        secp256k1_scalar_mul_mont(r1, am, am);
+        secp256k1_scalar_mul_mont(r1, r1, r1);
+        secp256k1_scalar_mul_mont(r1, r1, r1);
+        secp256k1_scalar_sqr_mont(r, am, 3);
+        if (fp256_cmp(r, r1) != 0) {
+            printf("scalar test %d, sqr fail\n", i+1);
+            return CRYPTO_ERR;
+        }
+
+        /* inversion */
+        fp256_set_hex(r1, (unsigned char*)scalar_test_vec[i].inv, strlen((const char*)scalar_test_vec[i].inv));
+        secp256k1_scalar_inverse(r, am);
+        secp256k1_scalar_from_mont(r, r);
+        if (fp256_cmp(r, r1) != 0) {
+            printf("scalar test %d, inverse fail\n", i+1);
+            return CRYPTO_ERR;
+        }
+
+        secp256k1_scalar_inverse_var(r, am);
+        secp256k1_scalar_from_mont(r, r);
+        if (fp256_cmp(r, r1) != 0) {
+            printf("scalar test %d, inverse var fail\n", i+1);
+            return CRYPTO_ERR;
+        }
+    }
+
+    /* secp256k1_get_order is what the range checks compare against */
+    fp256_set_hex(r1, (unsigned char*)"fffffffffffffffffffffffffffffffebaaedce6af48a03bbfd25e8cd0364141", 64);
+    secp256k1_get_order(r);
+    if (fp256_cmp(r, r1) != 0) {
+        printf("scalar test, order fail\n");
+        return CRYPTO_ERR;
+    }
+
+    secp256k1_scalar_reduce(r, r1);
+    if (!fp256_is_zero(r)) {
+        printf("scalar test, reduce order fail\n");
+        return CRYPTO_ERR;
+    }
+
+    printf("scalar test pass\n");
+    return CRYPTO_OK;
+}
+
+/************************** ECDSA VERIFY ***************************/
+typedef struct
+{
+    char *seckey; /* hex */
+    char *msg;    /* 32 bytes hash, hex */
+    char *sig;    /* r || s, hex */
+    int valid;
+}ECDSA_VERIFY_TEST_VEC;
+
+static const ECDSA_VERIFY_TEST_VEC ecdsa_verify_test_vec[] =
+{
+    /* 1, valid */
+    {
+        "d23f0824128b2f330c5c7fd0a6a3a4506513270e269e0d37f2a74de452e6b439",
+        "36f675cc81e74ef5e8e25d940ed904759531985d5d9dc9f81818e811892f902b",
+        "ae7d3f0fe4f12700c074d7e0f0ac8eb891052eaf464fd2f28de25f23ec9f034c74608d5f4aaa42205c06de681143b95cc8f0fa6f34043fd8e7306679e5d297db",
+        1,
+    },
+    /* 2, valid */
+    {
+        "a09f76b5a170b33839263059f28c105d1fb17c2390c192cfd3ac94af0f21ddb7",
+        "f9ebdacc0cb1e29c658cda1495e60af593bd04cf0fd630f1f29d0da9953f48f1",
+        "3d7c6598c0eb13b41c89d8c81caef2006e829a5ae9b1c740c4a4ec435b0a62d93931c1257373757a88041a0b3c2bb8a3c6bd36906c31dbbf98cd6a615e1b923e",
+        1,
+    },
+    /* 3, valid */
+    {
+        "1a61dbe22e44158bae97ba94d0eda82f8f6d05584ef8aa38922766581e27a1c1",
+        "b64ce4228c38fb2918f135d25f557203301850c5a38fd547923a736994e3bf91",
+        "6d2bab62ce63c6144f11c37a956158c4722f25da17725556702af8ff161cb0c5ca60377841a40985afbad2b8eca51d46a3341b9eb429080863aa36ab33fc95cf",
+        1,
+    },
+    /* 4, valid */
+    {
+        "4cbd87ad5c90a9587403e430ec66a78795e761d17731af10506bf2efc6f87719",
+        "930d6eaf14f4733f3e7d1bfbc7a2ea20b2f14c942e05319acb5c74273f98e277",
+        "ac6941c25ea5ed2efbe98ae625939fe1b2c19ce775c727d0c90455c2dabd1f969555d0d824ebf20c108d41931a23689cc58037a7aef0f5cdee89503f491ed78c",
+        1,
+    },
+    /* 5, high s */
+    {
+        "5790f82ec1d3fcff2a3af4d46b0a18e8830e07bc1e398f1012bd4acefaecbd39",
+        "b1fee08f571242425051c1ccd17f9acae01f5057ca02135e92b1d3f28ede0d7a",
+        "6e4641380cd3bd930cb3a70a511dfb777cc0e3358ab269642b0e2a48c321e83e497aff4e838d3f5f705f6f6b9fec467eabb927e282b119a3ddd0ca5340f6da60",
+        1,
+    },
+    /* 6, message changed */
+    {
+        "5790f82ec1d3fcff2a3af4d46b0a18e8830e07bc1e398f1012bd4acefaecbd39",
+        "b1fee08f571242425051c1ccd17f9acae01f5057ca02135e92b1d3f28ede0d7b",
+        "6e4641380cd3bd930cb3a70a511dfb777cc0e3358ab269642b0e2a48c321e83eb68500b17c72c0a08fa090946013b9800ef5b5042c978697e20194398f3f66e1",
+        0,
+    },
+    /* 7, other key */
+    {
+        "5790f82ec1d3fcff2a3af4d46b0a18e8830e07bc1e398f1012bd4acefaecbd3a",
+        "b1fee08f571242425051c1ccd17f9acae01f5057ca02135e92b1d3f28ede0d7a",
+        "6e4641380cd3bd930cb3a70a511dfb777cc0e3358ab269642b0e2a48c321e83eb68500b17c72c0a08fa090946013b9800ef5b5042c978697e20194398f3f66e1",
+        0,
+    },
+    /* 8, r = 0 */
+    {
+        "5790f82ec1d3fcff2a3af4d46b0a18e8830e07bc1e398f1012bd4acefaecbd39",
+        "b1fee08f571242425051c1ccd17f9acae01f5057ca02135e92b1d3f28ede0d7a",
+        "0000000000000000000000000000000000000000000000000000000000000000b68500b17c72c0a08fa090946013b9800ef5b5042c978697e20194398f3f66e1",
+        0,
+    },
+    /* 9, s = n */
+    {
+        "5790f82ec1d3fcff2a3af4d46b0a18e8830e07bc1e398f1012bd4acefaecbd39",
+        "b1fee08f571242425051c1ccd17f9acae01f5057ca02135e92b1d3f28ede0d7a",
+        "6e4641380cd3bd930cb3a70a511dfb777cc0e3358ab269642b0e2a48c321e83efffffffffffffffffffffffffffffffebaaedce6af48a03bbfd25e8cd0364141",
+        0,
+    },
+    /* 10, r = n */
+    {
+        "5790f82ec1d3fcff2a3af4d46b0a18e8830e07bc1e398f1012bd4acefaecbd39",
+        "b1fee08f571242425051c1ccd17f9acae01f5057ca02135e92b1d3f28ede0d7a",
+        "fffffffffffffffffffffffffffffffebaaedce6af48a03bbfd25e8cd0364141b68500b17c72c0a08fa090946013b9800ef5b5042c978697e20194398f3f66e1",
+        0,
+    },
+    /* 11, d = 1, e = 1 */
+    {
+        "1",
+        "0000000000000000000000000000000000000000000000000000000000000001",
+        "c6047f9441ed7d6d3045406e95c07cd85c778e4b8cef3ca7abac09b95c709ee563023fca20f6beb69822a0374ae03e6c2e3bc725c6779e53d5d604dcae384f73",
+        1,
+    },
+};
+
+static int secp256k1_ecdsa_verify_test()
+{
+    int i, ret;
+    POINT256 pubkey, R;
+    BN_ULONG seckey[P256_LIMBS];
+    BN_ULONG n[P256_LIMBS], k[P256_LIMBS], r[P256_LIMBS], s[P256_LIMBS];
+    BN_ULONG e[P256_LIMBS], t[P256_LIMBS], x[P256_LIMBS], y[P256_LIMBS];
+    unsigned char msg[32], sig[64];
+
+    for (i = 0; i < sizeof(ecdsa_verify_test_vec) / sizeof(ECDSA_VERIFY_TEST_VEC); i++) {
+        fp256_set_hex(seckey, (unsigned char*)ecdsa_verify_test_vec[i].seckey, strlen((const char*)ecdsa_verify_test_vec[i].seckey));
+        hex_to_u8(msg, (unsigned char*)ecdsa_verify_test_vec[i].msg, 64);
+        hex_to_u8(sig, (unsigned char*)ecdsa_verify_test_vec[i].sig, 128);
+
+        /* pubkey = seckey * G */
+        secp256k1_scalar_mul_gen(&pubkey, seckey);
+
+        ret = secp256k1_ecdsa_verify(msg, sig, &pubkey);
+        if ((ret == CRYPTO_OK) != ecdsa_verify_test_vec[i].valid) {
+            printf("ecdsa verify test %d fail\n", i+1);
+            return CRYPTO_ERR;
+        }
+    }
+
+    /*
+     * r and s against n. (r, 1) is made valid by choosing the message,
+     * e = k - r*d gives s = k^-1*(e + r*d) = 1, so (r, 1 + n) would pass
+     * if s was only reduced and not range checked.
+     */
+    fp256_set_hex(n, (unsigned char*)"fffffffffffffffffffffffffffffffebaaedce6af48a03bbfd25e8cd0364141", 64);
+    for (i = 0; i < 16; i++) {
+        secp256k1_rand(seckey);
+        secp256k1_scalar_reduce(seckey, seckey);
+        secp256k1_rand(k);
+        secp256k1_scalar_reduce(k, k);
+        if (fp256_is_zero(seckey) || fp256_is_zero(k))
+            continue;
+        secp256k1_scalar_mul_gen(&pubkey, seckey);
+        secp256k1_scalar_mul_gen(&R, k);
+        secp256k1_point_get_affine(x, y, &R);
+        secp256k1_scalar_reduce(r, x);
+
+        secp256k1_scalar_to_mont(t, r);
+        secp256k1_scalar_mul_mont(t, t, seckey);
+        secp256k1_scalar_sub(e, k, t);
+        fp256_get_bytes(msg, e);
+
+        fp256_get_bytes(sig, r);
+        fp256_set_word(s, 1);
+        fp256_get_bytes(sig + 32, s);
+        if (secp256k1_ecdsa_verify(msg, sig, &pubkey) != CRYPTO_OK) {
+            printf("ecdsa verify test, range %d fail\n", i+1);
+            return CRYPTO_ERR;
+        }
+
+        /* s = n + 1 */
+        fp256_copy(s, n);
+        s[0] += 1;
+        fp256_get_bytes(sig + 32, s);
+        if (secp256k1_ecdsa_verify(msg, sig, &pubkey) == CRYPTO_OK) {
+            printf("ecdsa verify test, range %d, s = n + 1 accepted\n", i+1);
+            return CRYPTO_ERR;
+        }
+
+        /* s = n */
+        fp256_get_bytes(sig + 32, n);
+        if (secp256k1_ecdsa_verify(msg, sig, &pubkey) == CRYPTO_OK) {
+            printf("ecdsa verify test, range %d, s = n accepted\n", i+1);
+            return CRYPTO_ERR;
+        }
+
+        /* r = n */
+        fp256_get_bytes(sig, n);
+        fp256_set_word(s, 1);
+        fp256_get_bytes(sig + 32, s);
+        if (secp256k1_ecdsa_verify(msg, sig, &pubkey) == CRYPTO_OK) {
+            printf("ecdsa verify test, range %d, r = n accepted\n", i+1);
+            return CRYPTO_ERR;
+        }
+    }
+
+    printf("ecdsa verify test pass\n");
+    return CRYPTO_OK;
+}
+
+/************************** SHA256 ***************************/
+typedef struct
+{
+    char *key;    /* NULL for sha256 */
+    char *msg;
+    char *digest; /* hex */
+}SHA256_TEST_VEC;
+
+static const SHA256_TEST_VEC sha256_test_vec[] =
+{
+    /* 1, empty */
+    {
+        NULL,
+        "",
+        "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855",
+    },
+    /* 2, one block */
+    {
+        NULL,
+        "abc",
+        "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad",
+    },
+    /* 3, two blocks */
+    {
+        NULL,
+        "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq",
+        "248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1",
+    },
+    /* 4, hmac, RFC 4231 case 2 */
+    {
+        "Jefe",
+        "what do ya want for nothing?",
+        "5bdcc146bf60754e6a042426089575c75a003f089d2739839dec58b964ec3843",
+    },
+    /* 5, hmac, key longer than block size */
+    {
+        "aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa",
+        "Test Using Larger Than Block-Size Key - Hash Key First",
+        "d021303c2f34bf3ae541b4ec9c672691694c6f71c5c0c55781545a66115b14a7",
+    },
+};
+
+static int sha256_test()
+{
+    int i, j;
+    size_t len;
+    SECP256K1_SHA256_CTX ctx;
+    unsigned char digest[32], expected[32];
+    const unsigned char *msg;
+
+    for (i = 0; i < sizeof(sha256_test_vec) / sizeof(SHA256_TEST_VEC); i++) {
+        msg = (const unsigned char*)sha256_test_vec[i].msg;
+        len = strlen(sha256_test_vec[i].msg);
+        hex_to_u8(expected, (unsigned char*)sha256_test_vec[i].digest, 64);
+
+        if (sha256_test_vec[i].key == NULL) {
+            secp256k1_sha256(digest, msg, len);
+            if (memcmp(digest, expected, 32) != 0) {
+                printf("sha256 test %d fail\n", i+1);
+                return CRYPTO_ERR;
+            }
+
+            /* byte by byte update */
+            secp256k1_sha256_init(&ctx);
+            for (j = 0; j < len; j++)
+                secp256k1_sha256_update(&ctx, msg + j, 1);
+            secp256k1_sha256_final(digest, &ctx);
+        }
+        else
+            secp256k1_hmac_sha256(digest, (const unsigned char*)sha256_test_vec[i].key,
+                                  strlen(sha256_test_vec[i].key), msg, len);
+
+        if (memcmp(digest, expected, 32) != 0) {
+            printf("sha256 test %d fail\n", i+1);
+            return CRYPTO_ERR;
+        }
+    }
+
+    printf("sha256 test pass\n");
+    return CRYPTO_OK;
+}
+
+/************************** ECDSA SIGN ***************************/
+typedef struct
+{
+    char *seckey; /* hex */
+    char *msg;    /* 32 bytes hash, hex */
+    char *sig;    /* r || s, hex */
+}ECDSA_SIGN_TEST_VEC;
+
+static const ECDSA_SIGN_TEST_VEC ecdsa_sign_test_vec[] =
+{
+    /* 1, d = 1, sha256("Satoshi Nakamoto") */
+    {
+        "1",
+        "a0dc65ffca799873cbea0ac274015b9526505daaaed385155425f7337704883e",
+        "934b1ea10a4b3c1757e2b0c017d0b6143ce3c9a7e6a4a49860d7a6ab210ee3d82442ce9d2b916064108014783e923ec36b49743e2ffa1c4496f01a512aafd9e5",
+    },
+    /* 2, d = n - 1 */
+    {
+        "fffffffffffffffffffffffffffffffebaaedce6af48a03bbfd25e8cd0364140",
+        "a0dc65ffca799873cbea0ac274015b9526505daaaed385155425f7337704883e",
+        "fd567d121db66e382991534ada77a6bd3106f0a1098c231e47993447cd6af2d06b39cd0eb1bc8603e159ef5c20a5c8ad685a45b06ce9bebed3f153d10d93bed5",
+    },
+    /* 3, sha256("Alan Turing") */
+    {
+        "f8b8af8ce3c7cca5e300d33939540c10d45ce001b8f252bfbc57ba0342904181",
+        "4ba38d48a60f1b29e9eb726eaff08b2e83d8d81e031666fee50e85900d7dc1ef",
+        "7063ae83e7f62bbb171798131b4a0564b956930092b33b07b395615d9ec7e15c58dfcc1e00a35e1572f366ffe34ba0fc47db1e7189759b9fb233c5b05ab388ea",
+    },
+    /* 4 */
+    {
+        "e91671c46231f833a6406ccbea0e3e392c76c167bac1cb013f6f1013980455c2",
+        "1609a53bb33ef00e0cc1e784b436d7924956d87ec2b399574378312f07cba3e8",
+        "b552edd27580141f3b2a5463048cb7cd3e047b97c9f98076c32dbdf85a68718b279fa72dd19bfae05577e06c7c0c1900c371fcd5893f7e1d56a37d30174671f6",
+    },
+    /* 5, msg > n */
+    {
+        "2",
+        "ffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffff",
+        "dd926427ae6b3df4a4e9242dc2261363b557b9af5e8c04a171f72bd8b295ebfa7e9ae9348c12debe52ee3df2557f5220c05df290aa8449025d5d29440411cf39",
+    },
+};
+
+static int secp256k1_ecdsa_sign_test()
+{
+    int i;
+    POINT256 pubkey;
+    BN_ULONG d[P256_LIMBS], s[P256_LIMBS], n_half[P256_LIMBS];
+    unsigned char seckey[32], msg[32], sig[64], expected[64];
+
+    for (i = 0; i < sizeof(ecdsa_sign_test_vec) / sizeof(ECDSA_SIGN_TEST_VEC); i++) {
+        fp256_set_hex(d, (unsigned char*)ecdsa_sign_test_vec[i].seckey, strlen((const char*)ecdsa_sign_test_vec[i].seckey));
+        fp256_get_bytes(seckey, d);
+        hex_to_u8(msg, (unsigned char*)ecdsa_sign_test_vec[i].msg, 64);
+        hex_to_u8(expected, (unsigned char*)ecdsa_sign_test_vec[i].sig, 128);
+
+        if (secp256k1_ecdsa_sign(sig, msg, seckey) != CRYPTO_OK ||
+            memcmp(sig, expected, 64) != 0) {
+            printf("ecdsa sign test %d fail\n", i+1);
+            return CRYPTO_ERR;
+        }
+    }
+
+    /* invalid secret keys */
+    memset(seckey, 0, 32);
+    if (secp256k1_ecdsa_sign(sig, msg, seckey) != CRYPTO_ERR) {
+        printf("ecdsa sign test, zero key accepted\n");
+        return CRYPTO_ERR;
+    }
+    fp256_set_hex(d, (unsigned char*)"fffffffffffffffffffffffffffffffebaaedce6af48a03bbfd25e8cd0364141", 64);
+    fp256_get_bytes(seckey, d);
+    if (secp256k1_ecdsa_sign(sig, msg, seckey) != CRYPTO_ERR) {
+        printf("ecdsa sign test, key = n accepted\n");
+        return CRYPTO_ERR;
+    }
+    d[0] += 1;
+    fp256_get_bytes(seckey, d);
+    if (secp256k1_ecdsa_sign(sig, msg, seckey) != CRYPTO_ERR) {
+        printf("ecdsa sign test, key = n + 1 accepted\n");
+        return CRYPTO_ERR;
+    }
+
+    /* random sign then verify, s must be low */
+    fp256_set_hex(n_half, (unsigned char*)"7fffffffffffffffffffffffffffffff5d576e7357a4501ddfe92f46681b20a0", 64);
+    for (i = 0; i < 100; i++) {
+        secp256k1_rand(d);
+        secp256k1_scalar_reduce(d, d);
+        if (fp256_is_zero(d))
+            continue;
+        fp256_get_bytes(seckey, d);
+        RAND_buf(msg, 32);
+
+        if (secp256k1_ecdsa_sign(sig, msg, seckey) != CRYPTO_OK) {
+            printf("ecdsa sign test, random %d sign fail\n", i+1);
+            return CRYPTO_ERR;
+        }
+
+        fp256_set_bytes(s, sig + 32, 32);
+        if (fp256_cmp(s, n_half) > 0) {
+            printf("ecdsa sign test, random %d high s\n", i+1);
+            return CRYPTO_ERR;
+        }
+
+        secp256k1_scalar_mul_gen(&pubkey, d);
+        if (secp256k1_ecdsa_verify(msg, sig, &pubkey) != CRYPTO_OK) {
+            printf("ecdsa sign test, random %d verify fail\n", i+1);
+            return CRYPTO_ERR;
+        }
+    }
+
+    printf("ecdsa sign test pass\n");
+    return CRYPTO_OK;
+}
+
+/************************** SCHNORRSIG ***************************/
+static int secp256k1_mod_sqrt_test()
+{
+    int i, squares = 0;
+    BN_ULONG a[P256_LIMBS], r[P256_LIMBS], t[P256_LIMBS];
+
+    for (i = 0; i < 1000; i++) {
+        secp256k1_rand(a);
+        secp256k1_to_mont(a, a);
+
+        /* a^2 is always a square */
+        secp256k1_sqr_mont(t, a);
+        if (secp256k1_mod_sqrt(r, t) != CRYPTO_OK) {
+            printf("mod sqrt test %d, square rejected\n", i+1);
+            return CRYPTO_ERR;
+        }
+        secp256k1_sqr_mont(r, r);
+        if (fp256_cmp(r, t) != 0) {
+            printf("mod sqrt test %d fail\n", i+1);
+            return CRYPTO_ERR;
+        }
+
+        /* about half of random elements are squares */
+        if (secp256k1_mod_sqrt(r, a) == CRYPTO_OK) {
+            secp256k1_sqr_mont(t, r);
+            if (fp256_cmp(t, a) != 0) {
+                printf("mod sqrt test %d fail\n", i+1);
+                return CRYPTO_ERR;
+            }
+            squares++;
+        }
+    }
+
+    if (squares < 400 || squares > 600) {
+        printf("mod sqrt test, %d squares out of 1000\n", squares);
+        return CRYPTO_ERR;
+    }
+
+    printf("mod sqrt test pass\n");
+    return CRYPTO_OK;
+}
+
+typedef struct
+{
+    char *seckey; /* hex, NULL for verify only */
+    char *pubkey; /* x-only, hex */
+    char *aux;    /* hex */
+    char *msg;    /* hex */
+    char *sig;    /* hex */
+    int valid;
+}SCHNORRSIG_TEST_VEC;
+
+/* 1 - 5 from BIP340 test-vectors.csv */
+static const SCHNORRSIG_TEST_VEC schnorrsig_test_vec[] =
+{
+    /* 1 */
+    {
+        "0000000000000000000000000000000000000000000000000000000000000003",
+        "f9308a019258c31049344f85f89d5229b531c845836f99b08601f113bce036f9",
+        "0000000000000000000000000000000000000000000000000000000000000000",
+        "0000000000000000000000000000000000000000000000000000000000000000",
+        "e907831f80848d1069a5371b402410364bdf1c5f8307b0084c55f1ce2dca821525f66a4a85ea8b71e482a74f382d2ce5ebeee8fdb2172f477df4900d310536c0",
+        1,
+    },
+    /* 2 */
+    {
+        "b7e151628aed2a6abf7158809cf4f3c762e7160f38b4da56a784d9045190cfef",
+        "dff1d77f2a671c5f36183726db2341be58feae1da2deced843240f7b502ba659",
+        "0000000000000000000000000000000000000000000000000000000000000001",
+        "243f6a8885a308d313198a2e03707344a4093822299f31d0082efa98ec4e6c89",
+        "6896bd60eeae296db48a229ff71dfe071bde413e6d43f917dc8dcf8c78de33418906d11ac976abccb20b091292bff4ea897efcb639ea871cfa95f6de339e4b0a",
+        1,
+    },
+    /* 3 */
+    {
+        "c90fdaa22168c234c4c6628b80dc1cd129024e088a67cc74020bbea63b14e5c9",
+        "dd308afec5777e13121fa72b9cc1b7cc0139715309b086c960e18fd969774eb8",
+        "c87aa53824b4d7ae2eb035a2b5bbbccc080e76cdc6d1692c4b0b62d798e6d906",
+        "7e2d58d8b3bcdf1abadec7829054f90dda9805aab56c77333024b9d0a508b75c",
+        "5831aaeed7b44bb74e5eab94ba9d4294c49bcf2a60728d8b4c200f50dd313c1bab745879a5ad954a72c45a91c3a51d3c7adea98d82f8481e0e1e03674a6f3fb7",
+        1,
+    },
+    /* 4 */
+    {
+        "0b432b2677937381aef05bb02a66ecd012773062cf3fa2549e44f58ed2401710",
+        "25d1dff95105f5253c4022f628a996ad3a0d95fbf21d468a1b33f8c160d8f517",
+        "ffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffff",
+        "ffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffff",
+        "7eb0509757e246f19449885651611cb965ecc1a187dd51b64fda1edc9637d5ec97582b9cb13db3933705b32ba982af5af25fd78881ebb32771fc5922efc66ea3",
+        1,
+    },
+    /* 5, r has leading zeros */
+    {
+        NULL,
+        "d69c3509bb99e412e68b0fe8544e72837dfa30746d8be2aa65975f29d22dc7b9",
+        NULL,
+        "4df3c3f68fcc83b27e9d42c90431a72499f17875c81a599b566c9889b9696703",
+        "00000000000000000000003b78ce563f89a0ed9414f5aa28ad0d96d6795f9c6376afb1548af603b3eb45c9f8207dee1060cb71c04e80f593060b07d28308d7f4",
+        1,
+    },
+    /* 6, public key not on the curve */
+    {
+        NULL,
+        "eefdea4cdb677750a420fee807eacf21eb9898ae79b9768766e4faa04a2d4a34",
+        NULL,
+        "243f6a8885a308d313198a2e03707344a4093822299f31d0082efa98ec4e6c89",
+        "6cff5c3ba86c69ea4b7376f31a9bcb4f74c1976089b2d9963da2e5543e17776969e89b4c5564d00349106b8497785dd7d1d713a8ae82b32fa79d5f7fc407d39b",
+        0,
+    },
+    /* 7, negated s */
+    {
+        NULL,
+        "dff1d77f2a671c5f36183726db2341be58feae1da2deced843240f7b502ba659",
+        NULL,
+        "243f6a8885a308d313198a2e03707344a4093822299f31d0082efa98ec4e6c89",
+        "6896bd60eeae296db48a229ff71dfe071bde413e6d43f917dc8dcf8c78de334176f92ee5368954334df4f6ed6d400b14312fe030755e191ec53c67ae9c97f637",
+        0,
+    },
+    /* 8, y(R) is odd */
+    {
+        NULL,
+        "dff1d77f2a671c5f36183726db2341be58feae1da2deced843240f7b502ba659",
+        NULL,
+        "243f6a8885a308d313198a2e03707344a4093822299f31d0082efa98ec4e6c89",
+        "fff97bd5755eeea420453a14355235d382f6472f8568a18b2f057a14602975563cc27944640ac607cd107ae10923d9ef7a73c643e166be5ebeafa34b1ac553e2",
+        0,
+    },
+    /* 9, y(R) is even, same key and message as 8 */
+    {
+        NULL,
+        "dff1d77f2a671c5f36183726db2341be58feae1da2deced843240f7b502ba659",
+        NULL,
+        "243f6a8885a308d313198a2e03707344a4093822299f31d0082efa98ec4e6c89",
+        "2f8bde4d1a07209355b4a7250a5c5128e88b84bddc619ab7cba8d569b240efe4629b790938034c9ab4b0d7ab45f33cdc0e50f919f68d630097b8811b7f660b38",
+        1,
+    },
+    /* 10, r = p */
+    {
+        NULL,
+        "dff1d77f2a671c5f36183726db2341be58feae1da2deced843240f7b502ba659",
+        NULL,
+        "243f6a8885a308d313198a2e03707344a4093822299f31d0082efa98ec4e6c89",
+        "fffffffffffffffffffffffffffffffffffffffffffffffffffffffefffffc2f8906d11ac976abccb20b091292bff4ea897efcb639ea871cfa95f6de339e4b0a",
+        0,
+    },
+    /* 11, s = n */
+    {
+        NULL,
+        "dff1d77f2a671c5f36183726db2341be58feae1da2deced843240f7b502ba659",
+        NULL,
+        "243f6a8885a308d313198a2e03707344a4093822299f31d0082efa98ec4e6c89",
+        "6896bd60eeae296db48a229ff71dfe071bde413e6d43f917dc8dcf8c78de3341fffffffffffffffffffffffffffffffebaaedce6af48a03bbfd25e8cd0364141",
+        0,
+    },
+    /* 12, message changed */
+    {
+        NULL,
+        "dff1d77f2a671c5f36183726db2341be58feae1da2deced843240f7b502ba659",
+        NULL,
+        "243f6a8885a308d313198a2e03707344a4093822299f31d0082efa98ec4e6c8a",
+        "6896bd60eeae296db48a229ff71dfe071bde413e6d43f917dc8dcf8c78de33418906d11ac976abccb20b091292bff4ea897efcb639ea871cfa95f6de339e4b0a",
+        0,
+    },
+};
+
+static int secp256k1_schnorrsig_test()
+{
+    int i;
+    BN_ULONG d[P256_LIMBS];
+    unsigned char seckey[32], pubkey[32], aux[32], msg[32], sig[64];
+    unsigned char expected_pubkey[32], expected_sig[64];
+
+    for (i = 0; i < sizeof(schnorrsig_test_vec) / sizeof(SCHNORRSIG_TEST_VEC); i++) {
+        hex_to_u8(expected_pubkey, (unsigned char*)schnorrsig_test_vec[i].pubkey, 64);
+        hex_to_u8(msg, (unsigned char*)schnorrsig_test_vec[i].msg, 64);
+        hex_to_u8(expected_sig, (unsigned char*)schnorrsig_test_vec[i].sig, 128);
+
+        if (schnorrsig_test_vec[i].seckey != NULL) {
+            hex_to_u8(seckey, (unsigned char*)schnorrsig_test_vec[i].seckey, 64);
+            hex_to_u8(aux, (unsigned char*)schnorrsig_test_vec[i].aux, 64);
+
+            if (secp256k1_xonly_pubkey_create(pubkey, seckey) != CRYPTO_OK ||
+                memcmp(pubkey, expected_pubkey, 32) != 0) {
+                printf("schnorrsig test %d, pubkey fail\n", i+1);
+                return CRYPTO_ERR;
+            }
+
+            if (secp256k1_schnorrsig_sign(sig, msg, seckey, aux) != CRYPTO_OK ||
+                memcmp(sig, expected_sig, 64) != 0) {
+                printf("schnorrsig test %d, sign fail\n", i+1);
+                return CRYPTO_ERR;
+            }
+        }
+
+        if ((secp256k1_schnorrsig_verify(expected_sig, msg, expected_pubkey) == CRYPTO_OK) != schnorrsig_test_vec[i].valid) {
+            printf("schnorrsig test %d, verify fail\n", i+1);
+            return CRYPTO_ERR;
+        }
+    }
+
+    /* secret keys n and n + 1 */
+    memset(aux, 0, 32);
+    memset(msg, 0, 32);
+    fp256_set_hex(d, (unsigned char*)"fffffffffffffffffffffffffffffffebaaedce6af48a03bbfd25e8cd0364141", 64);
+    for (i = 0; i < 2; i++) {
+        d[0] += i;
+        fp256_get_bytes(seckey, d);
+        if (secp256k1_xonly_pubkey_create(pubkey, seckey) != CRYPTO_ERR ||
+            secp256k1_schnorrsig_sign(sig, msg, seckey, aux) != CRYPTO_ERR) {
+            printf("schnorrsig test, key = n + %d accepted\n", i);
+            return CRYPTO_ERR;
+        }
+    }
+
+    /* random sign then verify */
+    for (i = 0; i < 100; i++) {
+        secp256k1_rand(d);
+        secp256k1_scalar_reduce(d, d);
+        if (fp256_is_zero(d))
+            continue;
+        fp256_get_bytes(seckey, d);
+        RAND_buf(aux, 32);
+        RAND_buf(msg, 32);
+
+        if (secp256k1_xonly_pubkey_create(pubkey, seckey) != CRYPTO_OK ||
+            secp256k1_schnorrsig_sign(sig, msg, seckey, aux) != CRYPTO_OK ||
+            secp256k1_schnorrsig_verify(sig, msg, pubkey) != CRYPTO_OK) {
+            printf("schnorrsig test, random %d fail\n", i+1);
+            return CRYPTO_ERR;
+        }
+
+        sig[63] ^= 1;
+        if (secp256k1_schnorrsig_verify(sig, msg, pubkey) == CRYPTO_OK) {
+            printf("schnorrsig test, random %d forged\n", i+1);
+            return CRYPTO_ERR;
+        }
+    }
+
+    printf("schnorrsig test pass\n");
+    return CRYPTO_OK;
+}
+
+static int secp256k1_schnorrsig_verify_batch_test()
+{
+    int i, k;
+    size_t j, n;
+    const size_t sizes[] = { 1, 2, 3, 65, 150 };
+    BN_ULONG d[P256_LIMBS];
+    unsigned char seckey[32], aux[32];
+    unsigned char (*sig)[64], (*msg)[32], (*pubkey)[32];
+
+    sig = (unsigned char (*)[64])malloc(150 * 64);
+    msg = (unsigned char (*)[32])malloc(150 * 32);
+    pubkey = (unsigned char (*)[32])malloc(150 * 32);
+
+    for (j = 0; j < 150; j++) {
+        do {
+            secp256k1_rand(d);
+            secp256k1_scalar_reduce(d, d);
+        } while (fp256_is_zero(d));
+        fp256_get_bytes(seckey, d);
+        RAND_buf(aux, 32);
+        RAND_buf(msg[j], 32);
+        secp256k1_xonly_pubkey_create(pubkey[j], seckey);
+        secp256k1_schnorrsig_sign(sig[j], msg[j], seckey, aux);
+    }
+
+    for (i = 0; i < sizeof(sizes) / sizeof(size_t); i++) {
+        n = sizes[i];
+        if (secp256k1_schnorrsig_verify_batch((const unsigned char (*)[64])sig, (const unsigned char (*)[32])msg,
+                                              (const unsigned char (*)[32])pubkey, n) != CRYPTO_OK) {
+            printf("schnorrsig verify batch test, n = %d fail\n", (int)n);
+            goto fail;
+        }
+
+        /* one bad signature anywhere fails the batch */
+        for (k = 0; k < 3; k++) {
+            j = (k == 0) ? 0 : (k == 1 ? n - 1 : n / 2);
+            sig[j][40] ^= 0x10;
+            if (secp256k1_schnorrsig_verify_batch((const unsigned char (*)[64])sig, (const unsigned char (*)[32])msg,
+                                                  (const unsigned char (*)[32])pubkey, n) == CRYPTO_OK) {
+                printf("schnorrsig verify batch test, n = %d, bad signature %d accepted\n", (int)n, (int)j);
+                goto fail;
+            }
+            sig[j][40] ^= 0x10;
+        }
+    }
+
+    /* valid BIP340 vectors together, then each invalid one added */
+    for (j = 0, n = 0; j < sizeof(schnorrsig_test_vec) / sizeof(SCHNORRSIG_TEST_VEC); j++) {
+        if (!schnorrsig_test_vec[j].valid)
+            continue;
+        hex_to_u8(pubkey[n], (unsigned char*)schnorrsig_test_vec[j].pubkey, 64);
+        hex_to_u8(msg[n], (unsigned char*)schnorrsig_test_vec[j].msg, 64);
+        hex_to_u8(sig[n], (unsigned char*)schnorrsig_test_vec[j].sig, 128);
+        n++;
+    }
+    if (secp256k1_schnorrsig_verify_batch((const unsigned char (*)[64])sig, (const unsigned char (*)[32])msg,
+                                          (const unsigned char (*)[32])pubkey, n) != CRYPTO_OK) {
+        printf("schnorrsig verify batch test, vectors fail\n");
+        goto fail;
+    }
+    for (j = 0; j < sizeof(schnorrsig_test_vec) / sizeof(SCHNORRSIG_TEST_VEC); j++) {
+        if (schnorrsig_test_vec[j].valid)
+            continue;
+        hex_to_u8(pubkey[n], (unsigned char*)schnorrsig_test_vec[j].pubkey, 64);
+        hex_to_u8(msg[n], (unsigned char*)schnorrsig_test_vec[j].msg, 64);
+        hex_to_u8(sig[n], (unsigned char*)schnorrsig_test_vec[j].sig, 128);
+        if (secp256k1_schnorrsig_verify_batch((const unsigned char (*)[64])sig, (const unsigned char (*)[32])msg,
+                                              (const unsigned char (*)[32])pubkey, n + 1) == CRYPTO_OK) {
+            printf("schnorrsig verify batch test, vector %d accepted\n", (int)j+1);
+            goto fail;
+        }
+    }
+
+    free(sig);
+    free(msg);
+    free(pubkey);
+    printf("schnorrsig verify batch test pass\n");
+    return CRYPTO_OK;
+
+fail:
+    free(sig);
+    free(msg);
+    free(pubkey);
+    return CRYPTO_ERR;
+}
+
+/************************** GLV ***************************/
+static const char *glv_test_scalars[] =
+{
+    "0",
+    "1",
+    "2",
+    "fffffffffffffffffffffffffffffffebaaedce6af48a03bbfd25e8cd0364140", /* n - 1 */
+    "7fffffffffffffffffffffffffffffff5d576e7357a4501ddfe92f46681b20a0", /* (n - 1) / 2 */
+    "5363ad4cc05c30e0a5261c028812645a122e22ea20816678df02967c1b23bd72", /* lambda */
+    "ac9c52b33fa3cf1f5ad9e3fd77ed9ba4a880b9fc8ec739c2e0cfc810b51283cf", /* n - lambda */
+    "ffffffffffffffffffffffffffffffff",
+    "100000000000000000000000000000000",
+    "e4437ed6010e88286f547fa90abfe4c3", /* -b1 */
+};
+
+static int secp256k1_glv_test()
+{
+    int i, j;
+    BN_ULONG k[P256_LIMBS], k1[P256_LIMBS], k2[P256_LIMBS];
+    BN_ULONG lambda[P256_LIMBS], t[P256_LIMBS];
+    POINT256 G, r1, r2;
+
+    fp256_set_hex(lambda, (unsigned char*)glv_test_scalars[5], 64);
+    secp256k1_scalar_to_mont(lambda, lambda);
+    secp256k1_get_generator(&G);
+
+    for (i = 0; i < 1000; i++) {
+        if (i < sizeof(glv_test_scalars) / sizeof(char*))
+            fp256_set_hex(k, (unsigned char*)glv_test_scalars[i], strlen(glv_test_scalars[i]));
+        else {
+            secp256k1_rand(k);
+            secp256k1_scalar_reduce(k, k);
+        }
+
+        /* k = k1 + k2*lambda */
+        secp256k1_scalar_split_lambda(k1, k2, k);
+        secp256k1_scalar_mul_mont(t, k2, lambda);
+        secp256k1_scalar_add(t, t, k1);
+        if (fp256_cmp(t, k) != 0) {
+            printf("glv test %d, split fail\n", i+1);
+            return CRYPTO_ERR;
+        }
+
+        /* |k1|, |k2| < 2^128 */
+        for (j = 0; j < 2; j++) {
+            fp256_copy(t, j == 0 ? k1 : k2);
+            if (t[2] | t[3])
+                secp256k1_scalar_neg(t, t);
+            if (t[2] | t[3]) {
+                printf("glv test %d, k%d too large\n", i+1, j+1);
+                return CRYPTO_ERR;
+            }
+        }
+
+        /* k*G by GLV ladder and by generator table */
+        if (i < 100) {
+            secp256k1_scalar_mul_point(&r1, k, &G);
+            secp256k1_scalar_mul_gen(&r2, k);
+            if (secp256k1_point_cmp(&r1, &r2) != 0) {
+                printf("glv test %d, mul point fail\n", i+1);
+                return CRYPTO_ERR;
+            }
+        }
+    }
+
+    printf("glv test pass\n");
+    return CRYPTO_OK;
+}
+
+static int secp256k1_mul_p_var_test()
+{
+    int i, w;
+    BN_ULONG k[P256_LIMBS];
+    POINT256 P, r1, r2;
+
+    for (i = 0; i < 200; i++) {
+        if (i < sizeof(glv_test_scalars) / sizeof(char*))
+            fp256_set_hex(k, (unsigned char*)glv_test_scalars[i], strlen(glv_test_scalars[i]));
+        else
+            secp256k1_rand(k);
+
+        /* random point */
+        secp256k1_rand(r1.X);
+        secp256k1_scalar_mul_gen(&P, r1.X);
+
+        secp256k1_scalar_mul_point(&r1, k, &P);
+        for (w = (i < 20 ? 2 : 0); w <= (i < 20 ? 8 : 0); w++) {
+            if (secp256k1_scalar_mul_point_var(&r2, k, &P, w) != CRYPTO_OK ||
+                secp256k1_point_cmp(&r1, &r2) != 0) {
+                printf("mul_p var test %d, w = %d fail\n", i+1, w);
+                return CRYPTO_ERR;
+            }
+        }
+    }
+
+    /* point at infinity */
+    memset(&P, 0, sizeof(POINT256));
+    if (secp256k1_scalar_mul_point_var(&r2, k, &P, 0) != CRYPTO_OK ||
+        !fp256_is_zero(r2.Z)) {
+        printf("mul_p var test, infinity fail\n");
+        return CRYPTO_ERR;
+    }
+
+    if (secp256k1_scalar_mul_point_var(&r2, k, &P, 1) != CRYPTO_ERR ||
+        secp256k1_scalar_mul_point_var(&r2, k, &P, 9) != CRYPTO_ERR) {
+        printf("mul_p var test, invalid window accepted\n");
+        return CRYPTO_ERR;
+    }
+
+    printf("mul_p var test pass\n");
+    return CRYPTO_OK;
+}
+
+/************************** FOUR LANES ***************************/
+static int secp256k1_scalar_mul_x4_test()
+{
+    int i, l;
+    const int nfixed = sizeof(glv_test_scalars) / sizeof(char*);
+    BN_ULONG k[4][P256_LIMBS];
+    POINT256 P[4], r[4], r1;
+
+    for (i = 0; i < 100; i++) {
+        for (l = 0; l < 4; l++) {
+            /* the fixed scalars in every lane */
+            if (i < nfixed)
+                fp256_set_hex(k[l], (unsigned char*)glv_test_scalars[(i + l) % nfixed],
+                              strlen(glv_test_scalars[(i + l) % nfixed]));
+            else
+                secp256k1_rand(k[l]);
+
+            /* random point, jacobian */
+            secp256k1_rand(r1.X);
+            secp256k1_scalar_mul_gen(&P[l], r1.X);
+        }
+
+        /* infinity and repeated points in some lanes */
+        if (i % 10 == 1)
+            memset(&P[i / 10 % 4], 0, sizeof(POINT256));
+        if (i % 10 == 2) {
+            P[1] = P[0];
+            fp256_copy(k[1], k[0]);
+        }
+
+        if (secp256k1_scalar_mul_gen_x4(r, (const BN_ULONG (*)[P256_LIMBS])k) != CRYPTO_OK) {
+            printf("mul x4 test %d, mul gen fail\n", i+1);
+            return CRYPTO_ERR;
+        }
+        for (l = 0; l < 4; l++) {
+            secp256k1_scalar_mul_gen(&r1, k[l]);
+            if (secp256k1_point_cmp(&r1, &r[l]) != 0) {
+                printf("mul x4 test %d, mul gen lane %d fail\n", i+1, l);
+                return CRYPTO_ERR;
+            }
+        }
+
+        if (secp256k1_scalar_mul_point_x4(r, (const BN_ULONG (*)[P256_LIMBS])k, P) != CRYPTO_OK) {
+            printf("mul x4 test %d, mul point fail\n", i+1);
+            return CRYPTO_ERR;
+        }
+        for (l = 0; l < 4; l++) {
+            secp256k1_scalar_mul_point(&r1, k[l], &P[l]);
+            if (secp256k1_point_cmp(&r1, &r[l]) != 0) {
+                printf("mul x4 test %d, mul point lane %d fail\n", i+1, l);
+                return CRYPTO_ERR;
+            }
+        }
+    }
+
+    printf("mul x4 test pass\n");
+    return CRYPTO_OK;
+}
+
+/* the AVX2 engine is not dispatched to, check it directly */
+static int secp256k1_scalar_mul_x4_avx2_test()
+{
+    int i, l;
+    const int nfixed = sizeof(glv_test_scalars) / sizeof(char*);
+    BN_ULONG k[4][P256_LIMBS];
+    POINT256 P[4], r[4], r1;
+
+    if (!runtime_has_avx2()) {
+        printf("mul x4 avx2 test skipped, no avx2\n");
+        return CRYPTO_OK;
+    }
+
+    for (i = 0; i < 100; i++) {
+        for (l = 0; l < 4; l++) {
+            if (i < nfixed)
+                fp256_set_hex(k[l], (unsigned char*)glv_test_scalars[(i + l) % nfixed],
+                              strlen(glv_test_scalars[(i + l) % nfixed]));
+            else
+                secp256k1_rand(k[l]);
+
+            secp256k1_rand(r1.X);
+            secp256k1_scalar_mul_gen(&P[l], r1.X);
+        }
+
+        /* infinity and repeated points in some lanes */
+        if (i % 10 == 1)
+            memset(&P[i / 10 % 4], 0, sizeof(POINT256));
+        if (i % 10 == 2) {
+            P[1] = P[0];
+            fp256_copy(k[1], k[0]);
+        }
+
+        if (secp256k1_scalar_mul_gen_x4_avx2(r, (const BN_ULONG (*)[P256_LIMBS])k) != CRYPTO_OK) {
+            printf("mul x4 avx2 test %d, mul gen fail\n", i+1);
+            return CRYPTO_ERR;
+        }
+        for (l = 0; l < 4; l++) {
+            secp256k1_scalar_mul_gen(&r1, k[l]);
+            if (secp256k1_point_cmp(&r1, &r[l]) != 0) {
+                printf("mul x4 avx2 test %d, mul gen lane %d fail\n", i+1, l);
+                return CRYPTO_ERR;
+            }
+        }
+
+        if (secp256k1_scalar_mul_point_x4_avx2(r, (const BN_ULONG (*)[P256_LIMBS])k, P) != CRYPTO_OK) {
+            printf("mul x4 avx2 test %d, mul point fail\n", i+1);
+            return CRYPTO_ERR;
+        }
+        for (l = 0; l < 4; l++) {
+            secp256k1_scalar_mul_point(&r1, k[l], &P[l]);
+            if (secp256k1_point_cmp(&r1, &r[l]) != 0) {
+                printf("mul x4 avx2 test %d, mul point lane %d fail\n", i+1, l);
+                return CRYPTO_ERR;
+            }
+        }
+    }
+
+    printf("mul x4 avx2 test pass\n");
+    return CRYPTO_OK;
+}
+
+/************************** MUL GEN BATCH ***************************/
+static int secp256k1_scalar_mul_gen_batch_test()
+{
+    int t;
+    size_t i, n;
+    const size_t sizes[] = { 0, 1, 15, 16, 17, 40 };
+    BN_ULONG k[40][P256_LIMBS];
+    POINT256 r[40], r1;
+
+    for (t = 0; t < (int)(sizeof(sizes) / sizeof(size_t)); t++) {
+        n = sizes[t];
+        for (i = 0; i < n; i++)
+            secp256k1_rand(k[i]);
+        /* zero, N and a repeated scalar */
+        if (n > 2) {
+            fp256_set_word(k[0], 0);
+            fp256_set_hex(k[1], (unsigned char*)"FFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFEBAAEDCE6AF48A03BBFD25E8CD0364141", 64);
+            fp256_copy(k[2], k[n - 1]);
+        }
+
+        if (secp256k1_scalar_mul_gen_batch(r, (const BN_ULONG (*)[P256_LIMBS])k, n) != CRYPTO_OK) {
+            printf("mul gen batch test %d fail\n", (int)n);
+            return CRYPTO_ERR;
+        }
+        for (i = 0; i < n; i++) {
+            secp256k1_scalar_mul_gen(&r1, k[i]);
+            if (secp256k1_point_cmp(&r1, &r[i]) != 0) {
+                printf("mul gen batch test %d, point %d fail\n", (int)n, (int)i);
+                return CRYPTO_ERR;
+            }
+        }
+    }
+
+    printf("mul gen batch test pass\n");
+    return CRYPTO_OK;
+}
+
+/************************** PREPARED POINT ***************************/
+static int secp256k1_prepared_point_test()
+{
+    int i, w;
+    size_t len;
+    BN_ULONG k[P256_LIMBS];
+    POINT256 P, r1, r2;
+    SECP256K1_PREPARED_POINT *pp = NULL, *pp2 = NULL;
+    unsigned char buf[2 + 64 * 128];
+
+    for (w = 4; w <= 8; w++) {
+        /* random point */
+        secp256k1_rand(r1.X);
+        secp256k1_scalar_mul_gen(&P, r1.X);
+
+        if ((pp = secp256k1_prepared_point_new(&P, w == 6 ? 0 : w)) == NULL) {
+            printf("prepared point test, w = %d new fail\n", w);
+            goto fail;
+        }
+
+        len = sizeof(buf);
+        if (secp256k1_prepared_point_serialize(buf, &len, pp) != CRYPTO_OK ||
+            len != secp256k1_prepared_point_serialized_size(pp) ||
+            (pp2 = secp256k1_prepared_point_load(buf, len)) == NULL) {
+            printf("prepared point test, w = %d serialize fail\n", w);
+            goto fail;
+        }
+
+        for (i = 0; i < 50; i++) {
+            if (i < sizeof(glv_test_scalars) / sizeof(char*))
+                fp256_set_hex(k, (unsigned char*)glv_test_scalars[i], strlen(glv_test_scalars[i]));
+            else
+                secp256k1_rand(k);
+
+            secp256k1_scalar_mul_point(&r1, k, &P);
+            if (secp256k1_scalar_mul_prepared(&r2, k, pp) != CRYPTO_OK ||
+                secp256k1_point_cmp(&r1, &r2) != 0) {
+                printf("prepared point test, w = %d, scalar %d fail\n", w, i+1);
+                goto fail;
+            }
+            if (secp256k1_scalar_mul_prepared(&r2, k, pp2) != CRYPTO_OK ||
+                secp256k1_point_cmp(&r1, &r2) != 0) {
+                printf("prepared point test, w = %d, scalar %d loaded fail\n", w, i+1);
+                goto fail;
+            }
+        }
+
+        /* truncated, bad version, point off the curve */
+        if (secp256k1_prepared_point_load(buf, len - 1) != NULL) {
+            printf("prepared point test, truncated buffer accepted\n");
+            goto fail;
+        }
+        buf[0] ^= 0xff;
+        if (secp256k1_prepared_point_load(buf, len) != NULL) {
+            printf("prepared point test, bad version accepted\n");
+            goto fail;
+        }
+        buf[0] ^= 0xff;
+        buf[len - 1] ^= 1;
+        if (secp256k1_prepared_point_load(buf, len) != NULL) {
+            printf("prepared point test, bad entry accepted\n");
+            goto fail;
+        }
+
+        secp256k1_prepared_point_free(pp);
+        secp256k1_prepared_point_free(pp2);
+        pp = pp2 = NULL;
+    }
+
+    memset(&P, 0, sizeof(POINT256));
+    if (secp256k1_prepared_point_new(&P, 0) != NULL ||
+        secp256k1_prepared_point_new(&r1, 3) != NULL ||
+        secp256k1_prepared_point_new(&r1, 9) != NULL) {
+        printf("prepared point test, invalid input accepted\n");
+        return CRYPTO_ERR;
+    }
+
+    printf("prepared point test pass\n");
+    return CRYPTO_OK;
+
+fail:
+    secp256k1_prepared_point_free(pp);
+    secp256k1_prepared_point_free(pp2);
+    return CRYPTO_ERR;
+}
+
+static int secp256k1_point_cache_test()
+{
+    int i;
+    /* a point is admitted on its second miss, 4 entries fit, P[4] evicts P[0] */
+    static const int order[] = { 0, 0, 1, 1, 2, 2, 3, 3, 0, 1, 2, 3, 4, 4, 3, 0 };
+    static const int hit[]   = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 0, 0, 1, 0 };
+    const int steps = sizeof(order) / sizeof(int);
+    BN_ULONG k[16][P256_LIMBS], x[P256_LIMBS], y[P256_LIMBS];
+    POINT256 P[5], J, r, expected[16];
+    SECP256K1_POINT_CACHE_STATS st;
+    uint64_t hits = 0, misses = 0;
+    size_t entry;
+
+    /* affine points(Z = 1) are cached, J is not */
+    for (i = 0; i < 5; i++) {
+        secp256k1_rand(k[0]);
+        secp256k1_scalar_mul_gen(&J, k[0]);
+        secp256k1_point_get_affine(x, y, &J);
+        secp256k1_point_set_affine(&P[i], x, y);
+    }
+
+    for (i = 0; i < steps; i++) {
+        secp256k1_rand(k[i]);
+        secp256k1_scalar_mul_point(&expected[i], k[i], &P[order[i]]);
+    }
+
+    /* size of one entry */
+    if (secp256k1_point_cache_config(1 << 20, 0) != CRYPTO_OK)
+        goto fail;
+    secp256k1_scalar_mul_point(&r, k[0], &P[0]);
+    secp256k1_point_cache_stats(&st);
+    if (st.entries != 0 || st.misses != 1 ||
+        secp256k1_point_cmp(&r, &expected[0]) != 0) {
+        printf("point cache test, first miss fail\n");
+        goto fail;
+    }
+    secp256k1_scalar_mul_point(&r, k[1], &P[0]);
+    secp256k1_point_cache_stats(&st);
+    if (st.entries != 1 || st.misses != 2 || st.bytes == 0 ||
+        secp256k1_point_cmp(&r, &expected[1]) != 0) {
+        printf("point cache test, first entry fail\n");
+        goto fail;
+    }
+    entry = st.bytes;
+
+    if (secp256k1_point_cache_config(4 * entry, 0) != CRYPTO_OK)
+        goto fail;
+
+    for (i = 0; i < steps; i++) {
+        secp256k1_scalar_mul_point(&r, k[i], &P[order[i]]);
+        if (secp256k1_point_cmp(&r, &expected[i]) != 0) {
+            printf("point cache test, step %d result fail\n", i);
+            goto fail;
+        }
+
+        hits += hit[i];
+        misses += !hit[i];
+        secp256k1_point_cache_stats(&st);
+        if (st.hits != hits || st.misses != misses) {
+            printf("point cache test, step %d counters fail\n", i);
+            goto fail;
+        }
+    }
+
+    if (st.evictions != 1 || st.entries != 4 || st.bytes != 4 * entry) {
+        printf("point cache test, eviction fail\n");
+        goto fail;
+    }
+
+    /* jacobian input bypasses the cache */
+    secp256k1_scalar_mul_point(&r, k[0], &J);
+    secp256k1_point_cache_stats(&st);
+    if (st.hits != hits || st.misses != misses) {
+        printf("point cache test, jacobian point cached\n");
+        goto fail;
+    }
+
+    /* unsupported window, budget below one entry */
+    if (secp256k1_point_cache_config(1 << 20, 3) != CRYPTO_ERR ||
+        secp256k1_point_cache_config(entry - 1, 0) != CRYPTO_ERR) {
+        printf("point cache test, invalid config accepted\n");
+        goto fail;
+    }
+
+    secp256k1_point_cache_config(0, 0);
+    secp256k1_scalar_mul_point(&r, k[0], &P[0]);
+    secp256k1_point_cache_stats(&st);
+    if (st.misses != 0 || st.entries != 0 || st.bytes != 0) {
+        printf("point cache test, disabled cache used\n");
+        return CRYPTO_ERR;
+    }
+
+    printf("point cache test pass\n");
+    return CRYPTO_OK;
+
+fail:
+    secp256k1_point_cache_config(0, 0);
+    return CRYPTO_ERR;
+}
+
+/************************** MULTI SCALAR MUL ***************************/
+static int secp256k1_multi_scalar_mul_test()
+{
+    int i;
+    size_t j, n;
+    const size_t sizes[] = { 0, 1, 2, 7, 255, 256, 257, 700 };
+    BN_ULONG (*scalars)[P256_LIMBS];
+    POINT256 *points;
+    POINT256 r1, r2, t;
+    void *scratch;
+
+    scalars = (BN_ULONG (*)[P256_LIMBS])malloc(700 * sizeof(BN_ULONG) * P256_LIMBS);
+    points = (POINT256*)malloc(700 * sizeof(POINT256));
+
+    for (j = 0; j < 700; j++) {
+        secp256k1_rand(scalars[j]);
+        secp256k1_rand(t.X);
+        secp256k1_scalar_mul_gen(&points[j], t.X);
+    }
+
+    /* duplicated points, opposite points, infinity, zero and n - 1 scalars */
+    points[3] = points[2];
+    points[4] = points[2];
+    fp256_copy(scalars[4], scalars[2]);
+    points[5] = points[2];
+    secp256k1_neg(points[5].Y, points[5].Y);
+    memset(&points[6], 0, sizeof(POINT256));
+    fp256_set_word(scalars[1], 0);
+    secp256k1_get_order(scalars[100]);
+    scalars[100][0] -= 1;
+    for (j = 150; j < 200; j++)
+        points[j] = points[149];
+
+    for (i = 0; i < sizeof(sizes) / sizeof(size_t); i++) {
+        n = sizes[i];
+
+        memset(&r1, 0, sizeof(POINT256));
+        for (j = 0; j < n; j++) {
+            secp256k1_scalar_mul_point_var(&t, scalars[j], &points[j], 0);
+            secp256k1_point_add(&r1, &r1, &t);
+        }
+
+        scratch = malloc(secp256k1_multi_scalar_mul_scratch_size(n) + 1);
+        if (secp256k1_multi_scalar_mul(&r2, (const BN_ULONG (*)[P256_LIMBS])scalars, points, n, scratch) != CRYPTO_OK ||
+            secp256k1_point_cmp(&r1, &r2) != 0) {
+            printf("multi scalar mul test, n = %d fail\n", (int)n);
+            free(scratch);
+            goto fail;
+        }
+        free(scratch);
+    }
+
+    free(scalars);
+    free(points);
+    printf("multi scalar mul test pass\n");
+    return CRYPTO_OK;
+
+fail:
+    free(scalars);
+    free(points);
+    return CRYPTO_ERR;
+}
+
+#ifdef TEST_NO_MULX
+extern unsigned int cpu_info[4];
+#endif
+
+int main(int argc, char **argv)
+{
+    int ret = 0;
+    if (CRYPTO_init() == CRYPTO_ERR)
+        return -1;
+#ifdef TEST_NO_MULX
+    /* clear bmi2/adx, the asm takes the mulq paths */
+    cpu_info[2] &= ~0x80100u;
+#endif
+
+    // TEST_ARGS args;
+    // args.ok = 0;
+    // args.N = 12345;
+    // args.num_threads = 4;
+    // get_test_args(argc, argv, &args);
+
+    if (secp256k1_mul_g_test() == CRYPTO_ERR) {
+        ret = -1;
+        goto end;
+    }
+
+    if (secp256k1_mul_g_config_test() == CRYPTO_ERR) {
+        ret = -1;
+        goto end;
+    }
+
+    if (secp256k1_mul_g_edge_test() == CRYPTO_ERR) {
+        ret = -1;
+        goto end;
+    }
+
+    if (secp256k1_mul_p_test() == CRYPTO_ERR) {
+        ret = -1;
+        goto end;
+    }
+
+    if (secp256k1_coor_test() == CRYPTO_ERR) {
+        ret = -1;
+        goto end;
+    }
+
+    if (secp256k1_coor_batch_test() == CRYPTO_ERR) {
+        ret = -1;
+        goto end;
+    }
+
+    if (secp256k1_mont_reduce_test() == CRYPTO_ERR) {
+        ret = -1;
+        goto end;
+    }
+
+    if (secp256k1_mul_pm_test() == CRYPTO_ERR) {
+        ret = -1;
+        goto end;
+    }
+
+    if (secp256k1_point_dbl_n_lookup_test() == CRYPTO_ERR) {
+        ret = -1;
+        goto end;
+    }
+
+    if (secp256k1_sqr_mont_n_test() == CRYPTO_ERR) {
+        ret = -1;
+        goto end;
+    }
+
+#ifdef SECP256K1_HAVE_INLINE_FIELD
+    if (secp256k1_field_inline_test() == CRYPTO_ERR) {
+        ret = -1;
+        goto end;
+    }
+#endif
+
+    if (secp256k1_mod_inverse_var_test() == CRYPTO_ERR) {
+        ret = -1;
+        goto end;
+    }
+
+    if (secp256k1_scalar_test() == CRYPTO_ERR) {
+        ret = -1;
+        goto end;
+    }
+
+    if (secp256k1_ecdsa_verify_test() == CRYPTO_ERR) {
+        ret = -1;
+        goto end;
+    }
+
+    if (sha256_test() == CRYPTO_ERR) {
+        ret = -1;
+        goto end;
+    }
+
+    if (secp256k1_ecdsa_sign_test() == CRYPTO_ERR) {
+        ret = -1;
+        goto end;
+    }
+
+    if (secp256k1_mod_sqrt_test() == CRYPTO_ERR) {
+        ret = -1;
+        goto end;
+    }
+
+    if (secp256k1_schnorrsig_test() == CRYPTO_ERR) {
+        ret = -1;
+        goto end;
+    }
+
+    if (secp256k1_schnorrsig_verify_batch_test() == CRYPTO_ERR) {
+        ret = -1;
+        goto end;
+    }
+
+    if (secp256k1_glv_test() == CRYPTO_ERR) {
+        ret = -1;
+        goto end;
+    }
+
+    if (secp256k1_mul_p_var_test() == CRYPTO_ERR) {
+        ret = -1;
+        goto end;
+    }
+
+    if (secp256k1_scalar_mul_x4_test() == CRYPTO_ERR) {
+        ret = -1;
+        goto end;
+    }
+
+    if (secp256k1_scalar_mul_x4_avx2_test() == CRYPTO_ERR) {
+        ret = -1;
+        goto end;
+    }
+
+    if (secp256k1_scalar_mul_gen_batch_test() == CRYPTO_ERR) {
+        ret = -1;
+        goto end;
+    }
+
+    if (secp256k1_prepared_point_test() == CRYPTO_ERR) {
+        ret = -1;
+        goto end;
+    }
+
+    if (secp256k1_point_cache_test() == CRYPTO_ERR) {
+        ret = -1;
+        goto end;
+    }
+
+    if (secp256k1_multi_scalar_mul_test() == CRYPTO_ERR) {
         ret = -1;
         goto end;
     }
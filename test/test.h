@@ -20,9 +20,12 @@
 
 #include <secp256k1_x64/common.h>
 #include <secp256k1_x64/crypto.h>
+#include <secp256k1_x64/ecdsa.h>
 #include <secp256k1_x64/fp256.h>
 #include <secp256k1_x64/rand.h>
+#include <secp256k1_x64/schnorrsig.h>
 #include <secp256k1_x64/secp256k1.h>
+#include <secp256k1_x64/sha256.h>
 #include <stdio.h>
 #include <time.h>
 #include <stdint.h>